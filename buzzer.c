@@ -1,51 +1,310 @@
 #include "buzzer.h"
-#include <wiringPi.h>
-#include <softTone.h>
+#include "command.h"
+#include "proto_verbs.h"
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include "gpio_hal.h"
+#include "device_state.h"
+#include "gpio_plugin.h"
 #define BUZZER 18
 
+static void record_buzzer(int on) {
+    struct device_state *st = device_state_begin();
+    st->buzzer_on = on;
+    device_state_end();
+}
+
+// 톤 출력과 함께 재생 위치를 상태에 기록
+static void play_tone(int song, int note, int freq) {
+    gpio_tone_write(BUZZER, freq);
+    struct device_state *st = device_state_begin();
+    st->buzzer_freq = freq;
+    st->buzzer_song = song;
+    st->buzzer_note = note;
+    device_state_end();
+}
+
+static int player_start(void);
+static void player_stop(void);
+
+// 핀 설정, 톤 생성기, 재생 스레드는 여기서 한 번만 만든다
+int buzzer_init(void) {
+    gpio_pin_mode(BUZZER, GPIO_OUTPUT);
+    gpio_write(BUZZER, 0);
+    if (gpio_tone_create(BUZZER) < 0) return -1;
+    return player_start();
+}
+
+void buzzer_teardown(void) {
+    player_stop();
+    play_tone(0, 0, 0);
+    gpio_pin_mode(BUZZER, GPIO_OUTPUT);
+    gpio_write(BUZZER, 0);
+    record_buzzer(0);
+}
+
 int buzzer_on(void) {
-    wiringPiSetupGpio();
-    pinMode(BUZZER, OUTPUT);
-    digitalWrite(BUZZER, 1);
+    gpio_pin_mode(BUZZER, GPIO_OUTPUT);
+    gpio_write(BUZZER, 1);
+    record_buzzer(1);
     return 0;
 }
 
 int buzzer_off(void) {
-    wiringPiSetupGpio();
-    pinMode(BUZZER, OUTPUT);
-    digitalWrite(BUZZER, 0);
+    buzzer_stop();
+    gpio_pin_mode(BUZZER, GPIO_OUTPUT);
+    gpio_write(BUZZER, 0);
+    record_buzzer(0);
     return 0;
 }
 
+uint32_t buzzer_off_mask(void) {
+    buzzer_stop();
+    gpio_pin_mode(BUZZER, GPIO_OUTPUT);
+    record_buzzer(0); // 호출한 쪽이 곧바로 마스크로 LOW를 쓴다
+    return 1u << BUZZER;
+}
+
+// ---- 재생 엔진 ----
+// 데몬 수명 동안 재생 스레드 하나와 톤 생성기 하나만 쓴다.
+// 명령은 큐에 넣고 바로 돌아오며, 정지/선점은 조건변수로 깨워 현재 음 도중에도 즉시 반영된다.
+
+struct song {
+    const int *notes;   // 주파수 (Hz)
+    const int *ms;      // 음 길이 (ms)
+    int len;
+    int gap_ms;         // 음 사이 쉼
+};
+
 // 곰 세 마리(대표 구절) 멜로디
 // 음계: C C F F A A F | G G E E D D C
-// 주파수: 262 262 349 349 440 440 349 | 392 392 330 330 294 294 262
-int buzzer_play_music(int music_id) {
-    wiringPiSetupGpio();
-    pinMode(BUZZER, OUTPUT);
-    softToneCreate(BUZZER);
-    if (music_id == 2) {
-        // 요아소비 '아이돌' 멜로디
-        int notes[] = {659, 784, 880, 1047, 880, 784, 880, 1047, 880, 784, 880, 659, 784, 880, 1319, 988, 784, 880, 988, 1319, 1175, 1397, 1319};
-        int beats[] = {125, 125, 250, 250, 250, 125, 250, 125, 125, 125, 250, 125, 125, 250, 250, 250, 125, 250, 125, 125, 125, 250, 250};
-        int len = sizeof(notes)/sizeof(notes[0]);
-        for (int i = 0; i < len; i++) {
-            softToneWrite(BUZZER, notes[i]);
-            delay(beats[i]);
-            softToneWrite(BUZZER, 0);
-            delay(20);
+static const int bear_notes[] = {262,262,349,349,440,440,349, 392,392,330,330,294,294,262};
+static const int bear_ms[] = {350,350,350,350,350,350,700, 350,350,350,350,350,350,700};
+// 요아소비 '아이돌' 멜로디
+static const int idol_notes[] = {659, 784, 880, 1047, 880, 784, 880, 1047, 880, 784, 880, 659, 784, 880, 1319, 988, 784, 880, 988, 1319, 1175, 1397, 1319};
+static const int idol_ms[] = {125, 125, 250, 250, 250, 125, 250, 125, 125, 125, 250, 125, 125, 250, 250, 250, 125, 250, 125, 125, 125, 250, 250};
+
+static const struct song songs[BUZZER_SONG_MAX + 1] = {
+    [BUZZER_SONG_BEAR] = {bear_notes, bear_ms, sizeof(bear_notes) / sizeof(bear_notes[0]), 0},
+    [BUZZER_SONG_IDOL] = {idol_notes, idol_ms, sizeof(idol_notes) / sizeof(idol_notes[0]), 20},
+};
+
+#define PLAY_QUEUE_SIZE 8
+
+static pthread_t player_thread;
+static int player_started = 0;
+static pthread_mutex_t player_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t player_cond;
+static int play_queue[PLAY_QUEUE_SIZE];
+static int queue_head = 0, queue_len = 0;
+static int cur_song = 0;           // 재생 중인 곡 (0이면 대기)
+static int cur_note = 0;           // 재생 중인 음 번호
+static unsigned long song_start = 0;
+static int interrupt = 0;          // 현재 곡을 끊으라는 요청 (정지/선점)
+static int quit = 0;
+
+static struct timespec deadline_after(int ms) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+// player_mutex를 잡은 상태에서 호출. 끊기 요청이 오면 1
+static int wait_ms(int ms) {
+    struct timespec until = deadline_after(ms);
+    while (!interrupt && !quit) {
+        if (pthread_cond_timedwait(&player_cond, &player_mutex, &until) == ETIMEDOUT) break;
+    }
+    return interrupt || quit;
+}
+
+static void *player_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&player_mutex);
+    while (!quit) {
+        if (queue_len == 0) {
+            pthread_cond_wait(&player_cond, &player_mutex);
+            continue;
         }
-    } else {
-        // 곰 세 마리(대표 구절) 멜로디
-        int notes[] = {262,262,349,349,440,440,349, 392,392,330,330,294,294,262};
-        int beats[] = {1,1,1,1,1,1,2, 1,1,1,1,1,1,2};
-        int len = sizeof(notes)/sizeof(notes[0]);
-        for (int i = 0; i < len; i++) {
-            softToneWrite(BUZZER, notes[i]);
-            delay(350 * beats[i]);
+        const struct song *s = &songs[play_queue[queue_head]];
+        cur_song = play_queue[queue_head];
+        queue_head = (queue_head + 1) % PLAY_QUEUE_SIZE;
+        queue_len--;
+        interrupt = 0;
+        song_start = gpio_millis();
+        for (cur_note = 0; cur_note < s->len; cur_note++) {
+            play_tone(cur_song, cur_note, s->notes[cur_note]);
+            if (wait_ms(s->ms[cur_note])) break;
+            if (s->gap_ms > 0) {
+                play_tone(cur_song, cur_note, 0);
+                if (wait_ms(s->gap_ms)) break;
+            }
         }
-        softToneWrite(BUZZER, 0);
+        play_tone(0, 0, 0);
+        cur_song = 0;
+        cur_note = 0;
     }
-    softToneWrite(BUZZER, 0);
+    pthread_mutex_unlock(&player_mutex);
+    return NULL;
+}
+
+static int player_start(void) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&player_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    quit = 0;
+    if (pthread_create(&player_thread, NULL, player_main, NULL) != 0) return -1;
+    player_started = 1;
     return 0;
-} 
\ No newline at end of file
+}
+
+static void player_stop(void) {
+    if (!player_started) return;
+    pthread_mutex_lock(&player_mutex);
+    quit = 1;
+    pthread_cond_signal(&player_cond);
+    pthread_mutex_unlock(&player_mutex);
+    pthread_join(player_thread, NULL);
+    player_started = 0;
+}
+
+int buzzer_play(int song, int mode) {
+    if (song < 1 || song > BUZZER_SONG_MAX) return -1;
+    pthread_mutex_lock(&player_mutex);
+    if (mode == BUZZER_PLAY_NOW) {
+        // 대기 중인 곡을 비우고 현재 곡을 끊는다
+        queue_len = 0;
+        if (cur_song) interrupt = 1;
+    } else if (queue_len == PLAY_QUEUE_SIZE) {
+        pthread_mutex_unlock(&player_mutex);
+        return -1;
+    }
+    play_queue[(queue_head + queue_len) % PLAY_QUEUE_SIZE] = song;
+    queue_len++;
+    int queued = queue_len;
+    pthread_cond_signal(&player_cond);
+    pthread_mutex_unlock(&player_mutex);
+    return queued;
+}
+
+void buzzer_stop(void) {
+    pthread_mutex_lock(&player_mutex);
+    queue_len = 0;
+    if (cur_song) interrupt = 1;
+    pthread_cond_signal(&player_cond);
+    pthread_mutex_unlock(&player_mutex);
+}
+
+void buzzer_status(struct buzzer_status *st) {
+    pthread_mutex_lock(&player_mutex);
+    st->song = cur_song;
+    st->note = cur_song ? cur_note : 0;
+    st->notes = cur_song ? songs[cur_song].len : 0;
+    st->elapsed_ms = cur_song ? (int)(gpio_millis() - song_start) : 0;
+    st->queued = queue_len;
+    pthread_mutex_unlock(&player_mutex);
+}
+
+// 예전 호출부 호환용: 지금 곡을 끊고 바로 재생 (블로킹하지 않음)
+int buzzer_play_music(int music_id) {
+    if (music_id < 1 || music_id > BUZZER_SONG_MAX) music_id = BUZZER_SONG_BEAR;
+    return buzzer_play(music_id, BUZZER_PLAY_NOW) < 0 ? -1 : 0;
+}
+
+// ---- 명령 핸들러 ----
+static void cmd_buzzer_on(const struct request *req, struct reply *rep) {
+    (void)req;
+    buzzer_on();
+    reply_ok(rep, "OK:BUZZER:ON");
+}
+
+static void cmd_buzzer_off(const struct request *req, struct reply *rep) {
+    (void)req;
+    buzzer_off();
+    reply_ok(rep, "OK:BUZZER:OFF");
+}
+
+static int song_arg(const struct request *req) {
+    if (req->nargs < 1) return BUZZER_SONG_BEAR;
+    int id = req->args[0];
+    return id < 1 || id > BUZZER_SONG_MAX ? BUZZER_SONG_BEAR : id;
+}
+
+// 재생 스레드에 넘기고 바로 응답 (현재 곡은 끊긴다)
+static void cmd_buzzer_music(const struct request *req, struct reply *rep) {
+    buzzer_play(song_arg(req), BUZZER_PLAY_NOW);
+    reply_ok(rep, "OK:BUZZER:MUSIC");
+}
+
+// 현재 곡 뒤에 이어서 재생, 응답 값은 대기 중인 곡 수
+static void cmd_buzzer_queue(const struct request *req, struct reply *rep) {
+    int queued = buzzer_play(song_arg(req), BUZZER_PLAY_QUEUE);
+    if (queued < 0) {
+        reply_error(rep, ST_BUSY);
+        return;
+    }
+    reply_ok(rep, "OK:BUZZER:QUEUE");
+    reply_value(rep, queued);
+}
+
+static void cmd_buzzer_stop(const struct request *req, struct reply *rep) {
+    (void)req;
+    buzzer_stop();
+    reply_ok(rep, "OK:BUZZER:STOP");
+}
+
+// VALUE:BUZZER:STATUS:<곡>:<음 번호>:<전체 음 수>:<경과 ms>:<대기 곡 수>
+static void cmd_buzzer_status(const struct request *req, struct reply *rep) {
+    (void)req;
+    struct buzzer_status st;
+    buzzer_status(&st);
+    reply_ok(rep, "VALUE:BUZZER:STATUS");
+    reply_value(rep, st.song);
+    reply_value(rep, st.note);
+    reply_value(rep, st.notes);
+    reply_value(rep, st.elapsed_ms);
+    reply_value(rep, st.queued);
+}
+
+static const struct command_def buzzer_commands[] = {
+    {VERB_BUZZER_ON,     cmd_buzzer_on},
+    {VERB_BUZZER_OFF,    cmd_buzzer_off},
+    {VERB_BUZZER_MUSIC,  cmd_buzzer_music},
+    {VERB_BUZZER_QUEUE,  cmd_buzzer_queue},
+    {VERB_BUZZER_STOP,   cmd_buzzer_stop},
+    {VERB_BUZZER_STATUS, cmd_buzzer_status},
+};
+
+// ---- 플러그인 기술자 ----
+// 재생 엔진은 모듈마다 따로 있으므로 핫 스왑 때는 새 엔진만 띄우고 옛 엔진은 멈춘다.
+// 핀 모드, 톤 생성기, BUZZER:ON 레벨은 그대로 둔다 (옛 엔진이 곡을 재생 중이었다면 그 곡은 끊김)
+static int buzzer_plugin_init(int flags) {
+    return flags & GPIO_PLUGIN_RELOAD ? player_start() : buzzer_init();
+}
+
+static void buzzer_plugin_teardown(int flags) {
+    if (flags & GPIO_PLUGIN_RELOAD) player_stop();
+    else buzzer_teardown();
+}
+
+GPIO_PLUGIN_EXPORT(buzzer) = {
+    .abi = GPIO_PLUGIN_ABI,
+    .name = "buzzer",
+    .version = 1,
+    .device = DEV_BUZZER,
+    .init = buzzer_plugin_init,
+    .teardown = buzzer_plugin_teardown,
+    .off_mask = buzzer_off_mask,
+    .commands = buzzer_commands,
+    .ncommands = sizeof(buzzer_commands) / sizeof(buzzer_commands[0]),
+};
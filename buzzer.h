@@ -1,8 +1,40 @@
 #ifndef BUZZER_H
 #define BUZZER_H
 
+#include <stdint.h>
+
+int buzzer_init(void);       // 핀 설정 + 톤 생성기 준비 (데몬 시작 시 한 번)
+void buzzer_teardown(void);  // 부저 OFF (데몬 종료 시)
 int buzzer_on(void);
 int buzzer_off(void);
-int buzzer_play_music(int music_id); // 음악 재생(추가기능)
+uint32_t buzzer_off_mask(void); // 출력 모드를 맞추고 OFF 시 LOW로 내릴 핀 마스크 반환
+int buzzer_play_music(int music_id); // 음악 재생(추가기능), 현재 곡을 끊고 바로 돌아옴
+
+// 재생 엔진 (재생 스레드 하나가 큐의 곡을 차례로 재생)
+enum buzzer_song {
+    BUZZER_SONG_BEAR = 1,   // 곰 세 마리
+    BUZZER_SONG_IDOL = 2,   // 아이돌
+    BUZZER_SONG_MAX = BUZZER_SONG_IDOL
+};
+
+enum buzzer_play_mode {
+    BUZZER_PLAY_NOW,        // 대기 곡을 비우고 현재 곡을 끊은 뒤 재생
+    BUZZER_PLAY_QUEUE       // 큐 끝에 추가
+};
+
+struct buzzer_status {
+    int song;        // 재생 중인 곡 (0이면 대기)
+    int note;        // 현재 음 번호 (0부터)
+    int notes;       // 곡의 전체 음 수
+    int elapsed_ms;  // 곡 시작 후 경과 시간
+    int queued;      // 대기 중인 곡 수
+};
+
+int buzzer_play(int song, int mode); // 대기 곡 수, 큐가 차면 -1
+void buzzer_stop(void);              // 대기 곡을 비우고 현재 곡 중단 (현재 음 도중에도 즉시)
+void buzzer_status(struct buzzer_status *st);
+
+struct gpio_plugin;
+extern const struct gpio_plugin buzzer_plugin; // 내장 플러그인 기술자 (buzzer.so와 같은 소스)
 
 #endif 
\ No newline at end of file
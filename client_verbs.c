@@ -0,0 +1,26 @@
+/**
+ * client_verbs.c - 클라이언트용 verb/opcode 표 (proto_verbs.h의 목록을 핸들러 없이 펼침)
+ */
+#include "client_verbs.h"
+#include "command.h"
+#include "proto_verbs.h"
+
+#define CLIENT_VERB(v) {v, NULL},
+
+static const struct command_def client_commands[] = {
+    GPIO_VERBS(CLIENT_VERB)
+};
+
+// 여러 곳(스크립트 모드, 연결 풀)에서 불러도 한 번만 등록
+int client_verbs_register(void) {
+    static int registered = 0;
+    if (registered) return 0;
+    if (command_register(client_commands, sizeof(client_commands) / sizeof(client_commands[0])) < 0) return -1;
+    registered = 1;
+    return 0;
+}
+
+const char *client_verb_name(int opcode) {
+    const struct command_def *d = command_by_opcode(opcode);
+    return d ? d->verb : NULL;
+}
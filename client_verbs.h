@@ -0,0 +1,13 @@
+#ifndef CLIENT_VERBS_H
+#define CLIENT_VERBS_H
+
+/*
+ * 클라이언트 쪽 명령 표
+ * 텍스트 명령("LED:BRIGHT:2")을 바이너리 요청으로 바꿀 때 proto_parse_text가
+ * verb → opcode를 찾을 수 있도록 데몬과 같은 verb/opcode/디바이스(proto_verbs.h)를 핸들러 없이 등록한다.
+ */
+
+int client_verbs_register(void);            // 0 또는 -1, 두 번째 호출부터는 아무 일도 하지 않음
+const char *client_verb_name(int opcode);   // 응답 표시용, 모르는 opcode면 NULL
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * cmd_bench.c - 디바이스 명령 지연시간 마이크로벤치마크 (시뮬레이션 백엔드)
+ *
+ * 명령마다 setup + pinMode를 다시 하던 기존 방식과, 초기화는 한 번만 하고
+ * 모드 캐시를 쓰는 현재 방식을 같은 명령열로 비교한다.
+ *
+ * 사용법: ./cmd_bench [반복횟수]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <syslog.h>
+#include "protocol.h"
+#include "command.h"
+#include "gpio_hal.h"
+#include "gpio_sim.h"
+#include "led.h"
+#include "seg7.h"
+#include "light_sensor.h"
+#include "gpio_plugin.h"
+
+#define DEFAULT_ITERATIONS 1000000
+#define LED 17
+#define LIGHT_SENSOR_PIN 27
+
+extern const struct gpio_backend gpio_sim_backend;
+static const struct gpio_backend *hw = &gpio_sim_backend;
+
+static const int bcd_pins[4] = {5, 6, 12, 13};
+
+// ---- 기존 구현 재현: 매 호출마다 setup + pinMode ----
+static void legacy_execute(const struct request *req, struct reply *rep) {
+    switch (req->opcode) {
+        case OP_LED_ON:
+        case OP_LED_OFF:
+            hw->setup();
+            hw->pin_mode(LED, GPIO_OUTPUT);
+            hw->write(LED, req->opcode == OP_LED_ON);
+            reply_ok(rep, req->opcode == OP_LED_ON ? "OK:LED:ON" : "OK:LED:OFF");
+            break;
+        case OP_LED_BRIGHT:
+            hw->setup();
+            hw->pin_mode(LED, GPIO_PWM_OUTPUT);
+            hw->pwm_write(LED, 170);
+            reply_ok(rep, "OK:LED:BRIGHT");
+            reply_value(rep, req->args[0]);
+            break;
+        case OP_SEG7_SHOW:
+            hw->setup();
+            for (int i = 0; i < 4; i++) hw->pin_mode(bcd_pins[i], GPIO_OUTPUT);
+            for (int i = 0; i < 4; i++) hw->write(bcd_pins[i], (req->args[0] >> i) & 1);
+            reply_ok(rep, "OK:SEG7");
+            reply_value(rep, req->args[0]);
+            break;
+        case OP_SENSOR_READ:
+            hw->setup();
+            hw->pin_mode(LIGHT_SENSOR_PIN, GPIO_INPUT);
+            reply_ok(rep, "VALUE:SENSOR");
+            reply_value(rep, req->args[0]);
+            reply_value(rep, hw->read(LIGHT_SENSOR_PIN));
+            syslog(LOG_INFO, "센서 핀 %d 값: %d", req->args[0], rep->vals[1]); // 기존 코드와 동일하게 로그 포함
+            break;
+    }
+}
+
+struct scenario {
+    const char *name;
+    const char *cmds[10];
+};
+
+static const struct scenario scenarios[] = {
+    {"LED ON/OFF",       {"LED:ON", "LED:OFF", NULL}},
+    {"SEG7 0-9",         {"SEG7:0", "SEG7:1", "SEG7:2", "SEG7:3", "SEG7:4",
+                          "SEG7:5", "SEG7:6", "SEG7:7", "SEG7:8", "SEG7:9"}},
+    {"SENSOR",           {"SENSOR:27", NULL}},
+    {"LED BRIGHT/ON",    {"LED:BRIGHT:1", "LED:ON", NULL}},
+};
+#define NUM_SCENARIOS (sizeof(scenarios) / sizeof(scenarios[0]))
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// 명령 한 개 = 텍스트 파싱 + 실행 + 응답 인코딩
+static void run(const struct scenario *sc, long iterations, int legacy, double *ns, double *ops) {
+    int n = 0;
+    while (n < 10 && sc->cmds[n]) n++;
+    char out[PROTO_MAX_REPLY];
+    unsigned long ops0 = gpio_sim_op_count();
+    double t0 = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        struct request req;
+        struct reply rep;
+        memset(&rep, 0, sizeof(rep));
+        proto_parse_text(sc->cmds[i % n], &req);
+        if (legacy) legacy_execute(&req, &rep);
+        else command_dispatch(&req, &rep);
+        proto_encode_text(&rep, out, sizeof(out));
+    }
+    *ns = (now_ns() - t0) / iterations;
+    *ops = (double)(gpio_sim_op_count() - ops0) / iterations;
+}
+
+int main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : DEFAULT_ITERATIONS;
+
+    gpio_init("sim");
+    gpio_setup();
+    // 플러그인 로더 없이 내장 모듈의 명령 표를 그대로 등록한다
+    const struct gpio_plugin *plugins[] = {&led_plugin, &seg7_plugin, &light_sensor_plugin};
+    for (size_t i = 0; i < sizeof(plugins) / sizeof(plugins[0]); i++) {
+        if (command_register(plugins[i]->commands, plugins[i]->ncommands) < 0) {
+            fprintf(stderr, "명령 등록 실패\n");
+            return 1;
+        }
+    }
+    led_init();
+    seg7_init();
+    light_sensor_init();
+
+    printf("반복 횟수: %ld (시뮬레이션 백엔드, 파싱+실행+응답 포함)\n", iterations);
+    printf("%-16s %12s %12s %12s %12s\n", "scenario", "before ns", "after ns", "before ops", "after ops");
+    for (size_t i = 0; i < NUM_SCENARIOS; i++) {
+        double before_ns, after_ns, before_ops, after_ops;
+        run(&scenarios[i], iterations, 1, &before_ns, &before_ops);
+        // 기존 방식이 백엔드 모드를 직접 바꿨으므로 캐시를 현재 방식 상태로 다시 맞춘다
+        gpio_init("sim");
+        led_init();
+        seg7_init();
+        light_sensor_init();
+        run(&scenarios[i], iterations, 0, &after_ns, &after_ops);
+        printf("%-16s %12.1f %12.1f %12.2f %12.2f\n", scenarios[i].name,
+               before_ns, after_ns, before_ops, after_ops);
+    }
+    return 0;
+}
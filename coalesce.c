@@ -0,0 +1,59 @@
+/**
+ * coalesce.c - 클라이언트 명령 출력 모으기
+ *
+ * 값은 HAL이 모아 두고(gpio_coalesce_*), 여기서는 창이 끝나는 시각에 한 번 쓰게만 한다.
+ * 창은 모아 둔 값이 처음 생길 때 시작하므로 명령 하나의 출력이 늦어지는 최대 시간이 창 크기다.
+ */
+#include "coalesce.h"
+#include "event_loop.h"
+#include "gpio_hal.h"
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+static unsigned window_ms = 0;
+static int tfd = -1;
+static int armed = 0;
+
+static void on_timer(int fd, uint32_t events, void *arg) {
+    (void)events;
+    (void)arg;
+    uint64_t expirations;
+    ssize_t n = read(fd, &expirations, sizeof(expirations));
+    (void)n;
+    armed = 0;
+    gpio_coalesce_flush();
+}
+
+int coalesce_init(unsigned ms) {
+    if (ms > COALESCE_MAX_MS) return -1;
+    window_ms = ms;
+    if (ms == 0) return 0;
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd < 0) return -1;
+    if (event_loop_add(tfd, EPOLLIN, on_timer, NULL) < 0) {
+        close(tfd);
+        tfd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+unsigned coalesce_window(void) {
+    return window_ms;
+}
+
+void coalesce_begin(void) {
+    if (tfd >= 0) gpio_coalesce_begin();
+}
+
+void coalesce_end(void) {
+    if (tfd < 0 || !gpio_coalesce_end() || armed) return;
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = window_ms / 1000;
+    its.it_value.tv_nsec = (long)(window_ms % 1000) * 1000000L;
+    timerfd_settime(tfd, 0, &its, NULL);
+    armed = 1;
+}
@@ -0,0 +1,20 @@
+#ifndef COALESCE_H
+#define COALESCE_H
+
+/*
+ * 클라이언트 명령 출력 모으기
+ * - 창(ms)이 0이 아니면 클라이언트 명령이 쓰는 GPIO 0~31 값을 바로 쓰지 않고 모아 두었다가
+ *   첫 쓰기부터 창이 지나면 마스크 한 번으로 쓴다. 그 사이 같은 핀에 온 명령은 마지막 값만 남는다
+ *   (LED:ON/LED:OFF 연타, 같은 SEG7 숫자 반복). 응답은 지금처럼 바로 보낸다
+ * - 시퀀서, 타이머, 음악 모드의 쓰기는 시각이 중요하므로 모으지 않는다
+ * - 모든 함수는 이벤트 루프 스레드에서만 호출할 것
+ */
+
+#define COALESCE_MAX_MS 1000
+
+int coalesce_init(unsigned window_ms);  // 0이면 끔. timerfd 생성 후 이벤트 루프에 등록
+unsigned coalesce_window(void);
+void coalesce_begin(void);              // 명령 실행 전후로 호출
+void coalesce_end(void);
+
+#endif
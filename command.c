@@ -0,0 +1,112 @@
+/**
+ * command.c - 명령 레지스트리와 O(1) 디스패처
+ *
+ * 디바이스 모듈이 자기 명령 테이블을 등록하면, 텍스트 verb는 충돌 없는
+ * 해시(완전 해시) 테이블로, 바이너리 opcode는 배열 인덱스로 바로 찾는다.
+ * 등록은 시작 시에만 일어나므로 등록할 때마다 해시 테이블을 다시 만든다.
+ */
+#include "command.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define MAX_OPCODES 256      // 바이너리 헤더 opcode가 1바이트
+#define MAX_SEED_TRIES 4096  // 테이블 크기별로 시도할 해시 시드 수
+
+struct slot {
+    const struct command_def *def;
+    size_t verb_len;
+};
+
+static const struct command_def **defs = NULL;
+static size_t num_defs = 0, defs_cap = 0;
+
+static struct slot *slots = NULL;
+static uint32_t slot_mask = 0;
+static uint32_t hash_seed = 0;
+
+static const struct command_def *by_opcode[MAX_OPCODES];
+
+// FNV-1a (시드 포함)
+static inline uint32_t verb_hash(const char *s, size_t len, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// 모든 verb가 서로 다른 슬롯에 들어가는 시드를 찾을 때까지 시도, 실패하면 테이블을 키운다
+static int rebuild_hash(void) {
+    uint32_t size = 8;
+    while (size < num_defs * 2) size <<= 1;
+    while (size <= (1u << 16)) {
+        struct slot *t = calloc(size, sizeof(*t));
+        if (!t) return -1;
+        for (uint32_t seed = 1; seed <= MAX_SEED_TRIES; seed++) {
+            size_t i;
+            for (i = 0; i < num_defs; i++) {
+                size_t len = strlen(defs[i]->verb);
+                uint32_t h = verb_hash(defs[i]->verb, len, seed) & (size - 1);
+                if (t[h].def) break;
+                t[h].def = defs[i];
+                t[h].verb_len = len;
+            }
+            if (i == num_defs) {
+                free(slots);
+                slots = t;
+                slot_mask = size - 1;
+                hash_seed = seed;
+                return 0;
+            }
+            memset(t, 0, size * sizeof(*t));
+        }
+        free(t);
+        size <<= 1;
+    }
+    return -1;
+}
+
+int command_register(const struct command_def *table, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const struct command_def *d = &table[i];
+        if (d->opcode <= OP_NONE || d->opcode >= MAX_OPCODES || by_opcode[d->opcode]) return -1;
+        if (command_lookup(d->verb, strlen(d->verb))) return -1;
+        if (num_defs == defs_cap) {
+            size_t cap = defs_cap ? defs_cap * 2 : 32;
+            const struct command_def **p = realloc(defs, cap * sizeof(*p));
+            if (!p) return -1;
+            defs = p;
+            defs_cap = cap;
+        }
+        defs[num_defs++] = d;
+        by_opcode[d->opcode] = d;
+    }
+    return rebuild_hash();
+}
+
+const struct command_def *command_lookup(const char *verb, size_t len) {
+    if (!slots) return NULL;
+    const struct slot *s = &slots[verb_hash(verb, len, hash_seed) & slot_mask];
+    if (s->def && s->verb_len == len && memcmp(s->def->verb, verb, len) == 0) return s->def;
+    return NULL;
+}
+
+const struct command_def *command_by_opcode(int opcode) {
+    if (opcode <= OP_NONE || opcode >= MAX_OPCODES) return NULL;
+    return by_opcode[opcode];
+}
+
+void command_dispatch(const struct request *req, struct reply *rep) {
+    const struct command_def *d = command_by_opcode(req->opcode);
+    if (!d || !d->handler) {
+        reply_error(rep, ST_UNKNOWN_COMMAND);
+        return;
+    }
+    d->handler(req, rep);
+}
+
+size_t command_count(void) {
+    return num_defs;
+}
@@ -0,0 +1,23 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stddef.h>
+#include "protocol.h"
+
+typedef void (*command_handler)(const struct request *req, struct reply *rep);
+
+// 디바이스 모듈이 등록하는 명령 정의
+struct command_def {
+    const char *verb;       // 텍스트 명령, 예: "LED:BRIGHT"
+    int opcode;             // 바이너리 opcode (protocol.h)
+    int device;             // enum proto_device
+    command_handler handler;
+};
+
+int command_register(const struct command_def *defs, size_t count); // 중복 verb/opcode면 -1
+const struct command_def *command_lookup(const char *verb, size_t len);
+const struct command_def *command_by_opcode(int opcode);
+void command_dispatch(const struct request *req, struct reply *rep);
+size_t command_count(void);
+
+#endif
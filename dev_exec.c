@@ -0,0 +1,362 @@
+/**
+ * dev_exec.c - 디바이스별 명령 실행기
+ *
+ * 큐는 침입형 MPSC 연결 리스트(Vyukov)다. 넣는 쪽은 head를 교환하고 이전 노드의 next를 잇는다.
+ * 꺼내는 쪽은 그 큐의 소비자 하나뿐이라 tail은 락 없이 만진다. 교환과 잇기 사이에 꺼내려 하면
+ * 잠깐 비어 보이므로, 소비자는 그때 양보하고 다시 본다.
+ * 소비자는 큐가 비면 idle을 1로 두고 한 번 더 확인한 뒤 eventfd에서 잔다. 넣는 쪽은 idle을 0으로
+ * 바꾼 쪽만 eventfd를 쓴다. 경합하면 토큰이 하나 남아 다음에 한 번 헛깨어날 뿐이다.
+ * 완료 알림도 같은 큐로 이벤트 루프 스레드에 넘긴다 (소비자 = 이벤트 루프, eventfd는 epoll에 등록).
+ */
+#define _GNU_SOURCE
+#include "dev_exec.h"
+#include "event_loop.h"
+#include "plugin.h"
+#include "command.h"
+#include "gpio_hal.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+
+struct job_queue {
+    struct dev_job *head;       // 넣는 쪽이 교환하는 끝
+    struct dev_job *tail;       // 소비자만 만진다
+    struct dev_job stub;
+    int idle;                   // 소비자가 자려는 중
+    int efd;
+};
+
+struct executor {
+    struct job_queue q;
+    int running;
+    uint64_t submitted;         // 넣는 쪽이 원자적으로 더한다
+    uint64_t executed;          // 실행 스레드만 쓴다
+    int posted;                 // 끝나지 않은 dev_exec_post 작업 수 (이벤트 루프 스레드만)
+};
+
+static const char *const names[DEV_MAX] = {
+    [DEV_LED] = "led",
+    [DEV_BUZZER] = "buzzer",
+    [DEV_SEG7] = "seg7",
+    [DEV_SENSOR] = "sensor",
+    [DEV_BUTTON] = "button",
+};
+
+static struct executor execs[DEV_MAX];
+static struct job_queue done_q;
+static int started = 0;
+static void (*batch_fn)(void) = NULL;
+static __thread int current_device = DEV_NONE;  // 실행 스레드라면 그 디바이스
+static struct dev_job *free_jobs = NULL;         // dev_exec_post용 (이벤트 루프 스레드만)
+
+// 일시 정지 관문: 실행기마다 관문 작업을 넣고, 모두 도착하면 호출한 쪽이 디바이스를 독점한다
+static pthread_mutex_t gate_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gate_cond = PTHREAD_COND_INITIALIZER;
+static int gate_parked = 0;
+static int gate_closed = 0;
+static struct dev_job gate_jobs[DEV_MAX];
+
+// ---- MPSC 큐 ----
+
+static int queue_init(struct job_queue *q, int idle, int efd_flags) {
+    memset(&q->stub, 0, sizeof(q->stub));
+    q->head = q->tail = &q->stub;
+    q->idle = idle;
+    q->efd = eventfd(0, EFD_CLOEXEC | efd_flags);
+    return q->efd < 0 ? -1 : 0;
+}
+
+static void queue_link(struct job_queue *q, struct dev_job *j) {
+    __atomic_store_n(&j->next, NULL, __ATOMIC_RELAXED);
+    struct dev_job *prev = __atomic_exchange_n(&q->head, j, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&prev->next, j, __ATOMIC_RELEASE);
+}
+
+static void queue_push(struct job_queue *q, struct dev_job *j) {
+    queue_link(q, j);
+    if (__atomic_exchange_n(&q->idle, 0, __ATOMIC_SEQ_CST)) {
+        uint64_t one = 1;
+        ssize_t n = write(q->efd, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+// 소비자 전용. 비었거나 넣는 중이면 NULL
+static struct dev_job *queue_pop(struct job_queue *q) {
+    struct dev_job *tail = q->tail;
+    struct dev_job *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (tail == &q->stub) {
+        if (!next) return NULL;
+        q->tail = tail = next;
+        next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    }
+    if (next) {
+        q->tail = next;
+        return tail;
+    }
+    if (tail != __atomic_load_n(&q->head, __ATOMIC_SEQ_CST)) return NULL;
+    // 마지막 노드를 꺼내려면 stub을 뒤에 다시 세운다
+    queue_link(q, &q->stub);
+    next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (next) {
+        q->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+// 소비자 전용
+static int queue_empty(struct job_queue *q) {
+    return q->tail == &q->stub && __atomic_load_n(&q->head, __ATOMIC_SEQ_CST) == &q->stub;
+}
+
+// 소비자 전용. 잘 차례면 1 (idle을 세운 뒤 다시 확인했는데도 비어 있음)
+static int queue_may_sleep(struct job_queue *q) {
+    if (!queue_empty(q)) {
+        sched_yield();      // 넣는 중인 노드가 이어지기를 기다린다
+        return 0;
+    }
+    __atomic_store_n(&q->idle, 1, __ATOMIC_SEQ_CST);
+    if (queue_empty(q)) return 1;
+    __atomic_store_n(&q->idle, 0, __ATOMIC_SEQ_CST);
+    return 0;
+}
+
+// ---- 실행 스레드 ----
+
+// 플러그인 버전을 잡은 채로 부른다
+static void job_finish(void *arg) {
+    struct dev_job *j = arg;
+    if (j->flags & DEV_JOB_COALESCE) gpio_coalesce_end();
+    if (j->finish) j->finish(j);
+}
+
+static void run_job(struct executor *ex, struct dev_job *j) {
+    // finish 뒤에는 (complete가 없으면) job이 재사용될 수 있으므로 필요한 값을 먼저 꺼내 둔다
+    int flags = j->flags;
+    int notify = j->complete || (flags & DEV_JOB_OWNED);
+    dev_job_fn finish = j->finish;
+    if (flags & DEV_JOB_COALESCE) gpio_coalesce_begin();
+    if (j->run) {
+        j->run(j);
+        __atomic_store_n(&ex->executed, ex->executed + 1, __ATOMIC_RELAXED);
+        if (flags & DEV_JOB_COALESCE) gpio_coalesce_end();
+        if (finish) finish(j);
+    } else {
+        int opcode = j->req.opcode;
+        uint64_t t0 = metrics_now();
+        plugin_execute(&j->req, &j->rep, job_finish, j);
+        metrics_record(METRIC_HIST_CMD(METRIC_EXEC, opcode), metrics_now() - t0);
+        __atomic_store_n(&ex->executed, ex->executed + 1, __ATOMIC_RELAXED);
+    }
+    if (notify) queue_push(&done_q, j);
+}
+
+static void *exec_thread(void *arg) {
+    struct executor *ex = arg;
+    int device = (int)(ex - execs);
+    char name[16];
+    snprintf(name, sizeof(name), "exec-%s", names[device] ? names[device] : "dev");
+    prctl(PR_SET_NAME, name, 0, 0, 0);
+    current_device = device;
+    for (;;) {
+        struct dev_job *j = queue_pop(&ex->q);
+        if (j) {
+            run_job(ex, j);
+            continue;
+        }
+        if (!queue_may_sleep(&ex->q)) continue;
+        uint64_t v;
+        ssize_t n = read(ex->q.efd, &v, sizeof(v));
+        (void)n;
+    }
+    return NULL;
+}
+
+// ---- 완료 (이벤트 루프 스레드) ----
+
+static void on_done(int fd, uint32_t events, void *arg) {
+    (void)events;
+    (void)arg;
+    uint64_t v;
+    ssize_t n = read(fd, &v, sizeof(v));
+    (void)n;
+    for (;;) {
+        struct dev_job *j;
+        while ((j = queue_pop(&done_q)) != NULL) {
+            if (j->complete) j->complete(j);
+            if (j->flags & DEV_JOB_OWNED) {
+                execs[j->req.device].posted--;
+                j->next = free_jobs;
+                free_jobs = j;
+            }
+        }
+        if (queue_may_sleep(&done_q)) break;
+    }
+    if (batch_fn) batch_fn();
+}
+
+int dev_exec_start(void (*batch_done)(void)) {
+    int want[DEV_MAX] = {0};
+    for (int op = OP_NONE + 1; op < OP_MAX; op++) {
+        int d = plugin_device(op);
+        if (d > DEV_NONE && d < DEV_MAX) want[d] = 1;
+    }
+    if (queue_init(&done_q, 1, EFD_NONBLOCK) < 0) return -1;
+    if (event_loop_add(done_q.efd, EPOLLIN, on_done, NULL) < 0) {
+        close(done_q.efd);
+        return -1;
+    }
+    batch_fn = batch_done;
+    for (int d = 0; d < DEV_MAX; d++) {
+        if (!want[d]) continue;
+        struct executor *ex = &execs[d];
+        if (queue_init(&ex->q, 0, 0) < 0) return -1;
+        pthread_t t;
+        if (pthread_create(&t, NULL, exec_thread, ex) != 0) return -1;
+        pthread_detach(t);
+        ex->running = 1;
+    }
+    started = 1;
+    return 0;
+}
+
+int dev_exec_device(int opcode) {
+    if (!started) return -1;
+    int d = plugin_device(opcode);
+    return d > DEV_NONE && d < DEV_MAX && execs[d].running ? d : -1;
+}
+
+int dev_exec_submit(int device, struct dev_job *job) {
+    if (!started || device <= DEV_NONE || device >= DEV_MAX || !execs[device].running) return -1;
+    struct executor *ex = &execs[device];
+    __atomic_add_fetch(&ex->submitted, 1, __ATOMIC_RELAXED);
+    queue_push(&ex->q, job);
+    return 0;
+}
+
+int dev_exec_post(const struct request *req, dev_job_fn complete, void *ctx) {
+    int device = dev_exec_device(req->opcode);
+    if (device < 0) return -1;
+    // 실행기가 따라오지 못하면 여기서 막는다 (밀린 작업 수만큼 메모리가 늘지 않도록)
+    if (execs[device].posted >= DEV_EXEC_POST_MAX) return ST_BUSY;
+    struct dev_job *j = free_jobs;
+    if (j) free_jobs = j->next;
+    else if (!(j = malloc(sizeof(*j)))) return -1;
+    memset(j, 0, sizeof(*j));
+    j->req = *req;
+    j->req.conn = NULL;
+    // 플러그인 명령은 숫자 인자만 쓴다 (text는 넣은 쪽 버퍼를 가리키므로 넘기지 않음)
+    j->req.text = NULL;
+    j->req.text_len = 0;
+    j->req.device = device;
+    j->flags = DEV_JOB_OWNED;
+    j->complete = complete;
+    j->ctx = ctx;
+    execs[device].posted++;
+    return dev_exec_submit(device, j);
+}
+
+// ---- 동기 호출 ----
+
+struct call_wait {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int done;
+};
+
+static void call_finish(struct dev_job *j) {
+    struct call_wait *w = j->ctx;
+    pthread_mutex_lock(&w->mutex);
+    w->done = 1;
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->mutex);
+}
+
+void dev_exec_call(int opcode, const int32_t *args, int nargs, struct reply *rep) {
+    int device = dev_exec_device(opcode);
+    // 실행기가 없거나 같은 디바이스의 실행 스레드 안이면 바로 실행 (스스로를 기다리지 않도록)
+    if (device < 0 || device == current_device) {
+        plugin_call(opcode, args, nargs, rep);
+        return;
+    }
+    struct call_wait w = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0};
+    struct dev_job j;
+    memset(&j, 0, sizeof(j));
+    j.req.opcode = opcode;
+    j.req.device = device;
+    for (int i = 0; i < nargs && i < PROTO_MAX_ARGS; i++) j.req.args[j.req.nargs++] = args[i];
+    j.finish = call_finish;
+    j.ctx = &w;
+    dev_exec_submit(device, &j);
+    pthread_mutex_lock(&w.mutex);
+    while (!w.done) pthread_cond_wait(&w.cond, &w.mutex);
+    pthread_mutex_unlock(&w.mutex);
+    *rep = j.rep;
+}
+
+// ---- 일시 정지 ----
+
+static void gate_run(struct dev_job *j) {
+    (void)j;
+    pthread_mutex_lock(&gate_mutex);
+    gate_parked++;
+    pthread_cond_broadcast(&gate_cond);
+    while (gate_closed) pthread_cond_wait(&gate_cond, &gate_mutex);
+    gate_parked--;
+    pthread_cond_broadcast(&gate_cond);
+    pthread_mutex_unlock(&gate_mutex);
+}
+
+void dev_exec_pause(void) {
+    if (!started) return;
+    int n = 0;
+    pthread_mutex_lock(&gate_mutex);
+    if (gate_closed) {
+        pthread_mutex_unlock(&gate_mutex);
+        return;
+    }
+    gate_closed = 1;
+    pthread_mutex_unlock(&gate_mutex);
+    for (int d = 0; d < DEV_MAX; d++) {
+        if (!execs[d].running) continue;
+        memset(&gate_jobs[d], 0, sizeof(gate_jobs[d]));
+        gate_jobs[d].run = gate_run;
+        dev_exec_submit(d, &gate_jobs[d]);
+        n++;
+    }
+    pthread_mutex_lock(&gate_mutex);
+    while (gate_parked < n) pthread_cond_wait(&gate_cond, &gate_mutex);
+    pthread_mutex_unlock(&gate_mutex);
+}
+
+// 실행기가 모두 관문을 떠난 뒤 돌아온다 (관문 작업을 바로 다시 쓸 수 있도록)
+void dev_exec_resume(void) {
+    if (!started) return;
+    pthread_mutex_lock(&gate_mutex);
+    gate_closed = 0;
+    pthread_cond_broadcast(&gate_cond);
+    while (gate_parked > 0) pthread_cond_wait(&gate_cond, &gate_mutex);
+    pthread_mutex_unlock(&gate_mutex);
+}
+
+// ---- 조회 ----
+
+int dev_exec_get_stats(int device, struct dev_exec_stats *s) {
+    if (!started || device <= DEV_NONE || device >= DEV_MAX || !execs[device].running) return -1;
+    s->executed = __atomic_load_n(&execs[device].executed, __ATOMIC_RELAXED);
+    s->submitted = __atomic_load_n(&execs[device].submitted, __ATOMIC_RELAXED);
+    if (s->submitted < s->executed) s->submitted = s->executed;
+    return 0;
+}
+
+const char *dev_exec_name(int device) {
+    return device > DEV_NONE && device < DEV_MAX && names[device] ? names[device] : "none";
+}
@@ -0,0 +1,59 @@
+#ifndef DEV_EXEC_H
+#define DEV_EXEC_H
+
+#include <stdint.h>
+#include "protocol.h"
+
+/*
+ * 디바이스별 명령 실행기
+ * - 플러그인 디바이스(LED, 부저, 7-Segment, 조도센서)마다 실행 스레드와 큐가 하나씩 있다.
+ *   같은 디바이스의 명령은 넣은 순서대로 하나씩 실행되고, 다른 디바이스의 명령은 동시에 실행된다
+ * - 넣는 쪽은 락이 없다 (원자적 교환 두 번, 실행 스레드가 자고 있을 때만 eventfd 쓰기 한 번)
+ * - 응답 문자열이 플러그인 안을 가리키므로 응답 인코딩은 finish에서 한다 (그 버전이 살아 있는 동안)
+ * - complete는 이벤트 루프 스레드에서 부른다. 한 번 깨어날 때 모인 완료를 모두 부른 뒤 batch_done을 부른다
+ * - 밀린 작업끼리 합치지 않는다 (작업마다 응답이 따로 있음). 같은 핀의 최신 값만 쓰는 일은 DEV_JOB_COALESCE로 HAL이 한다
+ * - dev_exec_post로 넣은 작업은 디바이스마다 DEV_EXEC_POST_MAX개까지만 밀릴 수 있다. 넘치면 ST_BUSY
+ *   (클라이언트 작업은 연결마다 개수가 제한되고, dev_exec_call은 끝날 때까지 기다리므로 따로 세지 않음)
+ */
+
+#define DEV_EXEC_POST_MAX 256       // 디바이스마다 끝나지 않은 dev_exec_post 작업 최대 수
+
+#define DEV_JOB_COALESCE 0x1        // 실행 중 쓴 출력을 모은다 (gpio_coalesce_begin/end)
+#define DEV_JOB_OWNED 0x2           // 내부용: dev_exec_post가 할당한 작업
+
+struct dev_job;
+typedef void (*dev_job_fn)(struct dev_job *job);
+
+struct dev_job {
+    struct request req;
+    struct reply rep;
+    int flags;
+    dev_job_fn run;             // 실행 스레드: NULL이면 req를 플러그인 핸들러로 실행
+    dev_job_fn finish;          // 실행 스레드: 실행 직후 (complete가 없으면 이 뒤로 job을 만지지 않음)
+    dev_job_fn complete;        // 이벤트 루프 스레드: 실행이 끝난 뒤 (NULL이면 알리지 않음)
+    void *ctx;
+    struct dev_job *next;       // 내부용 (큐 링크)
+};
+
+struct dev_exec_stats {
+    uint64_t submitted;
+    uint64_t executed;
+};
+
+int dev_exec_start(void (*batch_done)(void));   // 실행 스레드 시작, 완료 eventfd를 이벤트 루프에 등록
+int dev_exec_device(int opcode);                // 실행기로 보낼 명령이면 디바이스 번호, 아니면 -1
+int dev_exec_submit(int device, struct dev_job *job);  // 락 없음. 실행기가 없으면 -1 (job은 끝날 때까지 살아 있어야 함)
+// 이벤트 루프 스레드 전용, job은 실행기가 할당/회수. 넣었으면 0, 실행기 명령이 아니면 -1 (직접 실행할 것),
+// 그 디바이스에 끝나지 않은 작업이 DEV_EXEC_POST_MAX개면 ST_BUSY
+int dev_exec_post(const struct request *req, dev_job_fn complete, void *ctx);
+void dev_exec_call(int opcode, const int32_t *args, int nargs, struct reply *rep); // plugin_call과 같되 디바이스 순서대로 (끝날 때까지 대기)
+
+// 모든 실행기가 앞서 넣은 작업을 끝내고 멈출 때까지 기다린다. resume 전까지 새 작업은 실행되지 않는다
+// (여러 디바이스를 한 번에 바꾸는 ALL_OFF, 종료 정리용. 실행 스레드에서 부르면 안 됨)
+void dev_exec_pause(void);
+void dev_exec_resume(void);
+
+int dev_exec_get_stats(int device, struct dev_exec_stats *s);   // 실행기가 없으면 -1
+const char *dev_exec_name(int device);
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * device_state.c - 디바이스 상태 기록과 공유 메모리 게시 (seqlock 쓰기 쪽)
+ *
+ * 쓰는 스레드가 여럿이므로(이벤트 루프, 부저 재생 스레드, 음악 모드 스레드)
+ * 쓰기끼리는 뮤텍스로 줄 세우고, 읽는 쪽은 seq만 보고 락 없이 복사한다.
+ * 게시 전에는 프로세스 안의 정적 구조체에 기록하다가, 게시할 때 그 내용을 복사하고 포인터를 바꾼다.
+ */
+#include "device_state.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+
+static struct device_state local_state = {
+    .magic = DEVICE_STATE_MAGIC,
+    .version = DEVICE_STATE_VERSION,
+    .seg7_digit = -1,
+    .sensor_value = -1,
+};
+static struct device_state *state = &local_state;
+static pthread_mutex_t state_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char shm_name[64];
+static void (*state_hook)(const struct device_state *st) = NULL;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+struct device_state *device_state_begin(void) {
+    pthread_mutex_lock(&state_mutex);
+    __atomic_store_n(&state->seq, state->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);   // seq(홀수)가 본문 변경보다 먼저 보이도록
+    return state;
+}
+
+void device_state_end(void) {
+    state->updated_ns = now_ns();
+    __atomic_store_n(&state->seq, state->seq + 1, __ATOMIC_RELEASE);
+    void (*hook)(const struct device_state *) = __atomic_load_n(&state_hook, __ATOMIC_ACQUIRE);
+    if (hook) hook(state);
+    pthread_mutex_unlock(&state_mutex);
+}
+
+void device_state_set_hook(void (*fn)(const struct device_state *st)) {
+    __atomic_store_n(&state_hook, fn, __ATOMIC_RELEASE);
+}
+
+int device_state_publish(const char *name) {
+    if (!name) name = DEVICE_STATE_SHM;
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    if (ftruncate(fd, sizeof(struct device_state)) < 0) {
+        close(fd);
+        shm_unlink(name);
+        return -1;
+    }
+    void *p = mmap(NULL, sizeof(struct device_state), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        shm_unlink(name);
+        return -1;
+    }
+    pthread_mutex_lock(&state_mutex);
+    struct device_state *shared = p;
+    *shared = *state;
+    shared->seq = 0;
+    shared->pid = getpid();
+    shared->started_ns = now_ns();
+    state = shared;
+    strncpy(shm_name, name, sizeof(shm_name) - 1);
+    pthread_mutex_unlock(&state_mutex);
+    return 0;
+}
+
+void device_state_unpublish(void) {
+    pthread_mutex_lock(&state_mutex);
+    if (state != &local_state) {
+        local_state = *state;
+        munmap(state, sizeof(struct device_state));
+        state = &local_state;
+        shm_unlink(shm_name);
+    }
+    pthread_mutex_unlock(&state_mutex);
+}
@@ -0,0 +1,49 @@
+#ifndef DEVICE_STATE_H
+#define DEVICE_STATE_H
+
+#include <stdint.h>
+
+/*
+ * 데몬이 관리하는 디바이스 상태 (단일 원본)
+ * - 디바이스 모듈이 하드웨어에 쓸 때마다 여기에 기록한다
+ * - device_state_publish() 후에는 POSIX 공유 메모리에 그대로 놓여,
+ *   같은 Pi의 다른 프로세스가 소켓 없이 읽을 수 있다 (state_reader.h)
+ * - seqlock: 쓰는 동안 seq가 홀수, 읽는 쪽은 읽기 전후 seq가 같고 짝수일 때만 스냅샷을 인정
+ */
+
+#define DEVICE_STATE_SHM "/gpio_daemon_state"
+#define DEVICE_STATE_MAGIC 0x54535047u   // "GPST"
+#define DEVICE_STATE_VERSION 1
+
+struct device_state {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seq;            // seqlock 순번
+    int32_t pid;             // 데몬 PID
+    uint64_t started_ns;     // 데몬 시작 시각 (CLOCK_MONOTONIC)
+    uint64_t updated_ns;     // 마지막 갱신 시각
+
+    int32_t led_on;          // 0/1
+    int32_t led_pwm;         // 밝기 PWM 값 (0이면 디지털 ON/OFF)
+    int32_t buzzer_on;       // 디지털 ON 상태
+    int32_t buzzer_freq;     // 현재 톤 주파수 (0이면 무음)
+    int32_t buzzer_song;     // 재생 중인 곡 (0이면 정지)
+    int32_t buzzer_note;     // 재생 중인 음 번호
+    int32_t seg7_digit;      // 표시 중인 숫자 (-1이면 꺼짐)
+    int32_t sensor_value;    // 마지막으로 읽은 조도센서 값 (-1이면 아직 없음)
+    uint64_t sensor_ns;      // 그 시각
+    uint64_t button_presses; // 디바운스 후 버튼 눌림 수
+    uint64_t button_ns;      // 마지막 눌림 시각
+    int32_t clients;         // 접속 중인 클라이언트 수
+    int32_t music_mode;      // EXTRA_MUSIC_MODE 진행 중
+};
+
+// 쓰기 (데몬 안의 모든 스레드에서 호출 가능, begin/end 사이는 짧게)
+struct device_state *device_state_begin(void);
+void device_state_end(void);
+// device_state_end마다 쓰기 락 안에서 호출할 함수 (저널 기록용, NULL이면 해제)
+void device_state_set_hook(void (*fn)(const struct device_state *st));
+int device_state_publish(const char *name);   // 공유 메모리 생성 후 이후 갱신을 그곳에 기록 (NULL이면 기본 이름)
+void device_state_unpublish(void);
+
+#endif
@@ -0,0 +1,112 @@
+/**
+ * event_loop.c - epoll 기반 단일 스레드 이벤트 루프(reactor)
+ *
+ * 모든 소켓 I/O는 루프 스레드 하나에서 처리한다.
+ * 다른 스레드에서 루프로 넘길 일은 각 모듈이 자기 eventfd로 깨운다.
+ */
+#include "event_loop.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#define MAX_EVENTS 256
+
+struct handler {
+    event_cb cb;
+    void *arg;
+    uint32_t gen;   // fd 재사용 시 이전 이벤트를 걸러내기 위한 세대 번호
+};
+
+static int epfd = -1;
+static int wake_fd = -1;
+static volatile int running = 0;
+
+// fd 번호로 바로 찾는 핸들러 테이블
+static struct handler *handlers = NULL;
+static int handlers_cap = 0;
+
+static int ensure_capacity(int fd) {
+    if (fd < handlers_cap) return 0;
+    int cap = handlers_cap ? handlers_cap : 64;
+    while (cap <= fd) cap *= 2;
+    struct handler *h = realloc(handlers, cap * sizeof(*h));
+    if (!h) return -1;
+    memset(h + handlers_cap, 0, (cap - handlers_cap) * sizeof(*h));
+    handlers = h;
+    handlers_cap = cap;
+    return 0;
+}
+
+// event_loop_stop이 epoll_wait를 깨운 것: 비우기만 하고 루프 조건에서 빠져나간다
+static void on_wake(int fd, uint32_t events, void *arg) {
+    (void)events; (void)arg;
+    uint64_t n;
+    while (read(fd, &n, sizeof(n)) > 0) { }
+}
+
+int event_loop_init(void) {
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) return -1;
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd < 0) return -1;
+    return event_loop_add(wake_fd, EPOLLIN, on_wake, NULL);
+}
+
+int event_loop_add(int fd, uint32_t events, event_cb cb, void *arg) {
+    if (ensure_capacity(fd) < 0) return -1;
+    struct handler *h = &handlers[fd];
+    h->cb = cb;
+    h->arg = arg;
+    h->gen++;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.u64 = (uint64_t)h->gen << 32 | (uint32_t)fd;
+    return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+int event_loop_mod(int fd, uint32_t events) {
+    if (fd >= handlers_cap) return -1;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.u64 = (uint64_t)handlers[fd].gen << 32 | (uint32_t)fd;
+    return epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+int event_loop_del(int fd) {
+    if (fd >= handlers_cap) return -1;
+    handlers[fd].cb = NULL;
+    handlers[fd].gen++;
+    return epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+void event_loop_run(void) {
+    struct epoll_event events[MAX_EVENTS];
+    running = 1;
+    while (running) {
+        int n = epoll_wait(epfd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            int fd = (int)(uint32_t)events[i].data.u64;
+            uint32_t gen = (uint32_t)(events[i].data.u64 >> 32);
+            // 같은 배치에서 이미 닫힌 fd의 이벤트는 무시
+            if (fd >= handlers_cap || handlers[fd].gen != gen || !handlers[fd].cb) continue;
+            handlers[fd].cb(fd, events[i].events, handlers[fd].arg);
+        }
+    }
+}
+
+void event_loop_stop(void) {
+    running = 0;
+    if (wake_fd >= 0) {
+        uint64_t one = 1;
+        if (write(wake_fd, &one, sizeof(one)) < 0) { }
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdint.h>
+
+// fd 이벤트 콜백: events는 EPOLLIN/EPOLLOUT/EPOLLERR 등 epoll 플래그
+typedef void (*event_cb)(int fd, uint32_t events, void *arg);
+
+int event_loop_init(void);
+int event_loop_add(int fd, uint32_t events, event_cb cb, void *arg);
+int event_loop_mod(int fd, uint32_t events);
+int event_loop_del(int fd);
+void event_loop_run(void);
+void event_loop_stop(void);                 // event_loop_run을 끝낸다 (루프 스레드에서)
+
+#endif
@@ -0,0 +1,34 @@
+/**
+ * event_queue.c - 클라이언트별 유한 알림 대기열
+ *
+ * 느린 클라이언트 때문에 메모리가 무한히 늘지 않도록 크기를 고정하고,
+ * 넘치면 정책에 따라 버리거나 합친다. 버린 개수는 다음 전송 때 알린다.
+ */
+#include "event_queue.h"
+
+void event_queue_push(struct event_queue *q, const struct pin_event *ev, int policy) {
+    if (policy == EVQ_COALESCE) {
+        for (unsigned i = 0; i < q->len; i++) {
+            struct pin_event *e = &q->ev[(q->head + i) % EVENT_QUEUE_SIZE];
+            if (e->device == ev->device && e->pin == ev->pin) {
+                *e = *ev;
+                return;
+            }
+        }
+    }
+    if (q->len == EVENT_QUEUE_SIZE) {
+        q->head = (q->head + 1) % EVENT_QUEUE_SIZE;
+        q->len--;
+        q->dropped++;
+    }
+    q->ev[(q->head + q->len) % EVENT_QUEUE_SIZE] = *ev;
+    q->len++;
+}
+
+int event_queue_pop(struct event_queue *q, struct pin_event *ev) {
+    if (q->len == 0) return 0;
+    *ev = q->ev[q->head];
+    q->head = (q->head + 1) % EVENT_QUEUE_SIZE;
+    q->len--;
+    return 1;
+}
@@ -0,0 +1,28 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include "pin_events.h"
+
+// 클라이언트별 알림 대기열 (전송 버퍼에 자리가 없을 때 쌓아 두는 곳)
+#define EVENT_QUEUE_SIZE 32
+
+// 대기열이 찼을 때의 정책
+enum event_policy {
+    EVQ_DROP_OLDEST,   // 가장 오래된 이벤트를 버리고 새 이벤트 추가 (버튼 엣지 등 개별 사건)
+    EVQ_COALESCE       // 같은 디바이스/핀의 대기 이벤트를 최신 값으로 덮어씀 (레벨/측정값)
+};
+
+struct event_queue {
+    struct pin_event ev[EVENT_QUEUE_SIZE];
+    unsigned head, len;
+    unsigned long dropped;   // 아직 클라이언트에 알리지 않은 버린 개수
+};
+
+void event_queue_push(struct event_queue *q, const struct pin_event *ev, int policy);
+int event_queue_pop(struct event_queue *q, struct pin_event *ev); // 비었으면 0
+
+static inline int event_queue_empty(const struct event_queue *q) {
+    return q->len == 0 && q->dropped == 0;
+}
+
+#endif
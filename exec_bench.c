@@ -0,0 +1,210 @@
+/**
+ * exec_bench.c - 디바이스 실행기 경합 벤치마크 (시뮬레이션 백엔드)
+ *
+ * 여러 스레드가 동시에 디바이스 명령을 낼 때, 전역 락 하나로 직렬화하는 방식과
+ * 디바이스별 실행기(dev_exec)에 넘기는 방식을 같은 명령열로 비교한다.
+ * - across: 스레드 i는 디바이스 i % 4 (LED, 7-Segment, 부저, 조도센서)에만 명령
+ * - same:   모든 스레드가 LED에만 명령 (같은 디바이스는 어느 방식이든 직렬)
+ * - mutex:  전역 뮤텍스 안에서 command_dispatch (디바이스 구분 없는 잠금)
+ * - exec:   실행기에 넣고 끝날 때까지 대기 (dev_exec_call과 같은 왕복)
+ * - exec/8: 스레드마다 8개까지 넣어 두고 먼저 넣은 것부터 회수
+ * 시뮬레이션 백엔드의 핀 쓰기는 메모리 쓰기라 거의 공짜이므로, -u로 명령마다
+ * 실제 장치 I/O를 흉내 낸 바쁜 대기를 더한다 (락/실행기 안에서). -s를 주면 바쁜 대기 대신
+ * 잠들어 I2C/ADC처럼 기다리는 장치를 흉내 낸다 (코어가 하나뿐이어도 디바이스끼리 겹칠 수 있음).
+ *
+ * 사용법: ./exec_bench [-t 스레드] [-n 스레드당 명령 수] [-u 명령당 장치 작업 us] [-s]
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <pthread.h>
+#include "protocol.h"
+#include "command.h"
+#include "gpio_hal.h"
+#include "plugin.h"
+#include "event_loop.h"
+#include "dev_exec.h"
+
+#define DEFAULT_THREADS 4
+#define DEFAULT_COMMANDS 50000
+#define DEFAULT_WORK_US 2
+#define PIPE_DEPTH 8
+
+enum { MODE_MUTEX, MODE_EXEC, MODE_PIPE };
+static const char *const mode_names[] = {"mutex", "exec", "exec/8"};
+
+// 스레드가 번갈아 내는 명령 (디바이스마다 두 개)
+static const char *const device_cmds[4][2] = {
+    {"LED:ON", "LED:OFF"},
+    {"SEG7:3", "SEG7:8"},
+    {"BUZZER:ON", "BUZZER:OFF"},
+    {"SENSOR:27", "SENSOR:27"},
+};
+
+static pthread_mutex_t global_mutex = PTHREAD_MUTEX_INITIALIZER;
+static long commands = DEFAULT_COMMANDS;
+static long work_ns = DEFAULT_WORK_US * 1000;
+static int work_sleep = 0;
+static volatile int go = 0;
+
+struct slot {
+    struct dev_job job;
+    uint64_t t0;
+    int done;
+};
+
+struct worker {
+    pthread_t tid;
+    int mode;
+    int dev;                    // device_cmds 인덱스
+    struct request reqs[2];
+    uint64_t *lat;              // 명령마다 지연 (ns)
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void device_work(void) {
+    if (work_ns <= 0) return;
+    if (work_sleep) {
+        struct timespec ts = {work_ns / 1000000000, work_ns % 1000000000};
+        nanosleep(&ts, NULL);
+        return;
+    }
+    uint64_t end = now_ns() + work_ns;
+    while (now_ns() < end) {}
+}
+
+// 실행 스레드: 플러그인 핸들러 + 장치 작업
+static void job_run(struct dev_job *j) {
+    memset(&j->rep, 0, sizeof(j->rep));
+    command_dispatch(&j->req, &j->rep);
+    device_work();
+}
+
+static void job_finish(struct dev_job *j) {
+    struct slot *s = j->ctx;
+    s->t0 = now_ns() - s->t0;   // 지연으로 바꿔 둔다
+    __atomic_store_n(&s->done, 1, __ATOMIC_RELEASE);
+}
+
+static void wait_slot(struct slot *s) {
+    while (!__atomic_load_n(&s->done, __ATOMIC_ACQUIRE)) sched_yield();
+}
+
+static void *worker_main(void *arg) {
+    struct worker *w = arg;
+    while (!__atomic_load_n(&go, __ATOMIC_ACQUIRE)) sched_yield();
+    if (w->mode == MODE_MUTEX) {
+        for (long i = 0; i < commands; i++) {
+            struct reply rep;
+            uint64_t t0 = now_ns();
+            pthread_mutex_lock(&global_mutex);
+            memset(&rep, 0, sizeof(rep));
+            command_dispatch(&w->reqs[i & 1], &rep);
+            device_work();
+            pthread_mutex_unlock(&global_mutex);
+            w->lat[i] = now_ns() - t0;
+        }
+        return NULL;
+    }
+    int depth = w->mode == MODE_PIPE ? PIPE_DEPTH : 1;
+    struct slot slots[PIPE_DEPTH];
+    int device = w->reqs[0].device;
+    for (long i = 0; i < commands + depth; i++) {
+        struct slot *s = &slots[i % depth];
+        if (i >= depth) {
+            wait_slot(s);
+            w->lat[i - depth] = s->t0;
+        }
+        if (i >= commands) continue;
+        memset(&s->job, 0, sizeof(s->job));
+        s->job.req = w->reqs[i & 1];
+        s->job.run = job_run;
+        s->job.finish = job_finish;
+        s->job.ctx = s;
+        s->done = 0;
+        s->t0 = now_ns();
+        dev_exec_submit(device, &s->job);
+    }
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void run(const char *scenario, int same, int mode, int threads) {
+    struct worker *ws = calloc(threads, sizeof(*ws));
+    uint64_t *all = malloc(sizeof(uint64_t) * commands * threads);
+    if (!ws || !all) {
+        fprintf(stderr, "메모리 부족\n");
+        exit(1);
+    }
+    go = 0;
+    for (int i = 0; i < threads; i++) {
+        struct worker *w = &ws[i];
+        w->mode = mode;
+        w->dev = same ? 0 : i % 4;
+        w->lat = all + (size_t)i * commands;
+        for (int k = 0; k < 2; k++) {
+            if (proto_parse_text(device_cmds[w->dev][k], &w->reqs[k]) != ST_OK) {
+                fprintf(stderr, "명령 파싱 실패: %s\n", device_cmds[w->dev][k]);
+                exit(1);
+            }
+        }
+        pthread_create(&w->tid, NULL, worker_main, w);
+    }
+    uint64_t t0 = now_ns();
+    __atomic_store_n(&go, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < threads; i++) pthread_join(ws[i].tid, NULL);
+    double sec = (now_ns() - t0) / 1e9;
+    size_t total = (size_t)commands * threads;
+    qsort(all, total, sizeof(uint64_t), cmp_u64);
+    printf("%-8s %-8s %12.1f %10.2f %10.2f\n", scenario, mode_names[mode], total / sec / 1000.0,
+           all[total / 2] / 1000.0, all[total * 99 / 100] / 1000.0);
+    free(all);
+    free(ws);
+}
+
+int main(int argc, char *argv[]) {
+    int threads = DEFAULT_THREADS;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:n:u:s")) != -1) {
+        switch (opt) {
+            case 't': threads = atoi(optarg); break;
+            case 'n': commands = atol(optarg); break;
+            case 'u': work_ns = atol(optarg) * 1000; break;
+            case 's': work_sleep = 1; break;
+            default:
+                fprintf(stderr, "사용법: %s [-t 스레드] [-n 스레드당 명령 수] [-u 명령당 장치 작업 us] [-s]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (threads < 1 || commands < 1) {
+        fprintf(stderr, "스레드와 명령 수는 1 이상\n");
+        return 1;
+    }
+
+    if (gpio_init("sim") < 0 || gpio_setup() < 0 || event_loop_init() < 0 ||
+        plugin_init(NULL) < 0 || plugin_register_commands() < 0 || dev_exec_start(NULL) < 0) {
+        fprintf(stderr, "초기화 실패\n");
+        return 1;
+    }
+
+    printf("스레드 %d, 스레드당 명령 %ld, 명령당 장치 작업 %ld us %s (시뮬레이션 백엔드)\n",
+           threads, commands, work_ns / 1000, work_sleep ? "대기" : "계산");
+    printf("%-8s %-8s %12s %10s %10s\n", "scenario", "mode", "kops/s", "p50 us", "p99 us");
+    for (int same = 0; same < 2; same++)
+        for (int mode = MODE_MUTEX; mode <= MODE_PIPE; mode++)
+            run(same ? "same" : "across", same, mode, threads);
+    return 0;
+}
@@ -0,0 +1,363 @@
+/**
+ * gpio_bench.c - 데몬 부하 생성기 / 종단간 지연시간 벤치마크
+ *
+ * N개 연결로 명령 묶음(LED, SEG7, SENSOR, TIMER)을 목표 속도로 open-loop 전송한다.
+ * 요청마다 "보냈어야 할 시각"을 기준으로 지연시간을 재므로, 서버가 밀려도 측정이 느슨해지지 않는다.
+ * -e를 주면 시뮬레이션 입력(SIM:INPUT)으로 버튼을 눌러 모든 연결에 EVENT:BUTTON이 도착하기까지를 잰다.
+ * 시뮬레이션 백엔드 데몬(gpio_server_daemon_sim)을 상대로 일반 리눅스에서 실행할 수 있다.
+ *
+ * 사용법: ./gpio_bench [-h 호스트] [-p 포트] [-c 연결 수] [-r 초당 요청] [-d 초]
+ *                      [-m led=40,seg7=30,sensor=25,timer=5] [-e 버튼 간격 ms] [-P p99 한도 us]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <time.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+#define DEFAULT_CONNS 16
+#define DEFAULT_RATE 10000
+#define DEFAULT_DURATION 5
+#define MAX_CONNS 1024
+#define IN_BUF 8192
+#define DRAIN_TIMEOUT_MS 3000       // 전송을 멈춘 뒤 남은 응답을 기다리는 시간
+#define BUTTON_PIN 21
+#define BUTTON_MIN_MS 250           // 데몬의 디바운스(200ms)보다 길어야 함
+
+enum op { OP_LED, OP_SEG7, OP_SENSOR, OP_TIMER, OP_BUTTON, NUM_OPS };
+static const char *const op_names[NUM_OPS] = {"led", "seg7", "sensor", "timer", "button"};
+
+// 가변 길이 배열 (지연시간 표본, 대기 중인 요청)
+struct samples {
+    uint64_t *v;
+    size_t len, cap;
+};
+
+struct pending {
+    uint64_t intended_ns;   // 보냈어야 할 시각
+    int op;
+};
+
+struct conn {
+    int fd;
+    char *out;              // 아직 보내지 못한 요청
+    size_t out_len, out_cap;
+    char in[IN_BUF];
+    size_t in_len;
+    struct pending *q;      // 응답을 기다리는 요청 (응답은 요청 순서대로 온다)
+    size_t q_head, q_len, q_cap;
+    int events_seen;        // 받은 버튼 알림 수
+};
+
+static struct conn conns[MAX_CONNS];
+static int nconns = DEFAULT_CONNS;
+static int epfd;
+static struct samples lat[NUM_OPS], lat_all, fanout;
+static unsigned long sent = 0, completed = 0, errors = 0;
+static uint64_t press_ns = 0;       // 마지막 버튼 누름(상승 엣지 요청)을 보낸 시각
+static int presses = 0;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void die(const char *msg) {
+    perror(msg);
+    exit(2);
+}
+
+static void samples_add(struct samples *s, uint64_t v) {
+    if (s->len == s->cap) {
+        s->cap = s->cap ? s->cap * 2 : 4096;
+        s->v = realloc(s->v, s->cap * sizeof(*s->v));
+        if (!s->v) die("realloc");
+    }
+    s->v[s->len++] = v;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint64_t percentile(const struct samples *s, double p) {
+    if (s->len == 0) return 0;
+    size_t idx = (size_t)(p * (s->len - 1) + 0.5);
+    return s->v[idx];
+}
+
+static void print_row(const char *name, struct samples *s) {
+    if (s->len == 0) return;
+    qsort(s->v, s->len, sizeof(*s->v), cmp_u64);
+    printf("%-8s %10zu %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, s->len,
+           percentile(s, 0.50) / 1e3, percentile(s, 0.90) / 1e3, percentile(s, 0.99) / 1e3,
+           percentile(s, 0.999) / 1e3, s->v[s->len - 1] / 1e3);
+}
+
+static void conn_push(struct conn *c, const char *line, uint64_t intended, int op) {
+    size_t n = strlen(line);
+    if (c->out_len + n > c->out_cap) {
+        c->out_cap = (c->out_len + n) * 2;
+        c->out = realloc(c->out, c->out_cap);
+        if (!c->out) die("realloc");
+    }
+    memcpy(c->out + c->out_len, line, n);
+    c->out_len += n;
+    if (c->q_len == c->q_cap) {
+        // 링을 늘리면서 순서를 펼친다
+        size_t cap = c->q_cap ? c->q_cap * 2 : 256;
+        struct pending *q = malloc(cap * sizeof(*q));
+        if (!q) die("malloc");
+        for (size_t i = 0; i < c->q_len; i++) q[i] = c->q[(c->q_head + i) % c->q_cap];
+        free(c->q);
+        c->q = q;
+        c->q_head = 0;
+        c->q_cap = cap;
+    }
+    c->q[(c->q_head + c->q_len) % c->q_cap] = (struct pending){intended, op};
+    c->q_len++;
+    sent++;
+}
+
+static void conn_flush(struct conn *c) {
+    while (c->out_len > 0) {
+        ssize_t n = write(c->fd, c->out, c->out_len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) break;
+            die("write");
+        }
+        memmove(c->out, c->out + n, c->out_len - n);
+        c->out_len -= n;
+    }
+    struct epoll_event ev = {.events = EPOLLIN | (c->out_len ? EPOLLOUT : 0), .data.ptr = c};
+    epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+static void handle_line(struct conn *c, const char *line, uint64_t now) {
+    if (strncmp(line, "EVENT:", 6) == 0) {
+        if (strncmp(line, "EVENT:BUTTON:", 13) == 0 && press_ns) {
+            samples_add(&fanout, now - press_ns);
+            c->events_seen++;
+        }
+        return;
+    }
+    if (c->q_len == 0) {
+        fprintf(stderr, "요청하지 않은 응답: %s\n", line);
+        errors++;
+        return;
+    }
+    struct pending p = c->q[c->q_head];
+    c->q_head = (c->q_head + 1) % c->q_cap;
+    c->q_len--;
+    completed++;
+    if (strncmp(line, "ERR", 3) == 0) errors++;
+    uint64_t d = now > p.intended_ns ? now - p.intended_ns : 0;
+    samples_add(&lat[p.op], d);
+    if (p.op != OP_BUTTON) samples_add(&lat_all, d);
+}
+
+static void conn_read(struct conn *c) {
+    for (;;) {
+        ssize_t n = read(c->fd, c->in + c->in_len, sizeof(c->in) - c->in_len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) return;
+            die("read");
+        }
+        if (n == 0) {
+            fprintf(stderr, "서버가 연결을 닫음\n");
+            exit(2);
+        }
+        uint64_t now = now_ns();
+        c->in_len += n;
+        char *start = c->in, *nl;
+        while ((nl = memchr(start, '\n', c->in + c->in_len - start)) != NULL) {
+            *nl = '\0';
+            // 여러 줄 응답은 이 명령 묶음에 없으므로 한 줄 = 응답 하나
+            handle_line(c, start, now);
+            start = nl + 1;
+        }
+        c->in_len -= start - c->in;
+        memmove(c->in, start, c->in_len);
+    }
+}
+
+static int connect_to(const char *host, int port) {
+    struct addrinfo hints, *res;
+    char service[16];
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(service, sizeof(service), "%d", port);
+    if (getaddrinfo(host, service, &hints, &res) != 0) return -1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) < 0) {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+// "led=40,seg7=30,sensor=25,timer=5" → 가중치
+static int parse_mix(const char *spec, int weights[NUM_OPS]) {
+    char buf[128];
+    memset(weights, 0, sizeof(int) * NUM_OPS);
+    snprintf(buf, sizeof(buf), "%s", spec);
+    for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+        char *eq = strchr(tok, '=');
+        if (!eq) return -1;
+        *eq = '\0';
+        int op;
+        for (op = 0; op < OP_BUTTON; op++)
+            if (strcmp(tok, op_names[op]) == 0) break;
+        if (op == OP_BUTTON || atoi(eq + 1) < 0) return -1;
+        weights[op] = atoi(eq + 1);
+    }
+    int total = 0;
+    for (int op = 0; op < NUM_OPS; op++) total += weights[op];
+    return total > 0 ? total : -1;
+}
+
+// 요청 한 건을 만든다 (xorshift로 명령 종류를 고름, 실행마다 같은 순서)
+static int next_command(const int weights[NUM_OPS], int total, char *line, size_t cap) {
+    static uint32_t rng = 2463534242u;
+    static unsigned long seq = 0;
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    int pick = (int)(rng % (uint32_t)total), op = 0;
+    while (pick >= weights[op]) pick -= weights[op++];
+    seq++;
+    switch (op) {
+        case OP_LED: snprintf(line, cap, "%s\n", seq & 1 ? "LED:ON" : "LED:OFF"); break;
+        case OP_SEG7: snprintf(line, cap, "SEG7:%lu\n", seq % 10); break;
+        case OP_SENSOR: snprintf(line, cap, "SENSOR:27\n"); break;
+        case OP_TIMER: snprintf(line, cap, "TIMER:1:LED:OFF\n"); break;   // 1초 뒤 실행되고 사라짐
+    }
+    return op;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "사용법: %s [-h 호스트] [-p 포트] [-c 연결 수] [-r 초당 요청] [-d 초]\n"
+                    "       [-m led=40,seg7=30,sensor=25,timer=5] [-e 버튼 간격 ms] [-P p99 한도 us]\n", prog);
+    exit(2);
+}
+
+int main(int argc, char *argv[]) {
+    const char *host = "127.0.0.1", *mix = "led=40,seg7=30,sensor=25,timer=5";
+    int port = 5000, rate = DEFAULT_RATE, duration = DEFAULT_DURATION, button_ms = 0, opt;
+    double p99_limit_us = 0;
+    int weights[NUM_OPS];
+    char press_low[32], press_high[32];
+
+    while ((opt = getopt(argc, argv, "h:p:c:r:d:m:e:P:")) != -1) {
+        switch (opt) {
+            case 'h': host = optarg; break;
+            case 'p': port = atoi(optarg); break;
+            case 'c': nconns = atoi(optarg); break;
+            case 'r': rate = atoi(optarg); break;
+            case 'd': duration = atoi(optarg); break;
+            case 'm': mix = optarg; break;
+            case 'e': button_ms = atoi(optarg); break;
+            case 'P': p99_limit_us = atof(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    int total_weight = parse_mix(mix, weights);
+    if (nconns < 1 || nconns > MAX_CONNS || rate < 1 || duration < 1 || total_weight < 0) usage(argv[0]);
+    if (button_ms && button_ms < BUTTON_MIN_MS) button_ms = BUTTON_MIN_MS;
+
+    snprintf(press_low, sizeof(press_low), "SIM:INPUT:%d:0\n", BUTTON_PIN);
+    snprintf(press_high, sizeof(press_high), "SIM:INPUT:%d:1\n", BUTTON_PIN);
+
+    epfd = epoll_create1(0);
+    if (epfd < 0) die("epoll_create1");
+    for (int i = 0; i < nconns; i++) {
+        conns[i].fd = connect_to(host, port);
+        if (conns[i].fd < 0) die("connect");
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = &conns[i]};
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, conns[i].fd, &ev) < 0) die("epoll_ctl");
+    }
+    printf("대상 %s:%d, 연결 %d, 목표 %d req/s, %d초, 명령 비율 %s%s\n", host, port, nconns, rate, duration, mix,
+           button_ms ? ", 버튼 알림 측정" : "");
+
+    uint64_t start = now_ns(), end = start + (uint64_t)duration * 1000000000ULL;
+    uint64_t interval = 1000000000ULL / rate, next_send = start;
+    uint64_t next_press = button_ms ? start + (uint64_t)button_ms * 1000000ULL : UINT64_MAX;
+    unsigned long issued = 0;
+    uint64_t drain_deadline = 0;
+    struct epoll_event events[64];
+    char line[64];
+
+    for (;;) {
+        uint64_t now = now_ns();
+        if (now < end) {
+            // 밀린 만큼 한꺼번에 보낸다 (open-loop: 응답을 기다리지 않음)
+            while (next_send <= now) {
+                struct conn *c = &conns[issued % nconns];
+                int op = next_command(weights, total_weight, line, sizeof(line));
+                conn_push(c, line, next_send, op);
+                issued++;
+                next_send = start + issued * interval;
+            }
+            if (next_press <= now) {
+                // 버튼 눌림 = 0 → 1 상승 엣지, 상승 요청을 보낸 시각부터 알림 도착까지 잰다
+                conn_push(&conns[0], press_low, next_press, OP_BUTTON);
+                conn_push(&conns[0], press_high, next_press, OP_BUTTON);
+                press_ns = now;
+                presses++;
+                next_press += (uint64_t)button_ms * 1000000ULL;
+            }
+            for (int i = 0; i < nconns; i++) if (conns[i].out_len) conn_flush(&conns[i]);
+        } else {
+            if (!drain_deadline) drain_deadline = now + DRAIN_TIMEOUT_MS * 1000000ULL;
+            unsigned long waiting = 0;
+            for (int i = 0; i < nconns; i++) waiting += conns[i].q_len;
+            if (waiting == 0 || now >= drain_deadline) break;
+        }
+        uint64_t wake = now < end ? (next_send < next_press ? next_send : next_press) : now + 10000000ULL;
+        int timeout = wake > now ? (int)((wake - now + 999999) / 1000000) : 0;
+        int n = epoll_wait(epfd, events, 64, timeout);
+        for (int i = 0; i < n; i++) {
+            struct conn *c = events[i].data.ptr;
+            if (events[i].events & EPOLLIN) conn_read(c);
+            if (events[i].events & EPOLLOUT) conn_flush(c);
+        }
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+    unsigned long lost = sent - completed;
+
+    printf("보낸 요청 %lu, 응답 %lu, 오류 응답 %lu, 응답 없음 %lu\n", sent, completed, errors, lost);
+    printf("처리량: %.0f req/s (전송 구간 %d초 + 응답 대기 포함 %.2f초)\n", completed / elapsed, duration, elapsed);
+    printf("%-8s %10s %10s %10s %10s %10s %10s  (us, 보냈어야 할 시각 기준)\n",
+           "command", "count", "p50", "p90", "p99", "p99.9", "max");
+    print_row("all", &lat_all);
+    for (int op = 0; op < NUM_OPS; op++) print_row(op_names[op], &lat[op]);
+    if (button_ms) {
+        unsigned long expected = (unsigned long)presses * nconns;
+        printf("버튼 알림: 누름 %d회, 알림 %zu/%lu건 수신 (누름 → 각 연결 도착)\n", presses, fanout.len, expected);
+        print_row("fan-out", &fanout);
+    }
+    if (lost || errors) return 1;
+    if (p99_limit_us > 0 && percentile(&lat_all, 0.99) / 1e3 > p99_limit_us) {
+        printf("p99 %.1fus가 한도 %.1fus를 넘음\n", percentile(&lat_all, 0.99) / 1e3, p99_limit_us);
+        return 1;
+    }
+    return 0;
+}
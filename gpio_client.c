@@ -1,24 +1,36 @@
 /**
  * gpio_client.c - 클라이언트 GPIO 제어 및 상태 확인 프로그램
+ *
+ * 사용법: ./gpio_client [-p 포트] [-s 스크립트|-] [-w 동시 요청 수] <서버_IP>
+ *         ./gpio_client [-p 포트] [-t 제한 ms] [-c 명령]... [-s 스크립트|-] <서버_IP> <서버_IP>...
+ * 프로토콜 처리는 libgpioclient(gpioclient.h)와 연결 풀(gpio_pool.h)이 맡고, 이 파일은 화면 입출력만 다룬다.
+ * -s를 주면 메뉴 대신 스크립트(또는 표준입력)의 명령을 파이프라이닝하고,
+ * 응답을 seq로 요청과 짝지어 한 줄에 하나씩 JSON으로 출력한다.
+ * 서버를 여러 대 주거나 -c를 주면 모든 서버에 같은 명령을 동시에 보내고
+ * 서버별 결과와 명령별 요약을 출력한다.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
-#include <sys/types.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <netdb.h>
-#include <pthread.h>
 #include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <time.h>
+#include "gpioclient.h"
+#include "client_verbs.h"
+#include "gpio_pool.h"
 
 #define SERVER_PORT 5000
 #define BUFFER_SIZE 1024
-#define LED_PIN 17
-#define BUTTON_PIN 18
-#define SENSOR_PIN 19
-#define BUZZER_PIN 27
+#define CONNECT_TIMEOUT_MS 3000
+
+#define SCRIPT_WINDOW 64        // 기본 동시 요청 수 (응답을 기다리는 요청 최대 개수)
+#define SCRIPT_MAX_WINDOW GPIOCLIENT_MAX_WINDOW
+#define SCRIPT_LINE_MAX BUFFER_SIZE
+#define FANOUT_MAX_CMDS 64
 
 #define COLOR_RESET   "\033[0m"
 #define COLOR_YELLOW  "\033[33m"
@@ -29,14 +41,10 @@
 #define COLOR_BOLD    "\033[1m"
 
 // 함수 선언
-void control_led(int socket, int pin, int state);
-void read_button(int socket, int pin);
-void read_sensor(int socket, int pin);
-void display_digit(int socket, int digit);
-void *receive_updates(void *arg);
 void handle_signal(int sig);
-void control_buzzer(int socket, int pin);
-void device_self_test(int sockfd);
+int run_menu(struct gpioclient *c);
+int run_script(struct gpioclient *c, int in_fd);
+int run_fanout(char *const hosts[], int nhosts, int port, int timeout_ms, char *const cmds[], int ncmds, FILE *script);
 
 void print_menu() {
     printf(COLOR_CYAN);
@@ -62,52 +70,74 @@ void print_menu() {
 }
 
 int main(int argc, char *argv[]) {
-    int sockfd;
-    struct sockaddr_in serv_addr;
-    char buffer[BUFFER_SIZE];
-    pthread_t update_thread;
     struct sigaction sa;
-    
-    // 인자 확인
-    if (argc < 2) {
-        fprintf(stderr, COLOR_RED "사용법: %s <서버_IP>\n" COLOR_RESET, argv[0]);
-        exit(EXIT_FAILURE);
+    const char *script = NULL;
+    char *cmds[FANOUT_MAX_CMDS];
+    int ncmds = 0, usage_error = 0;
+    int port = SERVER_PORT, window = SCRIPT_WINDOW, timeout_ms = GPIOCLIENT_TIMEOUT_MS, opt;
+
+    while ((opt = getopt(argc, argv, "p:s:w:c:t:")) != -1) {
+        switch (opt) {
+            case 'p': port = atoi(optarg); break;
+            case 's': script = optarg; break;
+            case 'w': window = atoi(optarg); break;
+            case 't': timeout_ms = atoi(optarg); break;
+            case 'c':
+                if (ncmds < FANOUT_MAX_CMDS) cmds[ncmds++] = optarg;
+                else usage_error = 1;
+                break;
+            default: usage_error = 1; break;
+        }
     }
     
-    // 소켓 생성
-    sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sockfd < 0) {
-        perror("소켓 생성 실패");
+    // 인자 확인
+    if (usage_error || optind >= argc || window < 1 || window > SCRIPT_MAX_WINDOW || timeout_ms < 1) {
+        fprintf(stderr, COLOR_RED "사용법: %s [-p 포트] [-s 스크립트|-] [-w 동시 요청 수(1~%d)] <서버_IP>\n"
+                        "        %s [-p 포트] [-t 제한 ms] [-c 명령]... [-s 스크립트|-] <서버_IP[:포트]>...\n" COLOR_RESET,
+                argv[0], SCRIPT_MAX_WINDOW, argv[0]);
         exit(EXIT_FAILURE);
     }
-    
-    // 서버 정보 설정
-    memset(&serv_addr, 0, sizeof(serv_addr));
-    serv_addr.sin_family = AF_INET;
-    // IP 주소를 직접 사용하여 변환
-    if (inet_pton(AF_INET, argv[1], &serv_addr.sin_addr) <= 0) {
-        fprintf(stderr, COLOR_RED "유효하지 않은 IP 주소입니다: %s\n" COLOR_RESET, argv[1]);
-        exit(EXIT_FAILURE);
+
+    // 여러 서버 모드: 연결 풀로 같은 명령을 모든 서버에 동시에 보냄
+    if (ncmds > 0 || argc - optind > 1) {
+        FILE *in = NULL;
+        if (script) {
+            in = strcmp(script, "-") == 0 ? stdin : fopen(script, "r");
+            if (!in) {
+                perror("스크립트 열기 실패");
+                exit(EXIT_FAILURE);
+            }
+        }
+        return run_fanout(argv + optind, argc - optind, port, timeout_ms, cmds, ncmds, in);
     }
-    serv_addr.sin_port = htons(SERVER_PORT);
-    
+    const char *server_ip = argv[optind];
+
     // 연결 시도
-    if (connect(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
-        perror("연결 실패");
+    struct gpioclient *c = gpioclient_new(server_ip, port);
+    if (!c) {
+        fprintf(stderr, COLOR_RED "유효하지 않은 IP 주소입니다: %s\n" COLOR_RESET, server_ip);
         exit(EXIT_FAILURE);
     }
-    
-    printf(COLOR_GREEN "서버 %s에 연결됨\n" COLOR_RESET, argv[1]);
-    
-    // 업데이트 스레드 생성
-    if (pthread_create(&update_thread, NULL, receive_updates, &sockfd) != 0) {
-        perror("업데이트 스레드 생성 실패");
-        close(sockfd);
+    gpioclient_set_timeout(c, timeout_ms);
+    if (gpioclient_wait_ready(c, CONNECT_TIMEOUT_MS) < 0) {
+        fprintf(stderr, COLOR_RED "연결 실패: %s\n" COLOR_RESET, server_ip);
         exit(EXIT_FAILURE);
     }
+
+    // 스크립트 모드: 메뉴 없이 파이프라이닝 후 종료
+    if (script) {
+        int in_fd = strcmp(script, "-") == 0 ? STDIN_FILENO : open(script, O_RDONLY);
+        if (in_fd < 0) {
+            perror("스크립트 열기 실패");
+            exit(EXIT_FAILURE);
+        }
+        gpioclient_set_window(c, window);
+        int rc = run_script(c, in_fd);
+        gpioclient_free(c);
+        return rc;
+    }
     
-    // 사용자 선택
-    int choice, level, num, timer_sec;
+    printf(COLOR_GREEN "서버 %s에 연결됨\n" COLOR_RESET, server_ip);
     
     sa.sa_handler = handle_signal;
     sigemptyset(&sa.sa_mask);
@@ -116,217 +146,369 @@ int main(int argc, char *argv[]) {
         sigaction(i, &sa, NULL);
     }
     
-    while (1) {
-        print_menu();
-        if (scanf("%d", &choice) != 1) {
-            getchar(); // 입력 버퍼 비우기
-            continue;
-        }
-        
-        char command[64];
-        switch (choice) {
-            case 1: // LED ON
-                strcpy(command, "LED:ON");
-                write(sockfd, command, strlen(command));
-                break;
-                
-            case 2: // LED OFF
-                strcpy(command, "LED:OFF");
-                write(sockfd, command, strlen(command));
-                break;
-                
-            case 3: // LED 밝기 설정
-                printf(COLOR_MAGENTA "밝기 (0=최소, 1=중간, 2=최대): " COLOR_RESET);
-                scanf("%d", &level);
-                sprintf(command, "LED:BRIGHT:%d", level);
-                write(sockfd, command, strlen(command));
-                break;
-                
-            case 4: // BUZZER ON
-                strcpy(command, "BUZZER:ON");
-                write(sockfd, command, strlen(command));
-                break;
-                
-            case 5: // BUZZER OFF
-                strcpy(command, "BUZZER:OFF");
-                write(sockfd, command, strlen(command));
-                break;
-                
-            case 6: // BUZZER 음악 재생
-                printf(COLOR_MAGENTA "\n[BUZZER 음악 선택] 1=곰 세 마리, 2=아이돌\n" COLOR_RESET);
-                printf(COLOR_GREEN "음악 번호를 입력하세요 (1/2): " COLOR_RESET);
-                int music_sel = 1;
-                scanf("%d", &music_sel);
-                if (music_sel != 2) music_sel = 1;
-                sprintf(command, "BUZZER:MUSIC:%d", music_sel);
-                write(sockfd, command, strlen(command));
-                break;
-                
-            case 7: // 7-Segment 숫자 표시
-                printf(COLOR_MAGENTA "숫자 (0-9): " COLOR_RESET);
-                scanf("%d", &num);
-                sprintf(command, "SEG7:%d", num);
-                write(sockfd, command, strlen(command));
-                break;
-                
-            case 8: // 7-Segment OFF
-                strcpy(command, "SEG7:OFF");
-                write(sockfd, command, strlen(command));
-                break;
-                
-            case 9: // 조도센서 값 읽기
-                strcpy(command, "SENSOR:27");
-                write(sockfd, command, strlen(command));
-                break;
-                
-            case 10: // 추가기능(버튼+음악+LED+세그먼트)
-                strcpy(command, "EXTRA_MUSIC_MODE");
-                write(sockfd, command, strlen(command));
-                break;
-                
-            case 11: // 전체 OFF (ALL_OFF)
-                strcpy(command, "ALL_OFF");
-                write(sockfd, command, strlen(command));
-                break;
-                
-            case 12: // 예약 OFF (TIMER)
-                printf(COLOR_MAGENTA "예약 OFF 시간(초): " COLOR_RESET);
-                scanf("%d", &timer_sec);
-                sprintf(command, "TIMER:%d", timer_sec);
-                write(sockfd, command, strlen(command));
-                break;
-                
-            case 0: // 종료
+    int rc = run_menu(c);
+    gpioclient_free(c);
+    return rc;
+}
+
+void handle_signal(int sig) {
+    (void)sig;
+    printf("\n클라이언트 종료\n");
+    exit(0);
+}
+
+// ---- 메뉴 모드 ----
+
+// 응답을 "서버 응답: <명령> <상태>[:값...]" 형태로 출력
+static void menu_reply(const struct gpioclient_result *res, void *arg) {
+    (void)arg;
+    const char *verb = client_verb_name(res->opcode);
+    printf(res->status == ST_OK ? COLOR_GREEN : COLOR_RED);
+    printf("\n서버 응답: %s %s", verb ? verb : "?", gpioclient_status_name(res->status));
+    for (int i = 0; i < res->nvals; i++) printf(":%d", res->vals[i]);
+    printf(" (%.1fms)\n" COLOR_RESET, res->latency_ns / 1e6);
+    if (res->text_len > 0) printf("%.*s", (int)res->text_len, res->text);
+    fflush(stdout);
+}
+
+static void menu_event(const struct gpioclient_result *res, void *arg) {
+    (void)arg;
+    if (res->device == DEV_BUTTON) printf(COLOR_YELLOW "\n[알림] 버튼이 눌렸습니다!\n" COLOR_RESET);
+    fflush(stdout);
+}
+
+// 메뉴 번호(와 필요하면 추가 입력값)를 명령으로 보낸다
+static void menu_command(struct gpioclient *c, int choice, int value) {
+    char command[64];
+    switch (choice) {
+        case 1: gpioclient_led(c, 1, menu_reply, NULL); break;          // LED ON
+        case 2: gpioclient_led(c, 0, menu_reply, NULL); break;          // LED OFF
+        case 3: gpioclient_led_bright(c, value, menu_reply, NULL); break; // LED 밝기 설정
+        case 4: gpioclient_buzzer(c, 1, menu_reply, NULL); break;       // BUZZER ON
+        case 5: gpioclient_buzzer(c, 0, menu_reply, NULL); break;       // BUZZER OFF
+        case 6: gpioclient_buzzer_music(c, value == 2 ? 2 : 1, menu_reply, NULL); break; // BUZZER 음악 재생
+        case 7: gpioclient_seg7(c, value, menu_reply, NULL); break;     // 7-Segment 숫자 표시
+        case 8: gpioclient_seg7(c, -1, menu_reply, NULL); break;        // 7-Segment OFF
+        case 9: gpioclient_read_sensor(c, menu_reply, NULL); break;     // 조도센서 값 읽기
+        case 10: gpioclient_send(c, "EXTRA_MUSIC_MODE", menu_reply, NULL); break; // 추가기능(버튼+음악+LED+세그먼트)
+        case 11: gpioclient_send(c, "ALL_OFF", menu_reply, NULL); break; // 전체 OFF (ALL_OFF)
+        case 12: // 예약 OFF (TIMER)
+            snprintf(command, sizeof(command), "TIMER:%d", value);
+            gpioclient_send(c, command, menu_reply, NULL);
+            break;
+    }
+}
+
+// 추가 입력이 필요한 메뉴의 질문
+static const char *menu_prompt(int choice) {
+    switch (choice) {
+        case 3: return COLOR_MAGENTA "밝기 (0=최소, 1=중간, 2=최대): " COLOR_RESET;
+        case 6: return COLOR_MAGENTA "\n[BUZZER 음악 선택] 1=곰 세 마리, 2=아이돌\n" COLOR_RESET
+                       COLOR_GREEN "음악 번호를 입력하세요 (1/2): " COLOR_RESET;
+        case 7: return COLOR_MAGENTA "숫자 (0-9): " COLOR_RESET;
+        case 12: return COLOR_MAGENTA "예약 OFF 시간(초): " COLOR_RESET;
+        default: return NULL;
+    }
+}
+
+// 표준입력과 서버 연결을 poll 하나로 함께 기다린다 (응답/알림은 입력을 기다리는 동안에도 출력됨)
+int run_menu(struct gpioclient *c) {
+    char line[BUFFER_SIZE];
+    size_t len = 0;
+    int choice = -1;    // 추가 입력을 기다리는 메뉴 번호
+
+    gpioclient_on_event(c, menu_event, NULL);
+    print_menu();
+    for (;;) {
+        struct pollfd fds[2] = {
+            {.fd = STDIN_FILENO, .events = POLLIN},
+            {.fd = gpioclient_fd(c), .events = (short)gpioclient_events(c)},
+        };
+        if (poll(fds, 2, gpioclient_next_timeout(c)) < 0 && errno != EINTR) return 1;
+        if (fds[1].revents) gpioclient_handle(c, fds[1].revents);
+        gpioclient_tick(c);
+        if (!(fds[0].revents & (POLLIN | POLLHUP))) continue;
+
+        ssize_t n = read(STDIN_FILENO, line + len, sizeof(line) - 1 - len);
+        if (n <= 0) break;
+        len += n;
+        char *nl;
+        while ((nl = memchr(line, '\n', len)) != NULL) {
+            *nl = '\0';
+            char *end;
+            long v = strtol(line, &end, 10);
+            int valid = end != line;
+            len -= nl + 1 - line;
+            memmove(line, nl + 1, len);
+
+            if (choice >= 0) {
+                if (valid) menu_command(c, choice, (int)v);
+                choice = -1;
+            } else if (!valid) {
+                print_menu();
+                continue;
+            } else if (v == 0) {
+                gpioclient_wait(c, GPIOCLIENT_TIMEOUT_MS);  // 보낸 명령의 응답은 받고 종료
                 printf(COLOR_RED "프로그램을 종료합니다.\n" COLOR_RESET);
-                close(sockfd);
                 return 0;
-                
-            default:
+            } else if (v < 0 || v > 12) {
                 printf(COLOR_RED "잘못된 선택입니다. 다시 입력해주세요.\n" COLOR_RESET);
+            } else if (menu_prompt((int)v)) {
+                choice = (int)v;
+                printf("%s", menu_prompt(choice));
+                fflush(stdout);
+                continue;
+            } else {
+                menu_command(c, (int)v, 0);
+            }
+            print_menu();
         }
+        if (len == sizeof(line) - 1) len = 0;
     }
-    
+    // 입력이 끝나면 남은 응답을 받고 종료
+    gpioclient_wait(c, GPIOCLIENT_TIMEOUT_MS);
     return 0;
 }
 
-void control_led(int socket, int pin, int state) {
-    char command[64];
-    char buffer[BUFFER_SIZE];
-    
-    sprintf(command, "LED:%d:%d", pin, state);
-    
-    // 서버로 명령 전송
-    if (write(socket, command, strlen(command)) < 0) {
-        perror("명령 전송 실패");
-        return;
-    }
-    
-    // 응답 확인 (응답이 필요한 경우)
-    /*
-    int n = read(socket, buffer, BUFFER_SIZE - 1);
-    if (n > 0) {
-        buffer[n] = '\0';
-        printf("서버 응답: %s\n", buffer);
+// ---- 스크립트 모드 ----
+
+// 응답을 기다리는 스크립트 줄
+struct script_req {
+    unsigned long line_no;
+    int *errors;
+    int *lost;
+    char cmd[];
+};
+
+static void print_json_string(const char *s, size_t len) {
+    putchar('"');
+    for (size_t i = 0; i < len; i++) {
+        unsigned char ch = (unsigned char)s[i];
+        if (ch == '"' || ch == '\\') printf("\\%c", ch);
+        else if (ch == '\n') printf("\\n");
+        else if (ch < 0x20) printf("\\u%04x", ch);
+        else putchar(ch);
     }
-    */
+    putchar('"');
 }
 
-void read_button(int socket, int pin) {
-    char command[64];
-    
-    sprintf(command, "BTN:%d", pin);
-    
-    // 서버로 명령 전송
-    if (write(socket, command, strlen(command)) < 0) {
-        perror("명령 전송 실패");
-        return;
+// 응답 값과 여러 줄 응답 본문
+static void print_values(const struct gpioclient_result *res) {
+    printf(",\"values\":[");
+    for (int i = 0; i < res->nvals; i++) printf(i ? ",%d" : "%d", res->vals[i]);
+    putchar(']');
+    if (res->text_len > 0) {
+        printf(",\"text\":");
+        print_json_string(res->text, res->text_len);
     }
-    
-    // 응답 확인을 위해 대기
 }
 
-void read_sensor(int socket, int pin) {
-    char command[64];
-    
-    sprintf(command, "SENSOR:%d", pin);
-    
-    // 서버로 명령 전송
-    if (write(socket, command, strlen(command)) < 0) {
-        perror("명령 전송 실패");
-        return;
-    }
-    
-    // 응답 확인을 위해 대기
+static void script_result(const struct gpioclient_result *res, void *arg) {
+    struct script_req *r = arg;
+    printf("{\"line\":%lu,\"seq\":%u,\"cmd\":", r->line_no, res->seq);
+    print_json_string(r->cmd, strlen(r->cmd));
+    printf(",\"status\":\"%s\"", gpioclient_status_name(res->status));
+    print_values(res);
+    printf(",\"us\":%.1f}\n", res->latency_ns / 1e3);
+    if (res->status != ST_OK) (*r->errors)++;
+    if (res->status == GPIOCLIENT_ST_DOWN || res->status == GPIOCLIENT_ST_TIMEOUT) (*r->lost)++;
+    free(r);
 }
 
-void display_digit(int socket, int digit) {
-    char command[64];
-    
-    sprintf(command, "7SEG:%d", digit);
-    
-    // 서버로 명령 전송
-    if (write(socket, command, strlen(command)) < 0) {
-        perror("명령 전송 실패");
-        return;
+static void script_event(const struct gpioclient_result *res, void *arg) {
+    static const char *const dev_names[DEV_MAX] = {
+        [DEV_LED] = "LED", [DEV_BUZZER] = "BUZZER", [DEV_SEG7] = "SEG7",
+        [DEV_SENSOR] = "SENSOR", [DEV_BUTTON] = "BUTTON", [DEV_SYSTEM] = "SYSTEM",
+    };
+    (void)arg;
+    printf("{\"event\":\"%s\"", res->device < DEV_MAX && dev_names[res->device] ? dev_names[res->device] : "PIN");
+    print_values(res);
+    printf("}\n");
+}
+
+// 한 줄을 요청으로 보낸다, 서버로 보내지 못하는 줄은 바로 결과를 출력
+static void script_submit(struct gpioclient *c, char *line, unsigned long line_no, int *errors, int *lost) {
+    size_t len = strlen(line);
+    if (len > 0 && line[len - 1] == '\r') line[--len] = '\0';
+    if (len == 0 || line[0] == '#') return;
+
+    struct script_req *r = malloc(sizeof(*r) + len + 1);
+    int status = ST_FAILED;
+    if (r) {
+        r->line_no = line_no;
+        r->errors = errors;
+        r->lost = lost;
+        memcpy(r->cmd, line, len + 1);
+        status = gpioclient_send(c, line, script_result, r);
+    }
+    if (status != ST_OK) {
+        printf("{\"line\":%lu,\"seq\":0,\"cmd\":", line_no);
+        print_json_string(line, len);
+        printf(",\"status\":\"%s\",\"values\":[],\"us\":0}\n", gpioclient_status_name(status));
+        (*errors)++;
+        free(r);
     }
-    
-    // 응답 확인을 위해 대기
 }
 
-void *receive_updates(void *arg) {
-    int sockfd = *(int *)arg;
-    char buffer[BUFFER_SIZE];
-    while (1) {
-        int n = read(sockfd, buffer, BUFFER_SIZE - 1);
-        if (n > 0) {
-            buffer[n] = '\0';
-            if (strstr(buffer, "EVENT:BUTTON") != NULL) {
-                printf(COLOR_YELLOW "[알림] 버튼이 눌렸습니다!\n" COLOR_RESET);
-            } else {
-                printf(COLOR_GREEN "서버 응답: %s" COLOR_RESET, buffer);
+// 스크립트(또는 표준입력)의 명령을 창이 허락하는 만큼 응답을 기다리지 않고 보낸다.
+// 반환값: 0 모두 OK, 1 오류 응답 있음, 2 응답을 받기 전에 연결이 끊기거나 시간 초과
+int run_script(struct gpioclient *c, int in_fd) {
+    char line_buf[SCRIPT_LINE_MAX * 4];
+    size_t line_len = 0;
+    unsigned long line_no = 0;
+    int in_eof = 0, discarding = 0, errors = 0, lost = 0;
+
+    gpioclient_on_event(c, script_event, NULL);
+    for (;;) {
+        // 받아 둔 줄을 창이 허락하는 만큼 요청으로 바꿈
+        char *nl;
+        size_t used = 0;
+        while (gpioclient_can_send(c) && (nl = memchr(line_buf + used, '\n', line_len - used)) != NULL) {
+            *nl = '\0';
+            line_no++;
+            if (!discarding) script_submit(c, line_buf + used, line_no, &errors, &lost);
+            discarding = 0;
+            used = nl + 1 - line_buf;
+        }
+        memmove(line_buf, line_buf + used, line_len - used);
+        line_len -= used;
+        if (line_len == sizeof(line_buf) - 1) {
+            // 너무 긴 줄은 개행까지 버리고 TOO_LONG으로 보고
+            if (!discarding) {
+                printf("{\"line\":%lu,\"seq\":0,\"cmd\":\"\",\"status\":\"%s\",\"values\":[],\"us\":0}\n",
+                       line_no + 1, gpioclient_status_name(ST_TOO_LONG));
+                errors++;
             }
+            discarding = 1;
+            line_len = 0;
+        }
+        if (in_eof && line_len > 0 && gpioclient_can_send(c)) {
+            // 개행 없이 끝난 마지막 줄
+            line_buf[line_len] = '\0';
+            line_no++;
+            if (!discarding) script_submit(c, line_buf, line_no, &errors, &lost);
+            line_len = 0;
+        }
+        if (in_eof && line_len == 0 && gpioclient_pending(c) == 0) break;
+
+        int want_input = !in_eof && gpioclient_can_send(c) && !memchr(line_buf, '\n', line_len);
+        struct pollfd fds[2] = {
+            {.fd = gpioclient_fd(c), .events = (short)gpioclient_events(c)},
+            {.fd = want_input ? in_fd : -1, .events = POLLIN},
+        };
+        fflush(stdout);
+        if (poll(fds, 2, gpioclient_next_timeout(c)) < 0 && errno != EINTR) {
+            perror("poll");
+            return 2;
+        }
+        if (fds[0].revents) gpioclient_handle(c, fds[0].revents);
+        gpioclient_tick(c);
+        if (fds[1].revents & (POLLIN | POLLHUP)) {
+            ssize_t n = read(in_fd, line_buf + line_len, sizeof(line_buf) - 1 - line_len);
+            if (n > 0) line_len += n;
+            else if (n == 0 || errno != EINTR) in_eof = 1;
         }
     }
-    return NULL;
+    fflush(stdout);
+    return lost ? 2 : errors ? 1 : 0;
 }
 
-void handle_signal(int sig) {
-    printf("\n클라이언트 종료\n");
-    exit(0);
+// ---- 여러 서버 모드 ----
+
+// 명령 하나의 서버별 결과 모음
+struct fanout_cmd {
+    const char *cmd;
+    int done, ok;
+    uint64_t *latency_ns;   // 성공한 서버의 응답 시간
+};
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
 }
 
-void control_buzzer(int socket, int pin) {
-    char command[64];
-    sprintf(command, "BUZZER:%d", pin);
-    if (write(socket, command, strlen(command)) < 0) {
-        perror("명령 전송 실패");
-        return;
-    }
+static void fanout_result(const struct gpioclient_result *res, void *arg) {
+    struct fanout_cmd *fc = arg;
+    printf("{\"host\":");
+    print_json_string(res->name, strlen(res->name));
+    printf(",\"cmd\":");
+    print_json_string(fc->cmd, strlen(fc->cmd));
+    printf(",\"status\":\"%s\"", gpioclient_status_name(res->status));
+    print_values(res);
+    printf(",\"us\":%.1f}\n", res->latency_ns / 1e3);
+    if (res->status == ST_OK) fc->latency_ns[fc->ok++] = res->latency_ns;
+    fc->done++;
 }
 
-void device_self_test(int sockfd) {
-    printf("LED 테스트: ON\n");
-    control_led(sockfd, LED_PIN, 1);
-    sleep(1);
-    printf("LED 테스트: OFF\n");
-    control_led(sockfd, LED_PIN, 0);
-    sleep(1);
+static void fanout_event(const struct gpioclient_result *res, void *arg) {
+    (void)arg;
+    if (res->device != DEV_BUTTON) return;
+    printf("{\"host\":");
+    print_json_string(res->name, strlen(res->name));
+    printf(",\"event\":\"BUTTON\"");
+    print_values(res);
+    printf("}\n");
+}
 
-    printf("부저 테스트\n");
-    control_buzzer(sockfd, BUZZER_PIN);
-    sleep(1);
+// 명령 하나를 모든 서버에 보내고 결과가 다 모이면 요약 한 줄을 출력, 모두 OK면 0
+static int fanout_one(struct gpio_pool *pool, const char *cmd, int timeout_ms) {
+    int nhosts = gpio_pool_size(pool);
+    struct fanout_cmd fc = {.cmd = cmd};
+    fc.latency_ns = calloc(nhosts, sizeof(*fc.latency_ns));
+    if (!fc.latency_ns) return 1;
 
-    printf("7-Segment 테스트: 3\n");
-    display_digit(sockfd, 3);
-    sleep(2);
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int status = gpio_pool_broadcast(pool, cmd, fanout_result, &fc);
+    if (status != ST_OK) {
+        printf("{\"cmd\":");
+        print_json_string(cmd, strlen(cmd));
+        printf(",\"status\":\"%s\",\"hosts\":%d,\"ok\":0,\"failed\":%d}\n", gpioclient_status_name(status), nhosts, nhosts);
+        free(fc.latency_ns);
+        return 1;
+    }
+    // 시간 초과는 연결이 TIMEOUT 결과로 알려 주므로 여유를 두고 기다린다
+    while (fc.done < nhosts && gpio_pool_run(pool, timeout_ms * 2) > 0) {}
+    clock_gettime(CLOCK_MONOTONIC, &t1);
 
-    printf("센서 값 읽기: ");
-    read_sensor(sockfd, SENSOR_PIN);
-    sleep(1);
+    qsort(fc.latency_ns, fc.ok, sizeof(*fc.latency_ns), cmp_u64);
+    printf("{\"cmd\":");
+    print_json_string(cmd, strlen(cmd));
+    printf(",\"hosts\":%d,\"ok\":%d,\"failed\":%d", nhosts, fc.ok, nhosts - fc.ok);
+    if (fc.ok > 0) {
+        printf(",\"p50_us\":%.1f,\"max_us\":%.1f", fc.latency_ns[(fc.ok - 1) / 2] / 1e3,
+               fc.latency_ns[fc.ok - 1] / 1e3);
+    }
+    printf(",\"wall_us\":%.1f}\n", ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / 1e3);
+    fflush(stdout);
+    int failed = fc.ok != nhosts;
+    free(fc.latency_ns);
+    return failed;
+}
 
-    printf("버튼 상태 읽기: ");
-    read_button(sockfd, BUTTON_PIN);
-    sleep(1);
+// -c 명령들, 이어서 스크립트의 줄들을 차례로 모든 서버에 보낸다
+// 연결은 처음에 한 번 맺고 명령마다 재사용하며, 끊긴 서버는 백오프로 다시 연결한다.
+// 반환값: 0 모든 서버가 모든 명령에 OK, 1 실패 있음
+int run_fanout(char *const hosts[], int nhosts, int port, int timeout_ms, char *const cmds[], int ncmds, FILE *script) {
+    struct gpio_pool *pool = gpio_pool_create(hosts, nhosts, port, timeout_ms);
+    if (!pool) {
+        fprintf(stderr, "연결 풀 생성 실패 (주소 확인)\n");
+        return 2;
+    }
+    gpio_pool_on_event(pool, fanout_event, NULL);
+    int up = gpio_pool_connect(pool, timeout_ms);
+    if (up < nhosts) fprintf(stderr, "연결된 서버 %d/%d\n", up, nhosts);
 
-    printf("진단 완료. 각 장치의 실제 반응을 확인하세요.\n");
+    int failed = 0;
+    for (int i = 0; i < ncmds; i++) failed |= fanout_one(pool, cmds[i], timeout_ms);
+    if (script) {
+        char line[SCRIPT_LINE_MAX];
+        while (fgets(line, sizeof(line), script)) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (line[0] == '\0' || line[0] == '#') continue;
+            failed |= fanout_one(pool, line, timeout_ms);
+        }
+    }
+    gpio_pool_destroy(pool);
+    return failed;
 }
@@ -0,0 +1,324 @@
+/**
+ * gpio_hal.c - GPIO 하드웨어 추상화 계층
+ *
+ * 디바이스 모듈은 wiringPi 대신 gpio_* 함수만 호출하고,
+ * 실제 동작은 시작 시 선택한 백엔드가 담당한다.
+ */
+#include "gpio_hal.h"
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+extern const struct gpio_backend gpio_sim_backend;
+extern const struct gpio_backend gpio_mmap_backend;
+#ifdef GPIO_HAVE_WIRINGPI
+extern const struct gpio_backend gpio_wiringpi_backend;
+#endif
+
+// 빌드에 포함된 백엔드 (첫 번째가 기본값)
+static const struct gpio_backend *backends[] = {
+#ifdef GPIO_HAVE_WIRINGPI
+    &gpio_wiringpi_backend,
+#endif
+    &gpio_sim_backend,
+    &gpio_mmap_backend,   // 기본값이 아니므로 -b mmap으로만 선택
+};
+
+static const struct gpio_backend *backend = NULL;
+
+// 핀별 마지막 설정 모드 (모드 + 1, 0이면 아직 모름). 같은 모드 재설정은 백엔드까지 가지 않는다.
+static int mode_cache[GPIO_MAX_PINS];
+
+static inline int cached_mode_matches(int pin, int mode) {
+    if (pin < 0 || pin >= GPIO_MAX_PINS) return 0;
+    return __atomic_load_n(&mode_cache[pin], __ATOMIC_RELAXED) == mode + 1;
+}
+
+static inline void cache_mode(int pin, int mode) {
+    if (pin >= 0 && pin < GPIO_MAX_PINS) __atomic_store_n(&mode_cache[pin], mode + 1, __ATOMIC_RELAXED);
+}
+
+// 출력 레벨 캐시와 모아 둔 쓰기
+// - known/high: 마지막으로 백엔드에 쓴 레벨. 같은 값은 다시 쓰지 않는다 (모드가 바뀌면 모름으로)
+// - nocache: 톤 핀은 백엔드 스레드가 따로 토글하므로 캐시하지 않고 항상 쓴다
+// - busy: 핀별 잠금 비트. 백엔드에 쓰고 known/high를 고치는 동안 그 핀만 잡으므로 디바이스끼리는 겹쳐 쓴다.
+//   쓰는 쪽은 known을 먼저 내리고 high를 고친 뒤 다시 올리므로, 잠금 없이 생략을 판단하는 쪽이 반쯤 고친 값을 믿지 않는다
+// - pend: gpio_coalesce_begin 구간에서 쓴 GPIO 0~31 값. gpio_coalesce_flush 때 마스크 한 번으로 쓴다.
+//   그 전에 같은 핀을 다시 쓰면 마지막 값만 남고, 구간 밖에서 바로 쓰면 그 값이 이긴다.
+//   pend는 write_mutex가 지키고, 모으는 중이 아니고 모아 둔 핀도 아니면 쓰기 경로는 이 뮤텍스를 잡지 않는다
+static pthread_mutex_t write_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t known_mask = 0;
+static uint64_t high_mask = 0;
+static uint64_t nocache_mask = 0;
+static uint64_t busy_mask = 0;
+static uint32_t pend_mask = 0;
+static uint32_t pend_high = 0;
+static struct gpio_write_stats wstats;     // 원자적으로 더한다
+static __thread int coalescing = 0;
+
+// 입력 엔진이 엣지로 추적하는 핀의 레벨 (-1이면 그 핀은 백엔드에서 읽음)
+static int (*level_source)(int pin) = NULL;
+
+static inline uint64_t pin_bit(int pin) {
+    return pin >= 0 && pin < GPIO_MAX_PINS ? 1ull << pin : 0;
+}
+
+static inline void stat_add(uint64_t *v, int n) {
+    if (n) __atomic_add_fetch(v, (uint64_t)n, __ATOMIC_RELAXED);
+}
+
+// 핀들을 한꺼번에 잡는다. 일부가 이미 잡혀 있으면 잡은 것을 놓고 다시 시도 (같은 핀을 쓰는 쪽끼리만 기다림)
+static void pins_lock(uint64_t bits) {
+    for (;;) {
+        uint64_t old = __atomic_fetch_or(&busy_mask, bits, __ATOMIC_ACQUIRE);
+        if (!(old & bits)) return;
+        uint64_t got = bits & ~old;
+        if (got) __atomic_fetch_and(&busy_mask, ~got, __ATOMIC_RELEASE);
+        sched_yield();
+    }
+}
+
+static inline void pins_unlock(uint64_t bits) {
+    __atomic_fetch_and(&busy_mask, ~bits, __ATOMIC_RELEASE);
+}
+
+// 캐시상 이미 그 레벨인 핀 (잠금 없이 본다)
+static inline uint64_t cached_same(uint64_t set, uint64_t clear) {
+    uint64_t known = __atomic_load_n(&known_mask, __ATOMIC_ACQUIRE) & ~__atomic_load_n(&nocache_mask, __ATOMIC_RELAXED);
+    uint64_t high = __atomic_load_n(&high_mask, __ATOMIC_RELAXED);
+    return known & ((set & high) | (clear & ~high));
+}
+
+// 백엔드에 쓰고 캐시를 맞춘다 (여러 핀이면 GPIO 0~31)
+static void hw_write_mask(uint64_t set, uint64_t clear) {
+    uint64_t touch = set | clear;
+    if (!touch) return;
+    pins_lock(touch);
+    __atomic_fetch_and(&known_mask, ~touch, __ATOMIC_RELAXED);
+    if (!(touch & (touch - 1))) {
+        backend->write(__builtin_ctzll(touch), set != 0);
+    } else if (backend->write_mask) {
+        backend->write_mask((uint32_t)set, (uint32_t)clear);
+    } else {
+        for (uint64_t m = clear; m; m &= m - 1) backend->write(__builtin_ctzll(m), 0);
+        for (uint64_t m = set; m; m &= m - 1) backend->write(__builtin_ctzll(m), 1);
+    }
+    if (set) __atomic_fetch_or(&high_mask, set, __ATOMIC_RELAXED);
+    if (clear) __atomic_fetch_and(&high_mask, ~clear, __ATOMIC_RELAXED);
+    __atomic_fetch_or(&known_mask, touch & ~__atomic_load_n(&nocache_mask, __ATOMIC_RELAXED), __ATOMIC_RELEASE);
+    pins_unlock(touch);
+    stat_add(&wstats.writes, __builtin_popcountll(touch));
+}
+
+// write_mutex를 잡은 상태에서 호출. GPIO 0~31 쓰기 (모으는 중이거나 모아 둔 핀을 건드릴 때)
+static void write_mask_locked(uint32_t set, uint32_t clear) {
+    uint32_t nc = (uint32_t)__atomic_load_n(&nocache_mask, __ATOMIC_RELAXED);
+    uint32_t hw_known = (uint32_t)__atomic_load_n(&known_mask, __ATOMIC_ACQUIRE) & ~nc;
+    uint32_t hw_high = (uint32_t)__atomic_load_n(&high_mask, __ATOMIC_RELAXED);
+    // 지금 보이는 값(모아 둔 값 우선)과 같으면 생략
+    uint32_t eff_known = hw_known | pend_mask;
+    uint32_t eff_high = (hw_high & ~pend_mask) | (pend_high & pend_mask);
+    uint32_t same = eff_known & ((set & eff_high) | (clear & ~eff_high));
+    stat_add(&wstats.elided, __builtin_popcount(same));
+    set &= ~same;
+    clear &= ~same;
+    uint32_t touch = set | clear;
+    if (!touch) return;
+    stat_add(&wstats.coalesced, __builtin_popcount(touch & pend_mask));    // 아직 쓰지 않은 값이 덮였다
+    if (coalescing) {
+        uint32_t defer = touch & ~nc;
+        uint32_t pend = pend_mask | defer;
+        pend_high = (pend_high & ~defer) | (set & defer);
+        pend &= ~(hw_known & ~(hw_high ^ pend_high));              // 실제 핀 값으로 돌아왔으면 쓸 것이 없다
+        __atomic_store_n(&pend_mask, pend, __ATOMIC_RELAXED);
+        set &= nc;
+        clear &= nc;
+    } else {
+        __atomic_store_n(&pend_mask, pend_mask & ~touch, __ATOMIC_RELAXED);
+        uint32_t hw_same = hw_known & ((set & hw_high) | (clear & ~hw_high));
+        stat_add(&wstats.elided, __builtin_popcount(hw_same));
+        set &= ~hw_same;
+        clear &= ~hw_same;
+    }
+    hw_write_mask(set, clear);
+}
+
+// GPIO 0~31 쓰기 (set과 clear가 겹치면 set). 모을 것도 모아 둔 것도 없으면 뮤텍스 없이 쓴다
+static void write_mask(uint32_t set, uint32_t clear) {
+    clear &= ~set;
+    if (!coalescing && !(__atomic_load_n(&pend_mask, __ATOMIC_RELAXED) & (set | clear))) {
+        uint32_t same = (uint32_t)cached_same(set, clear);
+        stat_add(&wstats.elided, __builtin_popcount(same));
+        hw_write_mask(set & ~same, clear & ~same);
+        return;
+    }
+    pthread_mutex_lock(&write_mutex);
+    write_mask_locked(set, clear);
+    pthread_mutex_unlock(&write_mutex);
+}
+
+// 모아 둔 값을 버린다
+static void drop_pending(uint64_t bit) {
+    if (!(__atomic_load_n(&pend_mask, __ATOMIC_RELAXED) & bit)) return;
+    pthread_mutex_lock(&write_mutex);
+    __atomic_store_n(&pend_mask, pend_mask & ~(uint32_t)bit, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&write_mutex);
+}
+
+// 캐시한 레벨을 버린다 (모드 변경, PWM 출력)
+static void forget_level(int pin) {
+    uint64_t bit = pin_bit(pin);
+    if (!bit) return;
+    pins_lock(bit);
+    __atomic_fetch_and(&known_mask, ~bit, __ATOMIC_RELAXED);
+    pins_unlock(bit);
+    drop_pending(bit);
+}
+
+int gpio_init(const char *backend_name) {
+    memset(mode_cache, 0, sizeof(mode_cache));
+    // 다른 스레드가 쓰기 전 (main에서 한 번)
+    known_mask = high_mask = nocache_mask = busy_mask = 0;
+    pend_mask = pend_high = 0;
+    memset(&wstats, 0, sizeof(wstats));
+    if (!backend_name) {
+        backend = backends[0];
+        return 0;
+    }
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        if (strcmp(backends[i]->name, backend_name) == 0) {
+            backend = backends[i];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char *gpio_backend_name(void) {
+    return backend ? backend->name : "none";
+}
+
+int gpio_setup(void) {
+    if (!backend) gpio_init(NULL);
+    return backend->setup();
+}
+
+void gpio_pin_mode(int pin, int mode) {
+    if (cached_mode_matches(pin, mode)) return;
+    forget_level(pin);
+    backend->pin_mode(pin, mode);
+    cache_mode(pin, mode);
+}
+
+int gpio_get_mode(int pin) {
+    if (pin < 0 || pin >= GPIO_MAX_PINS) return -1;
+    return __atomic_load_n(&mode_cache[pin], __ATOMIC_RELAXED) - 1;
+}
+
+void gpio_write(int pin, int value) {
+    uint64_t bit = pin_bit(pin);
+    if (!bit) {
+        backend->write(pin, value);
+    } else if (bit >> 32 == 0) {
+        write_mask(value ? (uint32_t)bit : 0, value ? 0 : (uint32_t)bit);
+    } else if (cached_same(value ? bit : 0, value ? 0 : bit)) {
+        stat_add(&wstats.elided, 1);
+    } else {
+        hw_write_mask(value ? bit : 0, value ? 0 : bit);
+    }
+}
+
+void gpio_write_mask(uint32_t set_mask, uint32_t clear_mask) {
+    write_mask(set_mask, clear_mask);
+}
+
+// 모아 둔 값이 있으면 그 값을 돌려준다 (명령 직후 조회가 이전 값을 보지 않도록)
+// 입력 엔진이 잡은 핀은 마지막 엣지로 정해진 레벨을 돌려준다 (백엔드 읽기 없음)
+int gpio_read(int pin) {
+    uint32_t bit = (uint32_t)pin_bit(pin);
+    if (bit && (__atomic_load_n(&pend_mask, __ATOMIC_RELAXED) & bit)) {
+        pthread_mutex_lock(&write_mutex);
+        int pending = (pend_mask & bit) != 0;
+        int value = (pend_high & bit) != 0;
+        pthread_mutex_unlock(&write_mutex);
+        if (pending) return value;
+    }
+    int (*source)(int) = __atomic_load_n(&level_source, __ATOMIC_ACQUIRE);
+    if (source) {
+        int level = source(pin);
+        if (level >= 0) return level;
+    }
+    return backend->read(pin);
+}
+
+void gpio_set_level_source(int (*fn)(int pin)) {
+    __atomic_store_n(&level_source, fn, __ATOMIC_RELEASE);
+}
+
+void gpio_pwm_write(int pin, int value) {
+    forget_level(pin);
+    backend->pwm_write(pin, value);
+}
+
+int gpio_pwm_hw(int pin) {
+    return backend->pwm_hw && backend->pwm_hw(pin);
+}
+
+void gpio_pull_up_dn(int pin, int pud) {
+    backend->pull_up_dn(pin, pud);
+}
+
+int gpio_isr(int pin, int edge, void (*fn)(void)) {
+    return backend->isr(pin, edge, fn);
+}
+
+int gpio_tone_create(int pin) {
+    // softTone은 내부에서 핀을 OUTPUT으로 바꾼다
+    cache_mode(pin, GPIO_OUTPUT);
+    uint64_t bit = pin_bit(pin);
+    pins_lock(bit);
+    __atomic_fetch_or(&nocache_mask, bit, __ATOMIC_RELAXED);
+    __atomic_fetch_and(&known_mask, ~bit, __ATOMIC_RELAXED);
+    pins_unlock(bit);
+    drop_pending(bit);
+    return backend->tone_create(pin);
+}
+
+void gpio_tone_write(int pin, int freq) {
+    backend->tone_write(pin, freq);
+}
+
+void gpio_coalesce_begin(void) {
+    coalescing = 1;
+}
+
+int gpio_coalesce_end(void) {
+    coalescing = 0;
+    return __atomic_load_n(&pend_mask, __ATOMIC_RELAXED) != 0;
+}
+
+void gpio_coalesce_flush(void) {
+    pthread_mutex_lock(&write_mutex);
+    uint32_t set = pend_mask & pend_high, clear = pend_mask & ~pend_high;
+    __atomic_store_n(&pend_mask, 0, __ATOMIC_RELAXED);
+    hw_write_mask(set, clear);
+    pthread_mutex_unlock(&write_mutex);
+}
+
+void gpio_get_write_stats(struct gpio_write_stats *s) {
+    s->writes = __atomic_load_n(&wstats.writes, __ATOMIC_RELAXED);
+    s->elided = __atomic_load_n(&wstats.elided, __ATOMIC_RELAXED);
+    s->coalesced = __atomic_load_n(&wstats.coalesced, __ATOMIC_RELAXED);
+}
+
+unsigned long gpio_millis(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+}
+
+void gpio_delay(unsigned int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) < 0) { }
+}
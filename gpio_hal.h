@@ -0,0 +1,75 @@
+#ifndef GPIO_HAL_H
+#define GPIO_HAL_H
+
+#include <stdint.h>
+
+// 핀 모드 / 풀업 / 인터럽트 엣지 (wiringPi 상수와 같은 값)
+#define GPIO_INPUT 0
+#define GPIO_OUTPUT 1
+#define GPIO_PWM_OUTPUT 2
+
+#define GPIO_PUD_OFF 0
+#define GPIO_PUD_DOWN 1
+#define GPIO_PUD_UP 2
+
+#define GPIO_EDGE_FALLING 1
+#define GPIO_EDGE_RISING 2
+#define GPIO_EDGE_BOTH 3
+
+#define GPIO_MAX_PINS 64
+
+// BCM2711에서 PWM0/PWM1 채널로 쓸 수 있는 핀 (12/18: PWM0, 13/19: PWM1)
+#define GPIO_PWM_HW_PINS ((1ull << 12) | (1ull << 13) | (1ull << 18) | (1ull << 19))
+
+// GPIO 백엔드 인터페이스 (wiringPi, 시뮬레이션 등)
+struct gpio_backend {
+    const char *name;
+    int (*setup)(void);
+    void (*pin_mode)(int pin, int mode);
+    void (*write)(int pin, int value);
+    int (*read)(int pin);
+    void (*pwm_write)(int pin, int value);
+    void (*pull_up_dn)(int pin, int pud);
+    int (*isr)(int pin, int edge, void (*fn)(void));
+    int (*tone_create)(int pin);
+    void (*tone_write)(int pin, int freq);
+    void (*write_mask)(uint32_t set_mask, uint32_t clear_mask); // GPIO 0~31 일괄 쓰기 (없으면 핀별로 처리)
+    int (*pwm_hw)(int pin);     // 하드웨어 PWM 채널이 있는 핀이면 1 (없으면 모든 핀이 소프트웨어 PWM)
+};
+
+int gpio_init(const char *backend_name); // NULL이면 기본 백엔드, 없는 이름이면 -1
+const char *gpio_backend_name(void);
+
+int gpio_setup(void);
+void gpio_pin_mode(int pin, int mode);
+int gpio_get_mode(int pin);                      // 마지막으로 설정한 모드, 아직 모르면 -1
+void gpio_write(int pin, int value);
+void gpio_write_mask(uint32_t set_mask, uint32_t clear_mask); // 여러 핀을 한 번에 (GPIO 0~31)
+int gpio_read(int pin);
+void gpio_pwm_write(int pin, int value);          // 듀티 0~255 (PWM_OUTPUT 모드)
+int gpio_pwm_hw(int pin);                        // 하드웨어 PWM을 쓸 수 있는 핀이면 1
+void gpio_pull_up_dn(int pin, int pud);
+int gpio_isr(int pin, int edge, void (*fn)(void));
+void gpio_set_level_source(int (*fn)(int pin)); // gpio_read가 먼저 물어볼 입력 레벨 (-1이면 백엔드, NULL이면 해제)
+int gpio_tone_create(int pin);
+void gpio_tone_write(int pin, int freq);
+
+// 출력 쓰기 생략/모으기
+// - 핀마다 마지막으로 쓴 레벨을 기억해 같은 값 쓰기는 백엔드까지 가지 않는다 (모드가 바뀌면 다시 씀)
+// - begin~end 사이에 이 스레드가 쓴 GPIO 0~31 값은 바로 쓰지 않고 모아 둔다. 같은 핀은 마지막 값만 남고
+//   gpio_coalesce_flush가 마스크 한 번으로 쓴다. 그 사이 gpio_read는 모아 둔 값을 돌려준다
+struct gpio_write_stats {
+    uint64_t writes;        // 실제로 쓴 핀 수
+    uint64_t elided;        // 값이 같아 생략한 핀 수
+    uint64_t coalesced;     // 쓰기 전에 새 값으로 덮인 핀 수
+};
+
+void gpio_coalesce_begin(void);
+int gpio_coalesce_end(void);                     // 모아 둔 값이 남아 있으면 1
+void gpio_coalesce_flush(void);
+void gpio_get_write_stats(struct gpio_write_stats *s);
+
+unsigned long gpio_millis(void);  // 단조 시계 기준 밀리초
+void gpio_delay(unsigned int ms);
+
+#endif
@@ -0,0 +1,250 @@
+/**
+ * gpio_lines.c - GPIO 문자 장치 입력 엔진
+ *
+ * GPIO_V2_GET_LINE_IOCTL로 입력 핀들을 한 요청에 양쪽 엣지 감지로 잡는다. 풀업/풀다운은 핀마다
+ * 다를 수 있으므로 핀별 플래그 속성(GPIO_V2_LINE_ATTR_ID_FLAGS)으로 준다.
+ * 처음 레벨은 GPIO_V2_LINE_GET_VALUES_IOCTL로 읽고, 이후에는 엣지로만 갱신한다.
+ * 이벤트의 seqno(요청 전체 순번)에 틈이 생기면 커널 버퍼가 넘쳐 잃은 것으로 센다. 그 뒤에는
+ * 기억한 레벨이 틀릴 수 있으므로 다시 읽는다.
+ *
+ * mock: 파이프의 읽는 쪽을 요청 fd처럼 쓴다. gpio_lines_mock_input이 커널처럼 엣지를 판정해
+ * struct gpio_v2_line_event를 쓴다 (PIPE_BUF보다 작아 한 번에 들어감). 읽는 경로는 실제 장치와 같다.
+ * 파이프가 가득 차면 그 이벤트는 버리지만 순번은 올리므로, 읽는 쪽에서 커널 버퍼 초과와 똑같이 보인다.
+ */
+#define _GNU_SOURCE
+#include "gpio_lines.h"
+#include "gpio_hal.h"
+#include "event_loop.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+struct line {
+    struct gpio_line_config cfg;
+    int level;                  // 아무 스레드에서 읽는다 (원자적)
+    uint64_t last_ns;           // 마지막으로 알린 엣지의 커널 시각
+    int mock_level;             // mock: 마지막으로 넣은 레벨 (mock_mutex)
+    uint32_t mock_seqno;
+};
+
+static struct line lines[GPIO_LINES_MAX];
+static int num_lines = 0;       // 아무 스레드에서 읽는다 (원자적)
+static int line_fd = -1;
+static const char *chip_name = NULL;
+static pin_event_fn event_fn = NULL;
+static void *event_arg = NULL;
+static uint32_t last_seqno = 0;
+static struct gpio_lines_stats stats;   // 이벤트 루프 스레드가 쓰고 아무 스레드에서 읽는다
+
+// mock 장치 (쓰는 쪽은 아무 스레드)
+static pthread_mutex_t mock_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int mock_fd = -1;
+static uint32_t mock_seqno = 0;
+
+static inline void stat_add(uint64_t *v, uint64_t n) {
+    __atomic_add_fetch(v, n, __ATOMIC_RELAXED);
+}
+
+static struct line *find_line(int pin) {
+    int n = __atomic_load_n(&num_lines, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < n; i++)
+        if (lines[i].cfg.pin == pin) return &lines[i];
+    return NULL;
+}
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// 라인 요청을 만들고 요청 fd를 돌려준다 (칩 fd는 요청 뒤 필요 없음)
+static int request_lines(const char *chip) {
+    int fd = open(chip, O_RDWR | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct gpio_v2_line_request req;
+    memset(&req, 0, sizeof(req));
+    strncpy(req.consumer, "gpio_daemon", sizeof(req.consumer) - 1);
+    req.num_lines = num_lines;
+    req.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+    for (int i = 0; i < num_lines; i++) {
+        req.offsets[i] = lines[i].cfg.pin;
+        uint64_t bias = lines[i].cfg.pud == GPIO_PUD_UP ? GPIO_V2_LINE_FLAG_BIAS_PULL_UP :
+                        lines[i].cfg.pud == GPIO_PUD_DOWN ? GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN : 0;
+        if (!bias) continue;
+        struct gpio_v2_line_config_attribute *a = &req.config.attrs[req.config.num_attrs++];
+        a->attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+        a->attr.flags = req.config.flags | bias;
+        a->mask = 1ull << i;
+    }
+    int rc = ioctl(fd, GPIO_V2_GET_LINE_IOCTL, &req);
+    int err = errno;
+    close(fd);
+    if (rc < 0) {
+        errno = err;
+        return -1;
+    }
+    fcntl(req.fd, F_SETFL, fcntl(req.fd, F_GETFL) | O_NONBLOCK);
+    return req.fd;
+}
+
+// 현재 레벨을 다시 읽는다 (처음 열 때, 이벤트를 잃은 뒤)
+static void read_levels(void) {
+    if (mock_fd >= 0) {
+        pthread_mutex_lock(&mock_mutex);
+        for (int i = 0; i < num_lines; i++) __atomic_store_n(&lines[i].level, lines[i].mock_level, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&mock_mutex);
+        return;
+    }
+    struct gpio_v2_line_values v = {0, (1ull << num_lines) - 1};
+    if (ioctl(line_fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &v) < 0) return;
+    for (int i = 0; i < num_lines; i++) __atomic_store_n(&lines[i].level, (int)((v.bits >> i) & 1), __ATOMIC_RELAXED);
+}
+
+static void handle_event(const struct gpio_v2_line_event *ev) {
+    struct line *l = find_line((int)ev->offset);
+    if (!l) return;
+    stat_add(&stats.edges, 1);
+    int rising = ev->id == GPIO_V2_LINE_EVENT_RISING_EDGE;
+    __atomic_store_n(&l->level, rising, __ATOMIC_RELAXED);
+    if (!(l->cfg.edge & (rising ? GPIO_EDGE_RISING : GPIO_EDGE_FALLING))) return;
+    if (l->last_ns && ev->timestamp_ns - l->last_ns < (uint64_t)l->cfg.debounce_us * 1000) {
+        stat_add(&stats.debounced, 1);
+        return;
+    }
+    l->last_ns = ev->timestamp_ns;
+    stat_add(&stats.notified, 1);
+    struct pin_event pe = {ev->timestamp_ns, (uint8_t)l->cfg.device, (uint8_t)l->cfg.pin, (int16_t)rising};
+    event_fn(&pe, event_arg);
+}
+
+// 요청 fd가 읽을 수 있으면 한 묶음만 처리 (남았으면 epoll이 다시 깨운다)
+static void on_lines(int fd, uint32_t events, void *arg) {
+    (void)events;
+    (void)arg;
+    struct gpio_v2_line_event buf[GPIO_LINES_BATCH];
+    ssize_t r = read(fd, buf, sizeof(buf));
+    if (r == 0 || (r < 0 && errno != EAGAIN && errno != EINTR)) {
+        event_loop_del(fd);   // 장치가 사라짐: 이후 레벨은 마지막 값 그대로
+        return;
+    }
+    if (r < (ssize_t)sizeof(buf[0])) return;
+    stat_add(&stats.reads, 1);
+    int resync = 0;
+    size_t n = (size_t)r / sizeof(buf[0]);
+    for (size_t i = 0; i < n; i++) {
+        if (last_seqno && buf[i].seqno != last_seqno + 1) {
+            stat_add(&stats.lost, buf[i].seqno - last_seqno - 1);
+            resync = 1;
+        }
+        last_seqno = buf[i].seqno;
+        handle_event(&buf[i]);
+    }
+    if (resync) read_levels();
+}
+
+int gpio_lines_open(const char *chip, const struct gpio_line_config *cfg, int n, pin_event_fn fn, void *arg) {
+    if (line_fd >= 0 || n < 1 || n > GPIO_LINES_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    memset(lines, 0, sizeof(lines));
+    for (int i = 0; i < n; i++) {
+        lines[i].cfg = cfg[i];
+        lines[i].mock_level = cfg[i].pud == GPIO_PUD_UP;    // 아무것도 연결되지 않은 입력
+    }
+    num_lines = n;
+    int fd;
+    if (strcmp(chip, GPIO_LINES_MOCK) == 0) {
+        int p[2];
+        if (pipe2(p, O_CLOEXEC | O_NONBLOCK) < 0) return -1;
+        fd = p[0];
+        pthread_mutex_lock(&mock_mutex);
+        mock_fd = p[1];
+        mock_seqno = 0;
+        pthread_mutex_unlock(&mock_mutex);
+    } else if ((fd = request_lines(chip)) < 0) {
+        num_lines = 0;
+        return -1;
+    }
+    line_fd = fd;
+    last_seqno = 0;
+    event_fn = fn;
+    event_arg = arg;
+    chip_name = chip;
+    read_levels();
+    if (event_loop_add(fd, EPOLLIN, on_lines, NULL) < 0) {
+        int err = errno;
+        gpio_lines_close();
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+void gpio_lines_close(void) {
+    if (line_fd < 0) return;
+    __atomic_store_n(&num_lines, 0, __ATOMIC_RELEASE);
+    event_loop_del(line_fd);
+    close(line_fd);
+    line_fd = -1;
+    pthread_mutex_lock(&mock_mutex);
+    if (mock_fd >= 0) close(mock_fd);
+    mock_fd = -1;
+    pthread_mutex_unlock(&mock_mutex);
+    chip_name = NULL;
+}
+
+const char *gpio_lines_chip(void) {
+    return chip_name;
+}
+
+int gpio_lines_level(int pin) {
+    struct line *l = find_line(pin);
+    return l ? __atomic_load_n(&l->level, __ATOMIC_RELAXED) : -1;
+}
+
+int gpio_lines_set_debounce(int pin, uint32_t us) {
+    struct line *l = find_line(pin);
+    if (!l || us > GPIO_LINES_DEBOUNCE_MAX_US) return -1;
+    l->cfg.debounce_us = us;
+    return 0;
+}
+
+long gpio_lines_get_debounce(int pin) {
+    struct line *l = find_line(pin);
+    return l ? (long)l->cfg.debounce_us : -1;
+}
+
+void gpio_lines_get_stats(struct gpio_lines_stats *s) {
+    s->edges = __atomic_load_n(&stats.edges, __ATOMIC_RELAXED);
+    s->notified = __atomic_load_n(&stats.notified, __ATOMIC_RELAXED);
+    s->debounced = __atomic_load_n(&stats.debounced, __ATOMIC_RELAXED);
+    s->reads = __atomic_load_n(&stats.reads, __ATOMIC_RELAXED);
+    s->lost = __atomic_load_n(&stats.lost, __ATOMIC_RELAXED);
+}
+
+void gpio_lines_mock_input(int pin, int value) {
+    value = value ? 1 : 0;
+    pthread_mutex_lock(&mock_mutex);
+    struct line *l = mock_fd >= 0 ? find_line(pin) : NULL;
+    if (l && l->mock_level != value) {
+        l->mock_level = value;
+        struct gpio_v2_line_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.timestamp_ns = monotonic_ns();
+        ev.id = value ? GPIO_V2_LINE_EVENT_RISING_EDGE : GPIO_V2_LINE_EVENT_FALLING_EDGE;
+        ev.offset = (uint32_t)pin;
+        ev.seqno = ++mock_seqno;
+        ev.line_seqno = ++l->mock_seqno;
+        // 가득 차면 버린다 (순번은 이미 올렸으므로 읽는 쪽이 잃은 것으로 센다)
+        if (write(mock_fd, &ev, sizeof(ev)) < 0) { }
+    }
+    pthread_mutex_unlock(&mock_mutex);
+}
@@ -0,0 +1,52 @@
+#ifndef GPIO_LINES_H
+#define GPIO_LINES_H
+
+#include <stdint.h>
+#include "pin_events.h"
+
+/*
+ * GPIO 문자 장치(/dev/gpiochipN) 입력 엔진
+ * - 입력 핀들을 라인 요청(GPIO v2 uAPI) 하나로 잡고, 엣지마다 커널이 찍은 시각(CLOCK_MONOTONIC)을 받는다.
+ *   요청 fd를 이벤트 루프에 등록하므로 인터럽트 스레드가 없다
+ * - 깨어날 때 read 한 번으로 이벤트를 최대 GPIO_LINES_BATCH개 읽는다
+ * - 양쪽 엣지를 모두 받아 핀 레벨을 기억한다 (gpio_read가 백엔드를 읽지 않고 이 값을 씀).
+ *   알림은 설정한 엣지만, 핀별 디바운스를 거쳐 보낸다
+ * - 디바운스는 앞 엣지를 바로 알리고 그 뒤 기간 동안 같은 핀의 엣지를 버린다 (커널 시각 기준).
+ *   커널 디바운스는 선이 안정될 때까지 기다렸다 알리므로 누른 시각이 그만큼 늦어져 쓰지 않는다
+ * - "mock"은 같은 이벤트 구조체를 파이프로 흘려 보내는 대체 장치다 (gpio_lines_mock_input으로 입력 변경)
+ * - gpio_lines_open/close/set_debounce는 이벤트 루프 스레드에서만 호출할 것
+ */
+
+#define GPIO_LINES_CHIP "/dev/gpiochip0"
+#define GPIO_LINES_MOCK "mock"
+#define GPIO_LINES_MAX 8            // 한 번에 잡는 최대 핀 수
+#define GPIO_LINES_BATCH 16         // read 한 번에 읽는 최대 이벤트 수
+#define GPIO_LINES_DEBOUNCE_MAX_US 10000000
+
+struct gpio_line_config {
+    int pin;                // 칩의 라인 번호 (라즈베리파이 gpiochip0은 BCM 번호와 같음)
+    int device;             // 알림의 enum proto_device
+    int edge;               // 알릴 엣지 GPIO_EDGE_* (0이면 레벨만 추적)
+    int pud;                // GPIO_PUD_*
+    uint32_t debounce_us;
+};
+
+struct gpio_lines_stats {
+    uint64_t edges;         // 받은 엣지
+    uint64_t notified;      // 알린 엣지
+    uint64_t debounced;     // 디바운스로 버린 엣지
+    uint64_t reads;         // read 호출 수
+    uint64_t lost;          // 커널 버퍼가 넘쳐 잃은 엣지 (순번 틈)
+};
+
+// 0 성공, -1 실패 (칩이 없거나 라인을 잡을 수 없음, errno 유지)
+int gpio_lines_open(const char *chip, const struct gpio_line_config *cfg, int n, pin_event_fn fn, void *arg);
+void gpio_lines_close(void);
+const char *gpio_lines_chip(void);                  // 연 칩, 닫혀 있으면 NULL
+int gpio_lines_level(int pin);                      // 잡은 핀이면 0/1, 아니면 -1 (아무 스레드)
+int gpio_lines_set_debounce(int pin, uint32_t us);  // 잡은 핀이 아니면 -1
+long gpio_lines_get_debounce(int pin);              // us, 잡은 핀이 아니면 -1
+void gpio_lines_get_stats(struct gpio_lines_stats *s);
+void gpio_lines_mock_input(int pin, int value);     // mock 칩의 입력 변경, 엣지가 생기면 이벤트 (아무 스레드)
+
+#endif
@@ -0,0 +1,212 @@
+/**
+ * gpio_mmap.c - BCM GPIO 레지스터를 직접 매핑하는 백엔드
+ *
+ * /dev/gpiomem(또는 GPIO_MEM_DEVICE 환경변수로 지정한 파일)을 mmap하고
+ * GPSET/GPCLR 레지스터에 마스크를 써서 여러 핀을 한 번에 바꾼다.
+ * 일반 파일을 지정하면 하드웨어 대신 파일이 레지스터 역할을 하며,
+ * SET/CLR 쓰기가 LEV 레지스터에 반영되도록 흉내낸다 (테스트용).
+ *
+ * 인터럽트는 LEV 레지스터를 1ms 간격으로 확인하는 스레드로, 톤은 핀을 토글하는 스레드로 구현한다.
+ */
+#include "gpio_hal.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define GPIO_MEM_DEFAULT "/dev/gpiomem"
+#define GPIO_MEM_SIZE 4096
+
+// 레지스터 워드 오프셋 (BCM2711 기준)
+#define REG_FSEL0 0           // 0x00, 핀당 3비트
+#define REG_SET0 7            // 0x1C
+#define REG_CLR0 10           // 0x28
+#define REG_LEV0 13           // 0x34
+#define REG_PUP_PDN0 57       // 0xE4, 핀당 2비트 (00 없음, 01 풀업, 10 풀다운)
+
+#define BCM_PINS 58
+#define ISR_POLL_US 1000      // 인터럽트 대신 레벨을 확인하는 주기
+
+static volatile uint32_t *reg = NULL;
+static int emulate = 0;                      // 파일 대체물이면 LEV 레지스터를 직접 갱신
+static pthread_mutex_t fsel_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// 엣지 감지 폴링 스레드 상태
+static void (*isr_fn[BCM_PINS])(void);
+static int isr_edge[BCM_PINS];
+static int isr_thread_started = 0;
+
+// 소프트웨어 톤 상태
+static volatile int tone_freq[BCM_PINS];
+static int tone_started[BCM_PINS];
+
+static void set_clr(int bank, uint32_t set_mask, uint32_t clear_mask) {
+    // 하드웨어에서는 SET/CLR 각각이 한 번의 레지스터 쓰기로 해당 비트를 동시에 바꾼다
+    if (clear_mask) reg[REG_CLR0 + bank] = clear_mask;
+    if (set_mask) reg[REG_SET0 + bank] = set_mask;
+    if (emulate) reg[REG_LEV0 + bank] = (reg[REG_LEV0 + bank] & ~clear_mask) | set_mask;
+}
+
+static int mm_setup(void) {
+    if (reg) return 0;
+    const char *path = getenv("GPIO_MEM_DEVICE");
+    if (!path || !*path) path = GPIO_MEM_DEFAULT;
+    int fd = open(path, O_RDWR | O_SYNC | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        emulate = 1;
+        if (st.st_size < GPIO_MEM_SIZE && ftruncate(fd, GPIO_MEM_SIZE) < 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    void *p = mmap(NULL, GPIO_MEM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return -1;
+    reg = p;
+    return 0;
+}
+
+static int valid_pin(int pin) {
+    return reg && pin >= 0 && pin < BCM_PINS;
+}
+
+static void mm_pin_mode(int pin, int mode) {
+    if (!valid_pin(pin)) return;
+    // PWM 블록은 gpiomem으로 접근할 수 없으므로 PWM_OUTPUT도 일반 출력으로 설정
+    uint32_t fsel = mode == GPIO_INPUT ? 0 : 1;
+    int r = REG_FSEL0 + pin / 10, shift = (pin % 10) * 3;
+    pthread_mutex_lock(&fsel_mutex);
+    reg[r] = (reg[r] & ~(7u << shift)) | (fsel << shift);
+    pthread_mutex_unlock(&fsel_mutex);
+}
+
+static void mm_write(int pin, int value) {
+    if (!valid_pin(pin)) return;
+    uint32_t bit = 1u << (pin & 31);
+    set_clr(pin >> 5, value ? bit : 0, value ? 0 : bit);
+}
+
+static int mm_read(int pin) {
+    if (!valid_pin(pin)) return 0;
+    return (reg[REG_LEV0 + (pin >> 5)] >> (pin & 31)) & 1;
+}
+
+static void mm_write_mask(uint32_t set_mask, uint32_t clear_mask) {
+    if (!reg) return;
+    set_clr(0, set_mask, clear_mask & ~set_mask);
+}
+
+// PWM 블록에 접근할 수 없으므로 pwm_hw가 없다 (PWM 엔진이 모든 핀을 소프트웨어로 구동)
+static void mm_pwm_write(int pin, int value) {
+    // 엔진을 거치지 않고 직접 부른 경우만: 듀티 절반 이상이면 HIGH로 근사
+    mm_write(pin, value >= 128);
+}
+
+static void mm_pull_up_dn(int pin, int pud) {
+    if (!valid_pin(pin)) return;
+    uint32_t bits = pud == GPIO_PUD_UP ? 1 : pud == GPIO_PUD_DOWN ? 2 : 0;
+    int r = REG_PUP_PDN0 + pin / 16, shift = (pin % 16) * 2;
+    pthread_mutex_lock(&fsel_mutex);
+    reg[r] = (reg[r] & ~(3u << shift)) | (bits << shift);
+    pthread_mutex_unlock(&fsel_mutex);
+}
+
+static void sleep_us(long us) {
+    struct timespec ts = { us / 1000000, (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+// 등록된 핀의 레벨 변화를 감지해 콜백 호출
+static void *isr_poll_thread(void *arg) {
+    (void)arg;
+    uint32_t last[2] = { reg[REG_LEV0], reg[REG_LEV0 + 1] };
+    while (1) {
+        sleep_us(ISR_POLL_US);
+        uint32_t now[2] = { reg[REG_LEV0], reg[REG_LEV0 + 1] };
+        for (int bank = 0; bank < 2; bank++) {
+            uint32_t changed = now[bank] ^ last[bank];
+            while (changed) {
+                int bit = __builtin_ctz(changed);
+                changed &= changed - 1;
+                int pin = bank * 32 + bit;
+                if (pin >= BCM_PINS || !isr_fn[pin]) continue;
+                int rising = (now[bank] >> bit) & 1;
+                if ((rising && (isr_edge[pin] & GPIO_EDGE_RISING)) ||
+                    (!rising && (isr_edge[pin] & GPIO_EDGE_FALLING))) {
+                    isr_fn[pin]();
+                }
+            }
+            last[bank] = now[bank];
+        }
+    }
+    return NULL;
+}
+
+static int mm_isr(int pin, int edge, void (*fn)(void)) {
+    if (!valid_pin(pin)) return -1;
+    isr_edge[pin] = edge;
+    isr_fn[pin] = fn;
+    if (!isr_thread_started) {
+        pthread_t t;
+        if (pthread_create(&t, NULL, isr_poll_thread, NULL) != 0) return -1;
+        pthread_detach(t);
+        isr_thread_started = 1;
+    }
+    return 0;
+}
+
+// 핀 하나를 주파수에 맞춰 토글하는 톤 스레드 (softTone과 같은 방식)
+static void *tone_thread(void *arg) {
+    int pin = (int)(intptr_t)arg;
+    while (1) {
+        int freq = tone_freq[pin];
+        if (freq <= 0) {
+            sleep_us(1000);
+            continue;
+        }
+        long half = 500000L / freq;
+        mm_write(pin, 1);
+        sleep_us(half);
+        mm_write(pin, 0);
+        sleep_us(half);
+    }
+    return NULL;
+}
+
+static int mm_tone_create(int pin) {
+    if (!valid_pin(pin)) return -1;
+    if (tone_started[pin]) return 0;
+    mm_pin_mode(pin, GPIO_OUTPUT);
+    mm_write(pin, 0);
+    pthread_t t;
+    if (pthread_create(&t, NULL, tone_thread, (void *)(intptr_t)pin) != 0) return -1;
+    pthread_detach(t);
+    tone_started[pin] = 1;
+    return 0;
+}
+
+static void mm_tone_write(int pin, int freq) {
+    if (!valid_pin(pin)) return;
+    tone_freq[pin] = freq;
+}
+
+const struct gpio_backend gpio_mmap_backend = {
+    .name = "mmap",
+    .setup = mm_setup,
+    .pin_mode = mm_pin_mode,
+    .write = mm_write,
+    .read = mm_read,
+    .pwm_write = mm_pwm_write,
+    .pull_up_dn = mm_pull_up_dn,
+    .isr = mm_isr,
+    .tone_create = mm_tone_create,
+    .tone_write = mm_tone_write,
+    .write_mask = mm_write_mask,
+};
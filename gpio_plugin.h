@@ -0,0 +1,39 @@
+#ifndef GPIO_PLUGIN_H
+#define GPIO_PLUGIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "command.h"
+
+/*
+ * 디바이스 플러그인 ABI
+ * - 디바이스 모듈(led.c 등)은 기술자(struct gpio_plugin) 하나를 <이름>_plugin 심볼로 내보낸다
+ * - 같은 소스가 데몬에 내장 모듈로 링크되고, <이름>.so로도 빌드된다 (.so가 있으면 그쪽을 쓴다)
+ * - .so는 -fvisibility=hidden으로 빌드해 기술자만 보이게 하고, GPIO/상태/로그 함수는 데몬(-rdynamic)에서 가져온다
+ * - 구조체를 바꾸면 GPIO_PLUGIN_ABI를 올릴 것. 데몬은 ABI가 다른 .so를 거부한다
+ */
+
+#define GPIO_PLUGIN_ABI 1
+
+// init/teardown 인자
+enum gpio_plugin_flags {
+    GPIO_PLUGIN_RELOAD = 1  // 핫 스왑 중: 출력 상태를 건드리지 말고 모듈 자원만 준비/정리
+};
+
+struct gpio_plugin {
+    uint32_t abi;                       // GPIO_PLUGIN_ABI
+    const char *name;                   // 모듈 이름 = .so 파일 이름 (led → led.so)
+    uint32_t version;                   // 모듈 자체 버전 (PLUGIN:LIST 표시용)
+    int device;                         // enum proto_device
+    int (*init)(int flags);             // 0 또는 -1
+    void (*teardown)(int flags);
+    uint32_t (*off_mask)(void);         // ALL_OFF 때 LOW로 내릴 핀 마스크 (출력 장치가 아니면 NULL)
+    int (*read)(void);                  // 입력 값 읽기 (샘플러용, 입력 장치가 아니면 NULL)
+    const struct command_def *commands; // opcode는 내장 모듈이 등록한 것 중에서만
+    size_t ncommands;
+};
+
+#define GPIO_PLUGIN_EXPORT(name) \
+    __attribute__((visibility("default"))) const struct gpio_plugin name##_plugin
+
+#endif
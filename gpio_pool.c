@@ -0,0 +1,162 @@
+/**
+ * gpio_pool.c - 여러 데몬에 대한 지속 연결 풀 (epoll 하나로 다중화)
+ *
+ * 연결 하나하나는 gpioclient가 맡고, 풀은 각 연결의 fd와 감시 이벤트를 epoll에 맞춰 둔다.
+ * gpioclient는 다시 연결할 때 fd를 닫고 새로 만들므로, 호출이 끝날 때마다 등록 상태를 맞춘다.
+ * 닫힌 fd는 epoll에서 자동으로 빠지므로 지우지 않고 새 fd만 추가한다.
+ */
+#include "gpio_pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/epoll.h>
+
+#define POOL_MAX_EVENTS 64
+
+struct pool_host {
+    struct gpioclient *client;
+    int fd;                 // epoll에 등록한 fd (-1이면 없음)
+    uint32_t events;
+};
+
+struct gpio_pool {
+    int epfd;
+    int nhosts;
+    struct pool_host *hosts;
+};
+
+static uint64_t pool_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// 연결의 현재 fd/이벤트를 epoll 등록에 반영
+static void host_sync(struct gpio_pool *p, int host) {
+    struct pool_host *h = &p->hosts[host];
+    int fd = gpioclient_fd(h->client);
+    uint32_t events = gpioclient_events(h->client);
+    if (fd == h->fd && events == h->events) return;
+    struct epoll_event ev = {.events = events, .data.u32 = (uint32_t)host};
+    if (fd >= 0 && fd == h->fd) epoll_ctl(p->epfd, EPOLL_CTL_MOD, fd, &ev);
+    else if (fd >= 0 && epoll_ctl(p->epfd, EPOLL_CTL_ADD, fd, &ev) < 0 && errno == EEXIST)
+        epoll_ctl(p->epfd, EPOLL_CTL_MOD, fd, &ev);
+    h->fd = fd;
+    h->events = events;
+}
+
+// 콜백이 다른 호스트에 요청을 보낼 수 있으므로 호출 뒤에는 모두 맞춘다
+static void pool_sync(struct gpio_pool *p) {
+    for (int i = 0; i < p->nhosts; i++) host_sync(p, i);
+}
+
+struct gpio_pool *gpio_pool_create(char *const hosts[], int nhosts, int default_port, int timeout_ms) {
+    if (nhosts < 1) return NULL;
+    struct gpio_pool *p = calloc(1, sizeof(*p));
+    if (!p) return NULL;
+    p->hosts = calloc(nhosts, sizeof(*p->hosts));
+    p->epfd = epoll_create1(0);
+    if (!p->hosts || p->epfd < 0) {
+        gpio_pool_destroy(p);
+        return NULL;
+    }
+    p->nhosts = nhosts;
+    for (int i = 0; i < nhosts; i++) {
+        struct pool_host *h = &p->hosts[i];
+        h->fd = -1;
+        h->client = gpioclient_new(hosts[i], default_port);
+        if (!h->client) {
+            gpio_pool_destroy(p);
+            return NULL;
+        }
+        gpioclient_set_id(h->client, i);
+        gpioclient_set_timeout(h->client, timeout_ms);
+        host_sync(p, i);
+    }
+    return p;
+}
+
+void gpio_pool_destroy(struct gpio_pool *p) {
+    if (!p) return;
+    for (int i = 0; p->hosts && i < p->nhosts; i++) gpioclient_free(p->hosts[i].client);
+    if (p->epfd >= 0) close(p->epfd);
+    free(p->hosts);
+    free(p);
+}
+
+int gpio_pool_size(const struct gpio_pool *p) {
+    return p->nhosts;
+}
+
+struct gpioclient *gpio_pool_client(struct gpio_pool *p, int host) {
+    return p->hosts[host].client;
+}
+
+void gpio_pool_on_event(struct gpio_pool *p, gpioclient_cb cb, void *arg) {
+    for (int i = 0; i < p->nhosts; i++) gpioclient_on_event(p->hosts[i].client, cb, arg);
+}
+
+int gpio_pool_pending(const struct gpio_pool *p) {
+    int n = 0;
+    for (int i = 0; i < p->nhosts; i++) n += gpioclient_pending(p->hosts[i].client);
+    return n;
+}
+
+int gpio_pool_send(struct gpio_pool *p, int host, const char *cmd, gpioclient_cb cb, void *arg) {
+    if (host < 0 || host >= p->nhosts) return ST_BAD_ARGS;
+    int status = gpioclient_send(p->hosts[host].client, cmd, cb, arg);
+    pool_sync(p);
+    return status;
+}
+
+int gpio_pool_broadcast(struct gpio_pool *p, const char *cmd, gpioclient_cb cb, void *arg) {
+    struct request req;
+    int status = proto_parse_text(cmd, &req);
+    if (status != ST_OK) return status;
+    for (int i = 0; i < p->nhosts; i++) {
+        struct request copy = req;
+        gpioclient_send_request(p->hosts[i].client, &copy, cb, arg);
+    }
+    pool_sync(p);
+    return ST_OK;
+}
+
+int gpio_pool_poll(struct gpio_pool *p, int timeout_ms) {
+    // 가장 이른 재연결/시간 초과 시각까지만 기다림
+    for (int i = 0; i < p->nhosts; i++) {
+        int next = gpioclient_next_timeout(p->hosts[i].client);
+        if (next >= 0 && (timeout_ms < 0 || next < timeout_ms)) timeout_ms = next;
+    }
+    struct epoll_event events[POOL_MAX_EVENTS];
+    int n = epoll_wait(p->epfd, events, POOL_MAX_EVENTS, timeout_ms);
+    if (n < 0) return errno == EINTR ? 0 : -1;
+    for (int i = 0; i < n; i++) gpioclient_handle(p->hosts[events[i].data.u32].client, events[i].events);
+    for (int i = 0; i < p->nhosts; i++) gpioclient_tick(p->hosts[i].client);
+    pool_sync(p);
+    return n;
+}
+
+int gpio_pool_run(struct gpio_pool *p, int timeout_ms) {
+    uint64_t end = pool_now_ns() + (uint64_t)timeout_ms * 1000000ULL;
+    while (gpio_pool_pending(p) > 0) {
+        uint64_t now = pool_now_ns();
+        if (now >= end || gpio_pool_poll(p, (int)((end - now + 999999) / 1000000)) < 0) break;
+    }
+    return gpio_pool_pending(p);
+}
+
+int gpio_pool_connect(struct gpio_pool *p, int timeout_ms) {
+    uint64_t end = pool_now_ns() + (uint64_t)timeout_ms * 1000000ULL;
+    for (;;) {
+        int up = 0;
+        for (int i = 0; i < p->nhosts; i++) up += gpioclient_state(p->hosts[i].client) == GPIOCLIENT_READY;
+        uint64_t now = pool_now_ns();
+        if (up == p->nhosts || now >= end) return up;
+        // 끊긴 호스트는 재시도 시각이 되면 tick에서 다시 연결된다
+        int wait = (int)((end - now + 999999) / 1000000);
+        if (wait > 10) wait = 10;
+        if (gpio_pool_poll(p, wait) < 0) return up;
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef GPIO_POOL_H
+#define GPIO_POOL_H
+
+#include "gpioclient.h"
+
+/*
+ * 여러 데몬(라즈베리파이)에 대한 지속 연결 풀
+ * - 호스트마다 gpioclient 연결 하나를 유지하고, 모두 epoll 하나로 다중화한다
+ * - 재연결 백오프, 응답 짝짓기, 시간 초과는 gpioclient가 처리한다
+ * - 결과의 id는 호스트 인덱스(생성 시 순서), name은 호스트 주소
+ * - 모든 함수는 같은 스레드에서 호출할 것 (콜백도 gpio_pool_poll 안에서 호출된다)
+ */
+
+struct gpio_pool;
+
+// hosts: "IP" 또는 "IP:포트", 포트가 없으면 default_port
+struct gpio_pool *gpio_pool_create(char *const hosts[], int nhosts, int default_port, int timeout_ms);
+void gpio_pool_destroy(struct gpio_pool *p);
+
+int gpio_pool_size(const struct gpio_pool *p);
+struct gpioclient *gpio_pool_client(struct gpio_pool *p, int host);
+void gpio_pool_on_event(struct gpio_pool *p, gpioclient_cb cb, void *arg); // 서버 알림 콜백
+
+// 텍스트 명령을 보낸다. 0 또는 명령을 해석하지 못한 경우 상태 코드 (콜백 없음)
+// 보낼 수 없는 호스트(연결 없음, 대기 요청 초과)는 콜백으로 바로 실패를 알린다.
+int gpio_pool_send(struct gpio_pool *p, int host, const char *cmd, gpioclient_cb cb, void *arg);
+int gpio_pool_broadcast(struct gpio_pool *p, const char *cmd, gpioclient_cb cb, void *arg);
+
+int gpio_pool_poll(struct gpio_pool *p, int timeout_ms);     // 루프 한 번, 처리한 이벤트 수 또는 -1
+int gpio_pool_run(struct gpio_pool *p, int timeout_ms);      // 대기 요청이 없어질 때까지, 남은 대기 요청 수
+int gpio_pool_connect(struct gpio_pool *p, int timeout_ms);  // 모두 연결되거나 시간이 다 될 때까지, 연결된 호스트 수
+int gpio_pool_pending(const struct gpio_pool *p);
+
+#endif
@@ -1,46 +1,123 @@
 // --- gpio_server_daemon.c ---
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <fcntl.h>
-#include <syslog.h>
 #include <errno.h>
+#include <stdarg.h>
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <pthread.h>
-#include <wiringPi.h>
-#include <dlfcn.h>
 #include <arpa/inet.h>
 #include <sys/stat.h>
+#include <sys/resource.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <limits.h>
 #include <time.h>
-#include "led.h"
+#include "event_loop.h"
+#include "ringbuf.h"
+#include "protocol.h"
+#include "command.h"
+#include "proto_verbs.h"
+#include "gpio_hal.h"
+#include "gpio_sim.h"
 #include "buzzer.h"
-#include "seg7.h"
-#include "pushbutton.h"
+#include "light_sensor.h"
+#include "plugin.h"
+#include "timer_wheel.h"
+#include "sequencer.h"
+#include "journal.h"
+#include "coalesce.h"
+#include "dev_exec.h"
+#include "gpio_lines.h"
+#include "pin_events.h"
+#include "event_queue.h"
+#include "sampler.h"
+#include "device_state.h"
+#include "metrics.h"
+#include "metrics_http.h"
+#include "log.h"
 
 #define SERVER_PORT 5000
-#define MAX_CLIENTS 10
-#define BUFFER_SIZE 1024
-#define BUTTON_PIN 18
-#define BACKLOG 10
-
-// GPIO 핀 정의
-#define LED_PIN 17
-#define BUZZER_PIN 27
-#define SENSOR_PIN 19
-#define SEG_A_PIN 5   // a -> gp5
-#define SEG_B_PIN 6   // b -> gp6
-#define SEG_C_PIN 12  // c -> gp12
-#define SEG_D_PIN 13  // d -> gp13
-
-// 클라이언트 소켓 배열
-int client_sockets[MAX_CLIENTS];
-
-// 각 디바이스 제어용 동적 라이브러리 핸들 및 함수 포인터 선언
-void *led_lib = NULL, *buzzer_lib = NULL, *sensor_lib = NULL, *seg7_lib = NULL;
+#define MAX_CLIENTS 4096
+#define BUFFER_SIZE 1024                // 명령 한 줄 최대 길이
+#define INPUT_BUFFER_SIZE (4 * 1024)    // 클라이언트별 수신 링 버퍼 (2의 거듭제곱)
+#define OUTPUT_BUFFER_SIZE (16 * 1024)  // 클라이언트별 전송 링 버퍼 (2의 거듭제곱)
+#define BUTTON_PIN 21
+#define BACKLOG 128
+#define CLIENT_INFLIGHT_MAX 8           // 클라이언트별 디바이스 실행기에 넘긴 채 응답을 기다리는 명령 수
+#define TIMER_CMD_MAX 128               // TIMER로 예약할 명령 최대 길이
+#define TIMER_LIST_BYTES 768            // TIMER:LIST 응답 본문 최대 크기
+#define EVENT_MAX_LEN 64                // 알림 한 건의 최대 인코딩 크기
+#define BUTTON_DEBOUNCE_MS 200
+#define SENSOR_BATCH_MAX 32             // 구독자별 센서 샘플 묶음 최대 개수
+#define SENSOR_BATCH_MS 100             // 주기 구독은 이 시간만큼 모아서 한 줄로 전송
+#define SENSOR_BATCH_BYTES 512          // 샘플 묶음 한 건의 최대 인코딩 크기
+#define STATS_BYTES (PROTO_MAX_PAYLOAD - 64) // STATS 응답 본문 최대 크기 (첫 줄 OK:STATS와 값 4개 자리를 뺀 나머지)
+#define STATS_MORE_BYTES 16             // 못 실은 CMD 줄 수를 알리는 MORE 줄 자리
+#define PLUGIN_LIST_BYTES 384           // PLUGIN:LIST 응답 본문 최대 크기
+
+// 연결별 프로토콜 모드 (연결 직후 첫 바이트로 결정)
+enum client_mode {
+    MODE_DETECT = 0,
+    MODE_TEXT,
+    MODE_BINARY
+};
+
+// 조도센서 스트림 구독 상태
+struct sensor_sub {
+    int hz;                 // 0이면 구독 안 함
+    int change_only;        // 값이 바뀔 때만 전송
+    uint64_t period_ns;
+    uint64_t next_due_ns;   // 다음 샘플을 받을 수 있는 시각
+    int last_value;         // 마지막으로 보낸 값 (-1: 아직 없음)
+    int count;              // 묶음에 쌓인 샘플 수
+    int ready;              // 묶음을 보낼 때가 됨 (전송 버퍼에 자리가 나면 전송)
+    uint64_t first_ns;      // 묶음 첫 샘플 시각
+    int32_t batch[SENSOR_BATCH_MAX][2]; // {시각 ms, 값}
+};
+
+// 클라이언트 연결 상태
+struct client {
+    int fd;
+    struct ringbuf in;  // 수신 스트림 재조립용 (줄 단위 프레이밍)
+    struct ringbuf out; // 아직 전송하지 못한 응답
+    uint32_t events;    // 현재 epoll 감시 이벤트
+    int stalled;        // 전송 버퍼가 차서 명령 처리를 멈춘 상태
+    int discarding;     // 너무 긴 줄을 개행까지 버리는 중
+    size_t skip;        // 바이너리 모드에서 버릴 남은 바이트 (너무 긴 프레임)
+    int mode;           // enum client_mode
+    struct event_queue notify; // 전송 버퍼에 아직 넣지 못한 알림
+    int sub_button;     // 버튼 알림 구독 (연결 시 기본으로 구독)
+    struct sensor_sub sensor;
+    struct client_job *jobs_head, *jobs_tail; // 디바이스 실행기에 넘긴 명령 (응답 순서대로)
+    int inflight;
+    int waiting;        // 넘긴 명령이 끝나야 다음 명령을 처리할 수 있음
+    int batch_pending;  // 이번 완료 묶음에서 응답을 보낼 차례
+    struct client *batch_next;
+    struct client *prev, *next;
+};
+
+// 디바이스 실행기로 넘긴 클라이언트 명령. 응답은 실행 스레드에서 인코딩해 두고 받은 순서대로 보낸다
+struct client_job {
+    struct dev_job job;
+    struct client *c;           // 완료 전에 연결이 닫히면 NULL
+    struct client_job *order_next;
+    int binary;
+    int done;
+    size_t len;
+    char out[PROTO_MAX_REPLY];
+};
+
+// 접속 중인 클라이언트 목록 (이벤트 루프 스레드에서만 접근)
+struct client *client_list = NULL;
+int client_count = 0;
 
 // 7-세그먼트 숫자 0-9 패턴
 const int seven_seg_digits[10][7] = {
@@ -56,89 +133,216 @@ const int seven_seg_digits[10][7] = {
     {1, 1, 1, 1, 0, 1, 1}  // 9
 };
 
-// 추가기능 플래그
+// 추가기능 플래그 (music_mode_mutex)
+// 음악 모드는 루프 스레드가 세대를 올려 차지한 뒤 그 세대로 스레드를 띄운다. 출력은 한 번에 한 스레드만 만지고,
+// 더 새 세대에 밀린 스레드는 출력과 상태를 건드리지 않고 끝난다 (START→STOP→START가 1초 안에 와도 카운트다운은 하나)
 volatile int music_mode_active = 0;
+static unsigned int music_mode_gen = 0;     // 시작할 때마다 증가 (루프 스레드만 올림)
+static int music_mode_running = 0;          // 출력을 맡은 스레드가 있음
 pthread_mutex_t music_mode_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t music_mode_cond = PTHREAD_COND_INITIALIZER;
 
-volatile unsigned long last_button_time = 0;
+// music_mode_mutex를 잡은 상태에서 호출. 1초 동안 또는 이 세대가 멈추거나 밀릴 때까지 기다린다
+static void music_mode_wait(unsigned int gen) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec++;
+    while (gen == music_mode_gen && music_mode_active) {
+        if (pthread_cond_timedwait(&music_mode_cond, &music_mode_mutex, &deadline) == ETIMEDOUT) break;
+    }
+}
 
+// 디바이스 동작은 디바이스 실행기를 거쳐 현재 실린 플러그인 버전으로 간다 (클라이언트 명령과 같은 순서로)
 void* music_mode_thread(void* arg) {
+    unsigned int gen = (unsigned int)(uintptr_t)arg;
+    struct reply rep;
+    int32_t v;
+    // 앞 세대 스레드가 출력을 정리할 때까지 기다린다
     pthread_mutex_lock(&music_mode_mutex);
-    music_mode_active = 1;
-    pthread_mutex_unlock(&music_mode_mutex);
-    led_on();
-    buzzer_play_music(0);
-    int seconds = 9;
-    while (seconds >= 0) {
-        pthread_mutex_lock(&music_mode_mutex);
-        int active = music_mode_active;
+    while (music_mode_running) pthread_cond_wait(&music_mode_cond, &music_mode_mutex);
+    if (gen != music_mode_gen) {
         pthread_mutex_unlock(&music_mode_mutex);
-        if (!active) break;
-        seg7_display(seconds > 9 ? 9 : seconds);
-        sleep(1);
-        seconds--;
+        return NULL;
+    }
+    music_mode_running = 1;
+    int stopped = !music_mode_active;   // 시작하기도 전에 멈췄으면 앞 세대가 켜 둔 출력만 끈다
+    if (!stopped) {
+        pthread_mutex_unlock(&music_mode_mutex);
+        device_state_begin()->music_mode = 1;
+        device_state_end();
+        dev_exec_call(OP_LED_ON, NULL, 0, &rep);
+        // 음악은 재생 엔진이 맡고, 이 스레드는 재생과 동시에 카운트다운만 한다
+        v = BUZZER_SONG_BEAR;
+        dev_exec_call(OP_BUZZER_MUSIC, &v, 1, &rep);
+        pthread_mutex_lock(&music_mode_mutex);
+        for (int seconds = 9; seconds >= 0; seconds--) {
+            if (gen != music_mode_gen || !music_mode_active) {
+                stopped = 1;
+                break;
+            }
+            pthread_mutex_unlock(&music_mode_mutex);
+            v = seconds;
+            dev_exec_call(OP_SEG7_SHOW, &v, 1, &rep);
+            pthread_mutex_lock(&music_mode_mutex);
+            music_mode_wait(gen);
+        }
+    }
+    // 더 새 세대가 이미 시작했으면 출력은 그 스레드가 이어받는다
+    int superseded = gen != music_mode_gen;
+    if (!superseded) music_mode_active = 0;
+    pthread_mutex_unlock(&music_mode_mutex);
+    if (!superseded) {
+        if (stopped) dev_exec_call(OP_BUZZER_STOP, NULL, 0, &rep);
+        dev_exec_call(OP_LED_OFF, NULL, 0, &rep);
+        dev_exec_call(OP_SEG7_OFF, NULL, 0, &rep);
+        device_state_begin()->music_mode = 0;
+        device_state_end();
     }
-    led_off();
-    seg7_off();
     pthread_mutex_lock(&music_mode_mutex);
-    music_mode_active = 0;
+    music_mode_running = 0;
+    pthread_cond_broadcast(&music_mode_cond);
     pthread_mutex_unlock(&music_mode_mutex);
     return NULL;
 }
 
-void* timer_off_thread(void* arg) {
-    int seconds = *(int*)arg;
-    free(arg);
-    sleep(seconds);
-    led_off();
-    buzzer_off();
-    seg7_off();
-    syslog(LOG_INFO, "TIMER 예약 %d초 후 ALL_OFF 실행", seconds);
-    return NULL;
+// 루프 스레드: 음악 모드가 꺼져 있으면 켜고(1) 켜져 있으면 끈다(0).
+// 켤 때는 스레드를 띄우기 전에 세대를 올려 차지하므로, 연달아 눌러도 앞 스레드는 밀린 것을 안다
+static int music_mode_toggle(void) {
+    pthread_mutex_lock(&music_mode_mutex);
+    int start = !music_mode_active;
+    music_mode_active = start;
+    unsigned int gen = start ? ++music_mode_gen : music_mode_gen;
+    pthread_cond_broadcast(&music_mode_cond);   // 카운트다운 중인 스레드를 바로 깨운다
+    pthread_mutex_unlock(&music_mode_mutex);
+    if (!start) return 0;
+    pthread_t t;
+    if (pthread_create(&t, NULL, music_mode_thread, (void *)(uintptr_t)gen) != 0) {
+        log_msg(LOG_ERR, "음악 모드 스레드 생성 실패");
+        // 앞 세대가 출력을 정리하도록 되돌린다
+        pthread_mutex_lock(&music_mode_mutex);
+        music_mode_gen--;
+        music_mode_active = 0;
+        pthread_cond_broadcast(&music_mode_cond);
+        pthread_mutex_unlock(&music_mode_mutex);
+        return 0;
+    }
+    pthread_detach(t);
+    return 1;
+}
+
+// LED, 부저, 7-Segment를 한 번의 마스크 쓰기로 끈다 (같은 뱅크라 GPCLR 한 번)
+// 실행기를 멈춘 채로 써서 앞서 넣은 디바이스 명령은 모두 끝난 뒤, 뒤에 넣은 명령은 그 다음에 실행된다
+static void all_off(void) {
+    dev_exec_pause();
+    gpio_write_mask(0, plugin_off_mask());
+    dev_exec_resume();
 }
 
 // 함수 선언(프로토타입)
-void handle_signal(int sig);
 void daemonize(void);
 void setup_gpio(void);
+void teardown_gpio(void);
 void setup_server(void);
-void handle_client(int client_socket);
+void register_commands(void);
+void client_send(struct client *c, const char *data, size_t len);
 void cleanup(void);
 void write_to_gpio(int pin, int value);
 int read_from_gpio(int pin);
-void load_device_libs(void);
-void close_device_libs(void);
+void setup_signals(void);
+void check_input_pins(void);
+void daemon_signals(sigset_t *set);
 void button_isr(void);
+void dispatch_pin_event(const struct pin_event *ev, void *arg);
+void sample_sensor(uint64_t ts_ns);
+void update_sampler_rate(void);
+int read_input(int device);
+void restore_state(void);
+void journal_state(const struct device_state *st);
+size_t render_metrics(char *buf, size_t cap);
+
+// 실행 옵션
+int server_port = SERVER_PORT;
+int foreground = 0;            // -f: 데몬화하지 않음 (CI/시뮬레이션용)
+const char *backend_name = NULL;
+const char *state_shm_name = NULL;  // -s: 상태 공유 메모리 이름 (기본 DEVICE_STATE_SHM)
+int metrics_port = 0;          // -m: Prometheus 수집 포트 (0이면 사용 안 함)
+char plugin_path[PATH_MAX] = "";   // -l: 디바이스 플러그인(.so) 디렉터리 (데몬화 전에 절대 경로로)
+const char *journal_path = JOURNAL_PATH;   // -j: 상태 저널 파일 (빈 문자열이면 사용 안 함)
+int journal_status = -1;       // journal_open 결과 (-1이면 저널 없이 동작)
+int coalesce_ms = 0;           // -w: 클라이언트 명령 출력을 모으는 창 (ms, 0이면 바로 씀)
+const char *input_chip = NULL; // -i: 입력 GPIO 문자 장치 (NULL이면 sim 백엔드는 mock, 그 외는 GPIO_LINES_CHIP, "none"이면 백엔드 인터럽트)
+uint64_t button_debounce_ns = BUTTON_DEBOUNCE_MS * 1000000ULL; // 백엔드 인터럽트일 때만 (입력 엔진은 핀별로 직접)
+uint64_t started_ns = 0;
+
+static void usage(const char *prog) {
+    fprintf(stderr, "사용법: %s [-f] [-p 포트] [-b 백엔드(wiringpi|mmap|sim)] [-s 공유메모리 이름] [-m 메트릭 포트] [-l 플러그인 디렉터리] [-j 저널 파일] [-w 출력 모으기 ms] [-i 입력 칩(/dev/gpiochipN|mock|none)]\n", prog);
+    exit(EXIT_FAILURE);
+}
 
-int main(void) {
-    // 클라이언트 배열 초기화
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        client_sockets[i] = -1;
+int main(int argc, char *argv[]) {
+    int opt;
+    const char *plugin_dir = ".";
+    while ((opt = getopt(argc, argv, "fp:b:s:m:l:j:w:i:")) != -1) {
+        switch (opt) {
+            case 'f': foreground = 1; break;
+            case 'p': server_port = atoi(optarg); break;
+            case 'b': backend_name = optarg; break;
+            case 's': state_shm_name = optarg; break;
+            case 'm': metrics_port = atoi(optarg); break;
+            case 'l': plugin_dir = optarg; break;
+            case 'j': journal_path = optarg; break;
+            case 'w': coalesce_ms = atoi(optarg); break;
+            case 'i': input_chip = optarg; break;
+            default: usage(argv[0]);
+        }
+    }
+    started_ns = metrics_now();
+    // 데몬화하면 작업 디렉터리가 /로 바뀌므로 미리 절대 경로로 (없으면 내장 모듈만 사용)
+    if (!realpath(plugin_dir, plugin_path)) plugin_path[0] = '\0';
+    // SIGHUP/SIGINT/SIGTERM은 signalfd로 이벤트 루프에서 받는다. 스레드를 만들기 전에 막아 두어야 모든 스레드에 적용된다
+    sigset_t sigs;
+    daemon_signals(&sigs);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+    // GPIO 백엔드 선택 후 setup은 main에서 단 한 번만 호출
+    if (gpio_init(backend_name) < 0) {
+        fprintf(stderr, "알 수 없는 GPIO 백엔드: %s\n", backend_name);
+        exit(EXIT_FAILURE);
+    }
+    if (gpio_setup() < 0) {
+        fprintf(stderr, "GPIO 초기화 실패 (%s)\n", gpio_backend_name());
+        exit(EXIT_FAILURE);
     }
-    // wiringPiSetupGpio()를 main에서 단 한 번만 호출
-    wiringPiSetupGpio();
-    // 시그널 핸들러 등록
-    signal(SIGINT, handle_signal);
-    signal(SIGTERM, handle_signal);
+    // 상태 저널은 데몬화 전에 연다 (상대 경로 그대로, flock은 fork 뒤에도 유지됨)
+    if (journal_path[0]) journal_status = journal_open(journal_path);
+    signal(SIGPIPE, SIG_IGN); // 끊긴 클라이언트에 쓰면 EPIPE로 받고 연결만 정리
     // 데몬화
-    daemonize();
-    // syslog 초기화
-    openlog("gpio_daemon", LOG_PID, LOG_DAEMON);
-    syslog(LOG_INFO, "GPIO 데몬 시작");
-    // GPIO 초기화
-    setup_gpio();
-    // 버튼 인터럽트 등록 (wiringPiISR)
-    if (wiringPiISR(BUTTON_PIN, INT_EDGE_RISING, &button_isr) < 0) {
-        syslog(LOG_ERR, "버튼 인터럽트 등록 실패");
+    if (!foreground) daemonize();
+    // 로그 초기화 (플러시 스레드는 fork 뒤에 만들어야 하므로 데몬화 이후)
+    if (log_init("gpio_daemon", foreground) < 0) {
+        fprintf(stderr, "로그 스레드 생성 실패\n");
         exit(EXIT_FAILURE);
     }
-    // TCP 서버 설정
+    log_msg(LOG_INFO, "GPIO 데몬 시작 (백엔드: %s)", gpio_backend_name());
+    if (journal_path[0] && journal_status < 0)
+        log_msg(LOG_WARNING, "상태 저널을 열 수 없음 (다른 데몬이 사용 중이거나 권한 없음): %s", journal_path);
+    device_state_set_hook(journal_state);
+    // 디바이스 상태를 공유 메모리에 게시 (실패해도 TCP 제어는 그대로 동작)
+    if (device_state_publish(state_shm_name) < 0)
+        log_msg(LOG_WARNING, "상태 공유 메모리 생성 실패: %s", state_shm_name ? state_shm_name : DEVICE_STATE_SHM);
+    // GPIO 초기화
+    setup_gpio();
+    // 명령 레지스트리 구성
+    register_commands();
+    // TCP 서버 설정 (이벤트 루프에 리슨 소켓 등록)
     setup_server();
-    // 동적 라이브러리 로드
-    load_device_libs();
-    // 여기까지 실행되지 않음
+    // SIGHUP → 플러그인 다시 읽기, SIGINT/SIGTERM → 이벤트 루프 종료
+    setup_signals();
+    // 이전 실행의 출력과 타이머 복구
+    restore_state();
+    // 이벤트 루프 실행 (accept/read/응답 모두 이 스레드에서 처리)
+    event_loop_run();
+    // 종료 시그널로 루프가 끝나면 정리는 이 스레드에서 (락을 잡는 정리 함수를 시그널 핸들러에서 부르지 않음)
     cleanup();
-    close_device_libs();
     return 0;
 }
 
@@ -179,34 +383,614 @@ void daemonize(void) {
 }
 
 // GPIO 초기화 함수
+// 각 디바이스 플러그인(.so가 없으면 내장 모듈)이 자기 핀을 한 번만 설정하고, 이후 명령은 레지스터 쓰기만 한다
 void setup_gpio(void) {
-    pinMode(LED_PIN, OUTPUT); digitalWrite(LED_PIN, 0);
-    pinMode(BUZZER_PIN, OUTPUT); digitalWrite(BUZZER_PIN, 0);
-    pinMode(SENSOR_PIN, INPUT);
-    pinMode(BUTTON_PIN, INPUT);
-    pullUpDnControl(BUTTON_PIN, PUD_UP);
-    pinMode(SEG_A_PIN, OUTPUT); digitalWrite(SEG_A_PIN, 0);
-    pinMode(SEG_B_PIN, OUTPUT); digitalWrite(SEG_B_PIN, 0);
-    pinMode(SEG_C_PIN, OUTPUT); digitalWrite(SEG_C_PIN, 0);
-    pinMode(SEG_D_PIN, OUTPUT); digitalWrite(SEG_D_PIN, 0);
-}
-
-// 서버 소켓 설정 및 클라이언트 연결 처리 함수
+    if (!plugin_path[0]) log_msg(LOG_WARNING, "플러그인 디렉터리 없음, 내장 모듈만 사용");
+    if (plugin_init(plugin_path[0] ? plugin_path : NULL) < 0) {
+        log_msg(LOG_ERR, "디바이스 플러그인 초기화 실패");
+        exit(EXIT_FAILURE);
+    }
+    check_input_pins();
+    gpio_pin_mode(BUTTON_PIN, GPIO_INPUT);
+    gpio_pull_up_dn(BUTTON_PIN, GPIO_PUD_UP);
+}
+
+// 디바이스 출력 정리
+void teardown_gpio(void) {
+    plugin_shutdown();
+}
+
+static void record_clients(void) {
+    struct device_state *st = device_state_begin();
+    st->clients = client_count;
+    device_state_end();
+}
+
+static struct client_job *free_client_jobs = NULL;   // 이벤트 루프 스레드만
+static struct client *batch_clients = NULL;            // 이번 완료 묶음에서 응답을 보낼 연결
+
+static void client_job_free(struct client_job *j) {
+    j->order_next = free_client_jobs;
+    free_client_jobs = j;
+}
+
+// 클라이언트 연결 종료 및 정리
+static void client_close(struct client *c) {
+    log_msg(LOG_INFO, "클라이언트 연결 종료");
+    event_loop_del(c->fd);
+    close(c->fd);
+    if (c->prev) c->prev->next = c->next;
+    else client_list = c->next;
+    if (c->next) c->next->prev = c->prev;
+    client_count--;
+    record_clients();
+    if (c->sensor.hz) {
+        c->sensor.hz = 0;
+        update_sampler_rate();
+    }
+    // 실행 중인 명령은 완료될 때 회수한다
+    for (struct client_job *j = c->jobs_head, *next; j; j = next) {
+        next = j->order_next;
+        if (j->done) client_job_free(j);
+        else j->c = NULL;
+    }
+    if (c->batch_pending) {
+        struct client **pp = &batch_clients;
+        while (*pp != c) pp = &(*pp)->batch_next;
+        *pp = c->batch_next;
+    }
+    ringbuf_free(&c->in);
+    ringbuf_free(&c->out);
+    free(c);
+}
+
+// 센서 샘플 묶음 전송
+// 텍스트: EVENT:SENSOR:<핀>:<개수>:<시각 ms>:<값>:<시각 ms>:<값>...
+// 바이너리: OP_EVENT 프레임, 값 {핀, 개수} 뒤에 (int32 시각, int32 값) 쌍
+static void client_send_sensor_batch(struct client *c) {
+    struct sensor_sub *s = &c->sensor;
+    if (s->count == 0) {
+        s->ready = 0;
+        return;
+    }
+    if (ringbuf_space(&c->out) < PROTO_MAX_REPLY + SENSOR_BATCH_BYTES) return; // 자리가 날 때까지 계속 모음
+    if (c->mode == MODE_BINARY) {
+        uint32_t pairs[SENSOR_BATCH_MAX * 2];
+        uint8_t out[SENSOR_BATCH_BYTES];
+        struct reply rep;
+        memset(&rep, 0, sizeof(rep));
+        for (int i = 0; i < s->count; i++) {
+            pairs[i * 2] = htonl((uint32_t)s->batch[i][0]);
+            pairs[i * 2 + 1] = htonl((uint32_t)s->batch[i][1]);
+        }
+        reply_ok(&rep, "EVENT:SENSOR");
+        reply_value(&rep, LIGHT_SENSOR_PIN);
+        reply_value(&rep, s->count);
+        reply_text(&rep, (const char *)pairs, (size_t)s->count * 8);
+        size_t n = proto_encode_event(DEV_SENSOR, &rep, out, sizeof(out));
+        ringbuf_write(&c->out, (const char *)out, n);
+    } else {
+        char out[SENSOR_BATCH_BYTES];
+        int len = snprintf(out, sizeof(out), "EVENT:SENSOR:%d:%d", LIGHT_SENSOR_PIN, s->count);
+        for (int i = 0; i < s->count; i++)
+            len += snprintf(out + len, sizeof(out) - len, ":%d:%d", s->batch[i][0], s->batch[i][1]);
+        out[len++] = '\n';
+        ringbuf_write(&c->out, out, len);
+    }
+    metrics_add(METRIC_EVENTS, 1);
+    s->count = 0;
+    s->ready = 0;
+}
+
+// 대기 중인 알림을 전송 버퍼로 옮긴다. 응답 한 개 분량은 항상 남겨 두어 명령 처리가 밀리지 않게 한다.
+static void client_drain_events(struct client *c) {
+    static const char *const tags[DEV_MAX] = {
+        [DEV_BUTTON] = "EVENT:BUTTON",
+        [DEV_SENSOR] = "EVENT:SENSOR",
+    };
+    if (c->sensor.ready) client_send_sensor_batch(c);
+    while (!event_queue_empty(&c->notify) && ringbuf_space(&c->out) >= PROTO_MAX_REPLY + EVENT_MAX_LEN) {
+        struct reply rep;
+        struct pin_event ev;
+        int device = DEV_NONE;
+        memset(&rep, 0, sizeof(rep));
+        if (c->notify.dropped > 0) {
+            // EVENT:DROPPED:<버린 개수>
+            reply_ok(&rep, "EVENT:DROPPED");
+            reply_value(&rep, (int32_t)c->notify.dropped);
+            c->notify.dropped = 0;
+        } else {
+            event_queue_pop(&c->notify, &ev);
+            // EVENT:<디바이스>:<핀>:<값>:<발생 시각 ms>
+            device = ev.device;
+            reply_ok(&rep, device < DEV_MAX && tags[device] ? tags[device] : "EVENT:PIN");
+            reply_value(&rep, ev.pin);
+            reply_value(&rep, ev.value);
+            reply_value(&rep, (int32_t)(ev.ts_ns / 1000000 & 0x7fffffff));
+        }
+        if (c->mode == MODE_BINARY) {
+            uint8_t out[EVENT_MAX_LEN];
+            size_t n = proto_encode_event(device, &rep, out, sizeof(out));
+            ringbuf_write(&c->out, (const char *)out, n);
+        } else {
+            char out[EVENT_MAX_LEN];
+            size_t n = proto_encode_text(&rep, out, sizeof(out));
+            ringbuf_write(&c->out, out, n);
+        }
+        metrics_add(METRIC_EVENTS, 1);
+    }
+}
+
+// 전송 링 버퍼의 응답을 writev로 한 번에 전송
+static int client_flush(struct client *c) {
+    client_drain_events(c);
+    while (ringbuf_used(&c->out) > 0) {
+        struct iovec iov[2];
+        int cnt = ringbuf_data_iov(&c->out, iov);
+        ssize_t n = writev(c->fd, iov, cnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return -1;
+        }
+        ringbuf_consume(&c->out, n);
+        metrics_add(METRIC_BYTES_OUT, n);
+        client_drain_events(c);
+    }
+    // 전송이 밀려 있으면 EPOLLOUT 감시, 처리가 멈춘 동안은 새 입력을 읽지 않음
+    uint32_t events = c->stalled || c->waiting ? 0 : EPOLLIN;
+    if (ringbuf_used(&c->out) > 0) events |= EPOLLOUT;
+    if (events != c->events) {
+        event_loop_mod(c->fd, events);
+        c->events = events;
+    }
+    return 0;
+}
+
+// 응답을 전송 링 버퍼에 추가 (실제 전송은 client_flush에서 묶어서 처리)
+void client_send(struct client *c, const char *data, size_t len) {
+    if (ringbuf_write(&c->out, data, len) == 0 && len > 0) {
+        log_msg(LOG_WARNING, "클라이언트 %d 전송 버퍼 초과, 응답 폐기", c->fd);
+    }
+}
+
+// 실행 스레드에서 핸들러 직후 응답을 인코딩해 둔다
+static void client_job_encode(struct dev_job *job) {
+    struct client_job *j = (struct client_job *)job;
+    if (j->binary) j->len = proto_encode_binary(&job->req, &job->rep, (uint8_t *)j->out, sizeof(j->out));
+    else j->len = proto_encode_text(&job->rep, j->out, sizeof(j->out));
+}
+
+// 이벤트 루프 스레드: 응답 전송은 완료 묶음이 끝날 때 연결별로 한 번에
+static void client_job_complete(struct dev_job *job) {
+    struct client_job *j = (struct client_job *)job;
+    if (job->rep.status != ST_OK) metrics_add(METRIC_ERRORS_BASE + job->req.opcode, 1);
+    j->done = 1;
+    struct client *c = j->c;
+    if (!c) {
+        client_job_free(j);
+        return;
+    }
+    if (!c->batch_pending) {
+        c->batch_pending = 1;
+        c->batch_next = batch_clients;
+        batch_clients = c;
+    }
+}
+
+// 디바이스 명령이면 그 디바이스 실행기로 넘긴다 (응답은 완료 후 받은 순서대로). 넘겼으면 1
+static int client_submit(struct client *c, const struct request *req) {
+    int device = dev_exec_device(req->opcode);
+    if (device < 0) return 0;
+    struct client_job *j = free_client_jobs;
+    if (j) free_client_jobs = j->order_next;
+    else if (!(j = malloc(sizeof(*j)))) return 0;
+    memset(&j->job, 0, sizeof(j->job));
+    j->job.req = *req;
+    // 플러그인 명령은 숫자 인자만 쓴다 (text는 수신 줄 버퍼를 가리키므로 넘기지 않음)
+    j->job.req.text = NULL;
+    j->job.req.text_len = 0;
+    j->job.flags = coalesce_window() ? DEV_JOB_COALESCE : 0;
+    j->job.finish = client_job_encode;
+    j->job.complete = client_job_complete;
+    j->c = c;
+    j->order_next = NULL;
+    j->binary = c->mode == MODE_BINARY;
+    j->done = 0;
+    if (c->jobs_tail) c->jobs_tail->order_next = j;
+    else c->jobs_head = j;
+    c->jobs_tail = j;
+    c->inflight++;
+    dev_exec_submit(device, &j->job);
+    return 1;
+}
+
+// 앞에서부터 끝난 응답을 전송 버퍼로 옮긴다
+static void client_deliver(struct client *c) {
+    struct client_job *j;
+    while ((j = c->jobs_head) && j->done) {
+        c->jobs_head = j->order_next;
+        if (!c->jobs_head) c->jobs_tail = NULL;
+        c->inflight--;
+        client_send(c, j->out, j->len);
+        client_job_free(j);
+    }
+}
+
+// 넘긴 명령이 남아 있으면 디바이스 명령만 이어서 넘긴다. 나머지는 앞선 명령이 모두 끝난 뒤 실행해야
+// 같은 연결 안의 순서(예: SEG7:3 다음 ALL_OFF)가 지켜진다
+static int client_must_wait(struct client *c, const struct request *req, int status) {
+    if (c->inflight == 0) return 0;
+    if (c->inflight >= CLIENT_INFLIGHT_MAX) return 1;
+    return status != ST_OK || dev_exec_device(req->opcode) < 0;
+}
+
+// 디코딩된 요청을 실행하고 연결의 프로토콜 형식에 맞춰 응답
+static void client_execute(struct client *c, struct request *req, int status) {
+    struct reply rep;
+    memset(&rep, 0, sizeof(rep));
+    if (status == ST_OK && client_submit(c, req)) return;
+    if (status == ST_OK) {
+        uint64_t t0 = metrics_now();
+        req->conn = c;
+        coalesce_begin();
+        command_dispatch(req, &rep);
+        coalesce_end();
+        metrics_record(METRIC_HIST_CMD(METRIC_EXEC, req->opcode), metrics_now() - t0);
+    } else {
+        reply_error(&rep, status);
+    }
+    if (rep.status != ST_OK) metrics_add(METRIC_ERRORS_BASE + (req->opcode < OP_MAX ? req->opcode : OP_NONE), 1);
+    if (c->mode == MODE_BINARY) {
+        uint8_t out[PROTO_MAX_REPLY];
+        size_t n = proto_encode_binary(req, &rep, out, sizeof(out));
+        client_send(c, (const char *)out, n);
+    } else {
+        char out[PROTO_MAX_REPLY];
+        size_t n = proto_encode_text(&rep, out, sizeof(out));
+        client_send(c, out, n);
+    }
+}
+
+// 첫 바이트가 PROTO_MAGIC이면 바이너리 모드, 아니면 텍스트 모드
+// 반환값: 0 결정됨, -1 아직 판단할 바이트가 부족함
+static int client_detect_mode(struct client *c) {
+    char head[PROTO_MAGIC_LEN];
+    size_t n = ringbuf_peek(&c->in, head, PROTO_MAGIC_LEN);
+    if (memcmp(head, PROTO_MAGIC, n) != 0) {
+        c->mode = MODE_TEXT;
+        return 0;
+    }
+    if (n < PROTO_MAGIC_LEN) return -1;
+    ringbuf_consume(&c->in, PROTO_MAGIC_LEN);
+    client_send(c, PROTO_MAGIC, PROTO_MAGIC_LEN);
+    c->mode = MODE_BINARY;
+    log_msg(LOG_INFO, "클라이언트 %d 바이너리 프로토콜 사용", c->fd);
+    return 0;
+}
+
+// 수신 버퍼에서 개행으로 끝나는 명령 하나를 꺼내 처리, 처리할 줄이 없으면 0 반환
+// 한 번의 read에 여러 명령이 붙어 오거나 명령이 여러 read로 나뉘어 와도 줄 단위로 복원된다.
+static int client_next_text(struct client *c) {
+    char line[BUFFER_SIZE];
+    struct request req;
+    memset(&req, 0, sizeof(req));
+    ssize_t pos = ringbuf_find(&c->in, '\n');
+    if (pos < 0) {
+        // 개행 없이 한 줄 최대 길이를 넘으면 개행이 올 때까지 버림
+        if (ringbuf_used(&c->in) >= BUFFER_SIZE) {
+            if (!c->discarding && client_must_wait(c, &req, ST_TOO_LONG)) {
+                c->waiting = 1;
+                return 0;
+            }
+            if (!c->discarding) client_execute(c, &req, ST_TOO_LONG);
+            c->discarding = 1;
+            ringbuf_consume(&c->in, ringbuf_used(&c->in));
+        }
+        return 0;
+    }
+    if (c->discarding || pos >= BUFFER_SIZE) {
+        if (!c->discarding && client_must_wait(c, &req, ST_TOO_LONG)) {
+            c->waiting = 1;
+            return 0;
+        }
+        if (!c->discarding) client_execute(c, &req, ST_TOO_LONG);
+        c->discarding = 0;
+        ringbuf_consume(&c->in, pos + 1);
+        return 1;
+    }
+    ringbuf_peek(&c->in, line, pos);
+    size_t consumed = pos + 1;
+    if (pos > 0 && line[pos - 1] == '\r') pos--;
+    line[pos] = '\0';
+    if (pos == 0) {
+        ringbuf_consume(&c->in, consumed);
+        return 1;
+    }
+
+    uint64_t t0 = metrics_now();
+    int status = proto_parse_text(line, &req);
+    // 앞서 넘긴 명령을 기다려야 하면 줄을 남겨 두고 완료 후 다시 읽는다
+    if (client_must_wait(c, &req, status)) {
+        c->waiting = 1;
+        return 0;
+    }
+    ringbuf_consume(&c->in, consumed);
+    metrics_record(METRIC_HIST_CMD(METRIC_PARSE, req.opcode), metrics_now() - t0);
+    LOG_SAMPLED_TEXT(LOG_INFO, "명령 수신: ", line, pos);
+    client_execute(c, &req, status);
+    return 1;
+}
+
+// 길이 헤더로 구분된 바이너리 프레임 하나를 꺼내 처리, 프레임이 덜 왔으면 0 반환
+static int client_next_binary(struct client *c) {
+    uint8_t frame[PROTO_HDR_SIZE + PROTO_MAX_PAYLOAD];
+    struct request req;
+    if (c->skip > 0) {
+        size_t n = ringbuf_used(&c->in) < c->skip ? ringbuf_used(&c->in) : c->skip;
+        ringbuf_consume(&c->in, n);
+        c->skip -= n;
+        return c->skip == 0;
+    }
+    if (ringbuf_used(&c->in) < PROTO_HDR_SIZE) return 0;
+    ringbuf_peek(&c->in, frame, PROTO_HDR_SIZE);
+    size_t len = proto_frame_len(frame);
+    if (len > sizeof(frame)) {
+        // 헤더만 보고 오류 응답 후 프레임 나머지는 도착하는 대로 버림
+        proto_decode_binary(frame, PROTO_HDR_SIZE, &req);
+        if (client_must_wait(c, &req, ST_TOO_LONG)) {
+            c->waiting = 1;
+            return 0;
+        }
+        client_execute(c, &req, ST_TOO_LONG);
+        c->skip = len;
+        return 1;
+    }
+    if (ringbuf_used(&c->in) < len) return 0;
+    ringbuf_peek(&c->in, frame, len);
+
+    uint64_t t0 = metrics_now();
+    int status = proto_decode_binary(frame, len, &req);
+    if (client_must_wait(c, &req, status)) {
+        c->waiting = 1;
+        return 0;
+    }
+    ringbuf_consume(&c->in, len);
+    metrics_record(METRIC_HIST_CMD(METRIC_PARSE, req.opcode < OP_MAX ? req.opcode : OP_NONE), metrics_now() - t0);
+    LOG_SAMPLED(LOG_INFO, "바이너리 명령 수신: opcode %d", req.opcode);
+    client_execute(c, &req, status);
+    return 1;
+}
+
+// 수신 버퍼의 명령을 순서대로 처리
+static void client_process_input(struct client *c) {
+    c->stalled = 0;
+    c->waiting = 0;
+    if (c->mode == MODE_DETECT) {
+        if (ringbuf_used(&c->in) == 0 || client_detect_mode(c) < 0) return;
+    }
+    while (1) {
+        // 응답을 담을 공간이 없으면 전송이 빠질 때까지 처리 중단 (순서 보장, 넘긴 명령의 응답 자리도 비워 둠)
+        if (ringbuf_space(&c->out) < (size_t)(c->inflight + 1) * PROTO_MAX_REPLY) {
+            c->stalled = 1;
+            break;
+        }
+        int handled = c->mode == MODE_BINARY ? client_next_binary(c) : client_next_text(c);
+        if (!handled) break;
+    }
+}
+
+// 명령을 처리하고 전송. 연결을 닫았으면 -1
+static int client_pump(struct client *c, int process) {
+    if (process) client_process_input(c);
+    if (client_flush(c) < 0) {
+        client_close(c);
+        return -1;
+    }
+    // 전송이 모두 빠졌는데 아직 처리할 명령이 남아 있으면 이어서 처리
+    while (c->stalled && ringbuf_used(&c->out) == 0) {
+        client_process_input(c);
+        if (client_flush(c) < 0) {
+            client_close(c);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// 클라이언트 소켓 이벤트 처리
+static void on_client_event(int fd, uint32_t events, void *arg) {
+    struct client *c = arg;
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        client_close(c);
+        return;
+    }
+    if (events & EPOLLIN) {
+        struct iovec iov[2];
+        int cnt = ringbuf_space_iov(&c->in, iov);
+        if (cnt > 0) {
+            ssize_t bytes_read = readv(fd, iov, cnt);
+            if (bytes_read == 0 || (bytes_read < 0 && errno != EAGAIN && errno != EINTR)) {
+                client_close(c);
+                return;
+            }
+            if (bytes_read > 0) {
+                ringbuf_commit(&c->in, bytes_read);
+                metrics_add(METRIC_BYTES_IN, bytes_read);
+            }
+        }
+    }
+    // 새 입력 또는 전송 버퍼가 비어 멈췄던 처리를 재개
+    client_pump(c, (events & EPOLLIN) || c->stalled);
+}
+
+// 디바이스 실행기의 완료 묶음이 끝나면 연결별로 응답을 보내고, 기다리던 명령 처리를 재개
+static void client_jobs_done(void) {
+    coalesce_end();     // 실행 스레드가 모아 둔 출력이 있으면 창을 시작
+    while (batch_clients) {
+        struct client *c = batch_clients;
+        batch_clients = c->batch_next;
+        c->batch_pending = 0;
+        client_deliver(c);
+        client_pump(c, c->waiting);
+    }
+}
+
+// 새 연결 수락 (리슨 소켓이 읽기 가능할 때)
+static void on_accept(int sockfd, uint32_t events, void *arg) {
+    (void)events; (void)arg;
+    while (1) {
+        struct sockaddr_in client_addr;
+        socklen_t addr_len = sizeof(client_addr);
+        int client_socket = accept4(sockfd, (struct sockaddr *)&client_addr, &addr_len,
+                                    SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_socket < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) log_msg(LOG_ERR, "클라이언트 연결 실패");
+            return;
+        }
+        if (client_count >= MAX_CLIENTS) {
+            log_msg(LOG_WARNING, "최대 접속 수 초과, 연결 거부: %s", inet_ntoa(client_addr.sin_addr));
+            metrics_add(METRIC_REJECTED, 1);
+            close(client_socket);
+            continue;
+        }
+
+        log_msg(LOG_INFO, "새 클라이언트 접속: %s", inet_ntoa(client_addr.sin_addr));
+
+        int opt = 1;
+        setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+        struct client *c = calloc(1, sizeof(*c));
+        if (!c) {
+            close(client_socket);
+            continue;
+        }
+        c->fd = client_socket;
+        c->events = EPOLLIN;
+        c->sub_button = 1;
+        if (ringbuf_init(&c->in, INPUT_BUFFER_SIZE) < 0 || ringbuf_init(&c->out, OUTPUT_BUFFER_SIZE) < 0) {
+            ringbuf_free(&c->in);
+            close(client_socket);
+            free(c);
+            continue;
+        }
+        if (event_loop_add(client_socket, EPOLLIN, on_client_event, c) < 0) {
+            log_msg(LOG_ERR, "클라이언트 이벤트 등록 실패");
+            close(client_socket);
+            ringbuf_free(&c->in);
+            ringbuf_free(&c->out);
+            free(c);
+            continue;
+        }
+        // 클라이언트 목록에 추가
+        c->next = client_list;
+        if (client_list) client_list->prev = c;
+        client_list = c;
+        client_count++;
+        metrics_add(METRIC_ACCEPTED, 1);
+        record_clients();
+    }
+}
+
+// 입력 핀: 버튼은 누를 때(상승 엣지) 알리고, 조도센서는 레벨만 추적해 SENSOR/샘플러 읽기에 쓴다
+static const struct gpio_line_config input_lines[] = {
+    {BUTTON_PIN,       DEV_BUTTON, GPIO_EDGE_RISING, GPIO_PUD_UP,  BUTTON_DEBOUNCE_MS * 1000},
+    {LIGHT_SENSOR_PIN, DEV_SENSOR, 0,                GPIO_PUD_OFF, 0},
+};
+
+// 입력 핀을 잡으면 그 핀이 입력으로 바뀌므로, 디바이스 모듈이 출력으로 쓰는 핀과 겹치면 시작하지 않는다
+// (플러그인 init 뒤, 버튼 핀을 입력으로 설정하기 전에)
+void check_input_pins(void) {
+    int conflict = 0;
+    for (size_t i = 0; i < sizeof(input_lines) / sizeof(input_lines[0]); i++) {
+        int mode = gpio_get_mode(input_lines[i].pin);
+        if (mode == GPIO_OUTPUT || mode == GPIO_PWM_OUTPUT) {
+            log_msg(LOG_ERR, "입력 핀 %d: 디바이스 모듈이 출력으로 사용 중 (핀 배치 확인)", input_lines[i].pin);
+            conflict = 1;
+        }
+    }
+    if (conflict) exit(EXIT_FAILURE);
+}
+
+// 입력 엔진(GPIO 문자 장치)을 열고, 안 되면 백엔드 인터럽트로 버튼만 받는다 (이벤트 루프 생성 뒤)
+static void setup_input(void) {
+    const char *chip = input_chip ? input_chip :
+                       strcmp(gpio_backend_name(), "sim") == 0 ? GPIO_LINES_MOCK : GPIO_LINES_CHIP;
+    if (strcmp(chip, "none") != 0) {
+        int n = sizeof(input_lines) / sizeof(input_lines[0]);
+        if (gpio_lines_open(chip, input_lines, n, dispatch_pin_event, NULL) == 0) {
+            gpio_set_level_source(gpio_lines_level);
+            if (strcmp(chip, GPIO_LINES_MOCK) == 0) gpio_sim_set_input_hook(gpio_lines_mock_input);
+            button_debounce_ns = 0;
+            log_msg(LOG_INFO, "입력 엔진: %s (핀 %d개, 커널 시각)", chip, n);
+            return;
+        }
+        log_msg(LOG_WARNING, "입력 칩 %s를 열 수 없어 백엔드 인터럽트 사용: %s", chip, strerror(errno));
+    }
+    if (gpio_isr(BUTTON_PIN, GPIO_EDGE_RISING, &button_isr) < 0) {
+        log_msg(LOG_ERR, "버튼 인터럽트 등록 실패");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// 서버 소켓 설정 및 이벤트 루프 등록 함수
 void setup_server(void) {
     int sockfd;
     struct sockaddr_in serv_addr;
+
+    // 수천 개 연결을 위해 fd 한도 상향
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    if (event_loop_init() < 0) {
+        log_msg(LOG_ERR, "이벤트 루프 생성 실패");
+        exit(EXIT_FAILURE);
+    }
+    if (timer_wheel_init() < 0) {
+        log_msg(LOG_ERR, "타이머 휠 생성 실패");
+        exit(EXIT_FAILURE);
+    }
+    if (sequencer_init(read_input) < 0) {
+        log_msg(LOG_ERR, "시퀀서 생성 실패");
+        exit(EXIT_FAILURE);
+    }
+    if (coalesce_ms < 0 || coalesce_init((unsigned)coalesce_ms) < 0) {
+        log_msg(LOG_ERR, "출력 모으기 창 설정 실패 (0 ~ %d ms): %d", COALESCE_MAX_MS, coalesce_ms);
+        exit(EXIT_FAILURE);
+    }
+    if (dev_exec_start(client_jobs_done) < 0) {
+        log_msg(LOG_ERR, "디바이스 실행기 생성 실패");
+        exit(EXIT_FAILURE);
+    }
+    if (pin_events_init(dispatch_pin_event, NULL) < 0) {
+        log_msg(LOG_ERR, "인터럽트 이벤트 큐 생성 실패");
+        exit(EXIT_FAILURE);
+    }
+    setup_input();
+    if (sampler_init(sample_sensor) < 0) {
+        log_msg(LOG_ERR, "센서 샘플러 생성 실패");
+        exit(EXIT_FAILURE);
+    }
+    if (metrics_port > 0) {
+        if (metrics_http_start(metrics_port, render_metrics) < 0) log_msg(LOG_ERR, "메트릭 포트 %d 리슨 실패", metrics_port);
+        else log_msg(LOG_INFO, "메트릭 포트: %d", metrics_port);
+    }
     
     // 소켓 생성
-    sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (sockfd < 0) {
-        syslog(LOG_ERR, "소켓 생성 실패");
+        log_msg(LOG_ERR, "소켓 생성 실패");
         exit(EXIT_FAILURE);
     }
     
     // 소켓 옵션 설정
     int opt = 1;
     if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-        syslog(LOG_ERR, "소켓 옵션 설정 실패");
+        log_msg(LOG_ERR, "소켓 옵션 설정 실패");
         close(sockfd);
         exit(EXIT_FAILURE);
     }
@@ -215,266 +999,739 @@ void setup_server(void) {
     memset(&serv_addr, 0, sizeof(serv_addr));
     serv_addr.sin_family = AF_INET;
     serv_addr.sin_addr.s_addr = INADDR_ANY;
-    serv_addr.sin_port = htons(SERVER_PORT);
+    serv_addr.sin_port = htons(server_port);
     
     // 소켓 바인딩
     if (bind(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
-        syslog(LOG_ERR, "소켓 바인딩 실패");
+        log_msg(LOG_ERR, "소켓 바인딩 실패");
         close(sockfd);
         exit(EXIT_FAILURE);
     }
     
     // 소켓 리슨
     if (listen(sockfd, BACKLOG) < 0) {
-        syslog(LOG_ERR, "소켓 리슨 실패");
+        log_msg(LOG_ERR, "소켓 리슨 실패");
+        close(sockfd);
+        exit(EXIT_FAILURE);
+    }
+
+    if (event_loop_add(sockfd, EPOLLIN, on_accept, NULL) < 0) {
+        log_msg(LOG_ERR, "리슨 소켓 이벤트 등록 실패");
         close(sockfd);
         exit(EXIT_FAILURE);
     }
     
-    syslog(LOG_INFO, "서버 리슨 포트: %d", SERVER_PORT);
-    
-    // 클라이언트 연결 처리
-    while (1) {
-        int client_socket, addr_len;
-        struct sockaddr_in client_addr;
-        
-        addr_len = sizeof(client_addr);
-        client_socket = accept(sockfd, (struct sockaddr *)&client_addr, (socklen_t *)&addr_len);
-        
-        if (client_socket < 0) {
-            syslog(LOG_ERR, "클라이언트 연결 실패");
-            continue;
-        }
-        
-        syslog(LOG_INFO, "새 클라이언트 접속: %s", inet_ntoa(client_addr.sin_addr));
-        
-        // 클라이언트 소켓을 배열에 추가
-        for (int i = 0; i < MAX_CLIENTS; i++) {
-            if (client_sockets[i] < 0) {
-                client_sockets[i] = client_socket;
-                break;
-            }
-        }
-        
-        // 클라이언트 처리용 스레드 생성
-        pthread_t client_thread;
-        if (pthread_create(&client_thread, NULL, (void *)handle_client, (void *)(intptr_t)client_socket) != 0) {
-            syslog(LOG_ERR, "클라이언트 스레드 생성 실패");
-            close(client_socket);
+    log_msg(LOG_INFO, "서버 리슨 포트: %d", server_port);
+}
+
+// ---- 시스템 명령 핸들러 (디바이스 명령은 각 모듈이 등록) ----
+static void cmd_extra_music_mode(const struct request *req, struct reply *rep) {
+    (void)req;
+    reply_ok(rep, music_mode_toggle() ? "OK:EXTRA_MUSIC_MODE:START" : "OK:EXTRA_MUSIC_MODE:STOP");
+}
+
+static void cmd_all_off(const struct request *req, struct reply *rep) {
+    (void)req;
+    all_off();
+    reply_ok(rep, "OK:ALL_OFF");
+    log_msg(LOG_INFO, "ALL_OFF 명령으로 모든 디바이스 OFF");
+}
+
+// 예약된 명령 (타이머 휠의 arg)
+struct timer_job {
+    char cmd[TIMER_CMD_MAX];
+    uint64_t jkey;      // 상태 저널 키 (저널이 없으면 0)
+    uint32_t id;        // 실행기로 넘긴 뒤 완료 로그용
+};
+
+static void timer_job_finish(struct timer_job *job, int status) {
+    log_msg(LOG_INFO, "TIMER %u 실행: %s (%s)", job->id, job->cmd, proto_status_name(status));
+    journal_timer_done(job->jkey);
+    free(job);
+}
+
+static void timer_job_complete(struct dev_job *dj) {
+    timer_job_finish(dj->ctx, dj->rep.status);
+}
+
+// 타이머 만료 시 이벤트 루프 스레드에서 예약된 명령을 실행 (디바이스 명령은 그 실행기로)
+static void run_timer_job(uint32_t id, void *arg) {
+    struct timer_job *job = arg;
+    struct request req;
+    struct reply rep;
+    memset(&rep, 0, sizeof(rep));
+    job->id = id;
+    int status = proto_parse_text(job->cmd, &req);
+    if (status == ST_OK) {
+        int posted = dev_exec_post(&req, timer_job_complete, job);
+        if (posted == 0) return;
+        if (posted == ST_BUSY) {
+            // 실행기가 밀려 있다: 순서를 어기고 루프에서 실행하지 않고 실패로 남긴다
+            timer_job_finish(job, ST_BUSY);
+            return;
         }
-        
-        // 스레드 분리하여 자동 정리되도록 설정
-        pthread_detach(client_thread);
+        uint64_t t0 = metrics_now();
+        command_dispatch(&req, &rep);
+        metrics_record(METRIC_HIST_CMD(METRIC_EXEC, req.opcode), metrics_now() - t0);
+    } else {
+        reply_error(&rep, status);
     }
-    
-    close(sockfd);
+    timer_job_finish(job, rep.status);
 }
 
-// 클라이언트 명령 처리 함수
-void handle_client(int client_socket) {
-    char buffer[BUFFER_SIZE];
-    int bytes_read;
-    
-    while ((bytes_read = read(client_socket, buffer, BUFFER_SIZE - 1)) > 0) {
-        buffer[bytes_read] = '\0';
-        syslog(LOG_INFO, "명령 수신: %s", buffer);
-        char *cmd = strtok(buffer, ":");
-        if (cmd != NULL) {
-            if (strcmp(cmd, "LED") == 0) {
-                char *subcmd = strtok(NULL, ":");
-                if (subcmd) {
-                    if (strcmp(subcmd, "ON") == 0) {
-                        led_on();
-                        write(client_socket, "OK:LED:ON\n", 10);
-                    } else if (strcmp(subcmd, "OFF") == 0) {
-                        led_off();
-                        write(client_socket, "OK:LED:OFF\n", 11);
-                    } else if (strcmp(subcmd, "BRIGHT") == 0) {
-                        char *level_str = strtok(NULL, ":");
-                        if (level_str) {
-                            int level = atoi(level_str);
-                            led_set_brightness(level);
-                            char resp[32];
-                            sprintf(resp, "OK:LED:BRIGHT:%d\n", level);
-                            write(client_socket, resp, strlen(resp));
-                        }
-                    }
-                }
-            } else if (strcmp(cmd, "BUZZER") == 0) {
-                char *subcmd = strtok(NULL, ":");
-                if (subcmd) {
-                    if (strcmp(subcmd, "ON") == 0) {
-                        buzzer_on();
-                        write(client_socket, "OK:BUZZER:ON\n", 14);
-                    } else if (strcmp(subcmd, "OFF") == 0) {
-                        buzzer_off();
-                        write(client_socket, "OK:BUZZER:OFF\n", 15);
-                    } else if (strcmp(subcmd, "MUSIC") == 0) {
-                        char *music_id_str = strtok(NULL, ":");
-                        int music_id = 1;
-                        if (music_id_str) {
-                            music_id = atoi(music_id_str);
-                            if (music_id < 1 || music_id > 2) music_id = 1;
-                        }
-                        buzzer_play_music(music_id);
-                        write(client_socket, "OK:BUZZER:MUSIC\n", 17);
-                    }
-                }
-            } else if (strcmp(cmd, "SEG7") == 0) {
-                char *subcmd = strtok(NULL, ":");
-                if (subcmd) {
-                    if (strcmp(subcmd, "OFF") == 0) {
-                        seg7_off();
-                        write(client_socket, "OK:SEG7:OFF\n", 13);
-                    } else {
-                        int num = atoi(subcmd);
-                        seg7_display(num);
-                        char resp[32];
-                        sprintf(resp, "OK:SEG7:%d\n", num);
-                        write(client_socket, resp, strlen(resp));
-                    }
-                }
-            } else if (strcmp(cmd, "EXTRA_MUSIC_MODE") == 0) {
-                pthread_mutex_lock(&music_mode_mutex);
-                int active = music_mode_active;
-                pthread_mutex_unlock(&music_mode_mutex);
-                if (!active) {
-                    pthread_t t;
-                    pthread_create(&t, NULL, music_mode_thread, NULL);
-                    pthread_detach(t);
-                    write(client_socket, "OK:EXTRA_MUSIC_MODE:START\n", 25);
-                } else {
-                    pthread_mutex_lock(&music_mode_mutex);
-                    music_mode_active = 0;
-                    pthread_mutex_unlock(&music_mode_mutex);
-                    write(client_socket, "OK:EXTRA_MUSIC_MODE:STOP\n", 24);
-                }
-            } else if (strcmp(cmd, "SENSOR") == 0) {
-                char *pin_str = strtok(NULL, ":");
-                if (pin_str != NULL) {
-                    int pin = atoi(pin_str);
-                    int value = light_sensor_read();
-                    // 센서값 응답 전송
-                    char response[64];
-                    sprintf(response, "VALUE:SENSOR:%d:%d\n", pin, value);
-                    write(client_socket, response, strlen(response));
-                    syslog(LOG_INFO, "센서 핀 %d 값: %d", pin, value);
-                }
-            } else if (strcmp(cmd, "ALL_OFF") == 0) {
-                led_off();
-                buzzer_off();
-                seg7_off();
-                write(client_socket, "OK:ALL_OFF\n", 11);
-                syslog(LOG_INFO, "ALL_OFF 명령으로 모든 디바이스 OFF");
-            } else if (strcmp(cmd, "TIMER") == 0) {
-                char *sec_str = strtok(NULL, ":");
-                if (sec_str) {
-                    int *seconds = malloc(sizeof(int));
-                    *seconds = atoi(sec_str);
-                    pthread_t t;
-                    pthread_create(&t, NULL, timer_off_thread, seconds);
-                    pthread_detach(t);
-                    char resp[64];
-                    sprintf(resp, "OK:TIMER:%d\n", *seconds);
-                    write(client_socket, resp, strlen(resp));
-                    syslog(LOG_INFO, "TIMER 예약 %d초 후 ALL_OFF 예약", *seconds);
-                }
-            }
+// TIMER:<초>[:<명령>] → OK:TIMER:<초>:<ID>, 명령을 생략하면 ALL_OFF
+static void cmd_timer(const struct request *req, struct reply *rep) {
+    if (req->nargs < 1 || req->args[0] < 0 || req->text_len >= TIMER_CMD_MAX) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    struct timer_job *job = malloc(sizeof(*job));
+    if (!job) {
+        reply_error(rep, ST_FAILED);
+        return;
+    }
+    if (req->text_len > 0) {
+        memcpy(job->cmd, req->text, req->text_len);
+        job->cmd[req->text_len] = '\0';
+    } else {
+        strcpy(job->cmd, "ALL_OFF");
+    }
+    // 만료 시점이 아니라 지금 명령 이름을 검사해 잘못된 예약을 바로 알린다
+    struct request check;
+    uint32_t id = 0;
+    if (proto_parse_text(job->cmd, &check) != ST_OK ||
+        (id = timer_add((unsigned long)req->args[0] * 1000, run_timer_job, job)) == 0) {
+        free(job);
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    job->jkey = journal_timer_add(journal_realtime_ms() + (uint64_t)req->args[0] * 1000, job->cmd);
+    reply_ok(rep, "OK:TIMER");
+    reply_value(rep, req->args[0]);
+    reply_value(rep, (int32_t)id);
+    log_msg(LOG_INFO, "TIMER %u 예약: %d초 후 %s", id, req->args[0], job->cmd);
+}
+
+static void cmd_timer_cancel(const struct request *req, struct reply *rep) {
+    void *job;
+    if (req->nargs < 1 || timer_cancel((uint32_t)req->args[0], &job) < 0) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    journal_timer_done(((struct timer_job *)job)->jkey);
+    free(job);
+    reply_ok(rep, "OK:TIMER:CANCEL");
+    reply_value(rep, req->args[0]);
+}
+
+struct timer_list_ctx {
+    char *buf;
+    size_t len;
+    int shown;
+};
+
+static void list_timer(uint32_t id, unsigned long remaining_ms, void *arg, void *ctx) {
+    struct timer_list_ctx *lc = ctx;
+    const struct timer_job *job = arg;
+    char line[TIMER_CMD_MAX + 48];
+    int n = snprintf(line, sizeof(line), "TIMER:%u:%lu:%s\n", id, remaining_ms, job->cmd);
+    if (n < 0 || lc->len + n > TIMER_LIST_BYTES) return;
+    memcpy(lc->buf + lc->len, line, n);
+    lc->len += n;
+    lc->shown++;
+}
+
+// OK:TIMER:LIST:<전체 수>:<표시한 수> 다음 줄부터 TIMER:<ID>:<남은 ms>:<명령>
+// 응답 크기 제한을 넘는 타이머는 전체 수에만 포함된다
+static void cmd_timer_list(const struct request *req, struct reply *rep) {
+    (void)req;
+    static char buf[TIMER_LIST_BYTES];
+    struct timer_list_ctx lc = {buf, 0, 0};
+    timer_foreach(list_timer, &lc);
+    reply_ok(rep, "OK:TIMER:LIST");
+    reply_value(rep, (int32_t)timer_count());
+    reply_value(rep, lc.shown);
+    reply_text(rep, buf, lc.len);
+}
+
+// SUBSCRIBE:SENSOR:<hz>[:CHANGE] → OK:SUBSCRIBE:SENSOR:<hz>:<변화 시에만 1>
+// 다시 보내면 설정을 바꾼다. 샘플은 공유 샘플러가 읽어 구독자별 주기/조건에 맞춰 묶어 보낸다.
+static void cmd_subscribe_sensor(const struct request *req, struct reply *rep) {
+    struct client *c = req->conn;
+    if (!c || req->nargs < 1 || req->args[0] < 1 || req->args[0] > SAMPLER_MAX_HZ) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    int change_only = (req->nargs > 1 && req->args[1]) ||
+                      (req->text_len == 6 && strncmp(req->text, "CHANGE", 6) == 0);
+    memset(&c->sensor, 0, sizeof(c->sensor));
+    c->sensor.hz = req->args[0];
+    c->sensor.change_only = change_only;
+    c->sensor.period_ns = 1000000000ULL / c->sensor.hz;
+    c->sensor.last_value = -1;
+    update_sampler_rate();
+    reply_ok(rep, "OK:SUBSCRIBE:SENSOR");
+    reply_value(rep, req->args[0]);
+    reply_value(rep, change_only);
+}
+
+static void cmd_unsubscribe_sensor(const struct request *req, struct reply *rep) {
+    struct client *c = req->conn;
+    if (!c) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    memset(&c->sensor, 0, sizeof(c->sensor));
+    update_sampler_rate();
+    reply_ok(rep, "OK:UNSUBSCRIBE:SENSOR");
+}
+
+static void cmd_subscribe_button(const struct request *req, struct reply *rep) {
+    struct client *c = req->conn;
+    if (!c) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    c->sub_button = req->opcode == OP_SUBSCRIBE_BUTTON;
+    reply_ok(rep, c->sub_button ? "OK:SUBSCRIBE:BUTTON" : "OK:UNSUBSCRIBE:BUTTON");
+}
+
+// 조회 시점의 연결/대기열 상태 (이벤트 루프 스레드에서만 호출)
+struct daemon_gauges {
+    int clients;
+    size_t out_bytes, out_max;      // 전송 링 버퍼에 쌓인 바이트 (합계/연결별 최대)
+    unsigned notify, notify_max;    // 알림 대기열 길이
+    size_t pin_pending;             // 디스패치 전 인터럽트 이벤트
+    size_t timers;
+    int buzzer_queued;
+    int sampler_hz;
+};
+
+static void collect_gauges(struct daemon_gauges *g) {
+    struct reply bs;
+    memset(g, 0, sizeof(*g));
+    g->clients = client_count;
+    for (struct client *c = client_list; c; c = c->next) {
+        size_t used = ringbuf_used(&c->out);
+        g->out_bytes += used;
+        if (used > g->out_max) g->out_max = used;
+        g->notify += c->notify.len;
+        if (c->notify.len > g->notify_max) g->notify_max = c->notify.len;
+    }
+    g->pin_pending = pin_events_pending();
+    g->timers = timer_count();
+    plugin_call(OP_BUZZER_STATUS, NULL, 0, &bs);
+    g->buzzer_queued = bs.status == ST_OK && bs.nvals >= 5 ? bs.vals[4] : 0;
+    g->sampler_hz = sampler_rate();
+}
+
+static uint64_t total_errors(void) {
+    uint64_t n = 0;
+    for (int op = 0; op < OP_MAX; op++) n += metrics_counter(METRIC_ERRORS_BASE + op);
+    return n;
+}
+
+// STATS 본문에 한 줄 덧붙인다. cap을 넘으면 덧붙이지 않고 -1
+static int stats_line(char *buf, size_t cap, size_t *len, const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+static int stats_line(char *buf, size_t cap, size_t *len, const char *fmt, ...) {
+    va_list ap;
+    if (*len >= cap) return -1;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf + *len, cap - *len, fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= cap - *len) return -1;
+    *len += n;
+    return 0;
+}
+
+// OK:STATS:<클라이언트 수>:<처리한 명령 수>:<오류 응답 수>:<가동 시간 초> 다음 줄부터 (시간은 모두 ns)
+// CONN:<접속>:<누적 수락>:<거부>
+// QUEUE:<전송 대기 바이트>:<연결별 최대>:<알림 대기>:<연결별 최대>:<인터럽트 대기>:<타이머>:<부저 대기 곡>:<샘플러 Hz>
+// JOURNAL:<덧붙인 기록>:<압축 횟수>:<버린 기록>:<현재 영역 사용 바이트>:<기록상 타이머>
+// WRITE:<실제로 쓴 핀>:<같은 값이라 생략>:<쓰기 전에 덮임>:<모으기 창 ms>
+// EXEC:<디바이스>:<실행한 작업>:<대기 중인 작업> (디바이스 실행기마다 한 줄)
+// INPUT:<입력 칩|isr>:<받은 엣지>:<알린 엣지>:<디바운스로 버림>:<read 횟수>:<잃은 엣지>
+// ISR:<dispatch|notify>:<건수>:<p50>:<p99>:<최대>
+// CMD:<명령>:<건수>:<오류>:<parse p50>:<parse p99>:<exec p50>:<exec p99>:<exec p99.9>:<exec 최대>
+// CMD 줄은 많이 쓴 명령부터, 응답 크기 제한 안에서만 표시하고 못 실은 수는 MORE:<수> 줄로 알린다
+static void cmd_stats(const struct request *req, struct reply *rep) {
+    (void)req;
+    static char buf[STATS_BYTES];
+    struct daemon_gauges g;
+    struct metric_summary parse, exec;
+    uint64_t counts[OP_MAX], commands = 0;
+    int order[OP_MAX], used = 0;
+    size_t len = 0;
+
+    collect_gauges(&g);
+    stats_line(buf, sizeof(buf), &len, "CONN:%d:%llu:%llu\nQUEUE:%zu:%zu:%u:%u:%zu:%zu:%d:%d\n", g.clients,
+               (unsigned long long)metrics_counter(METRIC_ACCEPTED), (unsigned long long)metrics_counter(METRIC_REJECTED),
+               g.out_bytes, g.out_max, g.notify, g.notify_max, g.pin_pending, g.timers, g.buzzer_queued, g.sampler_hz);
+    struct journal_stats js;
+    journal_get_stats(&js);
+    stats_line(buf, sizeof(buf), &len, "JOURNAL:%llu:%llu:%llu:%zu:%zu\n", (unsigned long long)js.records,
+               (unsigned long long)js.compactions, (unsigned long long)js.dropped, js.used, js.timers);
+    struct gpio_write_stats ws;
+    gpio_get_write_stats(&ws);
+    stats_line(buf, sizeof(buf), &len, "WRITE:%llu:%llu:%llu:%u\n", (unsigned long long)ws.writes,
+               (unsigned long long)ws.elided, (unsigned long long)ws.coalesced, coalesce_window());
+    for (int d = 0; d < DEV_MAX; d++) {
+        struct dev_exec_stats es;
+        if (dev_exec_get_stats(d, &es) < 0) continue;
+        stats_line(buf, sizeof(buf), &len, "EXEC:%s:%llu:%llu\n", dev_exec_name(d), (unsigned long long)es.executed,
+                   (unsigned long long)(es.submitted - es.executed));
+    }
+    struct gpio_lines_stats ls;
+    gpio_lines_get_stats(&ls);
+    stats_line(buf, sizeof(buf), &len, "INPUT:%s:%llu:%llu:%llu:%llu:%llu\n", gpio_lines_chip() ? gpio_lines_chip() : "isr",
+               (unsigned long long)ls.edges, (unsigned long long)ls.notified, (unsigned long long)ls.debounced,
+               (unsigned long long)ls.reads, (unsigned long long)ls.lost);
+    static const struct { int hist; const char *name; } isr[] = {
+        {METRIC_HIST_ISR_DISPATCH, "dispatch"},
+        {METRIC_HIST_ISR_NOTIFY, "notify"},
+    };
+    for (size_t i = 0; i < sizeof(isr) / sizeof(isr[0]); i++) {
+        metrics_summarize(isr[i].hist, &exec);
+        stats_line(buf, sizeof(buf), &len, "ISR:%s:%llu:%llu:%llu:%llu\n", isr[i].name, (unsigned long long)exec.count,
+                   (unsigned long long)exec.p50_ns, (unsigned long long)exec.p99_ns, (unsigned long long)exec.max_ns);
+    }
+
+    // 처리 건수 = parse 건수 (실행 전에 실패한 명령 포함), 많은 순으로 정렬
+    for (int op = 0; op < OP_MAX; op++) {
+        metrics_summarize(METRIC_HIST_CMD(METRIC_PARSE, op), &parse);
+        metrics_summarize(METRIC_HIST_CMD(METRIC_EXEC, op), &exec);
+        counts[op] = parse.count > exec.count ? parse.count : exec.count;
+        commands += counts[op];
+        if (counts[op] == 0) continue;
+        int i = used++;
+        while (i > 0 && counts[order[i - 1]] < counts[op]) {
+            order[i] = order[i - 1];
+            i--;
         }
+        order[i] = op;
     }
-    
-    // 클라이언트 연결 종료
-    syslog(LOG_INFO, "클라이언트 연결 종료");
-    
-    // 클라이언트 배열 정리
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (client_sockets[i] == client_socket) {
-            client_sockets[i] = -1;
+    // 다 싣지 못하면 MORE 줄로 나머지 수를 알린다 (그 자리는 남겨 둔다)
+    int shown = 0;
+    for (; shown < used; shown++) {
+        int op = order[shown];
+        const struct command_def *d = command_by_opcode(op);
+        metrics_summarize(METRIC_HIST_CMD(METRIC_PARSE, op), &parse);
+        metrics_summarize(METRIC_HIST_CMD(METRIC_EXEC, op), &exec);
+        size_t cap = shown + 1 < used ? sizeof(buf) - STATS_MORE_BYTES : sizeof(buf);
+        if (stats_line(buf, cap, &len, "CMD:%s:%llu:%llu:%llu:%llu:%llu:%llu:%llu:%llu\n", d ? d->verb : "UNKNOWN",
+                       (unsigned long long)counts[op], (unsigned long long)metrics_counter(METRIC_ERRORS_BASE + op),
+                       (unsigned long long)parse.p50_ns, (unsigned long long)parse.p99_ns,
+                       (unsigned long long)exec.p50_ns, (unsigned long long)exec.p99_ns,
+                       (unsigned long long)exec.p999_ns, (unsigned long long)exec.max_ns) < 0)
             break;
+    }
+    if (shown < used) stats_line(buf, sizeof(buf), &len, "MORE:%d\n", used - shown);
+
+    reply_ok(rep, "OK:STATS");
+    reply_value(rep, g.clients);
+    reply_value(rep, (int32_t)commands);
+    reply_value(rep, (int32_t)total_errors());
+    reply_value(rep, (int32_t)((metrics_now() - started_ns) / 1000000000ULL));
+    reply_text(rep, buf, len);
+}
+
+// Prometheus 수집 본문: 히스토그램/카운터 뒤에 연결/대기열 게이지
+size_t render_metrics(char *buf, size_t cap) {
+    struct daemon_gauges g;
+    size_t len = metrics_render_prometheus(buf, cap);
+    collect_gauges(&g);
+    int n = snprintf(buf + len, cap - len,
+                     "# TYPE gpio_clients gauge\ngpio_clients %d\n"
+                     "# TYPE gpio_output_buffered_bytes gauge\ngpio_output_buffered_bytes %zu\n"
+                     "# TYPE gpio_output_buffered_bytes_max gauge\ngpio_output_buffered_bytes_max %zu\n"
+                     "# TYPE gpio_notify_queue_depth gauge\ngpio_notify_queue_depth %u\n"
+                     "# TYPE gpio_notify_queue_depth_max gauge\ngpio_notify_queue_depth_max %u\n"
+                     "# TYPE gpio_interrupt_queue_depth gauge\ngpio_interrupt_queue_depth %zu\n"
+                     "# TYPE gpio_interrupt_dropped_total counter\ngpio_interrupt_dropped_total %lu\n"
+                     "# TYPE gpio_timers_pending gauge\ngpio_timers_pending %zu\n"
+                     "# TYPE gpio_buzzer_queue_depth gauge\ngpio_buzzer_queue_depth %d\n"
+                     "# TYPE gpio_sampler_hz gauge\ngpio_sampler_hz %d\n"
+                     "# TYPE gpio_uptime_seconds gauge\ngpio_uptime_seconds %.3f\n",
+                     g.clients, g.out_bytes, g.out_max, g.notify, g.notify_max, g.pin_pending, pin_events_dropped(),
+                     g.timers, g.buzzer_queued, g.sampler_hz, (metrics_now() - started_ns) / 1e9);
+    if (n > 0 && (size_t)n < cap - len) len += n;
+    struct gpio_write_stats ws;
+    gpio_get_write_stats(&ws);
+    n = snprintf(buf + len, cap - len,
+                 "# TYPE gpio_pin_writes_total counter\ngpio_pin_writes_total %llu\n"
+                 "# TYPE gpio_pin_writes_elided_total counter\ngpio_pin_writes_elided_total %llu\n"
+                 "# TYPE gpio_pin_writes_coalesced_total counter\ngpio_pin_writes_coalesced_total %llu\n",
+                 (unsigned long long)ws.writes, (unsigned long long)ws.elided, (unsigned long long)ws.coalesced);
+    if (n > 0 && (size_t)n < cap - len) len += n;
+    n = snprintf(buf + len, cap - len, "# TYPE gpio_exec_jobs_total counter\n# TYPE gpio_exec_queue_depth gauge\n");
+    if (n > 0 && (size_t)n < cap - len) len += n;
+    for (int d = 0; d < DEV_MAX; d++) {
+        struct dev_exec_stats es;
+        if (dev_exec_get_stats(d, &es) < 0) continue;
+        n = snprintf(buf + len, cap - len, "gpio_exec_jobs_total{device=\"%s\"} %llu\ngpio_exec_queue_depth{device=\"%s\"} %llu\n",
+                     dev_exec_name(d), (unsigned long long)es.executed, dev_exec_name(d),
+                     (unsigned long long)(es.submitted - es.executed));
+        if (n > 0 && (size_t)n < cap - len) len += n;
+    }
+    struct gpio_lines_stats ls;
+    gpio_lines_get_stats(&ls);
+    n = snprintf(buf + len, cap - len,
+                 "# TYPE gpio_input_edges_total counter\ngpio_input_edges_total %llu\n"
+                 "# TYPE gpio_input_debounced_total counter\ngpio_input_debounced_total %llu\n"
+                 "# TYPE gpio_input_lost_total counter\ngpio_input_lost_total %llu\n"
+                 "# TYPE gpio_input_reads_total counter\ngpio_input_reads_total %llu\n",
+                 (unsigned long long)ls.edges, (unsigned long long)ls.debounced, (unsigned long long)ls.lost,
+                 (unsigned long long)ls.reads);
+    if (n > 0 && (size_t)n < cap - len) len += n;
+    return len;
+}
+
+// INPUT:DEBOUNCE:<핀>[:<ms>] → OK:INPUT:DEBOUNCE:<핀>:<ms> (입력 엔진이 잡은 핀만)
+static void cmd_input_debounce(const struct request *req, struct reply *rep) {
+    if (req->nargs < 1 || gpio_lines_get_debounce(req->args[0]) < 0 ||
+        (req->nargs > 1 && (req->args[1] < 0 || gpio_lines_set_debounce(req->args[0], (uint32_t)req->args[1] * 1000) < 0))) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    reply_ok(rep, "OK:INPUT:DEBOUNCE");
+    reply_value(rep, req->args[0]);
+    reply_value(rep, (int32_t)(gpio_lines_get_debounce(req->args[0]) / 1000));
+}
+
+// LOG:LEVEL[:<레벨>] → OK:LOG:LEVEL:<레벨>, 레벨은 숫자(0~7) 또는 ERR/WARNING/NOTICE/INFO/DEBUG
+static void cmd_log_level(const struct request *req, struct reply *rep) {
+    static const struct { const char *name; int level; } names[] = {
+        {"ERR", LOG_ERR}, {"WARNING", LOG_WARNING}, {"NOTICE", LOG_NOTICE}, {"INFO", LOG_INFO}, {"DEBUG", LOG_DEBUG},
+    };
+    if (req->nargs > 0) {
+        if (req->args[0] < LOG_EMERG || req->args[0] > LOG_DEBUG) {
+            reply_error(rep, ST_BAD_ARGS);
+            return;
         }
+        log_set_level(req->args[0]);
+    } else if (req->text_len > 0) {
+        size_t i;
+        for (i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+            if (strlen(names[i].name) == req->text_len && strncmp(names[i].name, req->text, req->text_len) == 0) break;
+        if (i == sizeof(names) / sizeof(names[0])) {
+            reply_error(rep, ST_BAD_ARGS);
+            return;
+        }
+        log_set_level(names[i].level);
     }
-    
-    close(client_socket);
+    reply_ok(rep, "OK:LOG:LEVEL");
+    reply_value(rep, log_get_level());
+}
+
+// LOG:SAMPLE[:<N>] → OK:LOG:SAMPLE:<N>, 명령 수신 같은 빈번한 로그를 N건마다 한 번만 기록 (1이면 모두)
+static void cmd_log_sample(const struct request *req, struct reply *rep) {
+    if (req->nargs > 0) {
+        if (req->args[0] < 1) {
+            reply_error(rep, ST_BAD_ARGS);
+            return;
+        }
+        log_set_sample((unsigned)req->args[0]);
+    }
+    reply_ok(rep, "OK:LOG:SAMPLE");
+    reply_value(rep, (int32_t)log_get_sample());
+}
+
+static int reload_plugins(const char *name, int *failed);
+
+// RELOAD[:<이름>] → OK:RELOAD:<교체 수>:<실패 수>
+// 이름이 없으면 파일이 바뀐 .so만, 이름을 주면 그 모듈을 무조건 다시 싣는다
+static void cmd_reload(const struct request *req, struct reply *rep) {
+    char name[32];
+    int failed = 0;
+    if (req->text_len >= sizeof(name)) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    memcpy(name, req->text, req->text_len);
+    name[req->text_len] = '\0';
+    int swapped = reload_plugins(req->text_len ? name : NULL, &failed);
+    if (swapped < 0) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    reply_ok(rep, "OK:RELOAD");
+    reply_value(rep, swapped);
+    reply_value(rep, failed);
+}
+
+// PLUGIN:LIST → OK:PLUGIN:LIST:<개수> 뒤에 모듈마다 PLUGIN:<이름>:<버전>:<세대>:<so|builtin>:<정리 대기 수>
+static void cmd_plugin_list(const struct request *req, struct reply *rep) {
+    (void)req;
+    static char buf[PLUGIN_LIST_BYTES];
+    size_t len = 0;
+    struct plugin_info info;
+    for (size_t i = 0; plugin_get_info(i, &info) == 0; i++) {
+        int n = snprintf(buf + len, sizeof(buf) - len, "PLUGIN:%s:%u:%u:%s:%d\n", info.name, info.version,
+                         info.generation, info.builtin ? "builtin" : "so", info.retiring);
+        if (n < 0 || len + n >= sizeof(buf)) break;
+        len += n;
+    }
+    reply_ok(rep, "OK:PLUGIN:LIST");
+    reply_value(rep, (int32_t)plugin_count());
+    reply_text(rep, buf, len);
+}
+
+static const struct command_def system_commands[] = {
+    {VERB_EXTRA_MUSIC_MODE,   cmd_extra_music_mode},
+    {VERB_ALL_OFF,            cmd_all_off},
+    {VERB_TIMER,              cmd_timer},
+    {VERB_TIMER_CANCEL,       cmd_timer_cancel},
+    {VERB_TIMER_LIST,         cmd_timer_list},
+    {VERB_SUBSCRIBE_SENSOR,   cmd_subscribe_sensor},
+    {VERB_UNSUBSCRIBE_SENSOR, cmd_unsubscribe_sensor},
+    {VERB_SUBSCRIBE_BUTTON,   cmd_subscribe_button},
+    {VERB_UNSUBSCRIBE_BUTTON, cmd_subscribe_button},
+    {VERB_STATS,              cmd_stats},
+    {VERB_LOG_LEVEL,          cmd_log_level},
+    {VERB_LOG_SAMPLE,         cmd_log_sample},
+    {VERB_RELOAD,             cmd_reload},
+    {VERB_PLUGIN_LIST,        cmd_plugin_list},
+    {VERB_INPUT_DEBOUNCE,     cmd_input_debounce},
+};
+
+// 각 디바이스 모듈과 데몬의 명령을 레지스트리에 등록
+void register_commands(void) {
+    if (plugin_register_commands() < 0 ||
+        command_register(system_commands, sizeof(system_commands) / sizeof(system_commands[0])) < 0 ||
+        sequencer_register_commands() < 0 ||
+        (strcmp(gpio_backend_name(), "sim") == 0 && gpio_sim_register_commands() < 0)) {
+        log_msg(LOG_ERR, "명령 등록 실패 (중복된 명령 또는 opcode)");
+        exit(EXIT_FAILURE);
+    }
+    log_msg(LOG_INFO, "명령 %zu개 등록", command_count());
 }
 
 // 자원 정리 함수
 void cleanup(void) {
     // 모든 클라이언트 소켓 닫기
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (client_sockets[i] > 0) {
-            close(client_sockets[i]);
-        }
+    for (struct client *c = client_list; c; c = c->next) {
+        close(c->fd);
     }
     
-    syslog(LOG_INFO, "GPIO 데몬 종료");
-    closelog();
-}
-
-// 시그널 핸들러 함수
-void handle_signal(int sig) {
-    syslog(LOG_INFO, "시그널 %d 수신, 종료합니다", sig);
-    cleanup();
-    exit(EXIT_SUCCESS);
+    // 디바이스 실행기를 멈춰 정리 중에 명령이 끼어들지 않게 한다 (재개하지 않음)
+    dev_exec_pause();
+    gpio_lines_close();
+    // 출력을 끄기 전에 저널을 닫아, 재시작하면 끄기 직전의 출력이 복구되도록
+    journal_close();
+    teardown_gpio();
+    device_state_unpublish();
+    log_msg(LOG_INFO, "GPIO 데몬 종료");
+    log_shutdown();
 }
 
 // GPIO 출력 함수
 void write_to_gpio(int pin, int value) {
-    pinMode(pin, OUTPUT);
-    digitalWrite(pin, value);
+    gpio_pin_mode(pin, GPIO_OUTPUT);
+    gpio_write(pin, value);
 }
 
 // GPIO 입력 함수
 int read_from_gpio(int pin) {
-    pinMode(pin, INPUT);
-    return digitalRead(pin);
+    gpio_pin_mode(pin, GPIO_INPUT);
+    return gpio_read(pin);
 }
 
-void load_device_libs() {
-    led_lib = dlopen("./led.so", RTLD_LAZY);
-    if (!led_lib) syslog(LOG_ERR, "led.so 로드 실패: %s", dlerror());
+// 바뀐 플러그인 .so를 다시 읽는다 (SIGHUP, RELOAD 명령 공통, 이벤트 루프 스레드)
+static int reload_plugins(const char *name, int *failed) {
+    int swapped = plugin_reload(name, failed);
+    if (swapped >= 0)
+        log_msg(LOG_INFO, "플러그인 다시 읽기: 교체 %d, 실패 %d", swapped, *failed);
+    return swapped;
+}
 
-    buzzer_lib = dlopen("./buzzer.so", RTLD_LAZY);
-    if (!buzzer_lib) syslog(LOG_ERR, "buzzer.so 로드 실패: %s", dlerror());
+// signalfd로 받는 시그널: SIGHUP(플러그인 다시 읽기), SIGINT/SIGTERM(종료)
+void daemon_signals(sigset_t *set) {
+    sigemptyset(set);
+    sigaddset(set, SIGHUP);
+    sigaddset(set, SIGINT);
+    sigaddset(set, SIGTERM);
+}
 
-    sensor_lib = dlopen("./light_sensor.so", RTLD_LAZY);
-    if (!sensor_lib) syslog(LOG_ERR, "light_sensor.so 로드 실패: %s", dlerror());
+static void on_signal(int fd, uint32_t events, void *arg) {
+    (void)events;
+    (void)arg;
+    struct signalfd_siginfo si;
+    int failed;
+    while (read(fd, &si, sizeof(si)) == (ssize_t)sizeof(si)) {
+        if (si.ssi_signo == SIGHUP) {
+            reload_plugins(NULL, &failed);
+            continue;
+        }
+        log_msg(LOG_INFO, "시그널 %u 수신, 종료합니다", si.ssi_signo);
+        event_loop_stop();
+    }
+}
 
-    seg7_lib = dlopen("./seg7.so", RTLD_LAZY);
-    if (!seg7_lib) syslog(LOG_ERR, "seg7.so 로드 실패: %s", dlerror());
+void setup_signals(void) {
+    sigset_t sigs;
+    daemon_signals(&sigs);
+    int fd = signalfd(-1, &sigs, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0 || event_loop_add(fd, EPOLLIN, on_signal, NULL) < 0) {
+        // 막아 둔 시그널을 받을 길이 없으면 종료할 수 없으므로 시작하지 않는다
+        log_msg(LOG_ERR, "시그널 수신 등록 실패");
+        exit(EXIT_FAILURE);
+    }
 }
 
-void close_device_libs() {
-    if (led_lib) dlclose(led_lib);
-    if (buzzer_lib) dlclose(buzzer_lib);
-    if (sensor_lib) dlclose(sensor_lib);
-    if (seg7_lib) dlclose(seg7_lib);
+// 알림 대기열 정책: 버튼 엣지는 하나하나가 사건이라 오래된 것부터 버리고, 측정값은 최신 값으로 합친다
+static int event_policy(int device) {
+    return device == DEV_BUTTON ? EVQ_DROP_OLDEST : EVQ_COALESCE;
 }
 
-// 버튼 인터럽트 콜백 함수
-void button_isr(void) {
-    unsigned long now = millis();
-    if (now - last_button_time < 200) return; // 200ms 이내 재진입 방지(디바운스)
-    last_button_time = now;
+// 이벤트를 구독자에게 뿌린다. 쓰기는 논블로킹이고 느린 클라이언트는 자기 대기열만 넘친다.
+static void fan_out_event(const struct pin_event *ev) {
+    int policy = event_policy(ev->device);
+    for (struct client *c = client_list; c; c = c->next) {
+        if (ev->device == DEV_BUTTON && !c->sub_button) continue;
+        event_queue_push(&c->notify, ev, policy);
+        client_flush(c); // 실패한 연결은 목록 순회 중이므로 닫지 않고 EPOLLERR/HUP에서 정리
+    }
+}
 
-    syslog(LOG_INFO, "버튼 인터럽트 발생!");
-    pthread_mutex_lock(&music_mode_mutex);
-    int active = music_mode_active;
-    pthread_mutex_unlock(&music_mode_mutex);
-    if (active) {
-        pthread_mutex_lock(&music_mode_mutex);
-        music_mode_active = 0;
-        pthread_mutex_unlock(&music_mode_mutex);
+static void on_button(const struct pin_event *ev) {
+    static uint64_t last_ns = 0;
+    if (last_ns && ev->ts_ns - last_ns < button_debounce_ns) return; // 디바운스 (입력 엔진이면 이미 거름)
+    last_ns = ev->ts_ns;
+    struct device_state *st = device_state_begin();
+    st->button_presses++;
+    st->button_ns = ev->ts_ns;
+    device_state_end();
+
+    log_msg(LOG_INFO, "버튼 인터럽트 발생!");
+    music_mode_toggle();
+    fan_out_event(ev);
+    metrics_record(METRIC_HIST_ISR_NOTIFY, metrics_now() - ev->ts_ns);
+}
+
+// device_state_end마다 (쓰기 락 안): 복구 대상 출력만 저널에 옮긴다. 바뀌지 않았으면 저널이 버린다
+void journal_state(const struct device_state *st) {
+    struct journal_outputs o = {st->led_on, st->led_pwm, st->buzzer_on, st->seg7_digit, st->music_mode};
+    journal_record_outputs(&o);
+}
+
+struct restore_ctx {
+    uint64_t now_ms;
+    int timers;
+};
+
+// 저널에 남은 타이머를 남은 시간으로 다시 예약 (지난 것은 바로 실행). 저널 키는 그대로 쓴다
+static void restore_timer(uint64_t key, uint64_t due_ms, const char *cmd, void *ctx) {
+    struct restore_ctx *rc = ctx;
+    struct timer_job *job = malloc(sizeof(*job));
+    if (!job) return;
+    snprintf(job->cmd, sizeof(job->cmd), "%s", cmd);
+    job->jkey = key;
+    if (timer_add(due_ms > rc->now_ms ? due_ms - rc->now_ms : 0, run_timer_job, job) == 0) {
+        free(job);
+        return;
+    }
+    rc->timers++;
+}
+
+// 이전 실행의 마지막 출력과 대기 중이던 타이머를 되살린다 (명령 등록, 타이머 휠 생성 뒤)
+// setup_gpio가 끈 출력을 플러그인 경로로 다시 켠다. 음악 모드 도중이었다면 그 출력은 끈 채로 둔다
+void restore_state(void) {
+    if (journal_status < 0) return;
+    uint64_t t0 = metrics_now();
+    struct journal_outputs o;
+    int recovered = journal_recovered(&o);
+    journal_start();
+    if (!recovered) {
+        log_msg(LOG_INFO, "상태 저널 새로 시작: %s", journal_path);
+        return;
+    }
+    struct reply rep;
+    int32_t v;
+    if (o.music_mode) {
+        log_msg(LOG_WARNING, "음악 모드 도중 종료됨: 출력은 끈 채로 시작");
     } else {
-        pthread_t t;
-        pthread_create(&t, NULL, music_mode_thread, NULL);
-        pthread_detach(t);
-    }
-    // 기존 클라이언트 알림 메시지 유지
-    char msg[64];
-    sprintf(msg, "EVENT:BUTTON:%d:1\n", BUTTON_PIN);
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (client_sockets[i] > 0) {
-            write(client_sockets[i], msg, strlen(msg));
+        if (o.led_pwm > 0) {
+            v = o.led_pwm;
+            dev_exec_call(OP_LED_LEVEL, &v, 1, &rep);
+        } else if (o.led_on) {
+            dev_exec_call(OP_LED_ON, NULL, 0, &rep);
+        }
+        if (o.seg7_digit >= 0) {
+            v = o.seg7_digit;
+            dev_exec_call(OP_SEG7_SHOW, &v, 1, &rep);
         }
+        if (o.buzzer_on) dev_exec_call(OP_BUZZER_ON, NULL, 0, &rep);
     }
+    struct restore_ctx rc = {journal_realtime_ms(), 0};
+    journal_foreach_timer(restore_timer, &rc);
+    // 복구하지 않은 출력(음악 모드 등)이 저널에 남지 않도록 지금 상태를 한 번 기록
+    device_state_begin();
+    device_state_end();
+    log_msg(LOG_INFO, "상태 저널 복구: LED %d/%d, 세그먼트 %d, 부저 %d, 타이머 %d개 (%.2fms)", o.led_on, o.led_pwm,
+            o.seg7_digit, o.buzzer_on, rc.timers, (metrics_now() - t0) / 1e6);
+}
+
+// 시퀀서 IF 조건: 버튼은 눌림(상승 엣지 쪽 레벨) 1, 조도센서는 플러그인 읽기
+int read_input(int device) {
+    if (device == DEV_BUTTON) return gpio_read(BUTTON_PIN);
+    if (device == DEV_SENSOR) return plugin_read(DEV_SENSOR);
+    return -1;
+}
+
+// 샘플러 주기 = 구독자 중 가장 높은 요청 주기
+void update_sampler_rate(void) {
+    int hz = 0;
+    for (struct client *c = client_list; c; c = c->next)
+        if (c->sensor.hz > hz) hz = c->sensor.hz;
+    if (sampler_set_rate(hz) < 0) log_msg(LOG_ERR, "센서 샘플러 주기 설정 실패 (%d Hz)", hz);
+}
+
+// 공유 샘플러 콜백: 센서를 한 번 읽어 구독자별 주기/변화 조건에 맞춰 묶음에 넣는다
+void sample_sensor(uint64_t now) {
+    int value = plugin_read(DEV_SENSOR);
+    int32_t ts_ms = (int32_t)(now / 1000000 & 0x7fffffff);
+    for (struct client *c = client_list; c; c = c->next) {
+        struct sensor_sub *s = &c->sensor;
+        if (!s->hz) continue;
+        // 샘플러 주기의 흔들림으로 한 칸씩 밀리지 않도록 반 주기 여유를 둔다
+        if (now + s->period_ns / 2 >= s->next_due_ns && !(s->change_only && value == s->last_value)) {
+            s->next_due_ns = now - s->next_due_ns < s->period_ns ? s->next_due_ns + s->period_ns : now + s->period_ns;
+            if (s->count == SENSOR_BATCH_MAX) {
+                // 전송이 밀려 묶음이 가득 참: 가장 오래된 샘플을 버림
+                memmove(s->batch, s->batch + 1, sizeof(s->batch[0]) * (SENSOR_BATCH_MAX - 1));
+                s->count--;
+                c->notify.dropped++;
+            }
+            if (s->count == 0) s->first_ns = now;
+            s->batch[s->count][0] = ts_ms;
+            s->batch[s->count][1] = value;
+            s->count++;
+            s->last_value = value;
+        }
+        if (s->count > 0 && (s->change_only || s->count == SENSOR_BATCH_MAX ||
+                             now - s->first_ns >= SENSOR_BATCH_MS * 1000000ULL)) {
+            s->ready = 1;
+            client_flush(c);
+        }
+    }
+}
+
+// 인터럽트 이벤트 디스패처 (이벤트 루프 스레드에서 실행)
+void dispatch_pin_event(const struct pin_event *ev, void *arg) {
+    (void)arg;
+    static unsigned long reported_drops = 0;
+    metrics_record(METRIC_HIST_ISR_DISPATCH, metrics_now() - ev->ts_ns);
+    unsigned long drops = pin_events_dropped();
+    if (drops != reported_drops) {
+        log_msg(LOG_WARNING, "인터럽트 이벤트 큐 초과로 %lu건 유실", drops - reported_drops);
+        reported_drops = drops;
+    }
+    if (ev->device == DEV_BUTTON) on_button(ev);
+    else fan_out_event(ev);
+}
+
+// 버튼 인터럽트 콜백 함수 (입력 엔진을 열 수 없을 때만, 백엔드의 인터럽트 스레드)
+// 시각을 찍어 링에 넣기만 하고, 디바운스/음악 모드/알림은 디스패처가 맡는다
+void button_isr(void) {
+    pin_events_push(DEV_BUTTON, BUTTON_PIN, 1);
 }
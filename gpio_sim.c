@@ -0,0 +1,263 @@
+/**
+ * gpio_sim.c - 메모리 기반 시뮬레이션 GPIO 백엔드
+ *
+ * 핀 모드/레벨/PWM 듀티/톤 주파수를 메모리에 두고 모든 변화를 시간과 함께 기록한다.
+ * 하드웨어 없이 데몬 전체를 빌드/실행하고 네트워크 경로를 부하 테스트하는 용도.
+ */
+#include "gpio_hal.h"
+#include "gpio_sim.h"
+#include "command.h"
+#include "proto_verbs.h"
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#define SIM_EVENT_LOG 4096   // 보관할 최근 이벤트 수 (2의 거듭제곱)
+
+struct sim_pin {
+    int mode;
+    int level;
+    int pwm;
+    int pud;
+    int tone;
+    int input_set;           // 외부 입력이 한 번이라도 주어졌는지
+    int edge;                // ISR 엣지 조건
+    void (*isr)(void);
+};
+
+static struct sim_pin pins[GPIO_MAX_PINS];
+static struct gpio_sim_event event_log[SIM_EVENT_LOG];
+static unsigned long event_count = 0;
+static unsigned long op_count = 0;
+static pthread_mutex_t sim_mutex = PTHREAD_MUTEX_INITIALIZER;
+static void (*input_hook)(int pin, int value) = NULL;
+
+static unsigned long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// sim_mutex를 잡은 상태에서 호출
+static void record_at(unsigned long long ts, int pin, int kind, int value) {
+    struct gpio_sim_event *e = &event_log[event_count & (SIM_EVENT_LOG - 1)];
+    e->ts_ns = ts;
+    e->pin = pin;
+    e->kind = kind;
+    e->value = value;
+    event_count++;
+}
+
+static void record(int pin, int kind, int value) {
+    record_at(now_ns(), pin, kind, value);
+}
+
+static int valid_pin(int pin) {
+    return pin >= 0 && pin < GPIO_MAX_PINS;
+}
+
+static int sim_setup(void) {
+    pthread_mutex_lock(&sim_mutex);
+    op_count++;
+    pthread_mutex_unlock(&sim_mutex);
+    return 0;
+}
+
+static void sim_pin_mode(int pin, int mode) {
+    if (!valid_pin(pin)) return;
+    pthread_mutex_lock(&sim_mutex);
+    op_count++;
+    pins[pin].mode = mode;
+    record(pin, SIM_EV_MODE, mode);
+    pthread_mutex_unlock(&sim_mutex);
+}
+
+static void sim_write(int pin, int value) {
+    if (!valid_pin(pin)) return;
+    pthread_mutex_lock(&sim_mutex);
+    op_count++;
+    pins[pin].level = value ? 1 : 0;
+    record(pin, SIM_EV_WRITE, pins[pin].level);
+    pthread_mutex_unlock(&sim_mutex);
+}
+
+static int sim_read(int pin) {
+    if (!valid_pin(pin)) return 0;
+    pthread_mutex_lock(&sim_mutex);
+    op_count++;
+    struct sim_pin *p = &pins[pin];
+    // 외부 입력이 없으면 풀업/풀다운 설정을 따름
+    int value = p->input_set || p->mode != GPIO_INPUT ? p->level : p->pud == GPIO_PUD_UP;
+    pthread_mutex_unlock(&sim_mutex);
+    return value;
+}
+
+// 마스크의 모든 핀을 같은 시각에 한 번에 바꾼다
+static void sim_write_mask(uint32_t set_mask, uint32_t clear_mask) {
+    clear_mask &= ~set_mask;
+    pthread_mutex_lock(&sim_mutex);
+    op_count++;
+    unsigned long long ts = now_ns();
+    for (int pin = 0; pin < 32; pin++) {
+        uint32_t bit = 1u << pin;
+        if (!((set_mask | clear_mask) & bit)) continue;
+        pins[pin].level = (set_mask & bit) ? 1 : 0;
+        record_at(ts, pin, SIM_EV_WRITE, pins[pin].level);
+    }
+    pthread_mutex_unlock(&sim_mutex);
+}
+
+static void sim_pwm_write(int pin, int value) {
+    if (!valid_pin(pin)) return;
+    pthread_mutex_lock(&sim_mutex);
+    op_count++;
+    pins[pin].pwm = value;
+    record(pin, SIM_EV_PWM, value);
+    pthread_mutex_unlock(&sim_mutex);
+}
+
+// 실제 Pi와 같은 핀에만 하드웨어 PWM이 있는 것으로 흉내낸다 (나머지는 소프트웨어 PWM 경로를 탄다)
+static int sim_pwm_hw(int pin) {
+    return valid_pin(pin) && ((GPIO_PWM_HW_PINS >> pin) & 1);
+}
+
+static void sim_pull_up_dn(int pin, int pud) {
+    if (!valid_pin(pin)) return;
+    pthread_mutex_lock(&sim_mutex);
+    op_count++;
+    pins[pin].pud = pud;
+    pthread_mutex_unlock(&sim_mutex);
+}
+
+static int sim_isr(int pin, int edge, void (*fn)(void)) {
+    if (!valid_pin(pin)) return -1;
+    pthread_mutex_lock(&sim_mutex);
+    pins[pin].edge = edge;
+    pins[pin].isr = fn;
+    pthread_mutex_unlock(&sim_mutex);
+    return 0;
+}
+
+static int sim_tone_create(int pin) {
+    return valid_pin(pin) ? 0 : -1;
+}
+
+static void sim_tone_write(int pin, int freq) {
+    if (!valid_pin(pin)) return;
+    pthread_mutex_lock(&sim_mutex);
+    op_count++;
+    pins[pin].tone = freq;
+    record(pin, SIM_EV_TONE, freq);
+    pthread_mutex_unlock(&sim_mutex);
+}
+
+const struct gpio_backend gpio_sim_backend = {
+    .name = "sim",
+    .setup = sim_setup,
+    .pin_mode = sim_pin_mode,
+    .write = sim_write,
+    .read = sim_read,
+    .pwm_write = sim_pwm_write,
+    .pull_up_dn = sim_pull_up_dn,
+    .isr = sim_isr,
+    .tone_create = sim_tone_create,
+    .tone_write = sim_tone_write,
+    .write_mask = sim_write_mask,
+    .pwm_hw = sim_pwm_hw,
+};
+
+void gpio_sim_set_input(int pin, int value) {
+    if (!valid_pin(pin)) return;
+    void (*fn)(void) = NULL;
+    pthread_mutex_lock(&sim_mutex);
+    struct sim_pin *p = &pins[pin];
+    int old = p->input_set ? p->level : p->pud == GPIO_PUD_UP;
+    p->level = value ? 1 : 0;
+    p->input_set = 1;
+    record(pin, SIM_EV_INPUT, p->level);
+    if (p->isr && old != p->level) {
+        int rising = p->level == 1;
+        if ((rising && (p->edge & GPIO_EDGE_RISING)) || (!rising && (p->edge & GPIO_EDGE_FALLING))) fn = p->isr;
+    }
+    int level = p->level;
+    pthread_mutex_unlock(&sim_mutex);
+    // 실제 인터럽트처럼 잠금 밖에서 콜백 호출
+    if (fn) fn();
+    void (*hook)(int, int) = __atomic_load_n(&input_hook, __ATOMIC_ACQUIRE);
+    if (hook) hook(pin, level);
+}
+
+void gpio_sim_set_input_hook(void (*fn)(int pin, int value)) {
+    __atomic_store_n(&input_hook, fn, __ATOMIC_RELEASE);
+}
+
+int gpio_sim_level(int pin) {
+    return valid_pin(pin) ? pins[pin].level : 0;
+}
+
+int gpio_sim_mode(int pin) {
+    return valid_pin(pin) ? pins[pin].mode : 0;
+}
+
+int gpio_sim_pwm(int pin) {
+    return valid_pin(pin) ? pins[pin].pwm : 0;
+}
+
+int gpio_sim_tone(int pin) {
+    return valid_pin(pin) ? pins[pin].tone : 0;
+}
+
+size_t gpio_sim_events(struct gpio_sim_event *out, size_t max) {
+    pthread_mutex_lock(&sim_mutex);
+    size_t avail = event_count < SIM_EVENT_LOG ? event_count : SIM_EVENT_LOG;
+    size_t n = avail < max ? avail : max;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = event_log[(event_count - n + i) & (SIM_EVENT_LOG - 1)];
+    }
+    pthread_mutex_unlock(&sim_mutex);
+    return n;
+}
+
+unsigned long gpio_sim_op_count(void) {
+    pthread_mutex_lock(&sim_mutex);
+    unsigned long n = op_count;
+    pthread_mutex_unlock(&sim_mutex);
+    return n;
+}
+
+// ---- 시뮬레이션 전용 명령 (하드웨어 없이 입력/핀 상태 확인) ----
+static void cmd_sim_input(const struct request *req, struct reply *rep) {
+    if (req->nargs < 2 || !valid_pin(req->args[0])) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    gpio_sim_set_input(req->args[0], req->args[1]);
+    reply_ok(rep, "OK:SIM:INPUT");
+    reply_value(rep, req->args[0]);
+    reply_value(rep, req->args[1] ? 1 : 0);
+}
+
+static void cmd_sim_pin(const struct request *req, struct reply *rep) {
+    if (req->nargs < 1 || !valid_pin(req->args[0])) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    int pin = req->args[0];
+    pthread_mutex_lock(&sim_mutex);
+    reply_ok(rep, "VALUE:SIM:PIN");
+    reply_value(rep, pin);
+    reply_value(rep, pins[pin].mode);
+    reply_value(rep, pins[pin].level);
+    reply_value(rep, pins[pin].pwm);
+    reply_value(rep, pins[pin].tone);
+    pthread_mutex_unlock(&sim_mutex);
+}
+
+static const struct command_def sim_commands[] = {
+    {VERB_SIM_INPUT, cmd_sim_input},
+    {VERB_SIM_PIN,   cmd_sim_pin},
+};
+
+int gpio_sim_register_commands(void) {
+    return command_register(sim_commands, sizeof(sim_commands) / sizeof(sim_commands[0]));
+}
@@ -0,0 +1,33 @@
+#ifndef GPIO_SIM_H
+#define GPIO_SIM_H
+
+#include <stddef.h>
+
+// 시뮬레이션 이벤트 종류
+enum gpio_sim_event_kind {
+    SIM_EV_MODE = 0,
+    SIM_EV_WRITE,
+    SIM_EV_PWM,
+    SIM_EV_TONE,
+    SIM_EV_INPUT
+};
+
+// 시간이 기록된 핀 이벤트
+struct gpio_sim_event {
+    unsigned long long ts_ns;   // CLOCK_MONOTONIC 기준
+    int pin;
+    int kind;
+    int value;
+};
+
+void gpio_sim_set_input(int pin, int value); // 외부 입력 변경, 엣지가 맞으면 ISR 호출
+void gpio_sim_set_input_hook(void (*fn)(int pin, int value)); // 입력 변경마다 추가로 호출 (mock 문자 장치 연결용)
+int gpio_sim_level(int pin);
+int gpio_sim_mode(int pin);
+int gpio_sim_pwm(int pin);
+int gpio_sim_tone(int pin);
+size_t gpio_sim_events(struct gpio_sim_event *out, size_t max); // 최근 이벤트 (오래된 순)
+unsigned long gpio_sim_op_count(void);                          // 백엔드 호출 누적 횟수
+int gpio_sim_register_commands(void);                           // SIM:INPUT / SIM:PIN 명령 등록
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * gpio_wiringpi.c - wiringPi 기반 GPIO 백엔드 (실제 라즈베리파이용)
+ */
+#include "gpio_hal.h"
+#include <wiringPi.h>
+#include <softTone.h>
+
+static int wp_setup(void) {
+    return wiringPiSetupGpio();
+}
+
+static void wp_pin_mode(int pin, int mode) {
+    pinMode(pin, mode);
+}
+
+static void wp_write(int pin, int value) {
+    digitalWrite(pin, value);
+}
+
+static int wp_read(int pin) {
+    return digitalRead(pin);
+}
+
+// wiringPi 기본 범위는 0~1023이므로 0~255 듀티를 늘려서 쓴다
+static void wp_pwm_write(int pin, int value) {
+    pwmWrite(pin, value * 1023 / 255);
+}
+
+static int wp_pwm_hw(int pin) {
+    return pin >= 0 && pin < 64 && ((GPIO_PWM_HW_PINS >> pin) & 1);
+}
+
+static void wp_pull_up_dn(int pin, int pud) {
+    pullUpDnControl(pin, pud);
+}
+
+static int wp_isr(int pin, int edge, void (*fn)(void)) {
+    return wiringPiISR(pin, edge, fn);
+}
+
+static int wp_tone_create(int pin) {
+    return softToneCreate(pin);
+}
+
+static void wp_tone_write(int pin, int freq) {
+    softToneWrite(pin, freq);
+}
+
+const struct gpio_backend gpio_wiringpi_backend = {
+    .name = "wiringpi",
+    .setup = wp_setup,
+    .pin_mode = wp_pin_mode,
+    .write = wp_write,
+    .read = wp_read,
+    .pwm_write = wp_pwm_write,
+    .pull_up_dn = wp_pull_up_dn,
+    .isr = wp_isr,
+    .tone_create = wp_tone_create,
+    .tone_write = wp_tone_write,
+    .pwm_hw = wp_pwm_hw,
+};
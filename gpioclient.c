@@ -0,0 +1,552 @@
+/**
+ * gpioclient.c - 데몬 연결 하나에 대한 논블로킹 클라이언트 (libgpioclient)
+ *
+ * 연결은 논블로킹 connect → PROTO_MAGIC 교환 → READY 순서로 진행된다.
+ * 연결 중에 보낸 요청은 매직 뒤에 쌓아 두었다가 연결되면 함께 나간다.
+ * 응답이 제한 시간을 넘기면 그 연결의 seq를 더 믿을 수 없으므로 끊고 다시 연결한다.
+ */
+#include "gpioclient.h"
+#include "client_verbs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#define BACKOFF_MIN_MS 100
+#define BACKOFF_MAX_MS 5000
+#define CLIENT_IN_BUF (PROTO_MAX_REPLY * 2)
+
+struct pending {
+    gpioclient_cb cb;
+    void *arg;
+    uint64_t sent_ns;
+    int opcode;
+    uint16_t seq;
+    int used;
+};
+
+struct gpioclient {
+    char name[64];
+    int id;
+    struct sockaddr_in addr;
+    int fd;
+    int state;
+    unsigned backoff_ms;
+    uint64_t retry_ns;                  // DOWN일 때 다음 연결 시도 시각
+    uint64_t timeout_ns;
+    char *out;                          // 아직 보내지 못한 바이트
+    size_t out_len, out_cap;
+    uint8_t in[CLIENT_IN_BUF];
+    size_t in_len;
+    struct pending *pending;            // seq & window_mask
+    unsigned window, window_mask;       // 표 크기 (2의 거듭제곱)
+    int limit;                          // 응답 대기 요청 최대 개수
+    int inflight;
+    uint16_t next_seq;
+    gpioclient_cb event_cb;
+    void *event_arg;
+};
+
+static const char *const client_status_names[GPIOCLIENT_ST_MAX - ST_MAX] = {
+    [GPIOCLIENT_ST_DOWN - ST_MAX] = "DOWN",
+    [GPIOCLIENT_ST_TIMEOUT - ST_MAX] = "TIMEOUT",
+};
+
+const char *gpioclient_status_name(int status) {
+    if (status >= ST_MAX && status < GPIOCLIENT_ST_MAX) return client_status_names[status - ST_MAX];
+    return proto_status_name(status);
+}
+
+static uint64_t client_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int client_out(struct gpioclient *c, const void *data, size_t len) {
+    if (c->out_len + len > c->out_cap) {
+        size_t cap = (c->out_len + len) * 2;
+        char *p = realloc(c->out, cap);
+        if (!p) return -1;
+        c->out = p;
+        c->out_cap = cap;
+    }
+    memcpy(c->out + c->out_len, data, len);
+    c->out_len += len;
+    return 0;
+}
+
+static void result_init(struct gpioclient_result *res, struct gpioclient *c, int status) {
+    memset(res, 0, sizeof(*res));
+    res->client = c;
+    res->id = c->id;
+    res->name = c->name;
+    res->status = status;
+}
+
+// 연결을 닫고 대기 중인 요청을 모두 실패 처리, 다음 연결 시도를 백오프만큼 미룸
+// timed_out_before가 0이 아니면 그 시각 전에 보낸 요청은 TIMEOUT, 나머지는 DOWN으로 보고
+static void client_fail(struct gpioclient *c, uint64_t timed_out_before) {
+    uint64_t now = client_now_ns();
+    if (c->fd >= 0) {
+        close(c->fd);
+        c->fd = -1;
+    }
+    c->state = GPIOCLIENT_DOWN;
+    c->retry_ns = now + (uint64_t)c->backoff_ms * 1000000ULL;
+    c->backoff_ms = c->backoff_ms * 2 > BACKOFF_MAX_MS ? BACKOFF_MAX_MS : c->backoff_ms * 2;
+    c->out_len = 0;
+    c->in_len = 0;
+    if (c->inflight == 0) return;
+
+    // 콜백이 다시 요청을 보낼 수 있으므로 대기 목록을 먼저 비운다
+    struct pending *failed = malloc(c->inflight * sizeof(*failed));
+    int n = 0;
+    for (unsigned i = 0; i < c->window; i++) {
+        if (!c->pending[i].used) continue;
+        if (failed) failed[n++] = c->pending[i];
+        c->pending[i].used = 0;
+    }
+    c->inflight = 0;
+    for (int i = 0; i < n; i++) {
+        struct gpioclient_result res;
+        int timed_out = timed_out_before && failed[i].sent_ns < timed_out_before;
+        result_init(&res, c, timed_out ? GPIOCLIENT_ST_TIMEOUT : GPIOCLIENT_ST_DOWN);
+        res.opcode = failed[i].opcode;
+        res.seq = failed[i].seq;
+        res.latency_ns = now - failed[i].sent_ns;
+        if (failed[i].cb) failed[i].cb(&res, failed[i].arg);
+    }
+    free(failed);
+}
+
+static void client_connect(struct gpioclient *c) {
+    c->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (c->fd < 0) {
+        client_fail(c, 0);
+        return;
+    }
+    int one = 1;
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    c->state = GPIOCLIENT_CONNECTING;
+    c->out_len = 0;
+    c->in_len = 0;
+    client_out(c, PROTO_MAGIC, PROTO_MAGIC_LEN);
+    if (connect(c->fd, (struct sockaddr *)&c->addr, sizeof(c->addr)) == 0) c->state = GPIOCLIENT_HANDSHAKE;
+    else if (errno != EINPROGRESS) client_fail(c, 0);
+}
+
+struct gpioclient *gpioclient_new(const char *addr, int default_port) {
+    char ip[64];
+    int port = default_port;
+    if (client_verbs_register() < 0) return NULL;
+    struct gpioclient *c = calloc(1, sizeof(*c));
+    if (!c) return NULL;
+    c->fd = -1;
+    c->backoff_ms = BACKOFF_MIN_MS;
+    c->timeout_ns = (uint64_t)GPIOCLIENT_TIMEOUT_MS * 1000000ULL;
+    snprintf(c->name, sizeof(c->name), "%s", addr);
+    snprintf(ip, sizeof(ip), "%s", addr);
+    char *colon = strchr(ip, ':');
+    if (colon) {
+        *colon = '\0';
+        port = atoi(colon + 1);
+    }
+    c->addr.sin_family = AF_INET;
+    c->addr.sin_port = htons(port);
+    if (port <= 0 || port > 65535 || inet_pton(AF_INET, ip, &c->addr.sin_addr) <= 0 ||
+        gpioclient_set_window(c, GPIOCLIENT_WINDOW) < 0) {
+        gpioclient_free(c);
+        return NULL;
+    }
+    client_connect(c);
+    return c;
+}
+
+void gpioclient_free(struct gpioclient *c) {
+    if (!c) return;
+    if (c->fd >= 0) close(c->fd);
+    free(c->out);
+    free(c->pending);
+    free(c);
+}
+
+int gpioclient_set_window(struct gpioclient *c, int window) {
+    if (window < 1 || window > GPIOCLIENT_MAX_WINDOW || c->inflight > 0) return -1;
+    unsigned size = 1;
+    while (size < (unsigned)window) size <<= 1;
+    struct pending *p = calloc(size, sizeof(*p));
+    if (!p) return -1;
+    free(c->pending);
+    c->pending = p;
+    c->window = size;
+    c->window_mask = size - 1;
+    c->limit = window;
+    return 0;
+}
+
+void gpioclient_set_timeout(struct gpioclient *c, int timeout_ms) {
+    c->timeout_ns = (uint64_t)timeout_ms * 1000000ULL;
+}
+
+void gpioclient_set_id(struct gpioclient *c, int id) {
+    c->id = id;
+}
+
+void gpioclient_on_event(struct gpioclient *c, gpioclient_cb cb, void *arg) {
+    c->event_cb = cb;
+    c->event_arg = arg;
+}
+
+const char *gpioclient_name(const struct gpioclient *c) {
+    return c->name;
+}
+
+int gpioclient_state(const struct gpioclient *c) {
+    return c->state;
+}
+
+int gpioclient_pending(const struct gpioclient *c) {
+    return c->inflight;
+}
+
+int gpioclient_can_send(const struct gpioclient *c) {
+    return c->inflight < c->limit;
+}
+
+int gpioclient_send_request(struct gpioclient *c, struct request *req, gpioclient_cb cb, void *arg) {
+    struct gpioclient_result res;
+    if (c->state == GPIOCLIENT_DOWN && c->retry_ns <= client_now_ns()) client_connect(c); // 재시도 시각이 지났으면 바로 다시 연결
+    if (c->state == GPIOCLIENT_DOWN || !gpioclient_can_send(c)) {
+        result_init(&res, c, c->state == GPIOCLIENT_DOWN ? GPIOCLIENT_ST_DOWN : ST_BUSY);
+        res.opcode = req->opcode;
+        if (cb) cb(&res, arg);
+        return ST_OK;
+    }
+    do {
+        c->next_seq++;
+    } while (c->next_seq == 0 || c->pending[c->next_seq & c->window_mask].used);
+    req->seq = c->next_seq;
+    uint8_t frame[PROTO_HDR_SIZE + PROTO_MAX_PAYLOAD];
+    size_t n = proto_encode_request(req, frame, sizeof(frame));
+    if (n == 0) return ST_TOO_LONG;
+    if (client_out(c, frame, n) < 0) return ST_FAILED;
+    struct pending *pd = &c->pending[req->seq & c->window_mask];
+    pd->cb = cb;
+    pd->arg = arg;
+    pd->opcode = req->opcode;
+    pd->seq = req->seq;
+    pd->sent_ns = client_now_ns();
+    pd->used = 1;
+    c->inflight++;
+    return ST_OK;
+}
+
+int gpioclient_send(struct gpioclient *c, const char *cmd, gpioclient_cb cb, void *arg) {
+    struct request req;
+    int status = proto_parse_text(cmd, &req);
+    if (status != ST_OK) return status;
+    return gpioclient_send_request(c, &req, cb, arg);
+}
+
+// 숫자 인자만 있는 요청
+static int send_args(struct gpioclient *c, int opcode, int device, int nargs, const int32_t *args,
+                     gpioclient_cb cb, void *arg) {
+    struct request req;
+    memset(&req, 0, sizeof(req));
+    req.opcode = opcode;
+    req.device = device;
+    req.nargs = nargs;
+    for (int i = 0; i < nargs; i++) req.args[i] = args[i];
+    return gpioclient_send_request(c, &req, cb, arg);
+}
+
+int gpioclient_led(struct gpioclient *c, int on, gpioclient_cb cb, void *arg) {
+    return send_args(c, on ? OP_LED_ON : OP_LED_OFF, DEV_LED, 0, NULL, cb, arg);
+}
+
+int gpioclient_led_bright(struct gpioclient *c, int level, gpioclient_cb cb, void *arg) {
+    int32_t a[1] = {level};
+    return send_args(c, OP_LED_BRIGHT, DEV_LED, 1, a, cb, arg);
+}
+
+int gpioclient_led_level(struct gpioclient *c, int level, gpioclient_cb cb, void *arg) {
+    int32_t a[1] = {level};
+    return send_args(c, OP_LED_LEVEL, DEV_LED, 1, a, cb, arg);
+}
+
+int gpioclient_led_fade(struct gpioclient *c, int from, int to, int ms, gpioclient_cb cb, void *arg) {
+    int32_t a[3] = {from, to, ms};
+    return send_args(c, OP_LED_FADE, DEV_LED, 3, a, cb, arg);
+}
+
+int gpioclient_seg7(struct gpioclient *c, int digit, gpioclient_cb cb, void *arg) {
+    int32_t a[1] = {digit};
+    if (digit < 0) return send_args(c, OP_SEG7_OFF, DEV_SEG7, 0, NULL, cb, arg);
+    return send_args(c, OP_SEG7_SHOW, DEV_SEG7, 1, a, cb, arg);
+}
+
+int gpioclient_buzzer(struct gpioclient *c, int on, gpioclient_cb cb, void *arg) {
+    return send_args(c, on ? OP_BUZZER_ON : OP_BUZZER_OFF, DEV_BUZZER, 0, NULL, cb, arg);
+}
+
+int gpioclient_buzzer_music(struct gpioclient *c, int song, gpioclient_cb cb, void *arg) {
+    int32_t a[1] = {song};
+    return send_args(c, OP_BUZZER_MUSIC, DEV_BUZZER, 1, a, cb, arg);
+}
+
+int gpioclient_read_sensor(struct gpioclient *c, gpioclient_cb cb, void *arg) {
+    int32_t a[1] = {27};    // 데몬의 조도센서 핀 (light_sensor.h)
+    return send_args(c, OP_SENSOR_READ, DEV_SENSOR, 1, a, cb, arg);
+}
+
+int gpioclient_subscribe_button(struct gpioclient *c, int on, gpioclient_cb cb, void *arg) {
+    return send_args(c, on ? OP_SUBSCRIBE_BUTTON : OP_UNSUBSCRIBE_BUTTON, DEV_BUTTON, 0, NULL, cb, arg);
+}
+
+// SUBSCRIBE:SENSOR:<hz>[:CHANGE], hz가 0이면 해제
+int gpioclient_subscribe_sensor(struct gpioclient *c, int hz, int change_only, gpioclient_cb cb, void *arg) {
+    struct request req;
+    if (hz <= 0) return send_args(c, OP_UNSUBSCRIBE_SENSOR, DEV_SENSOR, 0, NULL, cb, arg);
+    memset(&req, 0, sizeof(req));
+    req.opcode = OP_SUBSCRIBE_SENSOR;
+    req.device = DEV_SENSOR;
+    req.nargs = 1;
+    req.args[0] = hz;
+    if (change_only) {
+        req.text = "CHANGE";
+        req.text_len = 6;
+    }
+    return gpioclient_send_request(c, &req, cb, arg);
+}
+
+int gpioclient_fd(const struct gpioclient *c) {
+    return c->fd;
+}
+
+uint32_t gpioclient_events(const struct gpioclient *c) {
+    if (c->fd < 0) return 0;
+    return POLLIN | (c->state == GPIOCLIENT_CONNECTING || c->out_len ? POLLOUT : 0);
+}
+
+static int client_flush(struct gpioclient *c) {
+    while (c->out_len > 0) {
+        ssize_t n = write(c->fd, c->out, c->out_len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) break;
+            return -1;
+        }
+        memmove(c->out, c->out + n, c->out_len - n);
+        c->out_len -= n;
+    }
+    return 0;
+}
+
+// 응답/알림 프레임 하나를 결과로 바꿔 콜백 호출
+static void client_frame(struct gpioclient *c, const uint8_t *frame, size_t len, uint64_t now) {
+    struct gpioclient_result res;
+    uint16_t seq;
+    memcpy(&seq, frame + 2, 2);
+    seq = ntohs(seq);
+    result_init(&res, c, ST_OK);
+    res.opcode = frame[4];
+    res.nvals = frame[6];
+    if ((size_t)res.nvals * 4 > len - PROTO_HDR_SIZE) res.nvals = (int)((len - PROTO_HDR_SIZE) / 4);
+    if (res.nvals > PROTO_MAX_ARGS) res.nvals = PROTO_MAX_ARGS;
+    for (int i = 0; i < res.nvals; i++) {
+        uint32_t v;
+        memcpy(&v, frame + PROTO_HDR_SIZE + i * 4, 4);
+        res.vals[i] = (int32_t)ntohl(v);
+    }
+    size_t values_len = (size_t)frame[6] * 4;
+    if (len - PROTO_HDR_SIZE > values_len) {
+        res.text = (const char *)frame + PROTO_HDR_SIZE + values_len;
+        res.text_len = len - PROTO_HDR_SIZE - values_len;
+    }
+
+    if (frame[7] & PROTO_FLAG_EVENT) {
+        res.device = frame[5];
+        if (c->event_cb) c->event_cb(&res, c->event_arg);
+        return;
+    }
+    struct pending *pd = &c->pending[seq & c->window_mask];
+    if (!pd->used) return;  // 시간 초과로 이미 보고한 요청
+    struct pending done = *pd;
+    pd->used = 0;
+    c->inflight--;
+    res.status = frame[5];
+    res.seq = seq;
+    res.latency_ns = now - done.sent_ns;
+    if (done.cb) done.cb(&res, done.arg);
+}
+
+static void client_read(struct gpioclient *c) {
+    for (;;) {
+        ssize_t n = read(c->fd, c->in + c->in_len, sizeof(c->in) - c->in_len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) return;
+        if (n <= 0) {
+            client_fail(c, 0);
+            return;
+        }
+        c->in_len += n;
+        uint64_t now = client_now_ns();
+        size_t pos = 0;
+        if (c->state == GPIOCLIENT_HANDSHAKE) {
+            if (c->in_len < PROTO_MAGIC_LEN) continue;
+            if (memcmp(c->in, PROTO_MAGIC, PROTO_MAGIC_LEN) != 0) {
+                client_fail(c, 0);
+                return;
+            }
+            c->state = GPIOCLIENT_READY;
+            c->backoff_ms = BACKOFF_MIN_MS;
+            pos = PROTO_MAGIC_LEN;
+        }
+        int fd = c->fd;
+        while (c->in_len - pos >= PROTO_HDR_SIZE && c->in_len - pos >= proto_frame_len(c->in + pos)) {
+            size_t len = proto_frame_len(c->in + pos);
+            client_frame(c, c->in + pos, len, now);
+            if (c->fd != fd) return;    // 콜백 안에서 연결이 정리됨
+            pos += len;
+        }
+        if (c->in_len - pos >= PROTO_HDR_SIZE && proto_frame_len(c->in + pos) > sizeof(c->in)) {
+            client_fail(c, 0);
+            return;
+        }
+        memmove(c->in, c->in + pos, c->in_len - pos);
+        c->in_len -= pos;
+    }
+}
+
+void gpioclient_handle(struct gpioclient *c, uint32_t revents) {
+    if (c->fd < 0) return;
+    if (c->state == GPIOCLIENT_CONNECTING && (revents & (POLLOUT | POLLERR | POLLHUP))) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+            client_fail(c, 0);
+            return;
+        }
+        c->state = GPIOCLIENT_HANDSHAKE;
+    }
+    if (c->state == GPIOCLIENT_CONNECTING) return;
+    if (revents & (POLLIN | POLLERR | POLLHUP)) client_read(c);
+    if (c->fd >= 0 && c->out_len > 0 && client_flush(c) < 0) client_fail(c, 0);
+}
+
+void gpioclient_tick(struct gpioclient *c) {
+    uint64_t now = client_now_ns();
+    if (c->state == GPIOCLIENT_DOWN) {
+        if (c->retry_ns <= now) client_connect(c);
+        return;
+    }
+    // 응답이 늦은 연결은 끊고 다시 연결
+    for (unsigned i = 0; c->inflight > 0 && i < c->window; i++) {
+        if (c->pending[i].used && c->pending[i].sent_ns + c->timeout_ns <= now) {
+            client_fail(c, now - c->timeout_ns + 1);
+            return;
+        }
+    }
+}
+
+int gpioclient_next_timeout(const struct gpioclient *c) {
+    uint64_t now = client_now_ns(), wake = UINT64_MAX;
+    if (c->state == GPIOCLIENT_DOWN) {
+        // 대기 요청이 없으면 다음 send가 알아서 다시 연결한다
+        if (c->inflight == 0) return -1;
+        wake = c->retry_ns;
+    }
+    for (unsigned i = 0; c->inflight > 0 && i < c->window; i++) {
+        if (c->pending[i].used && c->pending[i].sent_ns + c->timeout_ns < wake)
+            wake = c->pending[i].sent_ns + c->timeout_ns;
+    }
+    if (wake == UINT64_MAX) return -1;
+    return wake > now ? (int)((wake - now + 999999) / 1000000) : 0;
+}
+
+int gpioclient_process(struct gpioclient *c, int timeout_ms) {
+    gpioclient_tick(c);
+    int next = gpioclient_next_timeout(c);
+    if (c->fd < 0 && c->retry_ns > client_now_ns()) next = (int)((c->retry_ns - client_now_ns() + 999999) / 1000000);
+    if (next >= 0 && (timeout_ms < 0 || next < timeout_ms)) timeout_ms = next;
+    struct pollfd pfd = {.fd = c->fd, .events = (short)gpioclient_events(c)};
+    int n = poll(&pfd, c->fd >= 0 ? 1 : 0, timeout_ms);
+    if (n < 0) return errno == EINTR ? 0 : -1;
+    if (n > 0) gpioclient_handle(c, pfd.revents);
+    gpioclient_tick(c);
+    return n;
+}
+
+int gpioclient_wait(struct gpioclient *c, int timeout_ms) {
+    uint64_t end = client_now_ns() + (uint64_t)timeout_ms * 1000000ULL;
+    while (c->inflight > 0) {
+        uint64_t now = client_now_ns();
+        if (now >= end || gpioclient_process(c, (int)((end - now + 999999) / 1000000)) < 0) break;
+    }
+    return c->inflight;
+}
+
+int gpioclient_wait_ready(struct gpioclient *c, int timeout_ms) {
+    uint64_t end = client_now_ns() + (uint64_t)timeout_ms * 1000000ULL;
+    while (c->state != GPIOCLIENT_READY) {
+        uint64_t now = client_now_ns();
+        if (now >= end) return -1;
+        if (c->state == GPIOCLIENT_DOWN && c->retry_ns <= now) client_connect(c);
+        // 연결 중이 아니면 재시도 시각까지 기다림
+        int wait = (int)((end - now + 999999) / 1000000);
+        if (c->state == GPIOCLIENT_DOWN && c->retry_ns > now && (c->retry_ns - now) / 1000000 < (uint64_t)wait)
+            wait = (int)((c->retry_ns - now + 999999) / 1000000);
+        if (gpioclient_process(c, wait) < 0) return -1;
+    }
+    return 0;
+}
+
+struct call_state {
+    struct gpioclient_result *result;
+    char *text;
+    size_t cap;
+    int done;
+};
+
+static void call_done(const struct gpioclient_result *res, void *arg) {
+    struct call_state *cs = arg;
+    *cs->result = *res;
+    cs->result->text = NULL;
+    cs->result->text_len = 0;
+    if (cs->text && cs->cap > 0) {
+        size_t n = res->text_len < cs->cap - 1 ? res->text_len : cs->cap - 1;
+        memcpy(cs->text, res->text, n);
+        cs->text[n] = '\0';
+        cs->result->text = cs->text;
+        cs->result->text_len = n;
+    }
+    cs->done = 1;
+}
+
+int gpioclient_call(struct gpioclient *c, const char *cmd, struct gpioclient_result *result,
+                    char *text, size_t cap, int timeout_ms) {
+    struct call_state cs = {result, text, cap, 0};
+    int status = gpioclient_send(c, cmd, call_done, &cs);
+    if (status != ST_OK) {
+        result_init(result, c, status);
+        return status;
+    }
+    uint64_t end = client_now_ns() + (uint64_t)timeout_ms * 1000000ULL;
+    while (!cs.done) {
+        uint64_t now = client_now_ns();
+        if (now >= end || gpioclient_process(c, (int)((end - now + 999999) / 1000000)) < 0) break;
+    }
+    if (!cs.done) {
+        // 응답이 아직 오지 않음: 연결을 끊어 대기 요청을 정리한다 (콜백이 한 번 불림)
+        client_fail(c, client_now_ns() + 1);
+    }
+    return result->status;
+}
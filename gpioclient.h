@@ -0,0 +1,105 @@
+#ifndef GPIOCLIENT_H
+#define GPIOCLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "protocol.h"
+
+/*
+ * libgpioclient - 데몬 연결 하나에 대한 논블로킹 클라이언트
+ * - 바이너리 프로토콜로 연결하고, 요청마다 seq를 붙여 응답을 콜백으로 돌려준다
+ * - 전송/수신 버퍼를 내부에 두므로 send는 막히지 않는다 (연결 중에 보낸 요청은 연결되면 나간다)
+ * - 응답이 제한 시간을 넘기면 TIMEOUT으로 알리고 연결을 끊는다. 끊긴 연결은 지수 백오프로 다시 연결한다
+ * - 단일 스레드용: 모든 함수와 콜백은 같은 스레드에서 호출된다
+ *
+ * 직접 돌릴 때는 gpioclient_process()를, 자기 이벤트 루프에 넣을 때는
+ * gpioclient_fd()/gpioclient_events()로 감시하고 gpioclient_handle()/gpioclient_tick()을 부른다.
+ * fd는 다시 연결할 때 바뀔 수 있으므로 매번 다시 확인할 것.
+ */
+
+#define GPIOCLIENT_WINDOW 256           // 기본 응답 대기 요청 최대 개수
+#define GPIOCLIENT_MAX_WINDOW 4096
+#define GPIOCLIENT_TIMEOUT_MS 2000
+
+// proto_status 뒤에 이어지는 클라이언트 전용 상태 코드
+enum gpioclient_status {
+    GPIOCLIENT_ST_DOWN = ST_MAX,        // 연결이 없거나 응답 전에 끊김
+    GPIOCLIENT_ST_TIMEOUT,              // 제한 시간 안에 응답 없음
+    GPIOCLIENT_ST_MAX
+};
+
+enum gpioclient_state {
+    GPIOCLIENT_DOWN = 0,
+    GPIOCLIENT_CONNECTING,
+    GPIOCLIENT_HANDSHAKE,
+    GPIOCLIENT_READY
+};
+
+struct gpioclient;
+
+struct gpioclient_result {
+    struct gpioclient *client;
+    int id;                             // gpioclient_set_id로 붙인 값 (연결 풀은 호스트 인덱스)
+    const char *name;                   // 생성 시 준 주소 문자열
+    int status;                         // enum proto_status 또는 enum gpioclient_status
+    int opcode;
+    uint16_t seq;                       // 요청에 붙인 seq (보내지 못한 요청과 알림은 0)
+    int device;                         // 알림이면 디바이스 ID
+    int nvals;
+    int32_t vals[PROTO_MAX_ARGS];
+    const char *text;                   // 여러 줄 응답 본문 (콜백 안에서만 유효)
+    size_t text_len;
+    uint64_t latency_ns;                // 요청을 버퍼에 넣은 뒤 응답까지
+};
+
+typedef void (*gpioclient_cb)(const struct gpioclient_result *res, void *arg);
+
+// addr: "IP" 또는 "IP:포트", 포트가 없으면 default_port. 연결은 바로 시작한다 (논블로킹)
+struct gpioclient *gpioclient_new(const char *addr, int default_port);
+void gpioclient_free(struct gpioclient *c);
+
+int gpioclient_set_window(struct gpioclient *c, int window);   // 대기 요청이 없을 때만, 0 또는 -1
+void gpioclient_set_timeout(struct gpioclient *c, int timeout_ms);
+void gpioclient_set_id(struct gpioclient *c, int id);
+void gpioclient_on_event(struct gpioclient *c, gpioclient_cb cb, void *arg);   // 서버 알림 콜백
+
+const char *gpioclient_name(const struct gpioclient *c);
+int gpioclient_state(const struct gpioclient *c);
+int gpioclient_pending(const struct gpioclient *c);
+int gpioclient_can_send(const struct gpioclient *c);           // 창에 여유가 있으면 1
+
+// 요청 보내기: 0 또는 명령을 해석하지 못한 경우 상태 코드 (이때는 콜백 없음)
+// 연결이 없거나 창이 가득 차면 콜백으로 바로 실패를 알린다.
+int gpioclient_send(struct gpioclient *c, const char *cmd, gpioclient_cb cb, void *arg);
+int gpioclient_send_request(struct gpioclient *c, struct request *req, gpioclient_cb cb, void *arg);
+
+// 자주 쓰는 명령
+int gpioclient_led(struct gpioclient *c, int on, gpioclient_cb cb, void *arg);
+int gpioclient_led_bright(struct gpioclient *c, int level, gpioclient_cb cb, void *arg);
+int gpioclient_led_level(struct gpioclient *c, int level, gpioclient_cb cb, void *arg);             // 0~255
+int gpioclient_led_fade(struct gpioclient *c, int from, int to, int ms, gpioclient_cb cb, void *arg); // 서버 쪽 페이드
+int gpioclient_seg7(struct gpioclient *c, int digit, gpioclient_cb cb, void *arg);   // digit < 0이면 끄기
+int gpioclient_buzzer(struct gpioclient *c, int on, gpioclient_cb cb, void *arg);
+int gpioclient_buzzer_music(struct gpioclient *c, int song, gpioclient_cb cb, void *arg);
+int gpioclient_read_sensor(struct gpioclient *c, gpioclient_cb cb, void *arg);      // vals = {핀, 값}
+int gpioclient_subscribe_button(struct gpioclient *c, int on, gpioclient_cb cb, void *arg);
+int gpioclient_subscribe_sensor(struct gpioclient *c, int hz, int change_only, gpioclient_cb cb, void *arg);
+
+// 이벤트 루프 연동
+int gpioclient_fd(const struct gpioclient *c);                  // 연결이 없으면 -1
+uint32_t gpioclient_events(const struct gpioclient *c);         // 감시할 POLLIN/POLLOUT (epoll 값과 같음)
+void gpioclient_handle(struct gpioclient *c, uint32_t revents);
+void gpioclient_tick(struct gpioclient *c);                     // 재연결, 응답 시간 초과 처리
+int gpioclient_next_timeout(const struct gpioclient *c);        // 다음 tick까지 ms, 없으면 -1
+
+// 단독 실행
+int gpioclient_process(struct gpioclient *c, int timeout_ms);   // poll 한 번, -1 오류
+int gpioclient_wait(struct gpioclient *c, int timeout_ms);      // 대기 요청이 없어질 때까지, 남은 대기 요청 수
+int gpioclient_wait_ready(struct gpioclient *c, int timeout_ms); // 연결되면 0, 아니면 -1
+// 동기 호출: 응답(또는 실패)을 기다려 result에 담는다. 본문은 text/cap에 복사한다. 반환값은 상태 코드
+int gpioclient_call(struct gpioclient *c, const char *cmd, struct gpioclient_result *result,
+                    char *text, size_t cap, int timeout_ms);
+
+const char *gpioclient_status_name(int status);
+
+#endif
@@ -0,0 +1,371 @@
+/**
+ * journal.c - mmap 상태 저널
+ *
+ * 파일: [헤더 4KB][영역 0][영역 1]. 영역은 BEGIN(세대, 다음 타이머 키) → OUTPUTS → TIMER_ADD... → SNAP_END
+ * 스냅샷으로 시작하고, 이후 OUTPUTS / TIMER_ADD / TIMER_DONE 기록이 이어진다.
+ * 기록: [체크섬 4][세대 4][길이 2][종류 1][0 1][본문], 8바이트 정렬. 본문을 먼저 쓰고 머리를 나중에 쓴다.
+ * 복구는 SNAP_END까지 온전한 영역 중 세대가 큰 쪽을, 체크섬이나 세대가 어긋나는 곳까지 재생한다.
+ * 저널은 출력과 타이머의 사본(mirror)을 메모리에 두고, 압축할 때 그 사본으로 스냅샷을 쓴다.
+ */
+#define _GNU_SOURCE
+#include "journal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define JOURNAL_MAGIC 0x4c4a5047u   // "GPJL"
+#define JOURNAL_VERSION 1
+#define JOURNAL_HDR_SIZE 4096
+#define JOURNAL_FILE_SIZE (JOURNAL_HDR_SIZE + 2 * JOURNAL_REGION_SIZE)
+#define REC_ALIGN 8
+#define SNAP_END_RESERVE 16         // 타이머가 넘쳐도 SNAP_END는 들어가도록 남겨 둘 자리
+#define TIMER_BUCKETS 1024
+
+struct file_hdr {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t region_size;
+    uint32_t reserved;
+};
+
+enum rec_type {
+    REC_BEGIN = 1,      // 본문: 다음 타이머 키 (uint64)
+    REC_OUTPUTS,        // 본문: struct journal_outputs
+    REC_TIMER_ADD,      // 본문: 키, 만료 시각(ms), 명령 (NUL 없음)
+    REC_TIMER_DONE,     // 본문: 키
+    REC_SNAP_END
+};
+
+struct rec_hdr {
+    uint32_t sum;       // 이 뒤의 머리 필드와 본문의 FNV-1a
+    uint32_t gen;
+    uint16_t len;       // 본문 길이
+    uint8_t type;
+    uint8_t pad;
+};
+
+struct rec_timer {
+    uint64_t key;
+    uint64_t due_ms;
+};
+
+// 쓰는 위치
+struct cursor {
+    uint8_t *base;      // 영역 시작
+    size_t pos;
+    size_t cap;
+    uint32_t gen;
+};
+
+struct jtimer {
+    uint64_t key;
+    uint64_t due_ms;
+    struct jtimer *next;
+    size_t len;
+    char cmd[JOURNAL_CMD_MAX + 1];
+};
+
+static pthread_mutex_t journal_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t *map = NULL;
+static int jfd = -1;
+static int active = 0;                  // 지금 덧붙이는 영역
+static struct cursor cur;
+static int recording = 0;
+static size_t snap_end = 0;             // 현재 영역에서 스냅샷이 끝나는 위치
+static uint64_t next_key = 1;
+
+static struct journal_outputs outputs = {.seg7_digit = -1};
+static struct jtimer *buckets[TIMER_BUCKETS];
+static size_t ntimers = 0;
+
+static int recovered = 0;
+static struct journal_outputs recovered_outputs;
+static struct journal_stats stats;
+
+uint64_t journal_realtime_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint8_t *region(int i) {
+    return map + JOURNAL_HDR_SIZE + (size_t)i * JOURNAL_REGION_SIZE;
+}
+
+static uint32_t fnv1a(uint32_t h, const void *data, size_t len) {
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t checksum(const struct rec_hdr *h, const void *body) {
+    uint32_t sum = fnv1a(2166136261u, (const uint8_t *)h + sizeof(h->sum), sizeof(*h) - sizeof(h->sum));
+    return fnv1a(sum, body, h->len);
+}
+
+// ---- 타이머 사본 ----
+
+static struct jtimer **timer_slot(uint64_t key) {
+    struct jtimer **pp = &buckets[key % TIMER_BUCKETS];
+    while (*pp && (*pp)->key != key) pp = &(*pp)->next;
+    return pp;
+}
+
+static void timer_put(uint64_t key, uint64_t due_ms, const char *cmd, size_t len) {
+    struct jtimer **pp = timer_slot(key);
+    if (*pp || len > JOURNAL_CMD_MAX) return;
+    struct jtimer *t = malloc(sizeof(*t));
+    if (!t) return;
+    t->key = key;
+    t->due_ms = due_ms;
+    t->next = NULL;
+    t->len = len;
+    memcpy(t->cmd, cmd, len);
+    t->cmd[len] = '\0';
+    *pp = t;
+    ntimers++;
+    if (key >= next_key) next_key = key + 1;
+}
+
+static void timer_drop(uint64_t key) {
+    struct jtimer **pp = timer_slot(key);
+    struct jtimer *t = *pp;
+    if (!t) return;
+    *pp = t->next;
+    free(t);
+    ntimers--;
+}
+
+// ---- 기록 ----
+
+// 본문 a, b를 이어 붙인 기록 하나. 자리가 없으면 -1
+static int emit(struct cursor *c, int type, const void *a, size_t alen, const void *b, size_t blen) {
+    size_t len = alen + blen;
+    size_t total = (sizeof(struct rec_hdr) + len + REC_ALIGN - 1) & ~(size_t)(REC_ALIGN - 1);
+    if (c->pos + total > c->cap) return -1;
+    uint8_t *p = c->base + c->pos;
+    struct rec_hdr h = {0, c->gen, (uint16_t)len, (uint8_t)type, 0};
+    if (alen) memcpy(p + sizeof(h), a, alen);
+    if (blen) memcpy(p + sizeof(h) + alen, b, blen);
+    h.sum = checksum(&h, p + sizeof(h));
+    memcpy(p, &h, sizeof(h));
+    c->pos += total;
+    return 0;
+}
+
+// journal_mutex를 잡은 상태에서 호출. 반대쪽 영역에 사본으로 스냅샷을 쓰고 넘어간다
+static void compact_locked(void) {
+    struct cursor c = {region(!active), 0, JOURNAL_REGION_SIZE - SNAP_END_RESERVE, cur.gen + 1};
+    emit(&c, REC_BEGIN, &next_key, sizeof(next_key), NULL, 0);
+    emit(&c, REC_OUTPUTS, &outputs, sizeof(outputs), NULL, 0);
+    for (int b = 0; b < TIMER_BUCKETS; b++) {
+        for (struct jtimer *t = buckets[b]; t; t = t->next) {
+            struct rec_timer rt = {t->key, t->due_ms};
+            if (emit(&c, REC_TIMER_ADD, &rt, sizeof(rt), t->cmd, t->len) < 0) stats.dropped++;
+        }
+    }
+    c.cap = JOURNAL_REGION_SIZE;
+    emit(&c, REC_SNAP_END, NULL, 0, NULL, 0);
+    // SNAP_END까지 쓴 뒤에야 새 영역이 복구 대상이 된다
+    active = !active;
+    cur = c;
+    snap_end = c.pos;
+    stats.compactions++;
+    msync(map, JOURNAL_FILE_SIZE, MS_ASYNC);
+}
+
+// journal_mutex를 잡은 상태에서 호출. 사본은 이미 바뀐 상태이므로 자리가 없으면 압축만으로 반영된다
+// 스냅샷 뒤 변경 기록이 남은 자리의 절반을 넘으면 압축해 재생할 양을 묶어 둔다
+static void append(int type, const void *a, size_t alen, const void *b, size_t blen) {
+    if (emit(&cur, type, a, alen, b, blen) < 0) {
+        compact_locked();
+        return;
+    }
+    stats.records++;
+    if (cur.pos - snap_end > (JOURNAL_REGION_SIZE - snap_end) / 2) compact_locked();
+}
+
+// ---- 복구 ----
+
+// 영역을 처음부터 읽어 온전한 기록 수만큼 진행한다. apply면 사본에 반영
+// 반환: 스냅샷이 완전하면 1 (gen, end에 세대와 끝 위치)
+static int replay(int r, int apply, uint32_t *gen, size_t *end) {
+    const uint8_t *base = region(r);
+    size_t pos = 0;
+    int complete = 0;
+    struct rec_hdr h;
+    memcpy(&h, base, sizeof(h));
+    if (h.type != REC_BEGIN || h.len != sizeof(uint64_t) || h.sum != checksum(&h, base + sizeof(h))) return 0;
+    *gen = h.gen;
+    while (pos + sizeof(h) <= JOURNAL_REGION_SIZE) {
+        memcpy(&h, base + pos, sizeof(h));
+        size_t total = (sizeof(h) + h.len + REC_ALIGN - 1) & ~(size_t)(REC_ALIGN - 1);
+        if (h.gen != *gen || pos + total > JOURNAL_REGION_SIZE || h.sum != checksum(&h, base + pos + sizeof(h))) break;
+        const uint8_t *body = base + pos + sizeof(h);
+        if (apply) {
+            struct rec_timer rt;
+            switch (h.type) {
+            case REC_BEGIN:
+                memcpy(&next_key, body, sizeof(next_key));
+                break;
+            case REC_OUTPUTS:
+                if (h.len == sizeof(outputs)) memcpy(&outputs, body, sizeof(outputs));
+                break;
+            case REC_TIMER_ADD:
+                if (h.len < sizeof(rt)) break;
+                memcpy(&rt, body, sizeof(rt));
+                timer_put(rt.key, rt.due_ms, (const char *)body + sizeof(rt), h.len - sizeof(rt));
+                break;
+            case REC_TIMER_DONE:
+                if (h.len != sizeof(rt.key)) break;
+                memcpy(&rt.key, body, sizeof(rt.key));
+                timer_drop(rt.key);
+                break;
+            }
+        }
+        if (h.type == REC_SNAP_END) complete = 1;
+        pos += total;
+    }
+    *end = pos;
+    return complete;
+}
+
+int journal_open(const char *path) {
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (flock(fd, LOCK_EX | LOCK_NB) < 0 || fstat(fd, &st) < 0) {
+        close(fd);
+        return -1;
+    }
+    int fresh = st.st_size != JOURNAL_FILE_SIZE;
+    if (fresh && (ftruncate(fd, 0) < 0 || ftruncate(fd, JOURNAL_FILE_SIZE) < 0)) {
+        close(fd);
+        return -1;
+    }
+    void *p = mmap(NULL, JOURNAL_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    pthread_mutex_lock(&journal_mutex);
+    map = p;
+    jfd = fd;
+    struct file_hdr *fh = (struct file_hdr *)map;
+    if (fh->magic != JOURNAL_MAGIC || fh->version != JOURNAL_VERSION || fh->region_size != JOURNAL_REGION_SIZE) {
+        memset(map, 0, JOURNAL_FILE_SIZE);
+        fh->magic = JOURNAL_MAGIC;
+        fh->version = JOURNAL_VERSION;
+        fh->region_size = JOURNAL_REGION_SIZE;
+        fresh = 1;
+    }
+    uint32_t gen[2] = {0, 0};
+    size_t end[2] = {0, 0};
+    int ok[2];
+    for (int r = 0; r < 2; r++) ok[r] = !fresh && replay(r, 0, &gen[r], &end[r]);
+    int pick = ok[0] && (!ok[1] || gen[0] > gen[1]) ? 0 : ok[1] ? 1 : -1;
+    active = pick >= 0 ? pick : 1;      // 첫 압축이 영역 0에 쓰도록
+    cur.base = region(active);
+    cur.cap = JOURNAL_REGION_SIZE;
+    cur.gen = gen[0] > gen[1] ? gen[0] : gen[1];
+    cur.pos = pick >= 0 ? end[pick] : 0;
+    if (pick >= 0) {
+        replay(pick, 1, &gen[pick], &end[pick]);
+        recovered = 1;
+        recovered_outputs = outputs;
+    }
+    pthread_mutex_unlock(&journal_mutex);
+    return recovered;
+}
+
+int journal_recovered(struct journal_outputs *out) {
+    pthread_mutex_lock(&journal_mutex);
+    int r = recovered;
+    if (r) *out = recovered_outputs;
+    pthread_mutex_unlock(&journal_mutex);
+    return r;
+}
+
+// fn 안에서 저널 함수를 부르지 말 것 (journal_mutex를 잡고 있음)
+void journal_foreach_timer(journal_timer_fn fn, void *ctx) {
+    pthread_mutex_lock(&journal_mutex);
+    for (int b = 0; b < TIMER_BUCKETS; b++) {
+        for (struct jtimer *t = buckets[b]; t; t = t->next) fn(t->key, t->due_ms, t->cmd, ctx);
+    }
+    pthread_mutex_unlock(&journal_mutex);
+}
+
+void journal_start(void) {
+    pthread_mutex_lock(&journal_mutex);
+    if (map) {
+        // 이전 실행의 꼬리(끊긴 기록 뒤 잔재)에 이어 쓰지 않도록 새 세대로 시작
+        compact_locked();
+        recording = 1;
+    }
+    pthread_mutex_unlock(&journal_mutex);
+}
+
+// ---- 기록 API ----
+
+void journal_record_outputs(const struct journal_outputs *o) {
+    pthread_mutex_lock(&journal_mutex);
+    if (recording && memcmp(o, &outputs, sizeof(outputs)) != 0) {
+        outputs = *o;
+        append(REC_OUTPUTS, &outputs, sizeof(outputs), NULL, 0);
+    }
+    pthread_mutex_unlock(&journal_mutex);
+}
+
+uint64_t journal_timer_add(uint64_t due_ms, const char *cmd) {
+    size_t len = strlen(cmd);
+    uint64_t key = 0;
+    pthread_mutex_lock(&journal_mutex);
+    if (recording && len <= JOURNAL_CMD_MAX) {
+        key = next_key++;
+        timer_put(key, due_ms, cmd, len);
+        struct rec_timer rt = {key, due_ms};
+        append(REC_TIMER_ADD, &rt, sizeof(rt), cmd, len);
+    }
+    pthread_mutex_unlock(&journal_mutex);
+    return key;
+}
+
+void journal_timer_done(uint64_t key) {
+    if (key == 0) return;
+    pthread_mutex_lock(&journal_mutex);
+    if (recording) {
+        timer_drop(key);
+        append(REC_TIMER_DONE, &key, sizeof(key), NULL, 0);
+    }
+    pthread_mutex_unlock(&journal_mutex);
+}
+
+void journal_close(void) {
+    pthread_mutex_lock(&journal_mutex);
+    if (map) {
+        recording = 0;
+        msync(map, JOURNAL_FILE_SIZE, MS_SYNC);
+        munmap(map, JOURNAL_FILE_SIZE);
+        close(jfd);
+        map = NULL;
+        jfd = -1;
+    }
+    pthread_mutex_unlock(&journal_mutex);
+}
+
+void journal_get_stats(struct journal_stats *s) {
+    pthread_mutex_lock(&journal_mutex);
+    *s = stats;
+    s->used = recording ? cur.pos : 0;
+    s->timers = ntimers;
+    pthread_mutex_unlock(&journal_mutex);
+}
@@ -0,0 +1,57 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 디바이스 상태 저널 (재시작 시 출력/타이머 복구용)
+ * - 파일 하나를 mmap해 두 영역을 번갈아 쓴다. 영역은 스냅샷(출력 + 대기 중인 타이머)으로 시작하고
+ *   그 뒤로 변경 기록을 덧붙인다. 변경 기록이 남은 자리의 절반을 넘으면 반대쪽 영역에
+ *   새 스냅샷을 쓰고 넘어간다(압축). 재시작 때 재생할 양이 영역 크기로 묶인다
+ * - 기록 한 건은 mmap에 memcpy 한 번이다 (fsync 없음). 프로세스가 죽어도 페이지 캐시에 남으므로
+ *   재시작하면 그대로 읽힌다. 디스크에는 압축할 때와 종료할 때 msync로 내보낸다
+ * - 기록마다 세대와 체크섬이 있어, 쓰다 만 기록이나 이전 세대의 잔재에서 재생을 멈춘다.
+ *   새 스냅샷이 끝 표시까지 다 써지기 전에 죽으면 이전 영역을 쓴다
+ * - 타이머는 저널이 정한 키로 기록한다 (재시작해도 다시 쓰지 않으므로 타이머 휠 ID와 무관)
+ * - 모든 함수는 아무 스레드에서나 호출할 수 있다
+ */
+
+#define JOURNAL_PATH "/var/tmp/gpio_daemon.journal"
+#define JOURNAL_REGION_SIZE (512 * 1024)    // 영역 하나의 크기 (파일은 헤더 4KB + 영역 2개)
+#define JOURNAL_CMD_MAX 128                 // 타이머 명령 최대 길이 (TIMER_CMD_MAX와 같게)
+
+// 복구 대상 출력 (device_state에서 옮겨 적는다)
+struct journal_outputs {
+    int32_t led_on;
+    int32_t led_pwm;
+    int32_t buzzer_on;
+    int32_t seg7_digit;         // -1이면 꺼짐
+    int32_t music_mode;         // EXTRA_MUSIC_MODE 진행 중이었음
+};
+
+struct journal_stats {
+    uint64_t records;           // 덧붙인 기록 수
+    uint64_t compactions;
+    uint64_t dropped;           // 공간이 모자라 버린 기록 수
+    size_t used;                // 현재 영역에서 쓴 바이트
+    size_t timers;              // 기록상 대기 중인 타이머
+};
+
+// 복구된 타이머 방문 함수: due_ms는 CLOCK_REALTIME 기준 만료 시각
+typedef void (*journal_timer_fn)(uint64_t key, uint64_t due_ms, const char *cmd, void *ctx);
+
+int journal_open(const char *path);     // 1 이전 상태 읽음, 0 새로 만듦, -1 실패 (다른 데몬이 쓰는 중 포함)
+int journal_recovered(struct journal_outputs *out);        // 이전 상태가 있으면 1
+void journal_foreach_timer(journal_timer_fn fn, void *ctx); // 기록상 대기 중인 타이머 (fn에서 저널 함수 호출 금지)
+void journal_start(void);               // 이후 변경부터 기록 (복구 전에 GPIO를 초기화하며 생긴 변경은 남기지 않음)
+
+void journal_record_outputs(const struct journal_outputs *o);   // 바뀐 경우만 기록
+uint64_t journal_timer_add(uint64_t due_ms, const char *cmd);   // 키, 저널이 꺼져 있으면 0
+void journal_timer_done(uint64_t key);                          // 실행 또는 취소 (키 0은 무시)
+
+void journal_close(void);               // msync(동기) 후 닫기
+void journal_get_stats(struct journal_stats *s);
+uint64_t journal_realtime_ms(void);
+
+#endif
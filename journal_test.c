@@ -0,0 +1,343 @@
+/**
+ * journal_test.c - 상태 저널의 복구 경로 확인 (임시 파일)
+ *
+ * 데몬 한 번의 실행을 자식 프로세스 하나로 흉내 낸다. 자식은 journal_close 없이 끝나므로
+ * kill -9와 같다 (mmap에 쓴 내용은 페이지 캐시에 남음). 실행 사이에 부모가 파일을 직접 고쳐
+ * 찢어진 기록, 이전 세대의 잔재, 끝 표시가 없는 스냅샷을 만든다.
+ *
+ * 사용법: make test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "journal.h"
+
+// journal.c의 파일 형식 (헤더 4KB 뒤에 영역 2개, 기록은 8바이트 정렬)
+#define HDR_SIZE 4096
+#define FILE_SIZE (HDR_SIZE + 2 * JOURNAL_REGION_SIZE)
+#define REC_OUTPUTS 2
+#define REC_SNAP_END 5
+
+struct rec_hdr {
+    uint32_t sum;
+    uint32_t gen;
+    uint16_t len;
+    uint8_t type;
+    uint8_t pad;
+};
+
+struct region_info {
+    uint32_t gen;
+    size_t end;             // 온전한 기록이 끝나는 위치
+    size_t last_outputs;    // 마지막 OUTPUTS 기록의 위치
+    size_t snap_end;        // SNAP_END 기록의 위치 (없으면 0)
+};
+
+static char path[] = "/tmp/journal_test.XXXXXX";
+static int failures = 0;
+
+static const struct journal_outputs out_a = {1, 0, 0, 5, 0};     // LED 켜짐, 7-Segment 5
+static const struct journal_outputs out_b = {0, 128, 1, 3, 0};   // LED 128, 부저 켜짐, 7-Segment 3
+
+static void check(int ok, const char *what) {
+    printf("%-44s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static uint32_t fnv1a(uint32_t h, const void *data, size_t len) {
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t checksum(const struct rec_hdr *h, const void *body) {
+    uint32_t sum = fnv1a(2166136261u, (const uint8_t *)h + sizeof(h->sum), sizeof(*h) - sizeof(h->sum));
+    return fnv1a(sum, body, h->len);
+}
+
+static size_t rec_total(const struct rec_hdr *h) {
+    return (sizeof(*h) + h->len + 7) & ~(size_t)7;
+}
+
+// ---- 파일 직접 조작 (부모) ----
+
+static uint8_t *map_file(void) {
+    int fd = open(path, O_RDWR);
+    if (fd < 0) return NULL;
+    void *p = mmap(NULL, FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+static uint8_t *region(uint8_t *map, int r) {
+    return map + HDR_SIZE + (size_t)r * JOURNAL_REGION_SIZE;
+}
+
+// 첫 기록의 세대와 같은 세대로 체크섬이 맞는 기록까지 훑는다
+static void scan(uint8_t *base, struct region_info *ri) {
+    struct rec_hdr h;
+    memset(ri, 0, sizeof(*ri));
+    memcpy(&h, base, sizeof(h));
+    ri->gen = h.gen;
+    while (ri->end + sizeof(h) <= JOURNAL_REGION_SIZE) {
+        memcpy(&h, base + ri->end, sizeof(h));
+        if (h.gen != ri->gen || h.sum != checksum(&h, base + ri->end + sizeof(h))) break;
+        if (h.type == REC_OUTPUTS) ri->last_outputs = ri->end;
+        if (h.type == REC_SNAP_END) ri->snap_end = ri->end;
+        ri->end += rec_total(&h);
+    }
+}
+
+// 세대가 큰 쪽이 현재 영역
+static int newest(uint8_t *map, struct region_info *ri) {
+    struct region_info r0, r1;
+    scan(region(map, 0), &r0);
+    scan(region(map, 1), &r1);
+    int r = r1.gen > r0.gen;
+    *ri = r ? r1 : r0;
+    return r;
+}
+
+// ---- 데몬 한 번의 실행 (자식) ----
+
+// fn을 자식에서 돌리고 그 반환값(실패 수)을 돌려준다. 자식은 journal_close 없이 끝난다
+static int run(int (*fn)(void)) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        int r = fn();
+        fflush(stdout);
+        _exit(r);
+    }
+    int status;
+    if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status)) return 1;
+    return WEXITSTATUS(status);
+}
+
+static int same(const struct journal_outputs *a, const struct journal_outputs *b) {
+    return memcmp(a, b, sizeof(*a)) == 0;
+}
+
+// 복구된 출력이 want인지 (child 안에서)
+static int recovered_is(const struct journal_outputs *want, const char *what) {
+    struct journal_outputs o;
+    int ok = journal_open(path) == 1 && journal_recovered(&o) && same(&o, want);
+    check(ok, what);
+    return !ok;
+}
+
+static struct {
+    int count;
+    uint64_t key;
+    uint64_t due_ms;
+    char cmd[JOURNAL_CMD_MAX + 1];
+} seen;
+
+static void collect_timer(uint64_t key, uint64_t due_ms, const char *cmd, void *ctx) {
+    (void)ctx;
+    seen.count++;
+    seen.key = key;
+    seen.due_ms = due_ms;
+    snprintf(seen.cmd, sizeof(seen.cmd), "%s", cmd);
+}
+
+// 새 파일에 A를 기록하고 죽는다
+static int write_a(void) {
+    if (journal_open(path) != 0) return 1;
+    journal_start();
+    journal_record_outputs(&out_a);
+    return 0;
+}
+
+// 재시작: A를 복구해 새 세대 스냅샷을 쓰고 B를 기록한 뒤 죽는다
+static int restart_write_b(void) {
+    int f = recovered_is(&out_a, "재시작: A 복구");
+    journal_start();
+    journal_record_outputs(&out_b);
+    return f;
+}
+
+static int expect_a_torn(void) {
+    return recovered_is(&out_a, "찢어진 기록 앞에서 재생 멈춤");
+}
+
+static int expect_b_stale(void) {
+    return recovered_is(&out_b, "이전 세대 잔재 앞에서 재생 멈춤");
+}
+
+static int expect_a_incomplete(void) {
+    return recovered_is(&out_a, "끝 표시 없는 새 스냅샷 대신 이전 영역");
+}
+
+// 압축이 두 번 넘게 일어나도록 출력을 바꿔 가며 기록한 뒤 B로 끝내고 죽는다
+static int write_many(void) {
+    struct journal_stats st;
+    struct journal_outputs o = out_a;
+    if (journal_open(path) != 0) return 1;
+    journal_start();
+    journal_timer_add(journal_realtime_ms() + 60000, "LED:OFF");
+    for (int i = 0; i < 40000; i++) {
+        o.led_pwm = i % 256;
+        o.seg7_digit = i % 10;
+        journal_record_outputs(&o);
+    }
+    journal_record_outputs(&out_b);
+    journal_get_stats(&st);
+    check(st.compactions >= 3 && st.used < JOURNAL_REGION_SIZE / 2, "압축으로 현재 영역 사용량 제한");
+    return st.compactions >= 3 ? 0 : 1;
+}
+
+static int expect_many(void) {
+    int f = recovered_is(&out_b, "압축 뒤 마지막 출력 복구");
+    memset(&seen, 0, sizeof(seen));
+    journal_foreach_timer(collect_timer, NULL);
+    int ok = seen.count == 1 && strcmp(seen.cmd, "LED:OFF") == 0;
+    check(ok, "압축 스냅샷에 남은 타이머 복구");
+    return f + !ok;
+}
+
+static uint64_t due_keep;     // 남겨 둘 타이머의 만료 시각 (fork 전에 정함)
+
+// 타이머 두 개를 걸고 하나는 끝낸 뒤 죽는다
+
+static int write_timers(void) {
+    if (journal_open(path) != 0) return 1;
+    journal_start();
+    uint64_t done = journal_timer_add(due_keep - 1000, "LED:ON");
+    journal_timer_add(due_keep, "SEG7:OFF");
+    journal_timer_done(done);
+    return 0;
+}
+
+// 재시작: 남은 타이머만 그 시각으로 돌아오는지, 다시 걸 때 기록을 쓰지 않는지 본다
+
+static int rearm_timers(void) {
+    struct journal_stats st;
+    journal_open(path);
+    memset(&seen, 0, sizeof(seen));
+    journal_foreach_timer(collect_timer, NULL);
+    int ok = seen.count == 1 && seen.due_ms == due_keep && strcmp(seen.cmd, "SEG7:OFF") == 0;
+    check(ok, "끝나지 않은 타이머만 복구");
+    journal_start();
+    journal_get_stats(&st);
+    int quiet = st.records == 0 && st.timers == 1;
+    check(quiet, "다시 걸어도 새 기록 없음");
+    return !ok + !quiet;
+}
+
+static int rearm_again(void) {
+    journal_open(path);
+    memset(&seen, 0, sizeof(seen));
+    journal_foreach_timer(collect_timer, NULL);
+    int ok = seen.count == 1 && seen.due_ms == due_keep;
+    check(ok, "두 번째 재시작에도 타이머 유지");
+    uint64_t key_keep = seen.key;
+    journal_start();
+    uint64_t next = journal_timer_add(due_keep + 1000, "LED:OFF");
+    int fresh_key = next > key_keep;
+    check(fresh_key, "새 타이머 키가 복구된 키와 겹치지 않음");
+    journal_timer_done(key_keep);
+    journal_timer_done(next);
+    return !ok + !fresh_key;
+}
+
+static int expect_no_timers(void) {
+    journal_open(path);
+    memset(&seen, 0, sizeof(seen));
+    journal_foreach_timer(collect_timer, NULL);
+    check(seen.count == 0, "끝낸 타이머는 복구하지 않음");
+    return seen.count != 0;
+}
+
+// ---- 시나리오 ----
+
+static void fresh_file(void) {
+    int fd = open(path, O_RDWR | O_TRUNC);
+    if (fd >= 0) close(fd);
+}
+
+static void test_torn(void) {
+    fresh_file();
+    failures += run(write_a) + run(restart_write_b);
+    uint8_t *map = map_file();
+    if (!map) {
+        check(0, "저널 파일 매핑");
+        return;
+    }
+    struct region_info ri;
+    int r = newest(map, &ri);
+    // 마지막 OUTPUTS(B)의 본문 한 바이트를 바꿔 쓰다 만 기록처럼 만든다
+    region(map, r)[ri.last_outputs + sizeof(struct rec_hdr)] ^= 0xff;
+    munmap(map, FILE_SIZE);
+    failures += run(expect_a_torn);
+}
+
+static void test_stale(void) {
+    fresh_file();
+    failures += run(write_a) + run(restart_write_b);
+    uint8_t *map = map_file();
+    if (!map) {
+        check(0, "저널 파일 매핑");
+        return;
+    }
+    struct region_info cur, old;
+    int r = newest(map, &cur);
+    scan(region(map, !r), &old);
+    // 이전 영역의 OUTPUTS(A, 체크섬은 맞고 세대만 낮음)를 현재 영역 끝에 붙인다
+    struct rec_hdr h;
+    memcpy(&h, region(map, !r) + old.last_outputs, sizeof(h));
+    memcpy(region(map, r) + cur.end, region(map, !r) + old.last_outputs, rec_total(&h));
+    munmap(map, FILE_SIZE);
+    failures += run(expect_b_stale);
+}
+
+static void test_incomplete(void) {
+    fresh_file();
+    failures += run(write_a) + run(restart_write_b);
+    uint8_t *map = map_file();
+    if (!map) {
+        check(0, "저널 파일 매핑");
+        return;
+    }
+    struct region_info ri;
+    int r = newest(map, &ri);
+    // 새 영역의 SNAP_END를 지워 스냅샷을 쓰다 죽은 것처럼 만든다 (이후 기록도 함께 끊김)
+    memset(region(map, r) + ri.snap_end, 0, sizeof(struct rec_hdr));
+    munmap(map, FILE_SIZE);
+    failures += run(expect_a_incomplete);
+}
+
+static void test_compaction(void) {
+    fresh_file();
+    failures += run(write_many) + run(expect_many);
+}
+
+static void test_timers(void) {
+    fresh_file();
+    due_keep = journal_realtime_ms() + 3600000;
+    failures += run(write_timers) + run(rearm_timers) + run(rearm_again) + run(expect_no_timers);
+}
+
+int main(void) {
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    test_torn();
+    test_stale();
+    test_incomplete();
+    test_compaction();
+    test_timers();
+    unlink(path);
+    printf("%s (실패 %d)\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
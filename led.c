@@ -1,28 +1,161 @@
 #include "led.h"
-#include <wiringPi.h>
+#include "command.h"
+#include "proto_verbs.h"
+#include "gpio_hal.h"
+#include "device_state.h"
+#include "gpio_plugin.h"
+#include "pwm.h"
 #define LED 17
 
+static void record_led(int on, int pwm) {
+    struct device_state *st = device_state_begin();
+    st->led_on = on;
+    st->led_pwm = pwm;
+    device_state_end();
+}
+
+// 핀 설정은 여기서 한 번만, 이후 동작은 레지스터 쓰기만 한다
+int led_init(void) {
+    gpio_pin_mode(LED, GPIO_OUTPUT);
+    gpio_write(LED, 0);
+    return 0;
+}
+
+void led_teardown(void) {
+    pwm_release(LED);
+    gpio_pin_mode(LED, GPIO_OUTPUT);
+    gpio_write(LED, 0);
+    record_led(0, 0);
+}
+
+// 밝기 조절 중이었으면 PWM 엔진에서 먼저 빼고 디지털 출력으로 돌아간다
+// gpio_pin_mode는 모드가 바뀔 때만 실제로 설정한다
 int led_on(void) {
-    wiringPiSetupGpio();
-    pinMode(LED, OUTPUT);
-    digitalWrite(LED, 1);
+    pwm_release(LED);
+    gpio_pin_mode(LED, GPIO_OUTPUT);
+    gpio_write(LED, 1);
+    record_led(1, 0);
     return 0;
 }
 
 int led_off(void) {
-    wiringPiSetupGpio();
-    pinMode(LED, OUTPUT);
-    digitalWrite(LED, 0);
+    pwm_release(LED);
+    gpio_pin_mode(LED, GPIO_OUTPUT);
+    gpio_write(LED, 0);
+    record_led(0, 0);
     return 0;
 }
 
+// 호출한 쪽이 곧바로 마스크로 LOW를 쓰므로 상태는 여기서 OFF로 기록
+uint32_t led_off_mask(void) {
+    pwm_release(LED);
+    gpio_pin_mode(LED, GPIO_OUTPUT);
+    record_led(0, 0);
+    return 1u << LED;
+}
+
 int led_set_brightness(int level) {
-    wiringPiSetupGpio();
-    pinMode(LED, PWM_OUTPUT);
     int pwm_val = 0;
     if (level == 0) pwm_val = 85;   // min
     else if (level == 1) pwm_val = 170; // mid
     else pwm_val = 255; // max
-    pwmWrite(LED, pwm_val);
+    return led_set_level(pwm_val);
+}
+
+// 핀 17은 하드웨어 PWM 핀이 아니므로 PWM 엔진의 소프트웨어 PWM으로 구동된다
+int led_set_level(int level) {
+    if (pwm_set(LED, level) < 0) return -1;
+    record_led(level > 0, level);
+    return 0;
+}
+
+// 공유 메모리에는 페이드 목표 밝기를 기록한다 (진행 중인 값은 LED:LEVEL로 조회)
+int led_fade(int from, int to, int ms) {
+    if (ms < 0 || pwm_fade(LED, from, to, (unsigned)ms) < 0) return -1;
+    record_led(to > 0, to);
     return 0;
-} 
\ No newline at end of file
+}
+
+// ---- 명령 핸들러 ----
+static void cmd_led_on(const struct request *req, struct reply *rep) {
+    (void)req;
+    led_on();
+    reply_ok(rep, "OK:LED:ON");
+}
+
+static void cmd_led_off(const struct request *req, struct reply *rep) {
+    (void)req;
+    led_off();
+    reply_ok(rep, "OK:LED:OFF");
+}
+
+static void cmd_led_bright(const struct request *req, struct reply *rep) {
+    if (req->nargs < 1) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    led_set_brightness(req->args[0]);
+    reply_ok(rep, "OK:LED:BRIGHT");
+    reply_value(rep, req->args[0]);
+}
+
+// LED:LEVEL:<0~255> → OK:LED:LEVEL:<값>, 인자 없으면 VALUE:LED:LEVEL:<현재 밝기>:<페이드 중>
+// (PWM을 쓰지 않는 중이면 밝기는 켜짐/꺼짐에 따라 255/0)
+static void cmd_led_level(const struct request *req, struct reply *rep) {
+    if (req->nargs > 0) {
+        if (led_set_level(req->args[0]) < 0) {
+            reply_error(rep, ST_BAD_ARGS);
+            return;
+        }
+        reply_ok(rep, "OK:LED:LEVEL");
+        reply_value(rep, req->args[0]);
+        return;
+    }
+    int level = pwm_level(LED);
+    if (level < 0) level = gpio_read(LED) ? PWM_LEVEL_MAX : 0;
+    reply_ok(rep, "VALUE:LED:LEVEL");
+    reply_value(rep, level);
+    reply_value(rep, pwm_fading(LED));
+}
+
+// LED:FADE:<시작>:<끝>:<ms> → OK:LED:FADE:<시작>:<끝>:<ms>, 서버가 PWM 주기마다 밝기를 바꾼다
+static void cmd_led_fade(const struct request *req, struct reply *rep) {
+    if (req->nargs < 3 || led_fade(req->args[0], req->args[1], req->args[2]) < 0) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    reply_ok(rep, "OK:LED:FADE");
+    reply_value(rep, req->args[0]);
+    reply_value(rep, req->args[1]);
+    reply_value(rep, req->args[2]);
+}
+
+static const struct command_def led_commands[] = {
+    {VERB_LED_ON,     cmd_led_on},
+    {VERB_LED_OFF,    cmd_led_off},
+    {VERB_LED_BRIGHT, cmd_led_bright},
+    {VERB_LED_LEVEL,  cmd_led_level},
+    {VERB_LED_FADE,   cmd_led_fade},
+};
+
+// ---- 플러그인 기술자 ----
+// 핫 스왑 때는 켜져 있던 LED를 그대로 두고 코드만 바꾼다
+static int led_plugin_init(int flags) {
+    return flags & GPIO_PLUGIN_RELOAD ? 0 : led_init();
+}
+
+static void led_plugin_teardown(int flags) {
+    if (!(flags & GPIO_PLUGIN_RELOAD)) led_teardown();
+}
+
+GPIO_PLUGIN_EXPORT(led) = {
+    .abi = GPIO_PLUGIN_ABI,
+    .name = "led",
+    .version = 2,
+    .device = DEV_LED,
+    .init = led_plugin_init,
+    .teardown = led_plugin_teardown,
+    .off_mask = led_off_mask,
+    .commands = led_commands,
+    .ncommands = sizeof(led_commands) / sizeof(led_commands[0]),
+};
@@ -1,8 +1,18 @@
 #ifndef LED_H
 #define LED_H
 
+#include <stdint.h>
+
+int led_init(void);       // 핀 설정 (데몬 시작 시 한 번)
+void led_teardown(void);  // LED OFF (데몬 종료 시)
 int led_on(void);
 int led_off(void);
+uint32_t led_off_mask(void); // 출력 모드를 맞추고 OFF 시 LOW로 내릴 핀 마스크 반환
 int led_set_brightness(int level); // 0: min, 1: mid, 2: max
+int led_set_level(int level);      // 0~255 (PWM 엔진)
+int led_fade(int from, int to, int ms); // from에서 to까지 ms 동안 서버에서 페이드
+
+struct gpio_plugin;
+extern const struct gpio_plugin led_plugin; // 내장 플러그인 기술자 (led.so와 같은 소스)
 
 #endif 
\ No newline at end of file
@@ -1,9 +1,70 @@
 #include "light_sensor.h"
-#include <wiringPi.h>
-#define LIGHT_SENSOR_PIN 27
+#include "log.h"
+#include "command.h"
+#include "proto_verbs.h"
+#include "gpio_hal.h"
+#include "device_state.h"
+#include "gpio_plugin.h"
+#include <time.h>
+// 입력 모드 설정 (데몬 시작 시 한 번)
+int light_sensor_init(void) {
+    gpio_pin_mode(LIGHT_SENSOR_PIN, GPIO_INPUT);
+    return 0;
+}
+
+void light_sensor_teardown(void) {
+}
+
 // 조도센서 값 읽기 함수: 지정 핀의 입력값 반환
 int light_sensor_read(void) {
-    wiringPiSetupGpio(); // GPIO 모드 설정
-    pinMode(LIGHT_SENSOR_PIN, INPUT); // 입력 모드
-    return digitalRead(LIGHT_SENSOR_PIN); // 값 반환
-} 
\ No newline at end of file
+    gpio_pin_mode(LIGHT_SENSOR_PIN, GPIO_INPUT); // 모드가 바뀌었을 때만 실제 설정
+    int value = gpio_read(LIGHT_SENSOR_PIN);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    struct device_state *st = device_state_begin();
+    st->sensor_value = value;
+    st->sensor_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    device_state_end();
+    return value; // 값 반환
+} 
+
+// ---- 명령 핸들러 ----
+static void cmd_sensor_read(const struct request *req, struct reply *rep) {
+    if (req->nargs < 1) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    int pin = req->args[0];
+    int value = light_sensor_read();
+    reply_ok(rep, "VALUE:SENSOR");
+    reply_value(rep, pin);
+    reply_value(rep, value);
+    LOG_SAMPLED(LOG_INFO, "센서 핀 %d 값: %d", pin, value);
+}
+
+static const struct command_def light_sensor_commands[] = {
+    {VERB_SENSOR_READ, cmd_sensor_read},
+};
+
+// ---- 플러그인 기술자 ----
+static int light_sensor_plugin_init(int flags) {
+    (void)flags;
+    return light_sensor_init();
+}
+
+static void light_sensor_plugin_teardown(int flags) {
+    (void)flags;
+    light_sensor_teardown();
+}
+
+GPIO_PLUGIN_EXPORT(light_sensor) = {
+    .abi = GPIO_PLUGIN_ABI,
+    .name = "light_sensor",
+    .version = 1,
+    .device = DEV_SENSOR,
+    .init = light_sensor_plugin_init,
+    .teardown = light_sensor_plugin_teardown,
+    .read = light_sensor_read,
+    .commands = light_sensor_commands,
+    .ncommands = sizeof(light_sensor_commands) / sizeof(light_sensor_commands[0]),
+};
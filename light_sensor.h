@@ -1,6 +1,13 @@
 #ifndef LIGHT_SENSOR_H
 #define LIGHT_SENSOR_H
 
+#define LIGHT_SENSOR_PIN 27
+
+int light_sensor_init(void);       // 입력 모드 설정 (데몬 시작 시 한 번)
+void light_sensor_teardown(void);
 int light_sensor_read(void); // 0: 어두움, 1: 밝음
 
+struct gpio_plugin;
+extern const struct gpio_plugin light_sensor_plugin; // 내장 플러그인 기술자 (light_sensor.so와 같은 소스)
+
 #endif 
\ No newline at end of file
@@ -0,0 +1,354 @@
+/**
+ * log.c - 스레드별 lock-free 링과 묶음 플러시 스레드로 동작하는 비동기 로그
+ *
+ * 링은 스레드마다 하나(생산자 하나, 소비자 하나)라 head/tail만 원자적으로 읽고 쓰면 된다.
+ * 소비자는 플러시 스레드 또는 log_flush()를 부른 스레드이며 drain_mutex로 한 번에 하나만 비운다.
+ * 여러 링의 기록은 시각 순으로 합쳐 /dev/log에 sendmmsg 한 번으로 보낸다.
+ * 스레드가 끝나면 링은 남은 기록을 유지한 채 다음 스레드가 재사용한다.
+ */
+#define _GNU_SOURCE
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#define LOG_RING_SLOTS 1024       // 스레드별 링 크기 (2의 거듭제곱), 한 칸 256바이트
+#define LOG_BATCH 64              // 한 번에 내보내는 최대 건수
+#define LOG_FLUSH_MS 20
+#define LOG_PREFIX_MAX 64         // syslog 헤더 "<pri>Mmm dd hh:mm:ss ident[pid]: "
+
+struct log_rec {
+    uint64_t ts_ns;               // CLOCK_REALTIME
+    uint16_t len;
+    uint8_t level;
+    char text[LOG_LINE_MAX];
+};
+
+struct log_ring {
+    struct log_rec rec[LOG_RING_SLOTS];
+    size_t head;                  // 생산자가 다음에 쓸 위치
+    size_t tail;                  // 소비자가 다음에 읽을 위치
+    int owned;
+    struct log_ring *next;
+};
+
+static int log_level = LOG_INFO;
+static unsigned sample_every = 1;
+static unsigned long dropped = 0;
+static unsigned long reported_drops = 0;
+
+static struct log_ring *rings = NULL;
+static pthread_mutex_t rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t drain_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t ring_key;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static __thread struct log_ring *my_ring = NULL;
+
+static char log_ident[32] = "log";
+static int log_stderr = 0;
+static int syslog_fd = -1;
+static pthread_t flusher;
+static int flusher_running = 0;
+static pthread_mutex_t flusher_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t flusher_cond = PTHREAD_COND_INITIALIZER;
+
+static void release_ring(void *p) {
+    struct log_ring *r = p;
+    pthread_mutex_lock(&rings_mutex);
+    r->owned = 0;
+    pthread_mutex_unlock(&rings_mutex);
+}
+
+static void make_key(void) {
+    pthread_key_create(&ring_key, release_ring);
+}
+
+static inline int log_enabled(int level) {
+    return level <= __atomic_load_n(&log_level, __ATOMIC_RELAXED);
+}
+
+static struct log_ring *get_ring(void) {
+    if (my_ring) return my_ring;
+    pthread_once(&key_once, make_key);
+    pthread_mutex_lock(&rings_mutex);
+    struct log_ring *r = rings;
+    while (r && r->owned) r = r->next;
+    if (!r) {
+        r = calloc(1, sizeof(*r));
+        if (!r) {
+            pthread_mutex_unlock(&rings_mutex);
+            return NULL;
+        }
+        r->next = rings;
+        __atomic_store_n(&rings, r, __ATOMIC_RELEASE);
+    }
+    r->owned = 1;
+    pthread_mutex_unlock(&rings_mutex);
+    pthread_setspecific(ring_key, r);
+    my_ring = r;
+    return r;
+}
+
+// 빈 칸을 잡는다. 가득 찼으면 NULL (버린 개수만 센다)
+static struct log_rec *reserve(int level) {
+    struct log_ring *r = get_ring();
+    if (!r) return NULL;
+    size_t head = r->head;
+    if (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >= LOG_RING_SLOTS) {
+        __atomic_add_fetch(&dropped, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    struct log_rec *rec = &r->rec[head & (LOG_RING_SLOTS - 1)];
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    rec->ts_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    rec->level = (uint8_t)level;
+    return rec;
+}
+
+// 링이 절반 찼을 때만 플러시 스레드를 깨운다 (평소에는 주기적으로 비움)
+static void commit(void) {
+    size_t head = my_ring->head + 1;
+    __atomic_store_n(&my_ring->head, head, __ATOMIC_RELEASE);
+    if (head - __atomic_load_n(&my_ring->tail, __ATOMIC_RELAXED) == LOG_RING_SLOTS / 2)
+        pthread_cond_signal(&flusher_cond);
+}
+
+void log_msg(int level, const char *fmt, ...) {
+    if (!log_enabled(level)) return;
+    struct log_rec *rec = reserve(level);
+    if (!rec) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(rec->text, sizeof(rec->text), fmt, ap);
+    va_end(ap);
+    if (n < 0) n = 0;
+    rec->len = (uint16_t)((size_t)n < sizeof(rec->text) ? (size_t)n : sizeof(rec->text) - 1);
+    commit();
+}
+
+void log_text(int level, const char *prefix, const char *text, size_t len) {
+    if (!log_enabled(level)) return;
+    struct log_rec *rec = reserve(level);
+    if (!rec) return;
+    size_t plen = strlen(prefix);
+    if (plen > sizeof(rec->text)) plen = sizeof(rec->text);
+    if (len > sizeof(rec->text) - plen) len = sizeof(rec->text) - plen;
+    memcpy(rec->text, prefix, plen);
+    memcpy(rec->text + plen, text, len);
+    rec->len = (uint16_t)(plen + len);
+    commit();
+}
+
+void log_set_level(int level) {
+    if (level < LOG_EMERG) level = LOG_EMERG;
+    if (level > LOG_DEBUG) level = LOG_DEBUG;
+    __atomic_store_n(&log_level, level, __ATOMIC_RELAXED);
+}
+
+int log_get_level(void) {
+    return __atomic_load_n(&log_level, __ATOMIC_RELAXED);
+}
+
+void log_set_sample(unsigned every) {
+    __atomic_store_n(&sample_every, every ? every : 1, __ATOMIC_RELAXED);
+}
+
+unsigned log_get_sample(void) {
+    return __atomic_load_n(&sample_every, __ATOMIC_RELAXED);
+}
+
+int log_sample_hit(int level, unsigned *seen) {
+    if (!log_enabled(level)) return 0;
+    unsigned every = __atomic_load_n(&sample_every, __ATOMIC_RELAXED);
+    if (every <= 1) return 1;
+    return __atomic_fetch_add(seen, 1, __ATOMIC_RELAXED) % every == 0;
+}
+
+unsigned long log_dropped(void) {
+    return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
+
+// ---- 소비자 쪽 ----
+
+static void open_syslog_socket(void) {
+    struct sockaddr_un addr;
+    syslog_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (syslog_fd < 0) return;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, _PATH_LOG, sizeof(addr.sun_path) - 1);
+    if (connect(syslog_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(syslog_fd);
+        syslog_fd = -1;   // syslog 데몬이 없으면 기록마다 syslog()로 대체
+    }
+}
+
+// 모은 기록을 한 번에 내보낸다
+static void emit(struct log_rec *const *batch, int n) {
+    char prefix[LOG_BATCH][LOG_PREFIX_MAX];
+    struct iovec iov[LOG_BATCH * 3];
+    struct mmsghdr msgs[LOG_BATCH];
+    static const char newline = '\n';
+    int pid = getpid();
+
+    if (syslog_fd >= 0) {
+        for (int i = 0; i < n; i++) {
+            time_t sec = (time_t)(batch[i]->ts_ns / 1000000000ULL);
+            struct tm tm;
+            char stamp[20];
+            localtime_r(&sec, &tm);
+            strftime(stamp, sizeof(stamp), "%b %e %H:%M:%S", &tm);
+            int plen = snprintf(prefix[i], LOG_PREFIX_MAX, "<%d>%s %s[%d]: ", LOG_DAEMON | batch[i]->level,
+                                stamp, log_ident, pid);
+            iov[i * 2].iov_base = prefix[i];
+            iov[i * 2].iov_len = plen > 0 && plen < LOG_PREFIX_MAX ? plen : 0;
+            iov[i * 2 + 1].iov_base = batch[i]->text;
+            iov[i * 2 + 1].iov_len = batch[i]->len;
+            memset(&msgs[i], 0, sizeof(msgs[i]));
+            msgs[i].msg_hdr.msg_iov = &iov[i * 2];
+            msgs[i].msg_hdr.msg_iovlen = 2;
+        }
+        int sent = 0;
+        while (sent < n) {
+            int r = sendmmsg(syslog_fd, msgs + sent, n - sent, 0);
+            if (r <= 0) break;
+            sent += r;
+        }
+    } else {
+        for (int i = 0; i < n; i++) syslog(batch[i]->level, "%.*s", batch[i]->len, batch[i]->text);
+    }
+
+    if (log_stderr) {
+        // LOG_PERROR와 같은 형식: "ident[pid]: 메시지"
+        int cnt = 0;
+        for (int i = 0; i < n; i++) {
+            int plen = snprintf(prefix[i], LOG_PREFIX_MAX, "%s[%d]: ", log_ident, pid);
+            iov[cnt].iov_base = prefix[i];
+            iov[cnt++].iov_len = plen > 0 && plen < LOG_PREFIX_MAX ? plen : 0;
+            iov[cnt].iov_base = batch[i]->text;
+            iov[cnt++].iov_len = batch[i]->len;
+            iov[cnt].iov_base = (void *)&newline;
+            iov[cnt++].iov_len = 1;
+        }
+        if (writev(STDERR_FILENO, iov, cnt) < 0) { }
+    }
+}
+
+// 모든 링을 시각 순으로 합쳐 비운다 (각 링 안은 이미 시각 순)
+static void drain(int wait) {
+    struct log_rec *batch[LOG_BATCH];
+    struct log_rec drop_rec;
+    if (wait) {
+        pthread_mutex_lock(&drain_mutex);
+    } else {
+        // 시그널 핸들러 경로: 플러시 스레드가 비우는 중이면 잠깐만 기다린다
+        int tries = 0;
+        while (pthread_mutex_trylock(&drain_mutex) != 0) {
+            if (++tries > 50) return;
+            usleep(1000);
+        }
+    }
+    for (;;) {
+        int n = 0;
+        unsigned long d = log_dropped();
+        if (d != reported_drops) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            drop_rec.ts_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+            drop_rec.level = LOG_WARNING;
+            drop_rec.len = (uint16_t)snprintf(drop_rec.text, sizeof(drop_rec.text),
+                                              "로그 버퍼 초과로 %lu건 유실", d - reported_drops);
+            reported_drops = d;
+            batch[n++] = &drop_rec;
+        }
+        // 링마다 읽을 수 있는 위치를 먼저 잡아 두고 가장 이른 기록부터 꺼낸다
+        struct log_ring *list = __atomic_load_n(&rings, __ATOMIC_ACQUIRE);
+        struct log_ring *pick_ring[LOG_BATCH];
+        while (n < LOG_BATCH) {
+            struct log_ring *best = NULL;
+            uint64_t best_ts = 0;
+            for (struct log_ring *r = list; r; r = r->next) {
+                size_t pending = r->tail;
+                for (int i = 0; i < n; i++) if (pick_ring[i] == r && batch[i] != &drop_rec) pending++;
+                if (pending == __atomic_load_n(&r->head, __ATOMIC_ACQUIRE)) continue;
+                uint64_t ts = r->rec[pending & (LOG_RING_SLOTS - 1)].ts_ns;
+                if (!best || ts < best_ts) {
+                    best = r;
+                    best_ts = ts;
+                }
+            }
+            if (!best) break;
+            size_t pos = best->tail;
+            for (int i = 0; i < n; i++) if (pick_ring[i] == best && batch[i] != &drop_rec) pos++;
+            pick_ring[n] = best;
+            batch[n++] = &best->rec[pos & (LOG_RING_SLOTS - 1)];
+        }
+        if (n == 0) break;
+        emit(batch, n);
+        // 다 쓴 칸을 생산자에게 돌려준다
+        for (int i = 0; i < n; i++)
+            if (batch[i] != &drop_rec)
+                __atomic_store_n(&pick_ring[i]->tail, pick_ring[i]->tail + 1, __ATOMIC_RELEASE);
+        if (n < LOG_BATCH) break;
+    }
+    pthread_mutex_unlock(&drain_mutex);
+}
+
+void log_flush(void) {
+    drain(1);
+}
+
+static void *flusher_thread(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&flusher_mutex);
+    while (flusher_running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += LOG_FLUSH_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&flusher_cond, &flusher_mutex, &deadline);
+        pthread_mutex_unlock(&flusher_mutex);
+        drain(1);
+        pthread_mutex_lock(&flusher_mutex);
+    }
+    pthread_mutex_unlock(&flusher_mutex);
+    return NULL;
+}
+
+int log_init(const char *ident, int to_stderr) {
+    strncpy(log_ident, ident, sizeof(log_ident) - 1);
+    log_stderr = to_stderr;
+    openlog(ident, LOG_PID, LOG_DAEMON);   // 대체 경로(syslog())용
+    open_syslog_socket();
+    flusher_running = 1;
+    if (pthread_create(&flusher, NULL, flusher_thread, NULL) != 0) {
+        flusher_running = 0;
+        return -1;
+    }
+    atexit(log_flush);
+    return 0;
+}
+
+void log_shutdown(void) {
+    // 시그널 핸들러에서도 불리므로 플러시 스레드를 join하지 않고 멈추라고만 알린다
+    __atomic_store_n(&flusher_running, 0, __ATOMIC_RELAXED);
+    pthread_cond_signal(&flusher_cond);
+    drain(0);
+    if (syslog_fd >= 0) {
+        close(syslog_fd);
+        syslog_fd = -1;
+    }
+    closelog();
+}
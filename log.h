@@ -0,0 +1,42 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stddef.h>
+#include <syslog.h>   // 레벨 값은 syslog와 같다 (LOG_ERR, LOG_WARNING, LOG_INFO, LOG_DEBUG ...)
+
+/*
+ * 비동기 로그
+ * - 호출한 스레드는 자기 전용 링(단일 생산자)에 기록만 하고 바로 돌아온다 (락/시스템 호출 없음)
+ * - 플러시 스레드가 주기적으로 모든 링을 시각 순으로 합쳐 syslog 소켓에 묶어 보낸다
+ *   (-f 실행이면 stderr에도 한 번의 writev로)
+ * - 링이 가득 차면 새 로그는 버리고 개수를 세어 다음 플러시 때 알린다
+ */
+
+#define LOG_LINE_MAX 244          // 메시지 한 건 최대 길이 (넘으면 잘림)
+
+int log_init(const char *ident, int to_stderr);   // 플러시 스레드 시작, 종료 시 남은 로그를 비우도록 atexit 등록
+void log_shutdown(void);                          // 남은 로그를 모두 쓰고 플러시 스레드 종료
+void log_flush(void);                             // 호출한 스레드에서 지금까지의 로그를 바로 씀
+
+void log_msg(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+void log_text(int level, const char *prefix, const char *text, size_t len); // 포맷 없이 prefix + text 복사
+
+void log_set_level(int level);          // 이 값보다 큰(덜 중요한) 레벨은 기록하지 않음 (기본 LOG_INFO)
+int log_get_level(void);
+void log_set_sample(unsigned every);   // LOG_SAMPLED 메시지를 every건마다 한 번 기록 (1이면 모두)
+unsigned log_get_sample(void);
+int log_sample_hit(int level, unsigned *seen); // 레벨과 호출 지점별 카운터로 이번 건을 기록할지 판단
+unsigned long log_dropped(void);
+
+// 명령 수신처럼 빈도가 높은 메시지용: 레벨 검사 후 샘플링 비율에 걸린 건만 기록
+#define LOG_SAMPLED(level, ...) do { \
+        static unsigned log_seen_; \
+        if (log_sample_hit(level, &log_seen_)) log_msg(level, __VA_ARGS__); \
+    } while (0)
+
+#define LOG_SAMPLED_TEXT(level, prefix, text, len) do { \
+        static unsigned log_seen_; \
+        if (log_sample_hit(level, &log_seen_)) log_text(level, prefix, text, len); \
+    } while (0)
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * log_bench.c - 호출 스레드가 로그 한 건에 쓰는 시간 비교 (동기 syslog vs 비동기 링)
+ *
+ * 스레드 수를 늘려 가며 syslog(), log_msg()(포맷), log_text()(복사만)를 같은 메시지로 호출한다.
+ * 링이 넘치지 않도록 BURST건씩 호출하고 비운 뒤 다시 호출하며, 호출 구간만 잰다.
+ * 비우는 비용(플러시 스레드 쪽)은 호출한 스레드의 지연에 들어가지 않는다.
+ *
+ * 사용법: ./log_bench [스레드당 반복횟수] [최대 스레드 수]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <syslog.h>
+#include "log.h"
+
+#define DEFAULT_ITERATIONS 50000
+#define MAX_THREADS 8
+#define BURST 256      // 스레드별 링(1024칸)의 절반 미만
+
+enum mode { MODE_SYSLOG, MODE_LOG_MSG, MODE_LOG_TEXT, MODES };
+static const char *const mode_names[MODES] = {"syslog", "log_msg", "log_text"};
+
+struct job {
+    int mode;
+    long iterations;
+    double ns;
+};
+
+static void *worker(void *arg) {
+    struct job *j = arg;
+    static const char line[] = "LED:BRIGHT:2";
+    struct timespec t0, t1;
+    double total = 0;
+    for (long done = 0; done < j->iterations; done += BURST) {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (int i = 0; i < BURST; i++) {
+            switch (j->mode) {
+                case MODE_SYSLOG: syslog(LOG_INFO, "명령 수신: %s", line); break;
+                case MODE_LOG_MSG: log_msg(LOG_INFO, "명령 수신: %s", line); break;
+                case MODE_LOG_TEXT: log_text(LOG_INFO, "명령 수신: ", line, sizeof(line) - 1); break;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        total += (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+        if (j->mode != MODE_SYSLOG) log_flush();
+    }
+    j->ns = total / ((j->iterations + BURST - 1) / BURST * BURST);
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : DEFAULT_ITERATIONS;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 4;
+    if (max_threads < 1) max_threads = 1;
+    if (max_threads > MAX_THREADS) max_threads = MAX_THREADS;
+
+    openlog("log_bench", LOG_PID, LOG_USER);
+    if (log_init("log_bench", 0) < 0) {
+        fprintf(stderr, "로그 스레드 생성 실패\n");
+        return 1;
+    }
+    printf("스레드당 반복 횟수: %ld\n", iterations);
+    printf("%-10s %8s %14s %12s\n", "mode", "threads", "ns/call", "dropped");
+    for (int m = 0; m < MODES; m++) {
+        for (int n = 1; n <= max_threads; n *= 2) {
+            pthread_t t[MAX_THREADS];
+            struct job jobs[MAX_THREADS];
+            unsigned long drops = log_dropped();
+            for (int i = 0; i < n; i++) {
+                jobs[i].mode = m;
+                jobs[i].iterations = iterations;
+                pthread_create(&t[i], NULL, worker, &jobs[i]);
+            }
+            double ns = 0;
+            for (int i = 0; i < n; i++) {
+                pthread_join(t[i], NULL);
+                ns += jobs[i].ns;
+            }
+            log_flush();
+            printf("%-10s %8d %14.1f %12lu\n", mode_names[m], n, ns / n, log_dropped() - drops);
+        }
+    }
+    log_shutdown();
+    return 0;
+}
@@ -0,0 +1,215 @@
+/**
+ * metrics.c - 스레드별 지연시간 히스토그램과 카운터
+ *
+ * 각 스레드는 처음 기록할 때 자기 전용 샤드를 받아 그곳에만 쓴다(쓰는 쪽이 하나뿐이라 원자적 load/store로 충분).
+ * 조회는 샤드 목록을 돌며 합친다. 스레드가 끝나면 샤드는 값을 유지한 채 다음 스레드가 재사용한다.
+ */
+#include "metrics.h"
+#include "command.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#define SUB_BITS 4
+#define SUB_COUNT (1 << SUB_BITS)
+#define MAX_EXP 40                                   // 2^40 ns(약 18분) 이상은 마지막 칸
+#define HIST_BUCKETS ((MAX_EXP - SUB_BITS + 1) * SUB_COUNT)
+
+struct metrics_shard {
+    uint64_t buckets[METRIC_HISTS][HIST_BUCKETS];
+    uint64_t sum[METRIC_HISTS];
+    uint64_t max[METRIC_HISTS];
+    uint64_t counters[METRIC_COUNTERS];
+    int owned;                  // 현재 이 샤드를 쓰는 스레드가 있음
+    struct metrics_shard *next;
+};
+
+static struct metrics_shard *shards = NULL;
+static pthread_mutex_t shards_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t shard_key;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static __thread struct metrics_shard *my_shard = NULL;
+
+static void release_shard(void *p) {
+    struct metrics_shard *s = p;
+    pthread_mutex_lock(&shards_mutex);
+    s->owned = 0;
+    pthread_mutex_unlock(&shards_mutex);
+}
+
+static void make_key(void) {
+    pthread_key_create(&shard_key, release_shard);
+}
+
+static struct metrics_shard *get_shard(void) {
+    if (my_shard) return my_shard;
+    pthread_once(&key_once, make_key);
+    pthread_mutex_lock(&shards_mutex);
+    struct metrics_shard *s = shards;
+    while (s && s->owned) s = s->next;
+    if (!s) {
+        s = calloc(1, sizeof(*s));
+        if (!s) {
+            pthread_mutex_unlock(&shards_mutex);
+            return NULL;
+        }
+        s->next = shards;
+        __atomic_store_n(&shards, s, __ATOMIC_RELEASE);
+    }
+    s->owned = 1;
+    pthread_mutex_unlock(&shards_mutex);
+    pthread_setspecific(shard_key, s);
+    my_shard = s;
+    return s;
+}
+
+// 값 → 칸 번호: 16 미만은 그대로, 그 이상은 (지수, 상위 4비트)
+static int bucket_of(uint64_t v) {
+    if (v < SUB_COUNT) return (int)v;
+    int e = 63 - __builtin_clzll(v);
+    if (e >= MAX_EXP) return HIST_BUCKETS - 1;
+    return (e - SUB_BITS + 1) * SUB_COUNT + (int)((v >> (e - SUB_BITS)) & (SUB_COUNT - 1));
+}
+
+// 칸 번호 → 그 칸에 들어가는 가장 큰 값
+static uint64_t bucket_value(int idx) {
+    if (idx < SUB_COUNT) return (uint64_t)idx;
+    int e = idx / SUB_COUNT + SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(idx % SUB_COUNT);
+    return ((SUB_COUNT + sub + 1) << (e - SUB_BITS)) - 1;
+}
+
+static inline void bump(uint64_t *p, uint64_t n) {
+    __atomic_store_n(p, __atomic_load_n(p, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+uint64_t metrics_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void metrics_record(int hist, uint64_t ns) {
+    struct metrics_shard *s = get_shard();
+    if (!s || hist < 0 || hist >= METRIC_HISTS) return;
+    bump(&s->buckets[hist][bucket_of(ns)], 1);
+    bump(&s->sum[hist], ns);
+    if (ns > __atomic_load_n(&s->max[hist], __ATOMIC_RELAXED))
+        __atomic_store_n(&s->max[hist], ns, __ATOMIC_RELAXED);
+}
+
+void metrics_add(int counter, uint64_t n) {
+    struct metrics_shard *s = get_shard();
+    if (!s || counter < 0 || counter >= METRIC_COUNTERS) return;
+    bump(&s->counters[counter], n);
+}
+
+uint64_t metrics_counter(int counter) {
+    uint64_t total = 0;
+    if (counter < 0 || counter >= METRIC_COUNTERS) return 0;
+    for (struct metrics_shard *s = __atomic_load_n(&shards, __ATOMIC_ACQUIRE); s; s = s->next)
+        total += __atomic_load_n(&s->counters[counter], __ATOMIC_RELAXED);
+    return total;
+}
+
+void metrics_summarize(int hist, struct metric_summary *out) {
+    uint64_t merged[HIST_BUCKETS];
+    memset(out, 0, sizeof(*out));
+    if (hist < 0 || hist >= METRIC_HISTS) return;
+    memset(merged, 0, sizeof(merged));
+    for (struct metrics_shard *s = __atomic_load_n(&shards, __ATOMIC_ACQUIRE); s; s = s->next) {
+        for (int i = 0; i < HIST_BUCKETS; i++) {
+            uint64_t n = __atomic_load_n(&s->buckets[hist][i], __ATOMIC_RELAXED);
+            merged[i] += n;
+            out->count += n;
+        }
+        out->sum_ns += __atomic_load_n(&s->sum[hist], __ATOMIC_RELAXED);
+        uint64_t m = __atomic_load_n(&s->max[hist], __ATOMIC_RELAXED);
+        if (m > out->max_ns) out->max_ns = m;
+    }
+    if (out->count == 0) return;
+
+    // 누적 개수가 각 분위 순위를 처음 넘는 칸의 상한 (최댓값보다 크게 보고하지 않음)
+    const uint64_t ranks[4] = {
+        (out->count * 500 + 999) / 1000, (out->count * 900 + 999) / 1000,
+        (out->count * 990 + 999) / 1000, (out->count * 999 + 999) / 1000,
+    };
+    uint64_t *dst[4] = {&out->p50_ns, &out->p90_ns, &out->p99_ns, &out->p999_ns};
+    uint64_t seen = 0;
+    int q = 0;
+    for (int i = 0; i < HIST_BUCKETS && q < 4; i++) {
+        seen += merged[i];
+        while (q < 4 && seen >= ranks[q]) {
+            uint64_t v = bucket_value(i);
+            *dst[q++] = v < out->max_ns ? v : out->max_ns;
+        }
+    }
+}
+
+static const char *opcode_name(int opcode) {
+    const struct command_def *d = command_by_opcode(opcode);
+    return d ? d->verb : "UNKNOWN";
+}
+
+#define APPEND(...) do { \
+        int n_ = snprintf(buf + len, cap - len, __VA_ARGS__); \
+        if (n_ < 0 || (size_t)n_ >= cap - len) return len; \
+        len += n_; \
+    } while (0)
+
+static size_t render_summary(char *buf, size_t cap, size_t len, const char *name, const char *labels,
+                             const struct metric_summary *m) {
+    static const char *const qs[4] = {"0.5", "0.9", "0.99", "0.999"};
+    const uint64_t vs[4] = {m->p50_ns, m->p90_ns, m->p99_ns, m->p999_ns};
+    for (int i = 0; i < 4; i++)
+        APPEND("%s{%s,quantile=\"%s\"} %.9f\n", name, labels, qs[i], vs[i] / 1e9);
+    APPEND("%s_sum{%s} %.9f\n", name, labels, m->sum_ns / 1e9);
+    APPEND("%s_count{%s} %llu\n", name, labels, (unsigned long long)m->count);
+    return len;
+}
+
+size_t metrics_render_prometheus(char *buf, size_t cap) {
+    static const char *const stages[METRIC_STAGES] = {"parse", "exec"};
+    size_t len = 0;
+    char labels[96];
+    struct metric_summary m;
+
+    APPEND("# HELP gpio_command_seconds 명령 처리 시간 (parse: 디코딩, exec: 핸들러/디바이스 조작)\n"
+           "# TYPE gpio_command_seconds summary\n");
+    for (int op = 0; op < OP_MAX; op++) {
+        for (int st = 0; st < METRIC_STAGES; st++) {
+            metrics_summarize(METRIC_HIST_CMD(st, op), &m);
+            if (m.count == 0) continue;
+            snprintf(labels, sizeof(labels), "command=\"%s\",stage=\"%s\"", opcode_name(op), stages[st]);
+            len = render_summary(buf, cap, len, "gpio_command_seconds", labels, &m);
+        }
+    }
+    APPEND("# HELP gpio_command_errors_total 오류 응답 수\n# TYPE gpio_command_errors_total counter\n");
+    for (int op = 0; op < OP_MAX; op++) {
+        uint64_t n = metrics_counter(METRIC_ERRORS_BASE + op);
+        if (n) APPEND("gpio_command_errors_total{command=\"%s\"} %llu\n", opcode_name(op), (unsigned long long)n);
+    }
+    APPEND("# HELP gpio_interrupt_seconds 인터럽트 발생부터 이벤트 루프 처리/알림 투입까지\n"
+           "# TYPE gpio_interrupt_seconds summary\n");
+    metrics_summarize(METRIC_HIST_ISR_DISPATCH, &m);
+    len = render_summary(buf, cap, len, "gpio_interrupt_seconds", "path=\"dispatch\"", &m);
+    metrics_summarize(METRIC_HIST_ISR_NOTIFY, &m);
+    len = render_summary(buf, cap, len, "gpio_interrupt_seconds", "path=\"notify\"", &m);
+
+    static const struct {
+        int id;
+        const char *name;
+    } counters[] = {
+        {METRIC_ACCEPTED, "gpio_connections_accepted_total"},
+        {METRIC_REJECTED, "gpio_connections_rejected_total"},
+        {METRIC_BYTES_IN, "gpio_received_bytes_total"},
+        {METRIC_BYTES_OUT, "gpio_sent_bytes_total"},
+        {METRIC_EVENTS, "gpio_events_sent_total"},
+    };
+    for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); i++)
+        APPEND("# TYPE %s counter\n%s %llu\n", counters[i].name, counters[i].name,
+               (unsigned long long)metrics_counter(counters[i].id));
+    return len;
+}
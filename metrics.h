@@ -0,0 +1,50 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "protocol.h"
+
+/*
+ * 지연시간 히스토그램과 카운터
+ * - 기록은 스레드별 버킷에 락 없이 더하고, 조회할 때 모든 스레드의 버킷을 합친다
+ * - 히스토그램은 HDR 방식(2의 거듭제곱 구간마다 16칸)이라 값 크기와 무관하게 상대 오차가 약 6% 이내
+ */
+
+// 명령별 측정 구간
+enum metric_stage {
+    METRIC_PARSE = 0,   // 텍스트/바이너리 디코딩
+    METRIC_EXEC,        // 핸들러 실행 (디바이스 조작 포함)
+    METRIC_STAGES
+};
+
+#define METRIC_HIST_CMD(stage, opcode) ((stage) * OP_MAX + (opcode))
+#define METRIC_HIST_ISR_DISPATCH (METRIC_STAGES * OP_MAX)     // 인터럽트 → 이벤트 루프 디스패치
+#define METRIC_HIST_ISR_NOTIFY (METRIC_HIST_ISR_DISPATCH + 1) // 인터럽트 → 구독자 전송 버퍼 투입
+#define METRIC_HISTS (METRIC_HIST_ISR_NOTIFY + 1)
+
+enum metric_counter {
+    METRIC_ACCEPTED = 0,    // 수락한 연결
+    METRIC_REJECTED,        // 최대 접속 수 초과로 거부한 연결
+    METRIC_BYTES_IN,
+    METRIC_BYTES_OUT,
+    METRIC_EVENTS,          // 클라이언트에 보낸 알림 건수
+    METRIC_ERRORS_BASE,     // + opcode: 오류 응답 수
+    METRIC_COUNTERS = METRIC_ERRORS_BASE + OP_MAX
+};
+
+struct metric_summary {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint64_t p50_ns, p90_ns, p99_ns, p999_ns;
+};
+
+uint64_t metrics_now(void);                      // CLOCK_MONOTONIC ns
+void metrics_record(int hist, uint64_t ns);      // 호출한 스레드의 버킷에 기록
+void metrics_add(int counter, uint64_t n);
+void metrics_summarize(int hist, struct metric_summary *out);
+uint64_t metrics_counter(int counter);
+size_t metrics_render_prometheus(char *buf, size_t cap);  // 히스토그램과 카운터를 Prometheus 텍스트 형식으로
+
+#endif
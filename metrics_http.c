@@ -0,0 +1,128 @@
+/**
+ * metrics_http.c - Prometheus 텍스트 형식 수집 엔드포인트
+ *
+ * 요청 헤더가 끝나면(빈 줄) 본문을 한 번에 만들어 논블로킹으로 보내고 연결을 닫는다.
+ * 명령 포트와 분리되어 있어 수집이 명령 처리 순서에 끼어들지 않는다.
+ */
+#define _GNU_SOURCE
+#include "metrics_http.h"
+#include "event_loop.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+#define REQUEST_MAX 2048
+#define BODY_MAX (64 * 1024)
+#define HEADER_MAX 128
+
+struct http_conn {
+    int fd;
+    char req[REQUEST_MAX];
+    size_t req_len;
+    char *resp;             // 응답 전체 (헤더 + 본문), 만들기 전에는 NULL
+    size_t resp_len, sent;
+};
+
+static metrics_render_fn render_fn = NULL;
+
+static void conn_close(struct http_conn *hc) {
+    event_loop_del(hc->fd);
+    close(hc->fd);
+    free(hc->resp);
+    free(hc);
+}
+
+static int build_response(struct http_conn *hc) {
+    hc->resp = malloc(HEADER_MAX + BODY_MAX);
+    if (!hc->resp) return -1;
+    size_t body = render_fn(hc->resp + HEADER_MAX, BODY_MAX);
+    char header[HEADER_MAX];
+    int n = snprintf(header, sizeof(header),
+                     "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                     "Content-Length: %zu\r\nConnection: close\r\n\r\n", body);
+    // 헤더를 본문 바로 앞에 붙여 한 버퍼로 보낸다
+    hc->sent = HEADER_MAX - n;
+    memcpy(hc->resp + hc->sent, header, n);
+    hc->resp_len = HEADER_MAX + body;
+    return 0;
+}
+
+static void on_conn_event(int fd, uint32_t events, void *arg) {
+    struct http_conn *hc = arg;
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        conn_close(hc);
+        return;
+    }
+    if (!hc->resp) {
+        ssize_t n = read(fd, hc->req + hc->req_len, sizeof(hc->req) - 1 - hc->req_len);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+            conn_close(hc);
+            return;
+        }
+        if (n > 0) hc->req_len += n;
+        hc->req[hc->req_len] = '\0';
+        if (!strstr(hc->req, "\r\n\r\n") && !strstr(hc->req, "\n\n")) {
+            if (hc->req_len == sizeof(hc->req) - 1) conn_close(hc);
+            return;
+        }
+        if (build_response(hc) < 0) {
+            conn_close(hc);
+            return;
+        }
+    }
+    while (hc->sent < hc->resp_len) {
+        ssize_t n = write(fd, hc->resp + hc->sent, hc->resp_len - hc->sent);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) {
+                event_loop_mod(fd, EPOLLOUT);
+                return;
+            }
+            break;
+        }
+        hc->sent += n;
+    }
+    conn_close(hc);
+}
+
+static void on_accept(int sockfd, uint32_t events, void *arg) {
+    (void)events; (void)arg;
+    while (1) {
+        int fd = accept4(sockfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        struct http_conn *hc = calloc(1, sizeof(*hc));
+        if (!hc) {
+            close(fd);
+            continue;
+        }
+        hc->fd = fd;
+        if (event_loop_add(fd, EPOLLIN, on_conn_event, hc) < 0) {
+            close(fd);
+            free(hc);
+        }
+    }
+}
+
+int metrics_http_start(int port, metrics_render_fn render) {
+    struct sockaddr_in addr;
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0 ||
+        event_loop_add(fd, EPOLLIN, on_accept, NULL) < 0) {
+        close(fd);
+        return -1;
+    }
+    render_fn = render;
+    return 0;
+}
@@ -0,0 +1,11 @@
+#ifndef METRICS_HTTP_H
+#define METRICS_HTTP_H
+
+#include <stddef.h>
+
+// Prometheus 수집용 HTTP 엔드포인트 (이벤트 루프에서 동작, 어떤 경로로 요청해도 같은 본문)
+typedef size_t (*metrics_render_fn)(char *buf, size_t cap);
+
+int metrics_http_start(int port, metrics_render_fn render);   // 리슨 소켓을 이벤트 루프에 등록
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * pin_events.c - ISR에서 이벤트 루프로 넘기는 lock-free MPSC 링
+ *
+ * 칸마다 순번(seq)을 두는 유한 MPSC 큐. 생산자는 enqueue 위치를 CAS로 잡고
+ * 칸을 채운 뒤 seq를 올려 소비자에게 공개한다. 소비자는 이벤트 루프 스레드 하나뿐이다.
+ * 깨우기용 eventfd 쓰기는 소비자가 잠들어 있을 때(pending == 0)만 한다.
+ */
+#include "pin_events.h"
+#include "event_loop.h"
+#include <stddef.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#define PIN_EVENT_RING 1024   // 2의 거듭제곱
+#define RING_MASK (PIN_EVENT_RING - 1)
+
+struct slot {
+    size_t seq;
+    struct pin_event ev;
+};
+
+static struct slot ring[PIN_EVENT_RING];
+static size_t enqueue_pos = 0;
+static size_t dequeue_pos = 0;     // 소비자 전용
+static int pending = 0;            // eventfd에 이미 신호를 넣었음
+static unsigned long dropped = 0;
+static int efd = -1;
+static pin_event_fn dispatch_fn = NULL;
+static void *dispatch_arg = NULL;
+
+static int ring_pop(struct pin_event *ev) {
+    struct slot *s = &ring[dequeue_pos & RING_MASK];
+    size_t seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+    if ((ptrdiff_t)(seq - (dequeue_pos + 1)) < 0) return 0;
+    *ev = s->ev;
+    __atomic_store_n(&s->seq, dequeue_pos + PIN_EVENT_RING, __ATOMIC_RELEASE);
+    dequeue_pos++;
+    return 1;
+}
+
+static void on_wake(int fd, uint32_t events, void *arg) {
+    (void)events; (void)arg;
+    uint64_t n;
+    while (read(fd, &n, sizeof(n)) > 0) { }
+    // 신호를 먼저 내려야 비우는 도중 들어온 이벤트가 다음 깨우기를 만든다
+    __atomic_store_n(&pending, 0, __ATOMIC_SEQ_CST);
+    struct pin_event ev;
+    while (ring_pop(&ev)) dispatch_fn(&ev, dispatch_arg);
+}
+
+int pin_events_init(pin_event_fn fn, void *arg) {
+    for (size_t i = 0; i < PIN_EVENT_RING; i++) ring[i].seq = i;
+    dispatch_fn = fn;
+    dispatch_arg = arg;
+    efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (efd < 0) return -1;
+    if (event_loop_add(efd, EPOLLIN, on_wake, NULL) < 0) return -1;
+    // 초기화 전에 들어온 인터럽트는 eventfd 쓰기에 실패했으므로 여기서 대신 깨운다
+    if (__atomic_load_n(&pending, __ATOMIC_SEQ_CST)) {
+        uint64_t one = 1;
+        if (write(efd, &one, sizeof(one)) < 0) { }
+    }
+    return 0;
+}
+
+int pin_events_push(int device, int pin, int value) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    size_t pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+    struct slot *s;
+    for (;;) {
+        s = &ring[pos & RING_MASK];
+        size_t seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        ptrdiff_t dif = (ptrdiff_t)(seq - pos);
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&enqueue_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+        } else if (dif < 0) {
+            __atomic_add_fetch(&dropped, 1, __ATOMIC_RELAXED);
+            return -1;
+        } else {
+            pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+    s->ev.ts_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    s->ev.device = (uint8_t)device;
+    s->ev.pin = (uint8_t)pin;
+    s->ev.value = (int16_t)value;
+    __atomic_store_n(&s->seq, pos + 1, __ATOMIC_RELEASE);
+    if (!__atomic_exchange_n(&pending, 1, __ATOMIC_SEQ_CST)) {
+        uint64_t one = 1;
+        if (write(efd, &one, sizeof(one)) < 0) { }
+    }
+    return 0;
+}
+
+unsigned long pin_events_dropped(void) {
+    return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
+
+size_t pin_events_pending(void) {
+    return __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED) - dequeue_pos;
+}
@@ -0,0 +1,28 @@
+#ifndef PIN_EVENTS_H
+#define PIN_EVENTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 인터럽트 → 이벤트 루프 전달 경로
+ * - ISR(백엔드 스레드 여러 개 가능)은 pin_events_push()로 lock-free MPSC 링에 넣기만 한다
+ * - 이벤트 루프 스레드가 eventfd로 깨어나 링을 비우며 디스패처 콜백을 호출한다
+ * - 링이 가득 차면 새 이벤트는 버리고 개수만 센다 (ISR은 절대 기다리지 않음)
+ */
+
+struct pin_event {
+    uint64_t ts_ns;     // CLOCK_MONOTONIC 기준 발생 시각
+    uint8_t device;     // enum proto_device
+    uint8_t pin;
+    int16_t value;
+};
+
+typedef void (*pin_event_fn)(const struct pin_event *ev, void *arg);
+
+int pin_events_init(pin_event_fn fn, void *arg); // eventfd를 이벤트 루프에 등록
+int pin_events_push(int device, int pin, int value); // ISR에서 호출, 가득 차면 -1
+unsigned long pin_events_dropped(void);
+size_t pin_events_pending(void);      // 아직 디스패치하지 않은 이벤트 수 (이벤트 루프 스레드에서 호출)
+
+#endif
@@ -0,0 +1,360 @@
+/**
+ * plugin.c - 디바이스 플러그인 로더와 RCU 방식 핫 스왑
+ *
+ * 읽는 쪽(명령 실행)은 슬롯의 현재 버전을 읽어 참조 수를 올리고, 포인터가 그대로인지 한 번 더 본다.
+ * 쓰는 쪽(교체)은 새 버전을 init한 뒤 포인터를 바꾸고, 옛 버전의 참조 수가 0이 되면 정리한다.
+ * 양쪽 모두 seq_cst라 "읽는 쪽은 옛 포인터로 들어왔는데 쓰는 쪽은 참조 0을 봤다"는 경우는 없다.
+ * 버전 구조체는 해제하지 않고 재사용하므로, 늦게 온 읽는 쪽이 참조 수를 잠깐 건드려도 안전하다.
+ *
+ * .so는 원본 파일을 memfd로 복사해서 싣는다. 같은 경로를 다시 dlopen하면 이미 실린 핸들이
+ * 돌아오기 때문이고, 실행 중에 원본 파일을 덮어써도 실린 코드가 깨지지 않는다.
+ */
+#define _GNU_SOURCE
+#include "plugin.h"
+#include "command.h"
+#include "timer_wheel.h"
+#include "log.h"
+#include "led.h"
+#include "buzzer.h"
+#include "seg7.h"
+#include "light_sensor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define PLUGIN_MAX 8
+#define PLUGIN_SYM_MAX 64
+
+struct plugin_slot;
+
+struct plugin_version {
+    const struct gpio_plugin *desc;
+    struct plugin_slot *slot;
+    void *handle;                       // dlopen 핸들 (내장 모듈이면 NULL)
+    int fd;                             // .so 사본 memfd (내장 모듈이면 -1)
+    unsigned generation;
+    int refs;                           // 이 버전에서 실행 중인 호출 수 (재사용할 때도 초기화하지 않음)
+    command_handler handlers[OP_MAX];   // 실을 때 한 번 만든 opcode → 핸들러 표
+    struct plugin_version *next_free;
+};
+
+struct plugin_slot {
+    const struct gpio_plugin *builtin;
+    struct plugin_version *cur;         // 원자적으로 교체
+    unsigned generation;
+    int retiring;                       // 참조가 남아 정리를 기다리는 옛 버전 수
+    struct stat file;                   // 지금 실은 .so 파일 (내장 모듈이면 st_ino 0)
+};
+
+static const struct gpio_plugin *const builtins[] = {
+    &led_plugin,
+    &buzzer_plugin,
+    &seg7_plugin,
+    &light_sensor_plugin,
+};
+
+static struct plugin_slot slots[PLUGIN_MAX];
+static size_t num_slots = 0;
+static struct plugin_slot *by_opcode[OP_MAX];
+static struct plugin_slot *by_device[DEV_MAX];
+static struct plugin_version *free_versions = NULL;
+static char plugin_dir[PATH_MAX];       // 비어 있으면 내장 모듈만 사용
+
+static inline struct plugin_version *version_enter(struct plugin_slot *s) {
+    for (;;) {
+        struct plugin_version *v = __atomic_load_n(&s->cur, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&v->refs, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&s->cur, __ATOMIC_SEQ_CST) == v) return v;
+        __atomic_sub_fetch(&v->refs, 1, __ATOMIC_RELEASE); // 그 사이 교체됨: 새 버전으로 다시
+    }
+}
+
+static inline void version_exit(struct plugin_version *v) {
+    __atomic_sub_fetch(&v->refs, 1, __ATOMIC_RELEASE);
+}
+
+static struct plugin_version *version_alloc(void) {
+    struct plugin_version *v = free_versions;
+    if (v) free_versions = v->next_free;
+    else v = calloc(1, sizeof(*v));
+    return v;
+}
+
+static void version_free(struct plugin_version *v) {
+    if (v->handle) dlclose(v->handle);
+    if (v->fd >= 0) close(v->fd);
+    v->handle = NULL;
+    v->fd = -1;
+    v->desc = NULL;
+    v->next_free = free_versions;
+    free_versions = v;
+}
+
+// 기술자를 검사하고 핸들러 표를 만든다. opcode는 내장 모듈이 등록한 것만 허용
+static int version_fill(struct plugin_version *v, struct plugin_slot *s, const struct gpio_plugin *d) {
+    if (d->abi != GPIO_PLUGIN_ABI) {
+        log_msg(LOG_ERR, "플러그인 %s: ABI %u (데몬 %d)", s->builtin->name, d->abi, GPIO_PLUGIN_ABI);
+        return -1;
+    }
+    if (!d->name || strcmp(d->name, s->builtin->name) != 0 || d->device != s->builtin->device || !d->init || !d->teardown) {
+        log_msg(LOG_ERR, "플러그인 %s: 기술자가 슬롯과 맞지 않음", s->builtin->name);
+        return -1;
+    }
+    memset(v->handlers, 0, sizeof(v->handlers));
+    for (size_t i = 0; i < d->ncommands; i++) {
+        int op = d->commands[i].opcode;
+        if (op <= OP_NONE || op >= OP_MAX || by_opcode[op] != s) {
+            log_msg(LOG_ERR, "플러그인 %s: 등록되지 않은 opcode %d (%s)", d->name, op, d->commands[i].verb);
+            return -1;
+        }
+        v->handlers[op] = d->commands[i].handler;
+    }
+    v->desc = d;
+    v->slot = s;
+    return 0;
+}
+
+// 참조가 남아 있으면 한 틱 뒤에 다시 본다. 타이머 콜백도 이벤트 루프 스레드라 응답 인코딩과 겹치지 않는다.
+static void retire_check(uint32_t id, void *arg) {
+    (void)id;
+    struct plugin_version *v = arg;
+    if (__atomic_load_n(&v->refs, __ATOMIC_SEQ_CST) > 0) {
+        if (timer_add(TIMER_TICK_MS, retire_check, v)) return;
+        log_msg(LOG_ERR, "플러그인 %s 세대 %u 정리 예약 실패 (버전을 남겨 둠)", v->desc->name, v->generation);
+        return;
+    }
+    v->desc->teardown(GPIO_PLUGIN_RELOAD);
+    v->slot->retiring--;
+    log_msg(LOG_INFO, "플러그인 %s 세대 %u 정리", v->desc->name, v->generation);
+    version_free(v);
+}
+
+static void publish(struct plugin_slot *s, struct plugin_version *v) {
+    struct plugin_version *old = s->cur;
+    v->generation = s->cur ? ++s->generation : s->generation;
+    __atomic_store_n(&s->cur, v, __ATOMIC_SEQ_CST);
+    if (old) {
+        s->retiring++;
+        retire_check(0, old);
+    }
+}
+
+// 원본을 memfd로 복사 (사본 fd, 실패 시 -1)
+static int copy_to_memfd(const char *path, const char *name) {
+    int in = open(path, O_RDONLY | O_CLOEXEC);
+    if (in < 0) return -1;
+    int fd = memfd_create(name, MFD_CLOEXEC);
+    char buf[16 * 1024];
+    ssize_t n = 0;
+    while (fd >= 0 && (n = read(in, buf, sizeof(buf))) > 0) {
+        if (write(fd, buf, n) != n) n = -1;
+        if (n < 0) break;
+    }
+    close(in);
+    if (fd >= 0 && n < 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+// dir/<이름>.so를 실어 슬롯에 넣는다. 1 교체, 0 파일이 없거나 그대로, -1 실패 (현재 버전 유지)
+static int slot_load(struct plugin_slot *s, int flags, int force) {
+    const char *name = s->builtin->name;
+    char path[PATH_MAX + PLUGIN_SYM_MAX];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/%s.so", plugin_dir, name);
+    if (stat(path, &st) < 0) return 0;
+    if (!force && st.st_dev == s->file.st_dev && st.st_ino == s->file.st_ino && st.st_size == s->file.st_size &&
+        st.st_mtim.tv_sec == s->file.st_mtim.tv_sec && st.st_mtim.tv_nsec == s->file.st_mtim.tv_nsec)
+        return 0;
+
+    int fd = copy_to_memfd(path, name);
+    if (fd < 0) {
+        log_msg(LOG_ERR, "플러그인 %s 복사 실패", path);
+        return -1;
+    }
+    // 살아 있는 버전마다 memfd를 열어 두므로 /proc 경로가 겹치지 않는다
+    char fdpath[32], sym[PLUGIN_SYM_MAX];
+    snprintf(fdpath, sizeof(fdpath), "/proc/self/fd/%d", fd);
+    snprintf(sym, sizeof(sym), "%s_plugin", name);
+    void *handle = dlopen(fdpath, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        log_msg(LOG_ERR, "플러그인 %s 로드 실패: %s", path, dlerror());
+        close(fd);
+        return -1;
+    }
+    struct plugin_version *v = version_alloc();
+    if (!v) {
+        dlclose(handle);
+        close(fd);
+        return -1;
+    }
+    v->handle = handle;
+    v->fd = fd;
+    const struct gpio_plugin *d = dlsym(handle, sym);
+    if (!d) {
+        log_msg(LOG_ERR, "플러그인 %s: %s 심볼 없음", path, sym);
+        version_free(v);
+        return -1;
+    }
+    if (version_fill(v, s, d) < 0) {
+        version_free(v);
+        return -1;
+    }
+    if (d->init(flags) < 0) {
+        log_msg(LOG_ERR, "플러그인 %s 초기화 실패", path);
+        version_free(v);
+        return -1;
+    }
+    s->file = st;
+    publish(s, v);
+    log_msg(LOG_INFO, "플러그인 %s v%u 로드 (세대 %u)", name, d->version, v->generation);
+    return 1;
+}
+
+// 내장 모듈을 현재 버전으로
+static int slot_use_builtin(struct plugin_slot *s) {
+    struct plugin_version *v = version_alloc();
+    if (!v) return -1;
+    v->handle = NULL;
+    v->fd = -1;
+    if (version_fill(v, s, s->builtin) < 0) {
+        version_free(v);
+        return -1;
+    }
+    if (s->builtin->init(0) < 0) log_msg(LOG_ERR, "%s 초기화 실패", s->builtin->name);
+    memset(&s->file, 0, sizeof(s->file));
+    publish(s, v);
+    return 0;
+}
+
+int plugin_init(const char *dir) {
+    if (dir && !realpath(dir, plugin_dir)) {
+        log_msg(LOG_WARNING, "플러그인 디렉터리 %s 없음, 내장 모듈만 사용", dir);
+        plugin_dir[0] = '\0';
+    }
+    for (size_t i = 0; i < sizeof(builtins) / sizeof(builtins[0]) && num_slots < PLUGIN_MAX; i++) {
+        struct plugin_slot *s = &slots[num_slots++];
+        s->builtin = builtins[i];
+        by_device[s->builtin->device] = s;
+        for (size_t j = 0; j < s->builtin->ncommands; j++) by_opcode[s->builtin->commands[j].opcode] = s;
+    }
+    for (size_t i = 0; i < num_slots; i++) {
+        struct plugin_slot *s = &slots[i];
+        if (plugin_dir[0] && slot_load(s, 0, 1) > 0) continue;
+        if (slot_use_builtin(s) < 0) return -1;
+    }
+    return 0;
+}
+
+// 레지스트리에 등록되는 공통 핸들러: 슬롯의 현재 버전으로 넘긴다
+static void plugin_dispatch(const struct request *req, struct reply *rep) {
+    plugin_execute(req, rep, NULL, NULL);
+}
+
+int plugin_register_commands(void) {
+    static struct command_def defs[OP_MAX];
+    size_t n = 0;
+    for (size_t i = 0; i < num_slots; i++) {
+        const struct gpio_plugin *b = slots[i].builtin;
+        for (size_t j = 0; j < b->ncommands && n < OP_MAX; j++) {
+            defs[n] = b->commands[j];
+            defs[n].handler = plugin_dispatch;
+            n++;
+        }
+    }
+    return command_register(defs, n);
+}
+
+int plugin_reload(const char *name, int *failed) {
+    int swapped = 0, found = 0;
+    if (failed) *failed = 0;
+    for (size_t i = 0; i < num_slots; i++) {
+        struct plugin_slot *s = &slots[i];
+        if (name && strcmp(name, s->builtin->name) != 0) continue;
+        found = 1;
+        if (!plugin_dir[0]) continue;
+        int r = slot_load(s, GPIO_PLUGIN_RELOAD, name != NULL);
+        if (r < 0 && failed) (*failed)++;
+        if (r > 0) swapped++;
+    }
+    return name && !found ? -1 : swapped;
+}
+
+void plugin_shutdown(void) {
+    for (size_t i = 0; i < num_slots; i++) {
+        struct plugin_version *v = slots[i].cur;
+        if (v) v->desc->teardown(0);
+    }
+}
+
+void plugin_call(int opcode, const int32_t *args, int nargs, struct reply *rep) {
+    struct request req;
+    memset(&req, 0, sizeof(req));
+    memset(rep, 0, sizeof(*rep));
+    const struct command_def *d = command_by_opcode(opcode);
+    req.opcode = opcode;
+    req.device = d ? d->device : DEV_SYSTEM;
+    for (int i = 0; i < nargs && i < PROTO_MAX_ARGS; i++) req.args[req.nargs++] = args[i];
+    command_dispatch(&req, rep);
+}
+
+void plugin_execute(const struct request *req, struct reply *rep, void (*after)(void *ctx), void *ctx) {
+    if (plugin_device(req->opcode) < 0) {
+        command_dispatch(req, rep);
+        if (after) after(ctx);
+        return;
+    }
+    struct plugin_version *v = version_enter(by_opcode[req->opcode]);
+    command_handler h = v->handlers[req->opcode];
+    if (h) h(req, rep);
+    else reply_error(rep, ST_UNKNOWN_COMMAND);
+    if (after) after(ctx);
+    version_exit(v);
+}
+
+int plugin_device(int opcode) {
+    if (opcode <= OP_NONE || opcode >= OP_MAX || !by_opcode[opcode]) return -1;
+    return by_opcode[opcode]->builtin->device;
+}
+
+uint32_t plugin_off_mask(void) {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < num_slots; i++) {
+        struct plugin_version *v = version_enter(&slots[i]);
+        if (v->desc->off_mask) mask |= v->desc->off_mask();
+        version_exit(v);
+    }
+    return mask;
+}
+
+int plugin_read(int device) {
+    if (device < 0 || device >= DEV_MAX || !by_device[device]) return -1;
+    struct plugin_version *v = version_enter(by_device[device]);
+    int value = v->desc->read ? v->desc->read() : -1;
+    version_exit(v);
+    return value;
+}
+
+size_t plugin_count(void) {
+    return num_slots;
+}
+
+int plugin_get_info(size_t i, struct plugin_info *info) {
+    if (i >= num_slots) return -1;
+    struct plugin_version *v = version_enter(&slots[i]);
+    info->name = slots[i].builtin->name;
+    info->version = v->desc->version;
+    info->generation = v->generation;
+    info->builtin = v->handle == NULL;
+    info->retiring = slots[i].retiring;
+    version_exit(v);
+    return 0;
+}
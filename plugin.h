@@ -0,0 +1,44 @@
+#ifndef PLUGIN_H
+#define PLUGIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "protocol.h"
+#include "gpio_plugin.h"
+
+/*
+ * 디바이스 플러그인 관리자 (gpio_plugin.h의 기술자를 싣고 핫 스왑)
+ * - 디바이스마다 슬롯 하나, 슬롯은 현재 버전 포인터 하나를 원자적으로 바꿔 끼운다
+ * - 명령 레지스트리에는 슬롯으로 넘기는 디스패치 함수가 한 번만 등록되고,
+ *   버전마다 opcode → 핸들러 표를 실을 때 한 번 만들어 둔다 (호출 경로에 dlsym/락 없음)
+ * - 진행 중인 명령은 옛 버전에서 끝난다. 옛 버전은 참조가 0이 된 뒤 이벤트 루프 스레드에서
+ *   teardown/dlclose 한다 (디바이스 실행기에서 도는 명령은 plugin_execute의 after에서 응답을
+ *   인코딩하므로, 그동안 버전이 잡혀 있어 응답 문자열도 안전)
+ * - plugin_reload와 plugin_shutdown은 이벤트 루프 스레드에서만 호출할 것
+ */
+
+struct plugin_info {
+    const char *name;
+    uint32_t version;
+    unsigned generation;    // 교체 횟수 (내장 모듈로 시작하면 0)
+    int builtin;            // 데몬에 내장된 모듈을 쓰는 중
+    int retiring;           // 아직 정리되지 않은 옛 버전 수
+};
+
+int plugin_init(const char *dir);               // 내장 모듈 등록, dir의 .so가 있으면 그쪽으로 시작 (dir NULL이면 내장만)
+int plugin_register_commands(void);             // 모든 슬롯의 명령을 레지스트리에 등록
+int plugin_reload(const char *name, int *failed); // 파일이 바뀐 .so만 교체 (name을 주면 그 모듈은 무조건), 교체한 수
+void plugin_shutdown(void);                     // teardown 후 .so 닫기
+
+// 이벤트 루프 밖(음악 모드 스레드 등)에서도 부를 수 있는 내부 실행 경로
+void plugin_call(int opcode, const int32_t *args, int nargs, struct reply *rep);
+// 핸들러를 실행하고 같은 버전을 잡은 채로 after를 부른다 (응답 문자열이 그 .so 안을 가리키는 동안 인코딩)
+void plugin_execute(const struct request *req, struct reply *rep, void (*after)(void *ctx), void *ctx);
+int plugin_device(int opcode);                  // 플러그인 명령이면 그 디바이스, 아니면 -1
+uint32_t plugin_off_mask(void);                 // 출력 장치들의 OFF 마스크를 모은 값
+int plugin_read(int device);                    // 입력 장치 값, 없으면 -1
+
+size_t plugin_count(void);
+int plugin_get_info(size_t i, struct plugin_info *info);
+
+#endif
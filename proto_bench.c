@@ -0,0 +1,158 @@
+/**
+ * proto_bench.c - 텍스트/바이너리 프로토콜 파싱 비용, 전송 바이트, 명령 디스패치 비용 벤치마크
+ *
+ * 사용법: ./proto_bench [반복횟수]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "protocol.h"
+#include "command.h"
+#include "proto_verbs.h"
+
+#define DEFAULT_ITERATIONS 2000000
+#define EXTRA_VERBS 150       // 디스패치 비용이 명령 수와 무관한지 보기 위한 가짜 명령 수
+#define EXTRA_OPCODE_BASE 100 // 가짜 명령 opcode 시작 값 (opcode는 1바이트)
+
+struct sample {
+    const char *text;     // 텍스트 요청 (개행 제외)
+    const char *tag;      // 응답 머리
+    int nvals;
+    int32_t vals[2];
+};
+
+static const struct sample samples[] = {
+    {"LED:ON",       "OK:LED:ON",     0, {0, 0}},
+    {"LED:BRIGHT:2", "OK:LED:BRIGHT", 1, {2, 0}},
+    {"SEG7:5",       "OK:SEG7",       1, {5, 0}},
+    {"SENSOR:27",    "VALUE:SENSOR",  2, {27, 1}},
+    {"TIMER:10",     "OK:TIMER",      1, {10, 0}},
+};
+#define NUM_SAMPLES (sizeof(samples) / sizeof(samples[0]))
+
+static void cmd_noop(const struct request *req, struct reply *rep) {
+    (void)req;
+    reply_ok(rep, "OK");
+}
+
+// 데몬과 같은 verb/opcode 구성 (핸들러는 비어 있음)
+static const struct command_def bench_commands[] = {
+    {VERB_LED_ON,           cmd_noop},
+    {VERB_LED_OFF,          cmd_noop},
+    {VERB_LED_BRIGHT,       cmd_noop},
+    {VERB_BUZZER_ON,        cmd_noop},
+    {VERB_BUZZER_OFF,       cmd_noop},
+    {VERB_BUZZER_MUSIC,     cmd_noop},
+    {VERB_SEG7_SHOW,        cmd_noop},
+    {VERB_SEG7_OFF,         cmd_noop},
+    {VERB_SENSOR_READ,      cmd_noop},
+    {VERB_EXTRA_MUSIC_MODE, cmd_noop},
+    {VERB_ALL_OFF,          cmd_noop},
+    {VERB_TIMER,            cmd_noop},
+};
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : DEFAULT_ITERATIONS;
+    uint8_t frames[NUM_SAMPLES][64];
+    size_t frame_len[NUM_SAMPLES];
+    struct reply replies[NUM_SAMPLES];
+    size_t text_req = 0, text_rep = 0, bin_req = 0, bin_rep = 0;
+
+    if (command_register(bench_commands, sizeof(bench_commands) / sizeof(bench_commands[0])) < 0) {
+        fprintf(stderr, "명령 등록 실패\n");
+        return 1;
+    }
+
+    // 같은 명령의 바이너리 프레임과 응답을 미리 만들어 둠
+    for (size_t i = 0; i < NUM_SAMPLES; i++) {
+        struct request req;
+        char out[PROTO_MAX_REPLY];
+        uint8_t bout[PROTO_MAX_REPLY];
+        if (proto_parse_text(samples[i].text, &req) != ST_OK) {
+            fprintf(stderr, "파싱 실패: %s\n", samples[i].text);
+            return 1;
+        }
+        frame_len[i] = proto_encode_request(&req, frames[i], sizeof(frames[i]));
+        memset(&replies[i], 0, sizeof(replies[i]));
+        reply_ok(&replies[i], samples[i].tag);
+        for (int v = 0; v < samples[i].nvals; v++) reply_value(&replies[i], samples[i].vals[v]);
+
+        text_req += strlen(samples[i].text) + 1;
+        text_rep += proto_encode_text(&replies[i], out, sizeof(out));
+        bin_req += frame_len[i];
+        bin_rep += proto_encode_binary(&req, &replies[i], bout, sizeof(bout));
+    }
+
+    volatile int sink = 0;
+    char out[PROTO_MAX_REPLY];
+    uint8_t bout[PROTO_MAX_REPLY];
+
+    // 텍스트: 줄 파싱 + 응답 문자열 생성
+    double t0 = now_ns();
+    for (long n = 0; n < iterations; n++) {
+        size_t i = n % NUM_SAMPLES;
+        struct request req;
+        proto_parse_text(samples[i].text, &req);
+        sink += req.opcode + (int)proto_encode_text(&replies[i], out, sizeof(out));
+    }
+    double text_ns = (now_ns() - t0) / iterations;
+
+    // 바이너리: 프레임 디코딩 + 응답 프레임 생성
+    t0 = now_ns();
+    for (long n = 0; n < iterations; n++) {
+        size_t i = n % NUM_SAMPLES;
+        struct request req;
+        proto_decode_binary(frames[i], frame_len[i], &req);
+        sink += req.opcode + (int)proto_encode_binary(&req, &replies[i], bout, sizeof(bout));
+    }
+    double bin_ns = (now_ns() - t0) / iterations;
+
+    // verb 조회 + 디스패치: 명령 12개일 때와 가짜 명령을 더 등록했을 때 비교
+    double lookup_ns[2];
+    for (int round = 0; round < 2; round++) {
+        if (round == 1) {
+            static struct command_def extra[EXTRA_VERBS];
+            static char names[EXTRA_VERBS][16];
+            for (int i = 0; i < EXTRA_VERBS; i++) {
+                snprintf(names[i], sizeof(names[i]), "FAKE%d:CMD", i);
+                extra[i].verb = names[i];
+                extra[i].opcode = EXTRA_OPCODE_BASE + i;
+                extra[i].device = DEV_NONE;
+                extra[i].handler = cmd_noop;
+            }
+            command_register(extra, EXTRA_VERBS);
+        }
+        t0 = now_ns();
+        for (long n = 0; n < iterations; n++) {
+            size_t i = n % NUM_SAMPLES;
+            const char *v = samples[i].text;
+            size_t len = strcspn(v, ":");
+            const struct command_def *d = command_lookup(v, len);
+            if (!d) d = command_lookup(v, strlen(v));
+            struct request req;
+            struct reply r;
+            req.opcode = d ? d->opcode : 0;
+            r.status = 0;
+            command_dispatch(&req, &r);
+            sink += r.status;
+        }
+        lookup_ns[round] = (now_ns() - t0) / iterations;
+    }
+
+    printf("반복 횟수: %ld (명령 %zu종 순환)\n", iterations, NUM_SAMPLES);
+    printf("%-8s %14s %14s %14s\n", "형식", "ns/명령", "요청 B/명령", "응답 B/명령");
+    printf("%-8s %14.1f %14.1f %14.1f\n", "text", text_ns,
+           (double)text_req / NUM_SAMPLES, (double)text_rep / NUM_SAMPLES);
+    printf("%-8s %14.1f %14.1f %14.1f\n", "binary", bin_ns,
+           (double)bin_req / NUM_SAMPLES, (double)bin_rep / NUM_SAMPLES);
+    printf("디스패치(verb 조회+핸들러 호출): 명령 %zu개 %.1f ns, 명령 %zu개 %.1f ns\n",
+           sizeof(bench_commands) / sizeof(bench_commands[0]), lookup_ns[0], command_count(), lookup_ns[1]);
+    return sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,89 @@
+#ifndef PROTO_VERBS_H
+#define PROTO_VERBS_H
+
+#include "protocol.h"
+
+/*
+ * 텍스트 verb, opcode, 디바이스의 유일한 정의
+ * - 데몬 모듈은 명령 표를 {VERB_LED_ON, cmd_led_on}처럼 핸들러만 붙여 쓴다
+ * - 클라이언트(client_verbs.c)는 GPIO_VERBS 목록을 펼쳐 핸들러 없는 같은 표를 만든다
+ * - 명령을 추가하면 아래 정의와 GPIO_VERBS에 한 줄씩 넣는다 (클라이언트가 모르는 verb는 보낼 수 없음)
+ */
+
+#define VERB_LED_ON             "LED:ON",             OP_LED_ON,             DEV_LED
+#define VERB_LED_OFF            "LED:OFF",            OP_LED_OFF,            DEV_LED
+#define VERB_LED_BRIGHT         "LED:BRIGHT",         OP_LED_BRIGHT,         DEV_LED
+#define VERB_LED_LEVEL          "LED:LEVEL",          OP_LED_LEVEL,          DEV_LED
+#define VERB_LED_FADE           "LED:FADE",           OP_LED_FADE,           DEV_LED
+#define VERB_BUZZER_ON          "BUZZER:ON",          OP_BUZZER_ON,          DEV_BUZZER
+#define VERB_BUZZER_OFF         "BUZZER:OFF",         OP_BUZZER_OFF,         DEV_BUZZER
+#define VERB_BUZZER_MUSIC       "BUZZER:MUSIC",       OP_BUZZER_MUSIC,       DEV_BUZZER
+#define VERB_BUZZER_QUEUE       "BUZZER:QUEUE",       OP_BUZZER_QUEUE,       DEV_BUZZER
+#define VERB_BUZZER_STOP        "BUZZER:STOP",        OP_BUZZER_STOP,        DEV_BUZZER
+#define VERB_BUZZER_STATUS      "BUZZER:STATUS",      OP_BUZZER_STATUS,      DEV_BUZZER
+#define VERB_SEG7_SHOW          "SEG7",               OP_SEG7_SHOW,          DEV_SEG7
+#define VERB_SEG7_OFF           "SEG7:OFF",           OP_SEG7_OFF,           DEV_SEG7
+#define VERB_SENSOR_READ        "SENSOR",             OP_SENSOR_READ,        DEV_SENSOR
+#define VERB_EXTRA_MUSIC_MODE   "EXTRA_MUSIC_MODE",   OP_EXTRA_MUSIC_MODE,   DEV_SYSTEM
+#define VERB_ALL_OFF            "ALL_OFF",            OP_ALL_OFF,            DEV_SYSTEM
+#define VERB_TIMER              "TIMER",              OP_TIMER,              DEV_SYSTEM
+#define VERB_TIMER_CANCEL       "TIMER:CANCEL",       OP_TIMER_CANCEL,       DEV_SYSTEM
+#define VERB_TIMER_LIST         "TIMER:LIST",         OP_TIMER_LIST,         DEV_SYSTEM
+#define VERB_SIM_INPUT          "SIM:INPUT",          OP_SIM_INPUT,          DEV_SYSTEM
+#define VERB_SIM_PIN            "SIM:PIN",            OP_SIM_PIN,            DEV_SYSTEM
+#define VERB_SUBSCRIBE_SENSOR   "SUBSCRIBE:SENSOR",   OP_SUBSCRIBE_SENSOR,   DEV_SENSOR
+#define VERB_UNSUBSCRIBE_SENSOR "UNSUBSCRIBE:SENSOR", OP_UNSUBSCRIBE_SENSOR, DEV_SENSOR
+#define VERB_SUBSCRIBE_BUTTON   "SUBSCRIBE:BUTTON",   OP_SUBSCRIBE_BUTTON,   DEV_BUTTON
+#define VERB_UNSUBSCRIBE_BUTTON "UNSUBSCRIBE:BUTTON", OP_UNSUBSCRIBE_BUTTON, DEV_BUTTON
+#define VERB_STATS              "STATS",              OP_STATS,              DEV_SYSTEM
+#define VERB_LOG_LEVEL          "LOG:LEVEL",          OP_LOG_LEVEL,          DEV_SYSTEM
+#define VERB_LOG_SAMPLE         "LOG:SAMPLE",         OP_LOG_SAMPLE,         DEV_SYSTEM
+#define VERB_RELOAD             "RELOAD",             OP_RELOAD,             DEV_SYSTEM
+#define VERB_PLUGIN_LIST        "PLUGIN:LIST",        OP_PLUGIN_LIST,        DEV_SYSTEM
+#define VERB_SEQ_DEF            "SEQ:DEF",            OP_SEQ_DEF,            DEV_SYSTEM
+#define VERB_SEQ_RUN            "SEQ:RUN",            OP_SEQ_RUN,            DEV_SYSTEM
+#define VERB_SEQ_STOP           "SEQ:STOP",           OP_SEQ_STOP,           DEV_SYSTEM
+#define VERB_SEQ_DEL            "SEQ:DEL",            OP_SEQ_DEL,            DEV_SYSTEM
+#define VERB_SEQ_LIST           "SEQ:LIST",           OP_SEQ_LIST,           DEV_SYSTEM
+#define VERB_INPUT_DEBOUNCE     "INPUT:DEBOUNCE",     OP_INPUT_DEBOUNCE,     DEV_SYSTEM
+
+// 모든 verb 목록: X(VERB_...) 꼴로 펼친다 (X의 인자는 펼치면 "verb", opcode, 디바이스 세 값)
+#define GPIO_VERBS(X) \
+    X(VERB_LED_ON) \
+    X(VERB_LED_OFF) \
+    X(VERB_LED_BRIGHT) \
+    X(VERB_LED_LEVEL) \
+    X(VERB_LED_FADE) \
+    X(VERB_BUZZER_ON) \
+    X(VERB_BUZZER_OFF) \
+    X(VERB_BUZZER_MUSIC) \
+    X(VERB_BUZZER_QUEUE) \
+    X(VERB_BUZZER_STOP) \
+    X(VERB_BUZZER_STATUS) \
+    X(VERB_SEG7_SHOW) \
+    X(VERB_SEG7_OFF) \
+    X(VERB_SENSOR_READ) \
+    X(VERB_EXTRA_MUSIC_MODE) \
+    X(VERB_ALL_OFF) \
+    X(VERB_TIMER) \
+    X(VERB_TIMER_CANCEL) \
+    X(VERB_TIMER_LIST) \
+    X(VERB_SIM_INPUT) \
+    X(VERB_SIM_PIN) \
+    X(VERB_SUBSCRIBE_SENSOR) \
+    X(VERB_UNSUBSCRIBE_SENSOR) \
+    X(VERB_SUBSCRIBE_BUTTON) \
+    X(VERB_UNSUBSCRIBE_BUTTON) \
+    X(VERB_STATS) \
+    X(VERB_LOG_LEVEL) \
+    X(VERB_LOG_SAMPLE) \
+    X(VERB_RELOAD) \
+    X(VERB_PLUGIN_LIST) \
+    X(VERB_SEQ_DEF) \
+    X(VERB_SEQ_RUN) \
+    X(VERB_SEQ_STOP) \
+    X(VERB_SEQ_DEL) \
+    X(VERB_SEQ_LIST) \
+    X(VERB_INPUT_DEBOUNCE)
+
+#endif
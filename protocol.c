@@ -0,0 +1,190 @@
+/**
+ * protocol.c - 텍스트/바이너리 명령 디코더와 응답 인코더
+ */
+#include "protocol.h"
+#include "command.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+static const char *status_names[ST_MAX] = {
+    [ST_OK] = "OK",
+    [ST_UNKNOWN_COMMAND] = "UNKNOWN_COMMAND",
+    [ST_BAD_ARGS] = "BAD_ARGS",
+    [ST_TOO_LONG] = "TOO_LONG",
+    [ST_BUSY] = "BUSY",
+    [ST_FAILED] = "FAILED",
+};
+
+const char *proto_status_name(int status) {
+    if (status < 0 || status >= ST_MAX || !status_names[status]) return "FAILED";
+    return status_names[status];
+}
+
+// "LED:BRIGHT:2" → opcode=OP_LED_BRIGHT, args={2}
+// 두 토큰 동사("LED:BRIGHT")를 먼저 찾고, 없으면 한 토큰 동사("SEG7")로 본다.
+int proto_parse_text(const char *line, struct request *req) {
+    memset(req, 0, sizeof(*req));
+    size_t len1 = strcspn(line, ":");
+    const struct command_def *v = NULL;
+    size_t verb_len = len1;
+    if (line[len1] == ':') {
+        size_t len2 = len1 + 1 + strcspn(line + len1 + 1, ":");
+        v = command_lookup(line, len2);
+        if (v) verb_len = len2;
+    }
+    if (!v) v = command_lookup(line, len1);
+    if (!v) return ST_UNKNOWN_COMMAND;
+    req->opcode = v->opcode;
+    req->device = v->device;
+
+    // 앞쪽의 숫자 인자는 args로, 나머지는 text로
+    const char *p = line + verb_len;
+    while (*p == ':') {
+        char *end;
+        long val = strtol(p + 1, &end, 10);
+        if (end == p + 1 || (*end != ':' && *end != '\0')) break;
+        if (req->nargs >= PROTO_MAX_ARGS) return ST_BAD_ARGS;
+        req->args[req->nargs++] = (int32_t)val;
+        p = end;
+    }
+    if (*p == ':') {
+        req->text = p + 1;
+        req->text_len = strlen(p + 1);
+    }
+    return ST_OK;
+}
+
+size_t proto_frame_len(const uint8_t *hdr) {
+    uint16_t len;
+    memcpy(&len, hdr, sizeof(len));
+    return PROTO_HDR_SIZE + ntohs(len);
+}
+
+static void read_hdr(const uint8_t *buf, struct proto_hdr *h) {
+    uint16_t v;
+    memcpy(&v, buf, 2);
+    h->len = ntohs(v);
+    memcpy(&v, buf + 2, 2);
+    h->seq = ntohs(v);
+    h->opcode = buf[4];
+    h->device = buf[5];
+    h->nargs = buf[6];
+    h->flags = buf[7];
+}
+
+static void write_hdr(uint8_t *buf, const struct proto_hdr *h) {
+    uint16_t v = htons(h->len);
+    memcpy(buf, &v, 2);
+    v = htons(h->seq);
+    memcpy(buf + 2, &v, 2);
+    buf[4] = h->opcode;
+    buf[5] = h->device;
+    buf[6] = h->nargs;
+    buf[7] = h->flags;
+}
+
+int proto_decode_binary(const uint8_t *frame, size_t len, struct request *req) {
+    struct proto_hdr h;
+    memset(req, 0, sizeof(*req));
+    if (len < PROTO_HDR_SIZE) return ST_BAD_ARGS;
+    read_hdr(frame, &h);
+    req->seq = h.seq;
+    req->opcode = h.opcode;   // 오류 응답에도 opcode를 돌려주기 위해 먼저 기록
+    if (h.len > PROTO_MAX_PAYLOAD) return ST_TOO_LONG;
+    if (PROTO_HDR_SIZE + (size_t)h.len > len) return ST_BAD_ARGS;
+    const struct command_def *d = command_by_opcode(h.opcode);
+    if (!d) return ST_UNKNOWN_COMMAND;
+    if (h.nargs > PROTO_MAX_ARGS || (size_t)h.nargs * 4 > h.len) return ST_BAD_ARGS;
+    if (h.device != DEV_NONE && h.device != d->device) return ST_BAD_ARGS;
+    req->device = d->device;
+    req->nargs = h.nargs;
+    const uint8_t *p = frame + PROTO_HDR_SIZE;
+    for (int i = 0; i < h.nargs; i++, p += 4) {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        req->args[i] = (int32_t)ntohl(v);
+    }
+    size_t text_len = h.len - (size_t)h.nargs * 4;
+    if (text_len > 0) {
+        req->text = (const char *)p;
+        req->text_len = text_len;
+    }
+    return ST_OK;
+}
+
+// "OK:LED:BRIGHT:2\n" 또는 "ERR:BAD_ARGS\n"
+size_t proto_encode_text(const struct reply *rep, char *out, size_t cap) {
+    int n;
+    if (rep->status != ST_OK || !rep->tag) {
+        n = snprintf(out, cap, "ERR:%s\n", proto_status_name(rep->status != ST_OK ? rep->status : ST_FAILED));
+        return n < 0 || (size_t)n >= cap ? 0 : (size_t)n;
+    }
+    size_t len = strlen(rep->tag);
+    if (len + 1 >= cap) return 0;
+    memcpy(out, rep->tag, len);
+    for (int i = 0; i < rep->nvals; i++) {
+        n = snprintf(out + len, cap - len, ":%d", rep->vals[i]);
+        if (n < 0 || (size_t)n >= cap - len) return 0;
+        len += n;
+    }
+    if (len + 1 + rep->text_len >= cap) return 0;
+    out[len++] = '\n';
+    if (rep->text_len > 0) {
+        memcpy(out + len, rep->text, rep->text_len);
+        len += rep->text_len;
+    }
+    return len;
+}
+
+size_t proto_encode_binary(const struct request *req, const struct reply *rep, uint8_t *out, size_t cap) {
+    struct proto_hdr h;
+    size_t payload = (size_t)rep->nvals * 4 + (rep->status == ST_OK ? rep->text_len : 0);
+    if (payload > PROTO_MAX_PAYLOAD || PROTO_HDR_SIZE + payload > cap) return 0;
+    h.len = (uint16_t)payload;
+    h.seq = req->seq;
+    h.opcode = (uint8_t)req->opcode;
+    h.device = (uint8_t)rep->status;
+    h.nargs = (uint8_t)rep->nvals;
+    h.flags = 0;
+    write_hdr(out, &h);
+    uint8_t *p = out + PROTO_HDR_SIZE;
+    for (int i = 0; i < rep->nvals; i++, p += 4) {
+        uint32_t v = htonl((uint32_t)rep->vals[i]);
+        memcpy(p, &v, 4);
+    }
+    if (rep->status == ST_OK && rep->text_len > 0) memcpy(p, rep->text, rep->text_len);
+    return PROTO_HDR_SIZE + payload;
+}
+
+size_t proto_encode_event(int device, const struct reply *rep, uint8_t *out, size_t cap) {
+    struct request req;
+    memset(&req, 0, sizeof(req));
+    req.opcode = OP_EVENT;
+    size_t n = proto_encode_binary(&req, rep, out, cap);
+    if (n == 0) return 0;
+    out[5] = (uint8_t)device;
+    out[7] = PROTO_FLAG_EVENT;
+    return n;
+}
+
+size_t proto_encode_request(const struct request *req, uint8_t *out, size_t cap) {
+    struct proto_hdr h;
+    size_t payload = (size_t)req->nargs * 4 + req->text_len;
+    if (payload > PROTO_MAX_PAYLOAD || PROTO_HDR_SIZE + payload > cap) return 0;
+    h.len = (uint16_t)payload;
+    h.seq = req->seq;
+    h.opcode = (uint8_t)req->opcode;
+    h.device = (uint8_t)req->device;
+    h.nargs = (uint8_t)req->nargs;
+    h.flags = 0;
+    write_hdr(out, &h);
+    uint8_t *p = out + PROTO_HDR_SIZE;
+    for (int i = 0; i < req->nargs; i++, p += 4) {
+        uint32_t v = htonl((uint32_t)req->args[i]);
+        memcpy(p, &v, 4);
+    }
+    if (req->text_len > 0) memcpy(p, req->text, req->text_len);
+    return PROTO_HDR_SIZE + payload;
+}
@@ -0,0 +1,150 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 명령 프로토콜
+ * - 텍스트: "LED:BRIGHT:2\n" 처럼 ':'로 구분하고 개행으로 끝나는 줄
+ * - 바이너리: 연결 직후 PROTO_MAGIC 4바이트를 보내면 전환, 서버도 같은 4바이트로 응답
+ *   [8바이트 헤더][int32 인자 * nargs][텍스트 인자], 모든 정수는 네트워크 바이트 순서
+ * 두 형식 모두 struct request로 변환된 뒤 명령 레지스트리(command.h)로 디스패치된다.
+ */
+
+#define PROTO_MAGIC "GPB1"
+#define PROTO_MAGIC_LEN 4
+#define PROTO_HDR_SIZE 8
+#define PROTO_MAX_ARGS 6
+#define PROTO_MAX_PAYLOAD 1024
+#define PROTO_MAX_REPLY (PROTO_HDR_SIZE + PROTO_MAX_PAYLOAD)
+#define PROTO_FLAG_EVENT 0x01   // 요청 없이 서버가 보내는 알림 프레임 (seq 0, device 자리에 디바이스 ID)
+
+// 디바이스 ID (바이너리 헤더의 device 필드)
+enum proto_device {
+    DEV_NONE = 0,
+    DEV_LED,
+    DEV_BUZZER,
+    DEV_SEG7,
+    DEV_SENSOR,
+    DEV_BUTTON,
+    DEV_SYSTEM,
+    DEV_MAX
+};
+
+// 명령 opcode (바이너리 프로토콜에서 값이 고정되므로 순서를 바꾸지 말 것)
+enum proto_opcode {
+    OP_NONE = 0,
+    OP_LED_ON,
+    OP_LED_OFF,
+    OP_LED_BRIGHT,
+    OP_BUZZER_ON,
+    OP_BUZZER_OFF,
+    OP_BUZZER_MUSIC,
+    OP_SEG7_SHOW,
+    OP_SEG7_OFF,
+    OP_SENSOR_READ,
+    OP_EXTRA_MUSIC_MODE,
+    OP_ALL_OFF,
+    OP_TIMER,
+    OP_SIM_INPUT,
+    OP_SIM_PIN,
+    OP_BUZZER_QUEUE,
+    OP_BUZZER_STOP,
+    OP_BUZZER_STATUS,
+    OP_TIMER_CANCEL,
+    OP_TIMER_LIST,
+    OP_EVENT,           // 알림 프레임 전용 (요청으로는 쓰지 않음)
+    OP_SUBSCRIBE_SENSOR,
+    OP_UNSUBSCRIBE_SENSOR,
+    OP_SUBSCRIBE_BUTTON,
+    OP_UNSUBSCRIBE_BUTTON,
+    OP_STATS,
+    OP_LOG_LEVEL,
+    OP_LOG_SAMPLE,
+    OP_RELOAD,
+    OP_PLUGIN_LIST,
+    OP_LED_LEVEL,
+    OP_LED_FADE,
+    OP_SEQ_DEF,
+    OP_SEQ_RUN,
+    OP_SEQ_STOP,
+    OP_SEQ_DEL,
+    OP_SEQ_LIST,
+    OP_INPUT_DEBOUNCE,
+    OP_MAX
+};
+
+// 응답 상태 코드 (바이너리 응답 헤더의 status 필드)
+enum proto_status {
+    ST_OK = 0,
+    ST_UNKNOWN_COMMAND,
+    ST_BAD_ARGS,
+    ST_TOO_LONG,
+    ST_BUSY,
+    ST_FAILED,
+    ST_MAX
+};
+
+// 바이너리 프레임 헤더 (요청/응답 공통)
+struct proto_hdr {
+    uint16_t len;     // 헤더 뒤 페이로드 길이
+    uint16_t seq;     // 요청 순번, 응답에 그대로 돌려줌
+    uint8_t opcode;
+    uint8_t device;   // 요청: 디바이스 ID, 응답: 상태 코드
+    uint8_t nargs;    // 페이로드 앞쪽 int32 개수
+    uint8_t flags;
+};
+
+// 디코딩된 요청 (텍스트/바이너리 공통)
+struct request {
+    int opcode;
+    int device;
+    uint16_t seq;
+    int nargs;
+    int32_t args[PROTO_MAX_ARGS];
+    const char *text;   // 숫자가 아닌 나머지 인자 (없으면 NULL)
+    size_t text_len;
+    void *conn;         // 요청을 보낸 연결 (내부 실행이면 NULL)
+};
+
+// 핸들러가 채우는 응답
+struct reply {
+    int status;
+    const char *tag;    // 텍스트 응답 머리, 예: "OK:LED:BRIGHT"
+    int nvals;
+    int32_t vals[PROTO_MAX_ARGS];
+    const char *text;   // 추가 본문 (여러 줄 응답 등, 각 줄은 개행으로 끝남), 없으면 NULL
+    size_t text_len;    // 텍스트 응답은 첫 줄 뒤에, 바이너리 응답은 int32 값 뒤에 붙는다
+};
+
+const char *proto_status_name(int status);
+
+int proto_parse_text(const char *line, struct request *req);                         // 0 또는 상태 코드
+int proto_decode_binary(const uint8_t *frame, size_t len, struct request *req);      // 0 또는 상태 코드
+size_t proto_frame_len(const uint8_t *hdr);                                           // 헤더로부터 프레임 전체 길이
+
+size_t proto_encode_text(const struct reply *rep, char *out, size_t cap);
+size_t proto_encode_binary(const struct request *req, const struct reply *rep, uint8_t *out, size_t cap);
+size_t proto_encode_event(int device, const struct reply *rep, uint8_t *out, size_t cap); // 바이너리 알림 프레임
+size_t proto_encode_request(const struct request *req, uint8_t *out, size_t cap);    // 바이너리 클라이언트용
+
+static inline void reply_ok(struct reply *rep, const char *tag) {
+    rep->status = ST_OK;
+    rep->tag = tag;
+}
+
+static inline void reply_value(struct reply *rep, int32_t v) {
+    if (rep->nvals < PROTO_MAX_ARGS) rep->vals[rep->nvals++] = v;
+}
+
+static inline void reply_text(struct reply *rep, const char *text, size_t len) {
+    rep->text = text;
+    rep->text_len = len;
+}
+
+static inline void reply_error(struct reply *rep, int status) {
+    rep->status = status;
+}
+
+#endif
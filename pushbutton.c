@@ -1,9 +1,8 @@
 #include "pushbutton.h"
-#include <wiringPi.h>
+#include "gpio_hal.h"
 #define BUTTON 21
 
 int pushbutton_read(void) {
-    wiringPiSetupGpio();
-    pinMode(BUTTON, INPUT);
-    return digitalRead(BUTTON);
+    gpio_pin_mode(BUTTON, GPIO_INPUT); // 모드가 바뀌었을 때만 실제 설정
+    return gpio_read(BUTTON);
 } 
\ No newline at end of file
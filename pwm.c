@@ -0,0 +1,283 @@
+/**
+ * pwm.c - 하드웨어/소프트웨어 PWM 엔진
+ *
+ * 스케줄러 스레드는 timerfd(절대 시각) 하나를 다음 엣지 시각에 맞춰 두고 기다린다.
+ * 주기 시작에 토글하는 핀을 모두 켜고, 엣지 표의 시각마다 듀티가 끝난 핀들을 마스크 한 번으로 끈다.
+ * 명령 스레드는 레벨만 바꾸고 표를 다시 만들라고 표시한다. 바뀐 레벨은 다음 주기부터 적용된다.
+ * 엔진 상태는 mutex 하나로 보호하고, 스레드는 엣지를 쓰는 동안만 잡는다.
+ * pwm_release가 돌아온 뒤에는 그 핀에 쓰지 않도록 엣지를 쓸 때마다 관리 중인 핀으로 다시 거른다.
+ */
+#define _GNU_SOURCE
+#include "pwm.h"
+#include "gpio_hal.h"
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/prctl.h>
+#include <sys/timerfd.h>
+
+#define PWM_PINS 32                                 // 소프트웨어 PWM은 마스크 쓰기가 되는 GPIO 0~31
+#define PWM_PERIOD_NS (1000000000ULL / PWM_SW_HZ)
+
+struct pwm_pin {
+    int active;             // 엔진이 쓰는 핀
+    int hw;                 // 하드웨어 PWM 채널
+    int level;              // 지금 출력 중인 레벨
+    int fading;
+    int from, to;
+    uint64_t fade_start_ns;
+    uint64_t fade_ns;
+};
+
+// 주기 시작 뒤 offset_ns에 clear 핀들을 끈다
+struct pwm_edge {
+    uint64_t offset_ns;
+    uint32_t clear;
+};
+
+static struct pwm_pin pins[PWM_PINS];
+static pthread_mutex_t pwm_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int tfd = -1;
+static int started = 0;
+static int idle = 1;                    // timerfd가 꺼져 있어 스레드가 깨워지기를 기다리는 중
+static int dirty = 0;                   // 엣지 표를 다시 만들어야 함
+static int fades = 0;                   // 진행 중인 페이드 수
+
+static uint32_t sw_mask = 0;            // 엔진이 쓰는 소프트웨어 PWM 핀
+static uint32_t toggle_mask = 0;        // 그중 주기마다 토글하는 핀 (0 < 레벨 < 255)
+static struct pwm_edge edges[PWM_PINS];
+static int nedges = 0, next_edge = 0;
+static uint64_t period_start = 0;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void arm(uint64_t at_ns) {
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = at_ns / 1000000000ULL;
+    its.it_value.tv_nsec = at_ns % 1000000000ULL;
+    timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+// pwm_mutex를 잡은 상태에서 호출. 레벨대로 엣지 표를 만들고 0/255 핀은 바로 쓴다
+static void build_table(void) {
+    uint32_t set = 0, clear = 0;
+    toggle_mask = 0;
+    nedges = 0;
+    for (int pin = 0; pin < PWM_PINS; pin++) {
+        if (!(sw_mask & (1u << pin))) continue;
+        int level = pins[pin].level;
+        if (level <= 0) {
+            clear |= 1u << pin;
+            continue;
+        }
+        if (level >= PWM_LEVEL_MAX) {
+            set |= 1u << pin;
+            continue;
+        }
+        toggle_mask |= 1u << pin;
+        // 시각 순으로 끼워 넣고 같은 시각은 한 엣지로 합친다
+        uint64_t off = PWM_PERIOD_NS * level / PWM_LEVEL_MAX;
+        int i = nedges;
+        while (i > 0 && edges[i - 1].offset_ns > off) i--;
+        if (i > 0 && edges[i - 1].offset_ns == off) {
+            edges[i - 1].clear |= 1u << pin;
+            continue;
+        }
+        memmove(&edges[i + 1], &edges[i], (nedges - i) * sizeof(edges[0]));
+        edges[i].offset_ns = off;
+        edges[i].clear = 1u << pin;
+        nedges++;
+    }
+    if (set || clear) gpio_write_mask(set, clear);
+    next_edge = nedges;     // 다음 깨어날 때 새 주기부터
+    dirty = 0;
+}
+
+// pwm_mutex를 잡은 상태에서 호출. 페이드 중인 핀의 레벨을 다시 계산한다
+static void step_fades(uint64_t now) {
+    for (int pin = 0; pin < PWM_PINS && fades > 0; pin++) {
+        struct pwm_pin *p = &pins[pin];
+        if (!p->fading) continue;
+        uint64_t t = now - p->fade_start_ns;
+        int level = p->to;
+        if (t < p->fade_ns) level = p->from + (int)((int64_t)(p->to - p->from) * (int64_t)t / (int64_t)p->fade_ns);
+        else {
+            p->fading = 0;
+            fades--;
+        }
+        if (level == p->level) continue;
+        p->level = level;
+        if (p->hw) gpio_pwm_write(pin, level);
+        else dirty = 1;
+    }
+}
+
+static void *pwm_thread(void *arg) {
+    (void)arg;
+    prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);     // 엣지 시각이 기본 50us만큼 늦춰지지 않도록
+    pthread_mutex_lock(&pwm_mutex);
+    for (;;) {
+        uint64_t now = now_ns();
+        if (next_edge < nedges) {
+            // 주기 중간: 듀티가 끝난 핀을 끈다
+            uint32_t clear = edges[next_edge++].clear & toggle_mask;
+            if (clear) gpio_write_mask(0, clear);
+        } else {
+            // 새 주기: 페이드 진행, 바뀐 레벨 반영, 토글 핀 켜기
+            step_fades(now);
+            if (dirty) build_table();
+            period_start = now - period_start < 2 * PWM_PERIOD_NS ? period_start + PWM_PERIOD_NS : now;
+            if (period_start > now) period_start = now;
+            next_edge = 0;
+            if (toggle_mask) gpio_write_mask(toggle_mask, 0);
+            else nedges = 0;
+        }
+        if (next_edge < nedges) {
+            arm(period_start + edges[next_edge].offset_ns);
+            idle = 0;
+        } else if (toggle_mask || fades) {
+            arm(period_start + PWM_PERIOD_NS);
+            idle = 0;
+        } else {
+            idle = 1;   // 할 일이 없으면 timerfd를 끈 채로 read에서 기다린다
+        }
+        pthread_mutex_unlock(&pwm_mutex);
+        uint64_t expirations;
+        ssize_t n = read(tfd, &expirations, sizeof(expirations));
+        (void)n;
+        pthread_mutex_lock(&pwm_mutex);
+    }
+    return NULL;
+}
+
+// pwm_mutex를 잡은 상태에서 호출. 필요하면 스레드를 띄우고, 쉬고 있으면 바로 깨운다
+static int kick(void) {
+    if (!started) {
+        tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+        if (tfd < 0) return -1;
+        pthread_t t;
+        if (pthread_create(&t, NULL, pwm_thread, NULL) != 0) {
+            close(tfd);
+            tfd = -1;
+            return -1;
+        }
+        pthread_detach(t);
+        started = 1;
+        return 0;   // 첫 루프가 바로 새 주기를 시작한다
+    }
+    if (idle && (dirty || fades)) {
+        idle = 0;
+        arm(now_ns());
+    }
+    return 0;
+}
+
+static int valid_pin(int pin) {
+    return pin >= 0 && pin < PWM_PINS;
+}
+
+// pwm_mutex를 잡은 상태에서 호출. 핀을 엔진에 넣고 출력 모드를 맞춘다
+static void claim(int pin) {
+    struct pwm_pin *p = &pins[pin];
+    if (p->active) return;
+    p->active = 1;
+    p->hw = gpio_pwm_hw(pin);
+    p->level = -1;
+    gpio_pin_mode(pin, p->hw ? GPIO_PWM_OUTPUT : GPIO_OUTPUT);
+    if (!p->hw) sw_mask |= 1u << pin;
+}
+
+// pwm_mutex를 잡은 상태에서 호출
+static void apply_level(int pin, int level) {
+    struct pwm_pin *p = &pins[pin];
+    if (level == p->level) return;
+    p->level = level;
+    if (p->hw) gpio_pwm_write(pin, level);
+    else if (level <= 0 || level >= PWM_LEVEL_MAX) {
+        // 꺼짐/완전 켜짐은 다음 주기를 기다리지 않고 바로 쓴다
+        gpio_write(pin, level > 0);
+        toggle_mask &= ~(1u << pin);
+        dirty = 1;
+    } else {
+        dirty = 1;
+    }
+}
+
+static void cancel_fade(struct pwm_pin *p) {
+    if (!p->fading) return;
+    p->fading = 0;
+    fades--;
+}
+
+int pwm_set(int pin, int level) {
+    if (!valid_pin(pin) || level < 0 || level > PWM_LEVEL_MAX) return -1;
+    pthread_mutex_lock(&pwm_mutex);
+    claim(pin);
+    cancel_fade(&pins[pin]);
+    apply_level(pin, level);
+    int r = kick();
+    pthread_mutex_unlock(&pwm_mutex);
+    return r;
+}
+
+int pwm_fade(int pin, int from, int to, unsigned ms) {
+    if (!valid_pin(pin) || from < 0 || from > PWM_LEVEL_MAX || to < 0 || to > PWM_LEVEL_MAX || ms > PWM_FADE_MAX_MS)
+        return -1;
+    if (ms == 0) return pwm_set(pin, to);
+    pthread_mutex_lock(&pwm_mutex);
+    claim(pin);
+    struct pwm_pin *p = &pins[pin];
+    apply_level(pin, from);
+    if (!p->fading) fades++;
+    p->fading = 1;
+    p->from = from;
+    p->to = to;
+    p->fade_start_ns = now_ns();
+    p->fade_ns = (uint64_t)ms * 1000000ULL;
+    int r = kick();
+    pthread_mutex_unlock(&pwm_mutex);
+    return r;
+}
+
+void pwm_release(int pin) {
+    if (!valid_pin(pin)) return;
+    pthread_mutex_lock(&pwm_mutex);
+    struct pwm_pin *p = &pins[pin];
+    if (p->active) {
+        cancel_fade(p);
+        if (p->hw) gpio_pwm_write(pin, 0);
+        p->active = 0;
+        p->level = -1;
+        sw_mask &= ~(1u << pin);
+        toggle_mask &= ~(1u << pin);
+        dirty = 1;
+    }
+    pthread_mutex_unlock(&pwm_mutex);
+}
+
+int pwm_level(int pin) {
+    if (!valid_pin(pin)) return -1;
+    pthread_mutex_lock(&pwm_mutex);
+    int level = pins[pin].active ? pins[pin].level : -1;
+    pthread_mutex_unlock(&pwm_mutex);
+    return level;
+}
+
+int pwm_fading(int pin) {
+    if (!valid_pin(pin)) return 0;
+    pthread_mutex_lock(&pwm_mutex);
+    int fading = pins[pin].fading;
+    pthread_mutex_unlock(&pwm_mutex);
+    return fading;
+}
+
+int pwm_is_hw(int pin) {
+    return valid_pin(pin) && gpio_pwm_hw(pin);
+}
@@ -0,0 +1,26 @@
+#ifndef PWM_H
+#define PWM_H
+
+/*
+ * PWM 엔진 (밝기 0~255, 서버 쪽 페이드)
+ * - 백엔드가 하드웨어 PWM을 지원하는 핀(gpio_pwm_hw)은 PWM 블록에 듀티만 쓴다
+ * - 나머지 핀(GPIO 0~31)은 스케줄러 스레드 하나가 timerfd 하나로 모두 구동한다.
+ *   레벨이 바뀔 때 한 주기 동안의 엣지 표(주기 시작에 켤 핀 마스크, 시각 순으로 끌 핀 마스크)를
+ *   미리 만들어 두고, 주기마다 표대로 마스크 쓰기만 한다 (DMA 방식과 같은 발상)
+ * - 0과 255는 토글하지 않고 한 번만 쓴다. 토글할 핀도 페이드도 없으면 스레드는 멈춰 있다
+ * - 페이드는 주기 시작마다 레벨을 다시 계산한다 (PWM_SW_HZ 간격)
+ * - 모든 함수는 아무 스레드에서나 호출할 수 있다
+ */
+
+#define PWM_LEVEL_MAX 255
+#define PWM_SW_HZ 200               // 소프트웨어 PWM 주기 (5ms, 한 단계 약 20us)
+#define PWM_FADE_MAX_MS 600000
+
+int pwm_set(int pin, int level);                        // 진행 중인 페이드는 취소, 0 또는 -1
+int pwm_fade(int pin, int from, int to, unsigned ms);   // from에서 to까지 ms 동안, 0 또는 -1
+void pwm_release(int pin);          // 엔진에서 뺀다 (반환 뒤에는 엔진이 이 핀에 쓰지 않음, 디지털 출력으로 돌아갈 때)
+int pwm_level(int pin);             // 현재 레벨, 엔진이 쓰지 않는 핀이면 -1
+int pwm_fading(int pin);            // 페이드 중이면 1
+int pwm_is_hw(int pin);
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ * reload_test.c - 플러그인 핫 스왑이 출력 상태를 건드리지 않는지 확인 (시뮬레이션 백엔드)
+ *
+ * 현재 디렉터리의 .so로 시작해 출력 장치를 켜 두고 RELOAD와 같은 경로(plugin_reload)로
+ * 모듈을 바꿔 끼운 뒤 핀 레벨과 상태 공유 메모리 값이 그대로인지 본다.
+ * 교체 뒤에도 새 모듈의 명령(끄기)이 동작하는지 함께 확인한다.
+ *
+ * 사용법: make test (플러그인 .so를 먼저 빌드함)
+ */
+#include <stdio.h>
+#include <string.h>
+#include "protocol.h"
+#include "command.h"
+#include "gpio_hal.h"
+#include "device_state.h"
+#include "plugin.h"
+#include "event_loop.h"
+
+struct reload_case {
+    const char *name;       // 모듈 이름
+    const char *on;         // 켜는 명령
+    const char *off;        // 끄는 명령
+    int pin;                // 확인할 출력 핀
+};
+
+static const struct reload_case cases[] = {
+    {"buzzer", "BUZZER:ON", "BUZZER:OFF", 18},
+    {"led", "LED:ON", "LED:OFF", 17},
+};
+
+static int failures = 0;
+
+static void check(int ok, const char *name, const char *what) {
+    printf("%-8s %-36s %s\n", name, what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static int run_cmd(const char *text) {
+    struct request req;
+    struct reply rep;
+    if (proto_parse_text(text, &req) != ST_OK) return -1;
+    memset(&rep, 0, sizeof(rep));
+    command_dispatch(&req, &rep);
+    return rep.status == ST_OK ? 0 : -1;
+}
+
+// 명령을 돌리는 스레드가 이 스레드뿐이므로 쓰기 구간을 빌려 그대로 읽는다
+static int state_on(const char *name) {
+    struct device_state *st = device_state_begin();
+    int on = strcmp(name, "buzzer") == 0 ? st->buzzer_on : st->led_on;
+    device_state_end();
+    return on;
+}
+
+static void test_reload(const struct reload_case *c) {
+    int failed = 0;
+    check(run_cmd(c->on) == 0 && gpio_read(c->pin) == 1, c->name, c->on);
+    check(plugin_reload(c->name, &failed) == 1 && failed == 0, c->name, "RELOAD (새 .so로 교체)");
+    check(gpio_read(c->pin) == 1, c->name, "교체 뒤 핀 HIGH 유지");
+    check(state_on(c->name) == 1, c->name, "교체 뒤 상태 유지");
+    check(run_cmd(c->off) == 0 && gpio_read(c->pin) == 0, c->name, "새 모듈로 끄기");
+}
+
+int main(void) {
+    if (gpio_init("sim") < 0 || gpio_setup() < 0 || event_loop_init() < 0 ||
+        plugin_init(".") < 0 || plugin_register_commands() < 0) {
+        fprintf(stderr, "초기화 실패\n");
+        return 1;
+    }
+    for (size_t i = 0; i < plugin_count(); i++) {
+        struct plugin_info info;
+        if (plugin_get_info(i, &info) == 0 && info.builtin) {
+            fprintf(stderr, "%s.so가 없음 (make test로 실행할 것)\n", info.name);
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) test_reload(&cases[i]);
+    plugin_shutdown();
+    printf("%s (실패 %d)\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * ringbuf.c - 연결별 스트림 재조립/응답 대기용 링 버퍼
+ *
+ * readv/writev로 커널과 직접 주고받아 추가 복사를 줄인다.
+ */
+#include "ringbuf.h"
+#include <stdlib.h>
+#include <string.h>
+
+int ringbuf_init(struct ringbuf *rb, size_t cap) {
+    // cap은 2의 거듭제곱이어야 마스킹이 성립
+    if (cap == 0 || (cap & (cap - 1)) != 0) return -1;
+    rb->data = malloc(cap);
+    if (!rb->data) return -1;
+    rb->cap = cap;
+    rb->head = rb->tail = 0;
+    return 0;
+}
+
+void ringbuf_free(struct ringbuf *rb) {
+    free(rb->data);
+    rb->data = NULL;
+    rb->cap = rb->head = rb->tail = 0;
+}
+
+size_t ringbuf_used(const struct ringbuf *rb) {
+    return rb->tail - rb->head;
+}
+
+size_t ringbuf_space(const struct ringbuf *rb) {
+    return rb->cap - (rb->tail - rb->head);
+}
+
+size_t ringbuf_write(struct ringbuf *rb, const void *src, size_t len) {
+    if (len > ringbuf_space(rb)) return 0;
+    size_t off = rb->tail & (rb->cap - 1);
+    size_t first = rb->cap - off < len ? rb->cap - off : len;
+    memcpy(rb->data + off, src, first);
+    memcpy(rb->data, (const char *)src + first, len - first);
+    rb->tail += len;
+    return len;
+}
+
+size_t ringbuf_peek(const struct ringbuf *rb, void *dst, size_t len) {
+    size_t used = ringbuf_used(rb);
+    if (len > used) len = used;
+    size_t off = rb->head & (rb->cap - 1);
+    size_t first = rb->cap - off < len ? rb->cap - off : len;
+    memcpy(dst, rb->data + off, first);
+    memcpy((char *)dst + first, rb->data, len - first);
+    return len;
+}
+
+void ringbuf_consume(struct ringbuf *rb, size_t len) {
+    size_t used = ringbuf_used(rb);
+    rb->head += len > used ? used : len;
+}
+
+ssize_t ringbuf_find(const struct ringbuf *rb, char ch) {
+    size_t used = ringbuf_used(rb);
+    size_t off = rb->head & (rb->cap - 1);
+    size_t first = rb->cap - off < used ? rb->cap - off : used;
+    const char *p = memchr(rb->data + off, ch, first);
+    if (p) return p - (rb->data + off);
+    p = memchr(rb->data, ch, used - first);
+    if (p) return first + (p - rb->data);
+    return -1;
+}
+
+int ringbuf_space_iov(struct ringbuf *rb, struct iovec iov[2]) {
+    size_t space = ringbuf_space(rb);
+    if (space == 0) return 0;
+    size_t off = rb->tail & (rb->cap - 1);
+    size_t first = rb->cap - off < space ? rb->cap - off : space;
+    iov[0].iov_base = rb->data + off;
+    iov[0].iov_len = first;
+    if (first == space) return 1;
+    iov[1].iov_base = rb->data;
+    iov[1].iov_len = space - first;
+    return 2;
+}
+
+void ringbuf_commit(struct ringbuf *rb, size_t len) {
+    rb->tail += len;
+}
+
+int ringbuf_data_iov(const struct ringbuf *rb, struct iovec iov[2]) {
+    size_t used = ringbuf_used(rb);
+    if (used == 0) return 0;
+    size_t off = rb->head & (rb->cap - 1);
+    size_t first = rb->cap - off < used ? rb->cap - off : used;
+    iov[0].iov_base = rb->data + off;
+    iov[0].iov_len = first;
+    if (first == used) return 1;
+    iov[1].iov_base = rb->data;
+    iov[1].iov_len = used - first;
+    return 2;
+}
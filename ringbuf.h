@@ -0,0 +1,28 @@
+#ifndef RINGBUF_H
+#define RINGBUF_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+// 연결별 송수신 링 버퍼 (용량은 2의 거듭제곱)
+struct ringbuf {
+    char *data;
+    size_t cap;
+    size_t head;    // 읽기 위치 (누적값, cap으로 마스킹)
+    size_t tail;    // 쓰기 위치 (누적값)
+};
+
+int ringbuf_init(struct ringbuf *rb, size_t cap);
+void ringbuf_free(struct ringbuf *rb);
+size_t ringbuf_used(const struct ringbuf *rb);
+size_t ringbuf_space(const struct ringbuf *rb);
+size_t ringbuf_write(struct ringbuf *rb, const void *src, size_t len); // 공간이 부족하면 0 반환(부분 쓰기 없음)
+size_t ringbuf_peek(const struct ringbuf *rb, void *dst, size_t len);  // 소비하지 않고 복사
+void ringbuf_consume(struct ringbuf *rb, size_t len);
+ssize_t ringbuf_find(const struct ringbuf *rb, char ch);               // ch까지의 오프셋, 없으면 -1
+int ringbuf_space_iov(struct ringbuf *rb, struct iovec iov[2]);        // readv용 빈 공간 구간
+void ringbuf_commit(struct ringbuf *rb, size_t len);                   // readv 후 쓰기 위치 이동
+int ringbuf_data_iov(const struct ringbuf *rb, struct iovec iov[2]);   // writev용 데이터 구간
+
+#endif
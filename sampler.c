@@ -0,0 +1,55 @@
+/**
+ * sampler.c - 구독 중인 입력 디바이스를 읽는 공유 샘플러
+ *
+ * 클라이언트마다 폴링하는 대신 데몬이 가장 높은 요청 주기로 한 번만 읽고
+ * 그 결과를 구독자별 주기/조건에 맞춰 나눠 준다 (이벤트 루프 스레드에서 실행).
+ */
+#include "sampler.h"
+#include "event_loop.h"
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+static int tfd = -1;
+static int cur_hz = 0;
+static sample_fn on_sample = NULL;
+
+static void on_tick(int fd, uint32_t events, void *arg) {
+    (void)events; (void)arg;
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) <= 0) return;
+    // 루프가 밀려 여러 주기가 지나도 한 번만 읽는다 (밀린 샘플을 만들어 내지 않음)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    on_sample((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+int sampler_init(sample_fn fn) {
+    on_sample = fn;
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd < 0) return -1;
+    return event_loop_add(tfd, EPOLLIN, on_tick, NULL);
+}
+
+int sampler_set_rate(int hz) {
+    if (hz < 0) hz = 0;
+    if (hz > SAMPLER_MAX_HZ) hz = SAMPLER_MAX_HZ;
+    if (hz == cur_hz) return 0;
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    if (hz > 0) {
+        long period = 1000000000L / hz;
+        its.it_interval.tv_sec = period / 1000000000L;
+        its.it_interval.tv_nsec = period % 1000000000L;
+        its.it_value = its.it_interval;
+    }
+    if (timerfd_settime(tfd, 0, &its, NULL) < 0) return -1;
+    cur_hz = hz;
+    return 0;
+}
+
+int sampler_rate(void) {
+    return cur_hz;
+}
@@ -0,0 +1,15 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdint.h>
+
+// 공유 샘플러: 이벤트 루프의 timerfd 하나로 주기적으로 콜백 호출 (구독자가 없으면 멈춤)
+#define SAMPLER_MAX_HZ 1000
+
+typedef void (*sample_fn)(uint64_t ts_ns);
+
+int sampler_init(sample_fn fn);   // timerfd를 이벤트 루프에 등록
+int sampler_set_rate(int hz);     // 0이면 정지, 바뀔 때만 timerfd를 다시 설정
+int sampler_rate(void);
+
+#endif
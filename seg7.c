@@ -1,5 +1,9 @@
 #include "seg7.h"
-#include <wiringPi.h>
+#include "command.h"
+#include "proto_verbs.h"
+#include "gpio_hal.h"
+#include "device_state.h"
+#include "gpio_plugin.h"
 #include <dlfcn.h>
 #include <unistd.h>
 #define BCD_A 5   // a -> gp5
@@ -7,7 +11,16 @@
 #define BCD_C 12  // c -> gp12
 #define BCD_D 13  // d -> gp13
 
+#define BCD_MASK ((1u << BCD_A) | (1u << BCD_B) | (1u << BCD_C) | (1u << BCD_D))
+
 static int bcd_pins[4] = {BCD_A, BCD_B, BCD_C, BCD_D};
+static uint32_t bcd_set_mask[10]; // 숫자별로 HIGH가 되는 핀 마스크 (나머지 BCD 핀은 LOW)
+
+static void record_digit(int digit) {
+    struct device_state *st = device_state_begin();
+    st->seg7_digit = digit;
+    device_state_end();
+}
 static int bcd_table[10][4] = {
     {0,0,0,0}, // 0
     {1,0,0,0}, // 1
@@ -21,23 +34,49 @@ static int bcd_table[10][4] = {
     {1,0,0,1}  // 9
 };
 
+static void build_masks(void) {
+    for (int n = 0; n < 10; n++) {
+        bcd_set_mask[n] = 0;
+        for (int i = 0; i < 4; i++)
+            if (bcd_table[n][i]) bcd_set_mask[n] |= 1u << bcd_pins[i];
+    }
+}
+
+// 핀 설정은 여기서 한 번만, 이후 표시는 레지스터 쓰기만 한다
+int seg7_init(void) {
+    build_masks();
+    for (int i = 0; i < 4; i++) {
+        gpio_pin_mode(bcd_pins[i], GPIO_OUTPUT);
+        gpio_write(bcd_pins[i], 0);
+    }
+    return 0;
+}
+
+void seg7_teardown(void) {
+    seg7_off();
+}
+
 int seg7_display(int num) {
-    wiringPiSetupGpio();
-    for (int i = 0; i < 4; i++) pinMode(bcd_pins[i], OUTPUT);
     if (num < 0 || num > 9) return -1;
-    for (int i = 0; i < 4; i++) digitalWrite(bcd_pins[i], bcd_table[num][i]);
+    for (int i = 0; i < 4; i++) gpio_pin_mode(bcd_pins[i], GPIO_OUTPUT);
+    // 4비트를 핀별로 쓰면 7447에 중간 숫자가 잠깐 보이므로 마스크로 한 번에 바꾼다
+    gpio_write_mask(bcd_set_mask[num], BCD_MASK & ~bcd_set_mask[num]);
+    record_digit(num);
     return 0;
 }
 
 int seg7_off(void) {
-    wiringPiSetupGpio();
-    for (int i = 0; i < 4; i++) {
-        pinMode(bcd_pins[i], OUTPUT);
-        digitalWrite(bcd_pins[i], 0);
-    }
+    gpio_write_mask(0, seg7_off_mask());
     return 0;
 }
 
+// 호출한 쪽이 곧바로 마스크로 LOW를 쓰므로 상태는 여기서 OFF로 기록
+uint32_t seg7_off_mask(void) {
+    for (int i = 0; i < 4; i++) gpio_pin_mode(bcd_pins[i], GPIO_OUTPUT);
+    record_digit(-1);
+    return BCD_MASK;
+}
+
 // 7-Segment 숫자 표시 함수: num부터 0까지 1초 간격으로 표시, 0에서 buzzer 동작
 void seg7_display_full(int num) {
     int seg_pins[7] = {BCD_A, BCD_B, BCD_C, BCD_D};
@@ -46,11 +85,10 @@ void seg7_display_full(int num) {
         {0,1,1,0,0,1,1}, {1,0,1,1,0,1,1}, {1,0,1,1,1,1,1}, {1,1,1,0,0,0,0},
         {1,1,1,1,1,1,1}, {1,1,1,1,0,1,1}
     };
-    wiringPiSetupGpio(); // GPIO 모드 설정
     for (int i = num; i >= 0; i--) {
         for (int j = 0; j < 7; j++) {
-            pinMode(seg_pins[j], OUTPUT); // 출력 모드
-            digitalWrite(seg_pins[j], digits[i][j]); // 세그먼트 출력
+            gpio_pin_mode(seg_pins[j], GPIO_OUTPUT); // 출력 모드
+            gpio_write(seg_pins[j], digits[i][j]); // 세그먼트 출력
         }
         sleep(1); // 1초 대기
     }
@@ -61,4 +99,49 @@ void seg7_display_full(int num) {
         if (buzzer_onoff) buzzer_onoff(27);
         dlclose(buzzer_lib);
     }
-} 
\ No newline at end of file
+} 
+
+// ---- 명령 핸들러 ----
+static void cmd_seg7_show(const struct request *req, struct reply *rep) {
+    if (req->nargs < 1 || seg7_display(req->args[0]) < 0) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    reply_ok(rep, "OK:SEG7");
+    reply_value(rep, req->args[0]);
+}
+
+static void cmd_seg7_off(const struct request *req, struct reply *rep) {
+    (void)req;
+    seg7_off();
+    reply_ok(rep, "OK:SEG7:OFF");
+}
+
+static const struct command_def seg7_commands[] = {
+    {VERB_SEG7_SHOW, cmd_seg7_show},
+    {VERB_SEG7_OFF,  cmd_seg7_off},
+};
+
+// ---- 플러그인 기술자 ----
+// 핫 스왑 때는 표시 중인 숫자를 그대로 두고 마스크 표만 새로 만든다
+static int seg7_plugin_init(int flags) {
+    if (!(flags & GPIO_PLUGIN_RELOAD)) return seg7_init();
+    build_masks();
+    return 0;
+}
+
+static void seg7_plugin_teardown(int flags) {
+    if (!(flags & GPIO_PLUGIN_RELOAD)) seg7_teardown();
+}
+
+GPIO_PLUGIN_EXPORT(seg7) = {
+    .abi = GPIO_PLUGIN_ABI,
+    .name = "seg7",
+    .version = 1,
+    .device = DEV_SEG7,
+    .init = seg7_plugin_init,
+    .teardown = seg7_plugin_teardown,
+    .off_mask = seg7_off_mask,
+    .commands = seg7_commands,
+    .ncommands = sizeof(seg7_commands) / sizeof(seg7_commands[0]),
+};
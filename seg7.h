@@ -1,7 +1,15 @@
 #ifndef SEG7_H
 #define SEG7_H
 
+#include <stdint.h>
+
+int seg7_init(void);       // 핀 설정 (데몬 시작 시 한 번)
+void seg7_teardown(void);  // 표시 끄기 (데몬 종료 시)
 int seg7_display(int num); // 0~9 (7447 BCD 입력)
 int seg7_off(void);
+uint32_t seg7_off_mask(void); // 출력 모드를 맞추고 OFF 시 LOW로 내릴 핀 마스크 반환
+
+struct gpio_plugin;
+extern const struct gpio_plugin seg7_plugin; // 내장 플러그인 기술자 (seg7.so와 같은 소스)
 
 #endif 
\ No newline at end of file
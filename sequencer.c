@@ -0,0 +1,510 @@
+/**
+ * sequencer.c - 서버 쪽 명령 시퀀서
+ *
+ * 정의는 단계 배열로 컴파일한다. 흐름 제어 단계는 점프할 인덱스를 미리 풀어 둔다.
+ *   LOOP: END 다음 / END(LOOP): 짝 LOOP / IF: 거짓일 때 ELSE 다음 또는 END 다음 / ELSE: END 다음 / BREAK: 짝 LOOP
+ * IF의 END는 단계를 만들지 않는다. 실행 중 상태는 pc, 다음 예정 시각, LOOP 남은 횟수 스택뿐이다.
+ * 디바이스 명령 단계는 실행기에 넘기고 완료가 올 때까지 pc를 멈춘다 (시퀀스마다 실행기에 한 단계만).
+ * 무한 LOOP는 한 바퀴에 반드시 거치는 WAIT의 합이 0보다 커야 한다 (IF 안의 WAIT, BREAK가 있는 안쪽 LOOP는
+ * 건너뛸 수 있으므로 세지 않음). 그래도 한 번 깨어날 때 SEQ_BURST 단계를 넘기면 다음 루프 회차로 미룬다.
+ */
+#include "sequencer.h"
+#include "event_loop.h"
+#include "dev_exec.h"
+#include "command.h"
+#include "proto_verbs.h"
+#include "metrics.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#define SEQ_BURST 256               // 한 번 깨어날 때 시퀀스 하나가 실행할 최대 단계 수
+#define SEQ_LIST_BYTES 768          // SEQ:LIST 응답 본문 최대 크기
+#define SEQ_RETRY_NS 1000000ULL     // 실행기 큐가 차 있을 때 같은 단계를 다시 넣어 볼 간격
+
+enum seq_op {
+    SEQ_OP_CMD = 0,
+    SEQ_OP_WAIT,
+    SEQ_OP_LOOP,
+    SEQ_OP_END_LOOP,
+    SEQ_OP_IF,
+    SEQ_OP_ELSE,
+    SEQ_OP_BREAK
+};
+
+struct seq_step {
+    int op;
+    int cond;               // IF: DEV_BUTTON 또는 DEV_SENSOR
+    int32_t value;          // LOOP: 반복 횟수 (0은 무한), IF: 비교 값
+    int jump;
+    uint64_t wait_ns;
+    struct request req;     // CMD: 미리 파싱한 요청 (text는 def 안을 가리킨다)
+};
+
+struct sequence {
+    char *def;              // 정의 사본 (';'를 '\0'으로 바꿔 단계별 문자열로 씀), NULL이면 비어 있음
+    struct seq_step *steps;
+    int nsteps;
+    int running;
+    int pc;
+    uint64_t deadline;      // 다음 단계를 실행할 시각 (CLOCK_MONOTONIC ns)
+    int depth;
+    int32_t loops[SEQ_DEPTH];   // LOOP별 남은 횟수 (0은 무한)
+    uint32_t runs;
+    uint64_t max_late_ns;   // 예정 시각보다 늦게 깨어난 최대 시간 (이번 실행)
+    int inflight;           // 실행기에 넘긴 단계가 아직 끝나지 않음 (DEL해도 유지)
+    uint32_t gen;           // SEQ:RUN마다 늘어난다. 이전 실행의 완료를 가려낸다 (DEL해도 유지)
+};
+
+static struct sequence seqs[SEQ_MAX + 1];
+static int tfd = -1;
+static seq_input_fn input_fn = NULL;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// 실행 중인 시퀀스 중 가장 이른 예정 시각에 맞춘다 (없으면 끈다)
+static void rearm(void) {
+    uint64_t at = 0;
+    for (int id = 1; id <= SEQ_MAX; id++) {
+        if (seqs[id].running && !seqs[id].inflight && (at == 0 || seqs[id].deadline < at)) at = seqs[id].deadline;
+    }
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    if (at) {
+        its.it_value.tv_sec = at / 1000000000ULL;
+        its.it_value.tv_nsec = at % 1000000000ULL;
+    }
+    timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+// ---- 컴파일 ----
+
+static int parse_num(const char *s, long min, long max, long *out) {
+    char *end;
+    long v = strtol(s, &end, 10);
+    if (end == s || *end != '\0' || v < min || v > max) return -1;
+    *out = v;
+    return 0;
+}
+
+struct block {
+    int step;               // LOOP 또는 IF 단계 인덱스
+    int is_loop;
+    uint64_t wait_ns;       // 한 바퀴에 반드시 기다리는 시간 (바로 안의 WAIT + BREAK 없는 안쪽 유한 LOOP 한 바퀴)
+    int has_break;          // LOOP: 이 LOOP를 빠져나가는 BREAK가 있음
+};
+
+// 정의 문자열(def, 제자리에서 잘림)을 단계 배열로. 실패하면 -1과 이유/단계 번호
+static int compile(char *def, struct seq_step *steps, int *nsteps, const char **why, int *at) {
+    struct block blocks[SEQ_DEPTH];
+    int depth = 0, n = 0, index = 0;
+    char *save = NULL;
+    *why = NULL;
+    for (char *tok = strtok_r(def, ";", &save); tok; tok = strtok_r(NULL, ";", &save), index++) {
+        *at = index;
+        long v;
+        int is_end = strcmp(tok, "END") == 0;
+        if (!is_end && n >= SEQ_STEPS_MAX) {
+            *why = "단계가 너무 많음";
+            return -1;
+        }
+        struct seq_step *st = &steps[n];
+        memset(st, 0, sizeof(*st));
+        if (strncmp(tok, "WAIT:US:", 8) == 0) {
+            if (parse_num(tok + 8, 0, (long)SEQ_WAIT_MAX_MS * 1000, &v) < 0) {
+                *why = "WAIT 시간";
+                return -1;
+            }
+            st->op = SEQ_OP_WAIT;
+            st->wait_ns = (uint64_t)v * 1000ULL;
+        } else if (strncmp(tok, "WAIT:", 5) == 0) {
+            if (parse_num(tok + 5, 0, SEQ_WAIT_MAX_MS, &v) < 0) {
+                *why = "WAIT 시간";
+                return -1;
+            }
+            st->op = SEQ_OP_WAIT;
+            st->wait_ns = (uint64_t)v * 1000000ULL;
+        } else if (strncmp(tok, "LOOP:", 5) == 0 || strncmp(tok, "IF:", 3) == 0) {
+            if (depth >= SEQ_DEPTH) {
+                *why = "중첩이 너무 깊음";
+                return -1;
+            }
+            if (tok[0] == 'L') {
+                if (parse_num(tok + 5, 0, SEQ_LOOP_MAX, &v) < 0) {
+                    *why = "LOOP 횟수";
+                    return -1;
+                }
+                st->op = SEQ_OP_LOOP;
+                st->value = (int32_t)v;
+            } else {
+                if (strncmp(tok + 3, "BUTTON:", 7) == 0) st->cond = DEV_BUTTON;
+                else if (strncmp(tok + 3, "SENSOR:", 7) == 0) st->cond = DEV_SENSOR;
+                if (!st->cond || parse_num(tok + 10, 0, 1, &v) < 0) {
+                    *why = "IF 조건";
+                    return -1;
+                }
+                st->op = SEQ_OP_IF;
+                st->value = (int32_t)v;
+            }
+            blocks[depth].step = n;
+            blocks[depth].is_loop = st->op == SEQ_OP_LOOP;
+            blocks[depth].wait_ns = 0;
+            blocks[depth].has_break = 0;
+            depth++;
+        } else if (strcmp(tok, "ELSE") == 0) {
+            if (depth == 0 || blocks[depth - 1].is_loop || steps[blocks[depth - 1].step].op != SEQ_OP_IF) {
+                *why = "짝 없는 ELSE";
+                return -1;
+            }
+            // IF가 거짓이면 ELSE 다음으로, ELSE 단계 자체는 END에서 점프 위치를 채운다
+            st->op = SEQ_OP_ELSE;
+            steps[blocks[depth - 1].step].jump = n + 1;
+            blocks[depth - 1].step = n;
+        } else if (strcmp(tok, "BREAK") == 0) {
+            int loop = depth - 1;
+            while (loop >= 0 && !blocks[loop].is_loop) loop--;
+            if (loop < 0) {
+                *why = "LOOP 밖의 BREAK";
+                return -1;
+            }
+            st->op = SEQ_OP_BREAK;
+            st->jump = blocks[loop].step;
+            blocks[loop].has_break = 1;
+        } else if (is_end) {
+            if (depth == 0) {
+                *why = "짝 없는 END";
+                return -1;
+            }
+            struct block *b = &blocks[--depth];
+            if (b->is_loop) {
+                if (n >= SEQ_STEPS_MAX) {
+                    *why = "단계가 너무 많음";
+                    return -1;
+                }
+                struct seq_step *loop = &steps[b->step];
+                // WAIT:0만 있는 무한 LOOP는 루프 스레드를 붙잡고 돈다
+                if (loop->value == 0 && b->wait_ns == 0) {
+                    *why = "대기 시간이 0인 무한 LOOP";
+                    return -1;
+                }
+                memset(st, 0, sizeof(*st));
+                st->op = SEQ_OP_END_LOOP;
+                st->jump = b->step;
+                loop->jump = n + 1;
+                n++;
+                if (loop->value > 0 && !b->has_break && depth > 0) blocks[depth - 1].wait_ns += b->wait_ns;
+            } else {
+                steps[b->step].jump = n;    // IF(ELSE가 없을 때) 또는 ELSE → END 다음
+            }
+            continue;
+        } else {
+            int status = proto_parse_text(tok, &st->req);
+            if (status != ST_OK) {
+                *why = status == ST_UNKNOWN_COMMAND ? "알 수 없는 명령" : "명령 인자";
+                return -1;
+            }
+            // 실행 중에 자기 자신을 바꾸거나 지우지 않도록 시퀀서 명령은 넣을 수 없다
+            if (st->req.opcode >= OP_SEQ_DEF && st->req.opcode <= OP_SEQ_LIST) {
+                *why = "SEQ 명령은 단계로 쓸 수 없음";
+                return -1;
+            }
+            st->op = SEQ_OP_CMD;
+        }
+        if (st->op == SEQ_OP_WAIT && depth > 0) blocks[depth - 1].wait_ns += st->wait_ns;
+        n++;
+    }
+    if (depth > 0) {
+        *why = "END가 빠짐";
+        return -1;
+    }
+    if (n == 0) {
+        *why = "빈 시퀀스";
+        return -1;
+    }
+    *nsteps = n;
+    return 0;
+}
+
+// ---- 실행 ----
+
+static int cond_true(const struct seq_step *st) {
+    return input_fn(st->cond) == st->value;
+}
+
+// 실행기 작업의 ctx: 시퀀스 ID(하위 8비트)와 넘길 때의 gen
+static void *step_ctx(int id) {
+    return (void *)(((uintptr_t)seqs[id].gen << 8) | (uintptr_t)id);
+}
+
+static void seq_advance(int id, uint64_t now);
+
+// 이벤트 루프 스레드: 실행기에 넘긴 단계가 끝났으니 같은 실행이면 다음 단계로 이어 간다
+static void step_complete(struct dev_job *job) {
+    int id = (int)((uintptr_t)job->ctx & 0xff);
+    struct sequence *s = &seqs[id];
+    int current = job->ctx == step_ctx(id);
+    s->inflight = 0;
+    if (job->rep.status != ST_OK)
+        LOG_SAMPLED(LOG_WARNING, "SEQ %d 단계 %d 실패 (%s)", id, current ? s->pc : -1, proto_status_name(job->rep.status));
+    if (!s->running) return;
+    if (current) s->pc++;
+    // 이전 실행의 단계였다면 SEQ:RUN이 미뤄 둔 새 실행을 처음부터 시작한다
+    seq_advance(id, now_ns());
+    rearm();
+}
+
+// 실행기가 없는 명령은 루프에서 바로 실행
+static void run_command(int id, int pc, const struct seq_step *st) {
+    struct request req = st->req;
+    struct reply rep;
+    memset(&rep, 0, sizeof(rep));
+    uint64_t t0 = metrics_now();
+    command_dispatch(&req, &rep);
+    metrics_record(METRIC_HIST_CMD(METRIC_EXEC, req.opcode), metrics_now() - t0);
+    if (rep.status != ST_OK) LOG_SAMPLED(LOG_WARNING, "SEQ %d 단계 %d 실패 (%s)", id, pc, proto_status_name(rep.status));
+}
+
+static void seq_stop(int id, const char *why) {
+    struct sequence *s = &seqs[id];
+    if (!s->running) return;
+    s->running = 0;
+    log_msg(LOG_INFO, "SEQ %d %s (최대 지연 %lluus)", id, why, (unsigned long long)(s->max_late_ns / 1000));
+}
+
+// 예정 시각이 된 시퀀스를 다음 WAIT까지 진행
+static void seq_advance(int id, uint64_t now) {
+    struct sequence *s = &seqs[id];
+    for (int burst = 0; burst < SEQ_BURST; burst++) {
+        if (s->pc >= s->nsteps) {
+            seq_stop(id, "완료");
+            return;
+        }
+        const struct seq_step *st = &s->steps[s->pc];
+        switch (st->op) {
+        case SEQ_OP_CMD: {
+            // 디바이스 명령은 그 실행기로 넘기고 끝날 때까지 기다린다 (한 시퀀스가 큐를 무한히 채우지 않도록)
+            int posted = dev_exec_post(&st->req, step_complete, step_ctx(id));
+            if (posted == 0) {
+                s->inflight = 1;
+                return;
+            }
+            if (posted == ST_BUSY) {
+                // 다른 작업으로 실행기 큐가 차 있다: 같은 단계를 조금 뒤에 다시
+                s->deadline = now + SEQ_RETRY_NS;
+                return;
+            }
+            run_command(id, s->pc, st);
+            s->pc++;
+            break;
+        }
+        case SEQ_OP_WAIT:
+            s->pc++;
+            s->deadline += st->wait_ns;
+            if (s->deadline > now) return;
+            break;
+        case SEQ_OP_LOOP:
+            s->loops[s->depth++] = st->value;
+            s->pc++;
+            break;
+        case SEQ_OP_END_LOOP: {
+            int32_t *left = &s->loops[s->depth - 1];
+            if (*left == 0 || --*left > 0) {
+                s->pc = st->jump + 1;
+            } else {
+                s->depth--;
+                s->pc++;
+            }
+            break;
+        }
+        case SEQ_OP_IF:
+            s->pc = cond_true(st) ? s->pc + 1 : st->jump;
+            break;
+        case SEQ_OP_ELSE:
+            s->pc = st->jump;
+            break;
+        case SEQ_OP_BREAK:
+            s->depth--;
+            s->pc = s->steps[st->jump].jump;
+            break;
+        }
+    }
+    // WAIT 없이 SEQ_BURST 단계를 넘겼다: 예정 시각은 그대로 두고 다른 이벤트를 처리한 뒤 이어서
+}
+
+static void on_timer(int fd, uint32_t events, void *arg) {
+    (void)events;
+    (void)arg;
+    uint64_t expirations;
+    ssize_t n = read(fd, &expirations, sizeof(expirations));
+    (void)n;
+    uint64_t now = now_ns();
+    for (int id = 1; id <= SEQ_MAX; id++) {
+        struct sequence *s = &seqs[id];
+        if (!s->running || s->inflight || s->deadline > now) continue;
+        if (now - s->deadline > s->max_late_ns) s->max_late_ns = now - s->deadline;
+        seq_advance(id, now);
+    }
+    rearm();
+}
+
+int sequencer_init(seq_input_fn read_input) {
+    input_fn = read_input;
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd < 0) return -1;
+    if (event_loop_add(tfd, EPOLLIN, on_timer, NULL) < 0) {
+        close(tfd);
+        tfd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+// ---- 명령 ----
+
+static int valid_id(const struct request *req) {
+    return req->nargs >= 1 && req->args[0] >= 1 && req->args[0] <= SEQ_MAX;
+}
+
+// SEQ:DEF:<ID>:<단계>;... → OK:SEQ:DEF:<ID>:<단계 수>, 실행 중인 ID는 ERR:BUSY
+static void cmd_seq_def(const struct request *req, struct reply *rep) {
+    if (!valid_id(req) || req->text_len == 0) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    int id = req->args[0];
+    struct sequence *s = &seqs[id];
+    if (s->running) {
+        reply_error(rep, ST_BUSY);
+        return;
+    }
+    char *def = malloc(req->text_len + 1);
+    struct seq_step *steps = malloc(SEQ_STEPS_MAX * sizeof(*steps));
+    if (!def || !steps) {
+        free(def);
+        free(steps);
+        reply_error(rep, ST_FAILED);
+        return;
+    }
+    memcpy(def, req->text, req->text_len);
+    def[req->text_len] = '\0';
+    int nsteps = 0, at = 0;
+    const char *why;
+    if (compile(def, steps, &nsteps, &why, &at) < 0) {
+        log_msg(LOG_WARNING, "SEQ %d 정의 거부: %d번째 단계, %s", id, at + 1, why);
+        free(def);
+        free(steps);
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    struct seq_step *fit = realloc(steps, nsteps * sizeof(*steps));
+    free(s->def);
+    free(s->steps);
+    s->def = def;
+    s->steps = fit ? fit : steps;
+    s->nsteps = nsteps;
+    reply_ok(rep, "OK:SEQ:DEF");
+    reply_value(rep, id);
+    reply_value(rep, nsteps);
+    log_msg(LOG_INFO, "SEQ %d 정의: 단계 %d개", id, nsteps);
+}
+
+// SEQ:RUN:<ID> → 처음부터 실행 (실행 중이면 다시 시작)
+static void cmd_seq_run(const struct request *req, struct reply *rep) {
+    if (!valid_id(req) || !seqs[req->args[0]].steps) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    struct sequence *s = &seqs[req->args[0]];
+    s->running = 1;
+    s->pc = 0;
+    s->depth = 0;
+    s->runs++;
+    s->gen++;
+    s->max_late_ns = 0;
+    // 첫 단계는 바로 넣어 응답 전에 실행기에 들어가도록 한다.
+    // 이전 실행의 단계가 아직 실행기에 있으면 그 완료(step_complete)에서 시작한다
+    uint64_t now = now_ns();
+    s->deadline = now;
+    if (!s->inflight) seq_advance(req->args[0], now);
+    rearm();
+    reply_ok(rep, "OK:SEQ:RUN");
+    reply_value(rep, req->args[0]);
+}
+
+// SEQ:STOP[:<ID>] → OK:SEQ:STOP:<멈춘 수>, ID를 생략하면 모두 멈춘다. 출력은 그대로 둔다
+static void cmd_seq_stop(const struct request *req, struct reply *rep) {
+    if (req->nargs >= 1 && !valid_id(req)) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    int stopped = 0;
+    for (int id = 1; id <= SEQ_MAX; id++) {
+        if (req->nargs >= 1 && id != req->args[0]) continue;
+        if (seqs[id].running) stopped++;
+        seq_stop(id, "중지");
+    }
+    rearm();
+    reply_ok(rep, "OK:SEQ:STOP");
+    reply_value(rep, stopped);
+}
+
+static void cmd_seq_del(const struct request *req, struct reply *rep) {
+    if (!valid_id(req) || !seqs[req->args[0]].steps) {
+        reply_error(rep, ST_BAD_ARGS);
+        return;
+    }
+    int id = req->args[0];
+    seq_stop(id, "삭제");
+    rearm();
+    free(seqs[id].def);
+    free(seqs[id].steps);
+    // 실행기에 남은 단계의 완료가 나중에 같은 ID로 다시 정의한 시퀀스를 움직이지 않도록 둘은 남긴다
+    int inflight = seqs[id].inflight;
+    uint32_t gen = seqs[id].gen;
+    memset(&seqs[id], 0, sizeof(seqs[id]));
+    seqs[id].inflight = inflight;
+    seqs[id].gen = gen;
+    reply_ok(rep, "OK:SEQ:DEL");
+    reply_value(rep, id);
+}
+
+// OK:SEQ:LIST:<정의된 수> 다음 줄부터 SEQ:<ID>:<단계 수>:<실행 중>:<pc>:<실행 횟수>:<최대 지연 us>
+static void cmd_seq_list(const struct request *req, struct reply *rep) {
+    (void)req;
+    static char buf[SEQ_LIST_BYTES];
+    size_t len = 0;
+    int defined = 0;
+    for (int id = 1; id <= SEQ_MAX; id++) {
+        const struct sequence *s = &seqs[id];
+        if (!s->steps) continue;
+        defined++;
+        int n = snprintf(buf + len, sizeof(buf) - len, "SEQ:%d:%d:%d:%d:%u:%llu\n", id, s->nsteps, s->running, s->pc,
+                         s->runs, (unsigned long long)(s->max_late_ns / 1000));
+        if (n > 0 && len + n < sizeof(buf)) len += n;
+    }
+    reply_ok(rep, "OK:SEQ:LIST");
+    reply_value(rep, defined);
+    reply_text(rep, buf, len);
+}
+
+static const struct command_def sequencer_commands[] = {
+    {VERB_SEQ_DEF,  cmd_seq_def},
+    {VERB_SEQ_RUN,  cmd_seq_run},
+    {VERB_SEQ_STOP, cmd_seq_stop},
+    {VERB_SEQ_DEL,  cmd_seq_del},
+    {VERB_SEQ_LIST, cmd_seq_list},
+};
+
+int sequencer_register_commands(void) {
+    return command_register(sequencer_commands, sizeof(sequencer_commands) / sizeof(sequencer_commands[0]));
+}
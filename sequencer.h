@@ -0,0 +1,29 @@
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+/*
+ * 명령 시퀀서 (서버 쪽 매크로)
+ * - SEQ:DEF:<ID>:<단계>;<단계>;... 정의를 받을 때 한 번만 파싱/검증해 단계 배열로 보관한다
+ *   (명령 단계는 struct request로 미리 파싱해 두므로 실행 중에는 문자열 처리가 없다)
+ * - 단계: 등록된 명령, WAIT:<ms>, WAIT:US:<us>, LOOP:<횟수>(0은 무한) ... END,
+ *   IF:BUTTON:<0|1> / IF:SENSOR:<0|1> ... [ELSE ...] END, BREAK (가장 안쪽 LOOP 탈출)
+ * - 실행은 이벤트 루프 스레드에서 timerfd 하나(절대 시각)로 구동한다. 대기 시각은 이전 예정 시각에
+ *   더해 가므로 명령 실행 시간이나 깨어나는 지연이 쌓이지 않는다 (타이머 휠의 10ms 틱을 쓰지 않음)
+ * - 디바이스 명령 단계는 그 디바이스 실행기에 넣고, 끝난 뒤에 다음 단계로 간다
+ *   (시퀀스마다 실행기에 한 단계만 있으므로 WAIT가 짧아도 큐가 쌓이지 않음. 실패는 완료 때 로그로 남김)
+ * - 모든 함수는 이벤트 루프 스레드에서만 호출할 것
+ */
+
+#define SEQ_MAX 16                  // 시퀀스 ID 1 ~ SEQ_MAX
+#define SEQ_STEPS_MAX 128           // 시퀀스 하나의 최대 단계 수
+#define SEQ_DEPTH 8                 // LOOP/IF 최대 중첩
+#define SEQ_WAIT_MAX_MS 3600000     // WAIT 한 번의 최대 시간
+#define SEQ_LOOP_MAX 1000000        // LOOP 최대 반복 횟수
+
+// IF 조건용 입력 읽기: device는 DEV_BUTTON 또는 DEV_SENSOR, 읽을 수 없으면 -1
+typedef int (*seq_input_fn)(int device);
+
+int sequencer_init(seq_input_fn read_input);    // timerfd 생성 후 이벤트 루프에 등록
+int sequencer_register_commands(void);  // SEQ:* 명령 등록
+
+#endif
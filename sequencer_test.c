@@ -0,0 +1,248 @@
+/**
+ * sequencer_test.c - 시퀀서의 흐름 제어와 정의 검증 확인 (하드웨어 불필요)
+ *
+ * 장치 명령은 실행 기록만 남기는 가짜 핸들러로 등록하고, dev_exec_post는 이 파일의 가짜 실행기로
+ * 바꿔 끼운다 (LED 명령은 실행기로 넘겨 이벤트 루프에서 나중에 끝내고, 나머지는 실행기가 없는 것처럼
+ * 루프에서 바로 실행). 중첩 LOOP/IF/ELSE/BREAK 정의를 돌려 실행 순서를 기대값과 비교하고,
+ * 거부해야 하는 정의가 ERR로 돌아오는지 본다.
+ *
+ * 사용법: make test
+ */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include "protocol.h"
+#include "command.h"
+#include "proto_verbs.h"
+#include "dev_exec.h"
+#include "event_loop.h"
+#include "sequencer.h"
+
+#define TRACE_BYTES 4096
+#define POLL_NS 200000          // 가짜 실행기가 넘겨받은 작업을 끝내는 간격
+#define TIMEOUT_POLLS 10000     // 시퀀스 하나를 기다리는 최대 횟수 (약 2초)
+
+struct order_case {
+    const char *def;
+    int button;
+    int sensor;
+    const char *want;           // 실행된 명령 (공백으로 구분)
+};
+
+static const struct order_case orders[] = {
+    {"LED:ON;LOOP:2;SEG7:1;IF:BUTTON:1;BUZZER:ON;ELSE;BUZZER:OFF;END;END;LED:OFF", 1, 0,
+     "LED:ON SEG7:1 BUZZER:ON SEG7:1 BUZZER:ON LED:OFF"},
+    {"LED:ON;LOOP:2;SEG7:1;IF:BUTTON:1;BUZZER:ON;ELSE;BUZZER:OFF;END;END;LED:OFF", 0, 0,
+     "LED:ON SEG7:1 BUZZER:OFF SEG7:1 BUZZER:OFF LED:OFF"},
+    // BREAK는 가장 안쪽 LOOP만 빠져나가고 바깥 LOOP 횟수는 그대로
+    {"LOOP:2;LOOP:5;LED:ON;BREAK;SEG7:9;END;LED:OFF;END", 0, 0,
+     "LED:ON LED:OFF LED:ON LED:OFF"},
+    // IF 안의 BREAK, 무한 LOOP 탈출 (WAIT를 거치므로 타이머로 진행)
+    {"LOOP:3;SEG7:1;LOOP:0;WAIT:US:100;BUZZER:ON;IF:SENSOR:1;BREAK;END;END;SEG7:2;END", 0, 1,
+     "SEG7:1 BUZZER:ON SEG7:2 SEG7:1 BUZZER:ON SEG7:2 SEG7:1 BUZZER:ON SEG7:2"},
+    // ELSE 안의 중첩 IF, 거짓인 IF는 ELSE가 없으면 END 다음으로
+    {"IF:BUTTON:1;LED:ON;ELSE;IF:SENSOR:1;SEG7:2;END;IF:SENSOR:0;SEG7:3;END;END;LED:OFF", 0, 1,
+     "SEG7:2 LED:OFF"},
+    {"LOOP:1;LOOP:1;LOOP:1;LOOP:1;LOOP:1;LOOP:1;LOOP:1;LOOP:2;BUZZER:OFF;END;END;END;END;END;END;END;END", 0, 0,
+     "BUZZER:OFF BUZZER:OFF"},
+};
+
+struct reject_case {
+    const char *def;
+    const char *why;
+};
+
+static const struct reject_case rejects[] = {
+    {"LOOP:0;LED:ON;END", "대기 시간이 0인 무한 LOOP"},
+    {"LOOP:0;WAIT:0;LED:ON;END", "WAIT:0만 있는 무한 LOOP"},
+    {"LOOP:0;IF:BUTTON:1;WAIT:10;END;END", "IF 안에만 WAIT가 있는 무한 LOOP"},
+    {"LOOP:0;LOOP:2;WAIT:10;BREAK;END;END", "BREAK 있는 안쪽 LOOP에만 WAIT"},
+    {"LED:ON;END", "짝 없는 END"},
+    {"ELSE;LED:ON", "짝 없는 ELSE"},
+    {"LOOP:2;ELSE;END", "LOOP 안의 ELSE"},
+    {"IF:BUTTON:1;LED:ON;ELSE;LED:OFF;ELSE;END", "ELSE 두 번"},
+    {"BREAK", "LOOP 밖의 BREAK"},
+    {"IF:BUTTON:1;BREAK;END", "IF 안이지만 LOOP 밖의 BREAK"},
+    {"LOOP:2;LED:ON", "END가 빠짐"},
+    {"LOOP:1;LOOP:1;LOOP:1;LOOP:1;LOOP:1;LOOP:1;LOOP:1;LOOP:1;LOOP:1;LED:ON;END;END;END;END;END;END;END;END;END",
+     "중첩이 너무 깊음"},
+    {"LED:ON;SEQ:RUN:1", "SEQ 명령 단계"},
+};
+
+// 거부하지 않아야 하는 무한 LOOP
+static const char *const accepts[] = {
+    "LOOP:0;LOOP:2;WAIT:10;END;END",                // BREAK 없는 안쪽 유한 LOOP의 WAIT
+    "LOOP:0;WAIT:10;IF:BUTTON:1;BREAK;END;END",
+    "LOOP:0;IF:BUTTON:1;WAIT:10;ELSE;WAIT:10;END;WAIT:US:1;END",
+};
+
+static char trace[TRACE_BYTES];
+static size_t trace_len = 0;
+static int button_level = 0;
+static int sensor_level = 0;
+static int failures = 0;
+
+static void check(int ok, const char *what) {
+    printf("%-52s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+// ---- 가짜 장치 명령 ----
+
+static void cmd_stub(const struct request *req, struct reply *rep) {
+    const struct command_def *def = command_by_opcode(req->opcode);
+    int n = snprintf(trace + trace_len, sizeof(trace) - trace_len, "%s%s", trace_len ? " " : "", def->verb);
+    if (n > 0 && trace_len + n < sizeof(trace)) trace_len += n;
+    for (int i = 0; i < req->nargs; i++) {
+        n = snprintf(trace + trace_len, sizeof(trace) - trace_len, ":%d", req->args[i]);
+        if (n > 0 && trace_len + n < sizeof(trace)) trace_len += n;
+    }
+    reply_ok(rep, def->verb);
+}
+
+static const struct command_def stub_commands[] = {
+    {VERB_LED_ON,     cmd_stub},
+    {VERB_LED_OFF,    cmd_stub},
+    {VERB_SEG7_SHOW,  cmd_stub},
+    {VERB_BUZZER_ON,  cmd_stub},
+    {VERB_BUZZER_OFF, cmd_stub},
+};
+
+static int read_input(int device) {
+    return device == DEV_BUTTON ? button_level : sensor_level;
+}
+
+// ---- 가짜 실행기: LED 명령 한 건을 받아 두었다가 다음 폴링에서 실행하고 완료를 알린다 ----
+
+static struct dev_job held;
+static int holding = 0;
+static int posts = 0;
+
+int dev_exec_post(const struct request *req, dev_job_fn complete, void *ctx) {
+    if (req->device != DEV_LED) return -1;
+    if (holding) return ST_BUSY;    // 시퀀서는 시퀀스마다 한 단계만 넘긴다
+    memset(&held, 0, sizeof(held));
+    held.req = *req;
+    held.complete = complete;
+    held.ctx = ctx;
+    holding = 1;
+    posts++;
+    return 0;
+}
+
+static int seq_running(int id) {
+    struct request req;
+    struct reply rep;
+    proto_parse_text("SEQ:LIST", &req);
+    memset(&rep, 0, sizeof(rep));
+    command_dispatch(&req, &rep);
+    for (const char *p = rep.text; p && p < rep.text + rep.text_len; p = strchr(p, '\n') + 1) {
+        int sid, nsteps, running;
+        if (sscanf(p, "SEQ:%d:%d:%d", &sid, &nsteps, &running) == 3 && sid == id) return running;
+    }
+    return 0;
+}
+
+static int polls = 0;
+
+static void on_poll(int fd, uint32_t events, void *arg) {
+    (void)events;
+    (void)arg;
+    uint64_t expirations;
+    ssize_t n = read(fd, &expirations, sizeof(expirations));
+    (void)n;
+    if (holding) {
+        holding = 0;
+        command_dispatch(&held.req, &held.rep);
+        held.complete(&held);
+    }
+    if (!seq_running(1) || ++polls >= TIMEOUT_POLLS) event_loop_stop();
+}
+
+// ---- 검사 ----
+
+static int run_cmd(const char *text) {
+    struct request req;
+    struct reply rep;
+    if (proto_parse_text(text, &req) != ST_OK) return -1;
+    memset(&rep, 0, sizeof(rep));
+    command_dispatch(&req, &rep);
+    return rep.status == ST_OK ? 0 : -1;
+}
+
+static int define(const char *def) {
+    char line[512];
+    snprintf(line, sizeof(line), "SEQ:DEF:1:%s", def);
+    return run_cmd(line);
+}
+
+static void test_order(const struct order_case *c) {
+    trace_len = 0;
+    trace[0] = '\0';
+    button_level = c->button;
+    sensor_level = c->sensor;
+    polls = 0;
+    if (define(c->def) < 0 || run_cmd("SEQ:RUN:1") < 0) {
+        check(0, c->want);
+        return;
+    }
+    if (seq_running(1) || holding) event_loop_run();
+    int ok = !seq_running(1) && !holding && strcmp(trace, c->want) == 0;
+    check(ok, c->want);
+    if (!ok) printf("  실행: %s\n", trace);
+}
+
+// WAIT 없는 유한 LOOP가 SEQ_BURST를 넘어도 끝까지 돈다 (나머지는 다음 루프 회차)
+static void test_burst(void) {
+    trace_len = 0;
+    polls = 0;
+    int ok = define("LOOP:300;BUZZER:OFF;END") == 0 && run_cmd("SEQ:RUN:1") == 0;
+    if (ok && seq_running(1)) event_loop_run();
+    size_t count = 0;
+    for (const char *p = trace; (p = strstr(p, "BUZZER:OFF")) != NULL; p++) count++;
+    check(ok && !seq_running(1) && count == 300, "WAIT 없는 LOOP:300 (한 번에 실행할 단계 수 초과)");
+}
+
+// 이전 실행의 LED 단계가 실행기에 있는 동안 다시 RUN해도 새 실행은 처음부터 한 번만 돈다
+static void test_rerun(void) {
+    trace_len = 0;
+    polls = 0;
+    int ok = define("LED:ON;SEG7:4") == 0 && run_cmd("SEQ:RUN:1") == 0 && holding && run_cmd("SEQ:RUN:1") == 0;
+    if (ok) event_loop_run();
+    ok = ok && !seq_running(1) && strcmp(trace, "LED:ON LED:ON SEG7:4") == 0;
+    check(ok, "실행기 단계가 끝나기 전 다시 RUN");
+    if (!ok) printf("  실행: %s\n", trace);
+}
+
+int main(void) {
+    if (event_loop_init() < 0 || command_register(stub_commands, sizeof(stub_commands) / sizeof(stub_commands[0])) < 0 ||
+        sequencer_init(read_input) < 0 || sequencer_register_commands() < 0) {
+        fprintf(stderr, "초기화 실패\n");
+        return 1;
+    }
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    struct itimerspec its = {{0, POLL_NS}, {0, POLL_NS}};
+    if (tfd < 0 || timerfd_settime(tfd, 0, &its, NULL) < 0 || event_loop_add(tfd, EPOLLIN, on_poll, NULL) < 0) {
+        fprintf(stderr, "초기화 실패\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < sizeof(orders) / sizeof(orders[0]); i++) test_order(&orders[i]);
+    check(posts > 0, "LED 단계는 실행기로 넘김");
+    test_burst();
+    test_rerun();
+    for (size_t i = 0; i < sizeof(rejects) / sizeof(rejects[0]); i++) {
+        char what[128];
+        snprintf(what, sizeof(what), "거부: %s", rejects[i].why);
+        check(define(rejects[i].def) < 0, what);
+    }
+    for (size_t i = 0; i < sizeof(accepts) / sizeof(accepts[0]); i++) {
+        char what[128];
+        snprintf(what, sizeof(what), "허용: %s", accepts[i]);
+        check(define(accepts[i]) == 0, what);
+    }
+    printf("%s (실패 %d)\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
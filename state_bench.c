@@ -0,0 +1,171 @@
+/**
+ * state_bench.c - 공유 메모리 상태 스냅샷 읽기 비용 벤치마크
+ *
+ * 쓰는 스레드가 쉬지 않고 상태를 갱신하는 동안 읽는 스레드 여러 개가 스냅샷을 뜬다.
+ * 스냅샷마다 led_pwm과 sensor_value가 같은지(쓰기 도중의 조각이 섞이지 않았는지) 확인한다.
+ * -p를 주면 실행 중인 데몬에 SENSOR:27을 보내는 소켓 왕복 시간과 비교한다.
+ *
+ * 사용법: ./state_bench [-r 읽기스레드수] [-t 초] [-p 데몬포트]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "device_state.h"
+#include "state_reader.h"
+
+#define BENCH_SHM "/gpio_state_bench"
+#define MAX_READERS 16
+#define TCP_ROUNDS 20000
+
+struct reader_result {
+    unsigned long snapshots;
+    unsigned long retries;
+    unsigned long torn;      // 조각난 스냅샷 (0이어야 함)
+    double ns_per_snapshot;
+};
+
+static volatile int stop = 0;
+static volatile int writer_on = 0;
+static int duration = 2;
+
+static double elapsed_ns(const struct timespec *a, const struct timespec *b) {
+    return (b->tv_sec - a->tv_sec) * 1e9 + (b->tv_nsec - a->tv_nsec);
+}
+
+static void *writer_thread(void *arg) {
+    unsigned long *writes = arg;
+    int32_t v = 0;
+    while (!stop) {
+        struct device_state *s = device_state_begin();
+        v++;
+        s->led_pwm = v;
+        s->seg7_digit = v % 10;
+        s->sensor_value = v;
+        device_state_end();
+        (*writes)++;
+    }
+    return NULL;
+}
+
+static void *reader_thread(void *arg) {
+    struct reader_result *res = arg;
+    struct state_reader *r = state_reader_open(BENCH_SHM);
+    if (!r) return NULL;
+    struct device_state snap;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while (!stop) {
+        state_reader_snapshot(r, &snap);
+        if (snap.led_pwm != snap.sensor_value) res->torn++;
+        res->snapshots++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    res->retries = state_reader_retries(r);
+    res->ns_per_snapshot = res->snapshots ? elapsed_ns(&t0, &t1) / res->snapshots : 0;
+    state_reader_close(r);
+    return NULL;
+}
+
+static void run(int readers) {
+    pthread_t wt, rt[MAX_READERS];
+    struct reader_result res[MAX_READERS];
+    unsigned long writes = 0;
+
+    memset(res, 0, sizeof(res));
+    stop = 0;
+    if (writer_on) pthread_create(&wt, NULL, writer_thread, &writes);
+    for (int i = 0; i < readers; i++) pthread_create(&rt[i], NULL, reader_thread, &res[i]);
+    sleep(duration);
+    stop = 1;
+    for (int i = 0; i < readers; i++) pthread_join(rt[i], NULL);
+    if (writer_on) pthread_join(wt, NULL);
+
+    unsigned long snaps = 0, retries = 0, torn = 0;
+    double ns = 0;
+    for (int i = 0; i < readers; i++) {
+        snaps += res[i].snapshots;
+        retries += res[i].retries;
+        torn += res[i].torn;
+        ns += res[i].ns_per_snapshot;
+    }
+    printf("%-8s %8d %14.0f %10.1f %12lu %8lu %14.0f\n", writer_on ? "yes" : "no", readers,
+           snaps / (double)duration, readers ? ns / readers : 0, retries, torn, writes / (double)duration);
+}
+
+// 데몬에 SENSOR:27을 보내고 한 줄 응답을 받는 왕복 시간
+static void tcp_compare(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("connect");
+        if (fd >= 0) close(fd);
+        return;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    char buf[256];
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < TCP_ROUNDS; i++) {
+        if (write(fd, "SENSOR:27\n", 10) != 10) break;
+        size_t got = 0;
+        while (got == 0 || buf[got - 1] != '\n') {
+            ssize_t n = read(fd, buf + got, sizeof(buf) - got);
+            if (n <= 0) {
+                close(fd);
+                return;
+            }
+            got += n;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    close(fd);
+    printf("TCP SENSOR:27 왕복: %.1f ns/요청 (%d회)\n", elapsed_ns(&t0, &t1) / TCP_ROUNDS, TCP_ROUNDS);
+}
+
+int main(int argc, char *argv[]) {
+    int max_readers = 4, port = 0, opt;
+    while ((opt = getopt(argc, argv, "r:t:p:")) != -1) {
+        switch (opt) {
+            case 'r': max_readers = atoi(optarg); break;
+            case 't': duration = atoi(optarg); break;
+            case 'p': port = atoi(optarg); break;
+            default:
+                fprintf(stderr, "사용법: %s [-r 읽기스레드수] [-t 초] [-p 데몬포트]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (max_readers < 1) max_readers = 1;
+    if (max_readers > MAX_READERS) max_readers = MAX_READERS;
+    if (duration < 1) duration = 1;
+
+    if (device_state_publish(BENCH_SHM) < 0) {
+        perror("device_state_publish");
+        return 1;
+    }
+    struct device_state *s = device_state_begin();
+    s->led_pwm = s->sensor_value = 0;
+    device_state_end();
+    printf("스냅샷 크기: %zu바이트, 측정 시간: %d초/시나리오\n", sizeof(struct device_state), duration);
+    printf("%-8s %8s %14s %10s %12s %8s %14s\n", "writer", "readers", "snapshots/s", "ns/snap", "retries", "torn", "writes/s");
+    for (int w = 0; w <= 1; w++) {
+        writer_on = w;
+        for (int n = 1; n <= max_readers; n *= 2) run(n);
+    }
+    device_state_unpublish();
+
+    if (port > 0) tcp_compare(port);
+    return 0;
+}
@@ -0,0 +1,59 @@
+/**
+ * state_reader.c - 디바이스 상태 공유 메모리 읽기 (seqlock 읽기 쪽)
+ */
+#include "state_reader.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+struct state_reader {
+    const struct device_state *shm;
+    unsigned long retries;
+};
+
+struct state_reader *state_reader_open(const char *name) {
+    if (!name) name = DEVICE_STATE_SHM;
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return NULL;
+    void *p = mmap(NULL, sizeof(struct device_state), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+    struct state_reader *r = calloc(1, sizeof(*r));
+    if (!r) {
+        munmap(p, sizeof(struct device_state));
+        return NULL;
+    }
+    r->shm = p;
+    return r;
+}
+
+int state_reader_snapshot(struct state_reader *r, struct device_state *out) {
+    const struct device_state *s = r->shm;
+    if (s->magic != DEVICE_STATE_MAGIC || s->version != DEVICE_STATE_VERSION) return -1;
+    for (;;) {
+        uint32_t begin = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        if (begin & 1) {
+            r->retries++;
+            continue;
+        }
+        memcpy(out, (const void *)s, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);   // 복사가 아래 seq 확인보다 먼저 끝나도록
+        if (__atomic_load_n(&s->seq, __ATOMIC_RELAXED) == begin) {
+            out->seq = begin;
+            return 0;
+        }
+        r->retries++;
+    }
+}
+
+unsigned long state_reader_retries(const struct state_reader *r) {
+    return r->retries;
+}
+
+void state_reader_close(struct state_reader *r) {
+    if (!r) return;
+    munmap((void *)r->shm, sizeof(struct device_state));
+    free(r);
+}
@@ -0,0 +1,18 @@
+#ifndef STATE_READER_H
+#define STATE_READER_H
+
+#include "device_state.h"
+
+/*
+ * 디바이스 상태 공유 메모리 읽기 라이브러리 (libgpiostate.a)
+ * 스냅샷은 시스템 호출 없이 공유 메모리에서 바로 복사한다.
+ */
+
+struct state_reader;
+
+struct state_reader *state_reader_open(const char *name); // NULL이면 기본 이름, 실패 시 NULL
+int state_reader_snapshot(struct state_reader *r, struct device_state *out); // 0, 형식이 다르면 -1
+unsigned long state_reader_retries(const struct state_reader *r); // 쓰기와 겹쳐 다시 읽은 횟수
+void state_reader_close(struct state_reader *r);
+
+#endif
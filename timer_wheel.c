@@ -0,0 +1,253 @@
+/**
+ * timer_wheel.c - 계층형 타이머 휠
+ *
+ * 만료 시각(틱)까지 남은 거리에 따라 레벨을 고르고, 레벨 L에서는 만료 틱의 (6L ~ 6L+5) 비트가 칸 번호다.
+ * 레벨 0 칸이 한 바퀴 돌 때마다 상위 레벨의 해당 칸을 아래로 다시 나눠 넣는다(cascade).
+ * 타이머는 인덱스로 연결된 풀에 두어 ID(세대 + 인덱스)로 바로 찾고 O(1)로 뺀다.
+ * timerfd는 다음으로 처리할 틱에만 맞춰 두므로 타이머가 없으면 깨어나지 않는다.
+ */
+#include "timer_wheel.h"
+#include "event_loop.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 5
+#define WHEEL_RANGE (1ULL << (WHEEL_BITS * WHEEL_LEVELS))   // 틱 단위 최대 거리
+
+#define IDX_BITS 20                       // ID 하위 비트: 풀 인덱스, 그 위 11비트: 세대 (ID는 항상 양의 int32)
+#define IDX_MASK ((1u << IDX_BITS) - 1)
+#define GEN_MASK ((1u << (31 - IDX_BITS)) - 1)
+#define MAX_TIMERS (1 << IDX_BITS)
+
+struct timer {
+    uint64_t expires;   // 만료 틱
+    timer_cb cb;
+    void *arg;
+    int prev, next;     // 칸 리스트 (또는 빈 칸 리스트) 인덱스, -1이면 끝
+    int16_t slot;       // 레벨 * WHEEL_SIZE + 칸, -1이면 미사용
+    uint16_t gen;       // 재사용 시 이전 ID를 무효화 (1 ~ GEN_MASK, ID가 0이 되지 않도록)
+};
+
+static struct timer *pool = NULL;
+static int pool_cap = 0;
+static int free_head = -1;
+static size_t active = 0;
+
+static int slots[WHEEL_LEVELS * WHEEL_SIZE];   // 칸별 리스트 머리
+static uint64_t occupied[WHEEL_LEVELS];        // 칸별 비어있지 않음 비트맵
+static uint64_t now_tick = 0;                  // 여기까지 처리함
+static struct timespec base;                   // 틱 0의 시각
+static int tfd = -1;
+static uint64_t armed_tick = 0;                // timerfd가 맞춰진 틱 (0이면 꺼짐)
+static int advancing = 0;                      // 만료 콜백 실행 중 (콜백에서 추가 시 재진입 방지)
+
+static uint64_t current_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)(ts.tv_sec - base.tv_sec) * 1000 + (ts.tv_nsec - base.tv_nsec) / 1000000;
+}
+
+static uint64_t current_tick(void) {
+    return current_ms() / TIMER_TICK_MS;
+}
+
+static int pool_grow(void) {
+    int cap = pool_cap ? pool_cap * 2 : 256;
+    if (cap > MAX_TIMERS) cap = MAX_TIMERS;
+    if (cap <= pool_cap) return -1;
+    struct timer *p = realloc(pool, cap * sizeof(*p));
+    if (!p) return -1;
+    for (int i = pool_cap; i < cap; i++) {
+        p[i].slot = -1;
+        p[i].gen = 1;
+        p[i].next = i + 1 < cap ? i + 1 : free_head;
+    }
+    free_head = pool_cap;
+    pool = p;
+    pool_cap = cap;
+    return 0;
+}
+
+static void slot_insert(int idx) {
+    struct timer *t = &pool[idx];
+    uint64_t delta = t->expires - now_tick;
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= (1ULL << (WHEEL_BITS * (level + 1)))) level++;
+    int s = level * WHEEL_SIZE + (int)((t->expires >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    t->slot = (int16_t)s;
+    t->prev = -1;
+    t->next = slots[s];
+    if (slots[s] >= 0) pool[slots[s]].prev = idx;
+    slots[s] = idx;
+    occupied[level] |= 1ULL << (s & WHEEL_MASK);
+}
+
+static void slot_remove(int idx) {
+    struct timer *t = &pool[idx];
+    int s = t->slot;
+    if (t->prev >= 0) pool[t->prev].next = t->next;
+    else slots[s] = t->next;
+    if (t->next >= 0) pool[t->next].prev = t->prev;
+    if (slots[s] < 0) occupied[s / WHEEL_SIZE] &= ~(1ULL << (s & WHEEL_MASK));
+    t->slot = -1;
+}
+
+static void release(int idx) {
+    pool[idx].gen = (pool[idx].gen + 1) & GEN_MASK;
+    if (pool[idx].gen == 0) pool[idx].gen = 1;
+    pool[idx].next = free_head;
+    free_head = idx;
+    active--;
+}
+
+// 상위 레벨 칸의 타이머를 현재 시각 기준으로 다시 배치
+static void cascade(int level) {
+    int s = level * WHEEL_SIZE + (int)((now_tick >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    int idx = slots[s];
+    slots[s] = -1;
+    occupied[level] &= ~(1ULL << (s & WHEEL_MASK));
+    while (idx >= 0) {
+        int next = pool[idx].next;
+        slot_insert(idx);
+        idx = next;
+    }
+}
+
+// 레벨 0의 현재 칸 만료 처리
+static void expire_slot(void) {
+    int s = (int)(now_tick & WHEEL_MASK);
+    while (slots[s] >= 0) {
+        int idx = slots[s];
+        struct timer *t = &pool[idx];
+        uint32_t id = (uint32_t)t->gen << IDX_BITS | (uint32_t)idx;
+        timer_cb cb = t->cb;
+        void *arg = t->arg;
+        slot_remove(idx);
+        release(idx);
+        cb(id, arg);   // 콜백 안에서 타이머를 추가/취소해도 된다
+    }
+}
+
+// now_tick을 target까지 진행. 빈 구간은 레벨 0 비트맵으로 건너뛴다.
+static void advance(uint64_t target) {
+    advancing = 1;
+    while (now_tick < target) {
+        uint64_t boundary = (now_tick | WHEEL_MASK) + 1;
+        uint64_t step = boundary;
+        int pos = (int)(now_tick & WHEEL_MASK);
+        if (pos < WHEEL_MASK) {
+            uint64_t ahead = occupied[0] & (~0ULL << (pos + 1));
+            if (ahead) step = (now_tick & ~(uint64_t)WHEEL_MASK) + __builtin_ctzll(ahead);
+        }
+        if (step > target) step = target;
+        now_tick = step;
+        if ((now_tick & WHEEL_MASK) == 0) {
+            for (int level = 1; level < WHEEL_LEVELS; level++) {
+                cascade(level);
+                if ((now_tick >> (WHEEL_BITS * level)) & WHEEL_MASK) break;
+            }
+        }
+        expire_slot();
+    }
+    advancing = 0;
+}
+
+// 다음에 깨어날 틱: 현재 바퀴의 다음 레벨 0 타이머, 없으면 다음 cascade 시점
+static uint64_t next_wake(void) {
+    if (active == 0) return 0;
+    uint64_t boundary = (now_tick | WHEEL_MASK) + 1;
+    int pos = (int)(now_tick & WHEEL_MASK);
+    if (pos < WHEEL_MASK) {
+        uint64_t ahead = occupied[0] & (~0ULL << (pos + 1));
+        if (ahead) return (now_tick & ~(uint64_t)WHEEL_MASK) + __builtin_ctzll(ahead);
+    }
+    return boundary;
+}
+
+static void rearm(void) {
+    if (advancing) return;   // 진행이 끝나면 on_timerfd에서 다시 맞춘다
+    uint64_t tick = next_wake();
+    if (tick == armed_tick) return;
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    if (tick) {
+        uint64_t ms = tick * TIMER_TICK_MS;
+        its.it_value.tv_sec = base.tv_sec + ms / 1000;
+        its.it_value.tv_nsec = base.tv_nsec + (long)(ms % 1000) * 1000000L;
+        if (its.it_value.tv_nsec >= 1000000000L) {
+            its.it_value.tv_sec++;
+            its.it_value.tv_nsec -= 1000000000L;
+        }
+    }
+    timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL);
+    armed_tick = tick;
+}
+
+static void on_timerfd(int fd, uint32_t events, void *arg) {
+    (void)events; (void)arg;
+    uint64_t n;
+    while (read(fd, &n, sizeof(n)) > 0) { }
+    armed_tick = 0;
+    advance(current_tick());
+    rearm();
+}
+
+int timer_wheel_init(void) {
+    for (int i = 0; i < WHEEL_LEVELS * WHEEL_SIZE; i++) slots[i] = -1;
+    clock_gettime(CLOCK_MONOTONIC, &base);
+    now_tick = 0;
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd < 0) return -1;
+    return event_loop_add(tfd, EPOLLIN, on_timerfd, NULL);
+}
+
+uint32_t timer_add(unsigned long ms, timer_cb cb, void *arg) {
+    if (ms / TIMER_TICK_MS >= WHEEL_RANGE - 1) return 0;
+    if (free_head < 0 && pool_grow() < 0) return 0;
+    // 밀린 틱을 먼저 처리해야 현재 시각 기준으로 칸을 고를 수 있다
+    if (!advancing) advance(current_tick());
+    // 틱 경계로 올림해서 요청보다 일찍 만료되지 않게 한다
+    uint64_t expires = (current_ms() + ms + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+    if (expires <= now_tick) expires = now_tick + 1;
+    int idx = free_head;
+    struct timer *t = &pool[idx];
+    free_head = t->next;
+    t->expires = expires;
+    t->cb = cb;
+    t->arg = arg;
+    slot_insert(idx);
+    active++;
+    rearm();
+    return (uint32_t)t->gen << IDX_BITS | (uint32_t)idx;
+}
+
+int timer_cancel(uint32_t id, void **arg) {
+    uint32_t idx = id & IDX_MASK;
+    if ((int)idx >= pool_cap || pool[idx].slot < 0 || pool[idx].gen != (id >> IDX_BITS)) return -1;
+    if (arg) *arg = pool[idx].arg;
+    slot_remove(idx);
+    release(idx);
+    rearm();
+    return 0;
+}
+
+size_t timer_count(void) {
+    return active;
+}
+
+void timer_foreach(timer_visit_fn fn, void *ctx) {
+    uint64_t now = current_tick();
+    for (int idx = 0; idx < pool_cap; idx++) {
+        struct timer *t = &pool[idx];
+        if (t->slot < 0) continue;
+        unsigned long remaining = t->expires > now ? (unsigned long)(t->expires - now) * TIMER_TICK_MS : 0;
+        fn((uint32_t)t->gen << IDX_BITS | (uint32_t)idx, remaining, t->arg, ctx);
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * 계층형 타이머 휠 (이벤트 루프의 timerfd 하나로 구동)
+ * - 틱 10ms, 레벨당 64칸 * 5레벨 (최대 약 124일)
+ * - 추가/취소 O(1), 콜백은 이벤트 루프 스레드에서 호출된다
+ * - 모든 함수는 이벤트 루프 스레드에서만 호출할 것
+ */
+
+#define TIMER_TICK_MS 10
+
+typedef void (*timer_cb)(uint32_t id, void *arg);
+// timer_foreach 방문 함수: remaining_ms는 남은 시간
+typedef void (*timer_visit_fn)(uint32_t id, unsigned long remaining_ms, void *arg, void *ctx);
+
+int timer_wheel_init(void);                                    // timerfd 생성 후 이벤트 루프에 등록
+uint32_t timer_add(unsigned long ms, timer_cb cb, void *arg);  // 타이머 ID, 실패 시 0
+int timer_cancel(uint32_t id, void **arg);                     // 0 성공 (arg 돌려줌), -1 없는 ID
+size_t timer_count(void);
+void timer_foreach(timer_visit_fn fn, void *ctx);
+
+#endif